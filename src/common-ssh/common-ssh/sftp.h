@@ -80,6 +80,12 @@ typedef struct guac_common_ssh_sftp_filesystem {
      */
     int disable_upload;
 
+    /**
+     * The maximum number of blobs which may be sent along each download
+     * stream without having been acknowledged.
+     */
+    int download_window;
+
 } guac_common_ssh_sftp_filesystem;
 
 /**
@@ -140,12 +146,18 @@ typedef struct guac_common_ssh_sftp_ls_state {
  * @param disable_upload
  *     Whether uploads from the local browser to SFTP should be disabled.
  *
+ * @param download_window
+ *     The maximum number of blobs which may be sent along each download
+ *     stream without having been acknowledged. If less than one,
+ *     GUAC_COMMON_DOWNLOAD_DEFAULT_WINDOW is used.
+ *
  * @return
  *     A new SFTP filesystem object, not yet exposed to users.
  */
 guac_common_ssh_sftp_filesystem* guac_common_ssh_create_sftp_filesystem(
         guac_common_ssh_session* session, const char* root_path,
-        const char* name, int disable_download, int disable_upload);
+        const char* name, int disable_download, int disable_upload,
+        int download_window);
 
 /**
  * Destroys the given filesystem object, disconnecting from SFTP and freeing
@@ -17,6 +17,7 @@
  * under the License.
  */
 
+#include "common/download.h"
 #include "common-ssh/sftp.h"
 #include "common-ssh/ssh.h"
 
@@ -441,85 +442,45 @@ int guac_common_ssh_sftp_handle_file_stream(
 }
 
 /**
- * Handler for ack messages which continue an outbound SFTP data transfer
- * (download), signaling the current status and requesting additional data.
- * The data associated with the given stream is expected to be a pointer to an
- * open LIBSSH2_SFTP_HANDLE for the file from which the data is to be read.
+ * Read handler for outbound SFTP data transfers (downloads), reading the next
+ * portion of the file being downloaded. The given data is expected to be a
+ * pointer to an open LIBSSH2_SFTP_HANDLE for the file from which the data is
+ * to be read.
  *
- * @param user
- *     The user receiving the ack message.
+ * @param data
+ *     The LIBSSH2_SFTP_HANDLE of the file being downloaded.
  *
- * @param stream
- *     The Guacamole protocol stream associated with the received ack message.
+ * @param buffer
+ *     The buffer to read data into.
  *
- * @param message
- *     An arbitrary human-readable message describing the nature of the
- *     success or failure denoted by the ack message.
- *
- * @param status
- *     The status code associated with the ack message, which may indicate
- *     success or an error.
+ * @param length
+ *     The maximum number of bytes to read.
  *
  * @return
- *     Zero if the file is read from successfully, or non-zero on error.
+ *     The number of bytes read, zero if the end of the file has been reached,
+ *     or a negative value if an error occurs.
  */
-static int guac_common_ssh_sftp_ack_handler(guac_user* user,
-        guac_stream* stream, char* message, guac_protocol_status status) {
-
-    /* Pull file from stream */
-    LIBSSH2_SFTP_HANDLE* file = (LIBSSH2_SFTP_HANDLE*) stream->data;
-
-    /* If successful, read data */
-    if (status == GUAC_PROTOCOL_STATUS_SUCCESS) {
+static int guac_common_ssh_sftp_download_read_handler(void* data,
+        char* buffer, int length) {
 
-        /* Attempt read into buffer */
-        char buffer[4096];
-        int bytes_read = libssh2_sftp_read(file, buffer, sizeof(buffer)); 
+    LIBSSH2_SFTP_HANDLE* file = (LIBSSH2_SFTP_HANDLE*) data;
 
-        /* If bytes read, send as blob */
-        if (bytes_read > 0) {
-            guac_protocol_send_blob(user->socket, stream,
-                    buffer, bytes_read);
+    /* Large reads are split by libssh2 into several concurrent SFTP read
+     * requests, overlapping the latency of the SFTP server */
+    return libssh2_sftp_read(file, buffer, length);
 
-            guac_user_log(user, GUAC_LOG_DEBUG, "%i bytes sent to user",
-                    bytes_read);
-
-        }
-
-        /* If bytes could not be read, handle EOF or error condition */
-        else {
-
-            /* If EOF, send end */
-            if (bytes_read == 0) {
-                guac_user_log(user, GUAC_LOG_DEBUG, "File sent");
-                guac_protocol_send_end(user->socket, stream);
-                guac_user_free_stream(user, stream);
-            }
-
-            /* Otherwise, fail stream */
-            else {
-                guac_user_log(user, GUAC_LOG_INFO, "Error reading file");
-                guac_protocol_send_end(user->socket, stream);
-                guac_user_free_stream(user, stream);
-            }
-
-            /* Close file */
-            if (libssh2_sftp_close(file) == 0)
-                guac_user_log(user, GUAC_LOG_DEBUG, "File closed");
-            else
-                guac_user_log(user, GUAC_LOG_INFO, "Unable to close file");
-
-        }
-
-        guac_socket_flush(user->socket);
-
-    }
-
-    /* Otherwise, return stream to user */
-    else
-        guac_user_free_stream(user, stream);
+}
 
-    return 0;
+/**
+ * Close handler for outbound SFTP data transfers (downloads), closing the
+ * file that was downloaded. The given data is expected to be a pointer to an
+ * open LIBSSH2_SFTP_HANDLE for that file.
+ *
+ * @param data
+ *     The LIBSSH2_SFTP_HANDLE of the file that was downloaded.
+ */
+static void guac_common_ssh_sftp_download_close_handler(void* data) {
+    libssh2_sftp_close((LIBSSH2_SFTP_HANDLE*) data);
 }
 
 guac_stream* guac_common_ssh_sftp_download_file(
@@ -549,8 +510,10 @@ guac_stream* guac_common_ssh_sftp_download_file(
 
     /* Allocate stream */
     stream = guac_user_alloc_stream(user);
-    stream->ack_handler = guac_common_ssh_sftp_ack_handler;
-    stream->data = file;
+    guac_common_download_begin(stream,
+            guac_common_ssh_sftp_download_read_handler,
+            guac_common_ssh_sftp_download_close_handler,
+            file, filesystem->download_window);
 
     /* Send stream start, strip name */
     filename = basename(filename);
@@ -827,8 +790,10 @@ static int guac_common_ssh_sftp_get_handler(guac_user* user,
 
         /* Allocate stream for body */
         guac_stream* stream = guac_user_alloc_stream(user);
-        stream->ack_handler = guac_common_ssh_sftp_ack_handler;
-        stream->data = file;
+        guac_common_download_begin(stream,
+                guac_common_ssh_sftp_download_read_handler,
+                guac_common_ssh_sftp_download_close_handler,
+                file, filesystem->download_window);
 
         /* Associate new stream with get request */
         guac_protocol_send_body(user->socket, object, stream,
@@ -961,7 +926,8 @@ guac_object* guac_common_ssh_alloc_sftp_filesystem_object(
 
 guac_common_ssh_sftp_filesystem* guac_common_ssh_create_sftp_filesystem(
         guac_common_ssh_session* session, const char* root_path,
-        const char* name, int disable_download, int disable_upload) {
+        const char* name, int disable_download, int disable_upload,
+        int download_window) {
 
     /* Request SFTP */
     LIBSSH2_SFTP* sftp_session = libssh2_sftp_init(session->session);
@@ -980,6 +946,9 @@ guac_common_ssh_sftp_filesystem* guac_common_ssh_create_sftp_filesystem(
     filesystem->disable_download = disable_download;
     filesystem->disable_upload = disable_upload;
 
+    /* Keep several blobs in flight for each download */
+    filesystem->download_window = download_window;
+
     /* Normalize and store the provided root path */
     if (!guac_common_ssh_sftp_normalize_path(filesystem->root_path,
                 root_path)) {
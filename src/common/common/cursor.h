@@ -33,6 +33,14 @@
  */
 #define GUAC_COMMON_CURSOR_DEFAULT_SIZE 64*64*4
 
+/**
+ * The maximum amount of time that a change in cursor position or button
+ * state may wait to be sent along with the next frame, in milliseconds. If no
+ * frame is flushed within this time, the change is sent to other users
+ * directly.
+ */
+#define GUAC_COMMON_CURSOR_MAX_DELAY 40
+
 /**
  * Cursor object which maintains and synchronizes the current mouse cursor
  * state across all users of a specific client.
@@ -123,6 +131,36 @@ typedef struct guac_common_cursor {
      */
     guac_timestamp timestamp;
 
+    /**
+     * Non-zero if the location or button state of the cursor has changed
+     * since it was last sent to other users, zero otherwise.
+     */
+    int update_pending;
+
+    /**
+     * The time at which update_pending was most recently set, such that the
+     * change can be sent directly if no frame follows in time.
+     */
+    guac_timestamp pending_since;
+
+    /**
+     * The minimum amount of time between changes in cursor state sent to
+     * each other user, in milliseconds, or zero if changes may be sent with
+     * every frame.
+     */
+    int update_interval;
+
+    /**
+     * The time at which the state of the cursor was last sent to other users.
+     */
+    guac_timestamp last_update_sent;
+
+    /**
+     * Non-zero if the thread sending pending changes should stop, zero
+     * otherwise.
+     */
+    int stopping;
+
     /**
      * Lock which restricts simultaneous access to the cursor, guaranteeing
      * ordered modifications to the cursor and that incompatible operations
@@ -131,6 +169,18 @@ typedef struct guac_common_cursor {
      */
     pthread_mutex_t _lock;
 
+    /**
+     * Condition which is signalled when a change becomes pending or the
+     * cursor is being freed.
+     */
+    pthread_cond_t _modified;
+
+    /**
+     * Thread which sends pending changes to other users if no frame is
+     * flushed within GUAC_COMMON_CURSOR_MAX_DELAY.
+     */
+    pthread_t _thread;
+
 } guac_common_cursor;
 
 /**
@@ -173,7 +223,12 @@ void guac_common_cursor_dup(
 /**
  * Updates the current position and button state of the mouse cursor, marking
  * the given user as the most recent user of the mouse. The remote mouse cursor
- * will be hidden for this user and shown for all others.
+ * will be hidden for this user and shown for all others. The new position is
+ * not sent to other users until guac_common_cursor_flush() is invoked, such
+ * that any number of updates between frames result in only the latest
+ * position being sent. If no frame is flushed within
+ * GUAC_COMMON_CURSOR_MAX_DELAY milliseconds, the latest position is sent
+ * directly.
  *
  * @param cursor
  *     The cursor being updated.
@@ -203,6 +258,34 @@ void guac_common_cursor_dup(
 void guac_common_cursor_update(guac_common_cursor* cursor, guac_user* user,
         int x, int y, int button_mask);
 
+/**
+ * Sends the current position and button state of the mouse cursor to all
+ * users except the user that moved the cursor last, if it has changed since
+ * it was last sent and the update interval of the cursor allows. This should
+ * be invoked once per frame, prior to the end of that frame. The sockets of
+ * those users are not flushed.
+ *
+ * @param cursor
+ *     The cursor whose pending position should be sent.
+ */
+void guac_common_cursor_flush(guac_common_cursor* cursor);
+
+/**
+ * Sets the minimum amount of time between changes in cursor position or
+ * button state sent to each user other than the user moving the cursor. By
+ * default, there is no minimum, and the latest state is sent with each frame.
+ *
+ * @param cursor
+ *     The cursor to modify.
+ *
+ * @param interval
+ *     The minimum amount of time between cursor updates sent to each other
+ *     user, in milliseconds, or zero to send the latest state with each
+ *     frame.
+ */
+void guac_common_cursor_set_update_interval(guac_common_cursor* cursor,
+        int interval);
+
 /**
  * Sets the cursor image to the given raw image data. This raw image data must
  * be in 32-bit ARGB format, having 8 bits per color component, where the
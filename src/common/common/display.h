@@ -21,9 +21,12 @@
 #define GUAC_COMMON_DISPLAY_H
 
 #include "cursor.h"
+#include "quality.h"
 #include "surface.h"
+#include "tile-cache.h"
 
 #include <guacamole/client.h>
+#include <guacamole/recording.h>
 #include <guacamole/socket.h>
 
 #include <pthread.h>
@@ -99,6 +102,19 @@ typedef struct guac_common_display {
      */
     guac_common_display_layer* buffers;
 
+    /**
+     * The cache of recently-sent images shared by all surfaces of this
+     * display.
+     */
+    guac_common_tile_cache* tile_cache;
+
+    /**
+     * The controller deciding the quality and format of lossy images sent
+     * for all surfaces of this display, as well as the rate at which frames
+     * should be sent.
+     */
+    guac_common_quality* quality;
+
     /**
      * Non-zero if all graphical updates for this display should use lossless
      * compression, 0 otherwise. By default, newly-created displays will use
@@ -163,7 +179,10 @@ void guac_common_display_dup(
 
 /**
  * Flushes pending changes to the given display. All pending operations will
- * become visible to any connected users.
+ * become visible to any connected users. The time taken to encode and send
+ * those changes is provided to the quality controller of the display, which
+ * is updated once per flush. Any change in the position of the shared cursor
+ * is also sent to all users other than the user that moved it.
  *
  * @param display
  *     The display to flush.
@@ -258,5 +277,36 @@ void guac_common_display_free_buffer(guac_common_display* display,
 void guac_common_display_set_lossless(guac_common_display* display,
         int lossless);
 
+/**
+ * Writes the full state of the given display to the given recording as a
+ * keyframe, as would be sent to a newly-joined user, if the recording is
+ * indexed and a keyframe is due. This should be invoked only after the display
+ * has been flushed and the frame ended.
+ *
+ * @param display
+ *     The display whose state should be written to the recording.
+ *
+ * @param recording
+ *     The recording to write the keyframe to.
+ */
+void guac_common_display_record_keyframe(guac_common_display* display,
+        guac_recording* recording);
+
+/**
+ * Returns the minimum amount of time that should elapse between frames sent
+ * for the given display, as decided by its quality controller based on how
+ * quickly connected users are processing frames and how long frames are
+ * taking to encode. Updates received from the remote desktop within this
+ * time should be combined into a single frame.
+ *
+ * @param display
+ *     The display to query.
+ *
+ * @return
+ *     The minimum amount of time that should elapse between frames, in
+ *     milliseconds.
+ */
+int guac_common_display_get_frame_delay(guac_common_display* display);
+
 #endif
 
@@ -0,0 +1,177 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_COMMON_DOWNLOAD_H
+#define GUAC_COMMON_DOWNLOAD_H
+
+#include "config.h"
+
+#include <guacamole/protocol-constants.h>
+#include <guacamole/stream.h>
+#include <guacamole/timestamp.h>
+#include <guacamole/user.h>
+
+#include <stdint.h>
+
+/**
+ * The default number of blobs which may be sent along a download stream
+ * without having yet been acknowledged by the user.
+ */
+#define GUAC_COMMON_DOWNLOAD_DEFAULT_WINDOW 16
+
+/**
+ * The number of bytes which are read from the file being downloaded at once.
+ * Reading well ahead of the blobs actually being sent allows the latency of
+ * the underlying storage to overlap with that of the network. This value
+ * should be a multiple of GUAC_PROTOCOL_BLOB_MAX_LENGTH.
+ */
+#define GUAC_COMMON_DOWNLOAD_BUFFER_SIZE (GUAC_PROTOCOL_BLOB_MAX_LENGTH * 16)
+
+/**
+ * Handler which reads the next portion of the file being downloaded.
+ *
+ * @param data
+ *     The arbitrary data provided to guac_common_download_begin().
+ *
+ * @param buffer
+ *     The buffer to read data into.
+ *
+ * @param length
+ *     The maximum number of bytes to read.
+ *
+ * @return
+ *     The number of bytes read, zero if the end of the file has been reached,
+ *     or a negative value if an error occurs.
+ */
+typedef int guac_common_download_read_handler(void* data, char* buffer,
+        int length);
+
+/**
+ * Handler which is invoked exactly once when a download has completed, either
+ * successfully or due to an error, such that the file being downloaded can
+ * be closed and any associated data freed.
+ *
+ * @param data
+ *     The arbitrary data provided to guac_common_download_begin().
+ */
+typedef void guac_common_download_close_handler(void* data);
+
+/**
+ * The state of a file being downloaded by a user. Rather than sending a
+ * single blob and waiting for that blob to be acknowledged, up to a fixed
+ * window of blobs are kept in flight at any one time, with each
+ * acknowledgement allowing another blob to be sent.
+ */
+typedef struct guac_common_download {
+
+    /**
+     * The handler which reads data from the file being downloaded.
+     */
+    guac_common_download_read_handler* read_handler;
+
+    /**
+     * The handler which closes the file being downloaded.
+     */
+    guac_common_download_close_handler* close_handler;
+
+    /**
+     * Arbitrary data which is passed to the read and close handlers.
+     */
+    void* data;
+
+    /**
+     * The maximum number of instructions which may be sent along the stream
+     * without having been acknowledged.
+     */
+    int window;
+
+    /**
+     * The number of instructions sent along the stream which have not yet
+     * been acknowledged.
+     */
+    int in_flight;
+
+    /**
+     * Non-zero if no further data will be read, either because the end of
+     * the file has been reached or because an error occurred.
+     */
+    int complete;
+
+    /**
+     * Non-zero if the download failed due to an error reading the file.
+     */
+    int failed;
+
+    /**
+     * Data which has been read from the file but not yet sent.
+     */
+    char buffer[GUAC_COMMON_DOWNLOAD_BUFFER_SIZE];
+
+    /**
+     * The number of bytes of data currently within the buffer.
+     */
+    int length;
+
+    /**
+     * The offset within the buffer of the first byte not yet sent.
+     */
+    int offset;
+
+    /**
+     * The total number of bytes sent thus far.
+     */
+    uint64_t bytes_sent;
+
+    /**
+     * The time at which the download began.
+     */
+    guac_timestamp started;
+
+} guac_common_download;
+
+/**
+ * Associates a new download with the given stream, replacing the stream's
+ * data and ack handler. The caller must then begin the stream with a "file"
+ * or "body" instruction. Each subsequent acknowledgement received along the
+ * stream results in the window of unacknowledged blobs being refilled, with
+ * the stream being ended and freed once all data has been sent and
+ * acknowledged.
+ *
+ * @param stream
+ *     The stream along which the file will be downloaded.
+ *
+ * @param read_handler
+ *     The handler which should be invoked to read data from the file.
+ *
+ * @param close_handler
+ *     The handler which should be invoked when the download is complete.
+ *
+ * @param data
+ *     Arbitrary data to pass to the read and close handlers.
+ *
+ * @param window
+ *     The maximum number of blobs which may be in flight at any one time. If
+ *     less than one, GUAC_COMMON_DOWNLOAD_DEFAULT_WINDOW is used.
+ */
+void guac_common_download_begin(guac_stream* stream,
+        guac_common_download_read_handler* read_handler,
+        guac_common_download_close_handler* close_handler,
+        void* data, int window);
+
+#endif
@@ -0,0 +1,236 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_COMMON_ENCODER_H
+#define GUAC_COMMON_ENCODER_H
+
+#include <cairo/cairo.h>
+#include <guacamole/client.h>
+#include <guacamole/layer.h>
+#include <guacamole/protocol-types.h>
+#include <guacamole/socket.h>
+
+#include <stddef.h>
+
+/**
+ * The maximum number of worker threads which will be used to encode images
+ * in parallel, regardless of the number of available processors.
+ */
+#define GUAC_COMMON_ENCODER_MAX_THREADS 8
+
+/**
+ * The minimum number of pixels within an image for that image to be encoded
+ * by a worker thread. Smaller images are encoded immediately, as handing
+ * them to another thread would cost more than it saves.
+ */
+#define GUAC_COMMON_ENCODER_MIN_PIXELS 4096
+
+/**
+ * The maximum number of images which may be buffered by a single encoder
+ * before the encoder is automatically flushed. Each buffered image holds an
+ * allocated stream until it is sent, and the number of streams available to
+ * each client is limited.
+ */
+#define GUAC_COMMON_ENCODER_MAX_IMAGES 16
+
+/**
+ * The image formats which may be produced by a guac_common_encoder.
+ */
+typedef enum guac_common_encoder_format {
+
+    /**
+     * Lossless PNG.
+     */
+    GUAC_COMMON_ENCODER_PNG,
+
+    /**
+     * Lossy JPEG.
+     */
+    GUAC_COMMON_ENCODER_JPEG,
+
+    /**
+     * Lossy or lossless WebP.
+     */
+    GUAC_COMMON_ENCODER_WEBP
+
+} guac_common_encoder_format;
+
+/**
+ * A contiguous portion of the output of a guac_common_encoder, consisting
+ * either of instructions written directly to the encoder's socket or of the
+ * instructions streaming a single image which is encoded by a worker thread.
+ */
+typedef struct guac_common_encoder_segment guac_common_encoder_segment;
+
+/**
+ * Reorders the encoding of images such that several images can be encoded in
+ * parallel by a shared pool of worker threads, while the resulting
+ * instructions are still sent in exactly the order they were produced.
+ * Instructions written to the encoder's socket and images passed to
+ * guac_common_encoder_stream() are buffered, and are only sent to the
+ * underlying socket by guac_common_encoder_flush().
+ */
+typedef struct guac_common_encoder {
+
+    /**
+     * The client that image streams should be allocated from.
+     */
+    guac_client* client;
+
+    /**
+     * The socket that all buffered instructions will ultimately be sent to.
+     */
+    guac_socket* socket;
+
+    /**
+     * A socket which buffers all instructions written to it, such that they
+     * are sent to the underlying socket in order with any images being
+     * encoded. Instructions which must be ordered relative to image streams
+     * MUST be written to this socket rather than the underlying socket.
+     */
+    guac_socket* buffered_socket;
+
+    /**
+     * The first segment of buffered output, or NULL if nothing is buffered.
+     */
+    guac_common_encoder_segment* head;
+
+    /**
+     * The last segment of buffered output, or NULL if nothing is buffered.
+     */
+    guac_common_encoder_segment* tail;
+
+    /**
+     * The number of images currently buffered.
+     */
+    int images;
+
+} guac_common_encoder;
+
+/**
+ * Acquires a reference to the pool of worker threads shared by all encoders
+ * within the current process, starting those threads if this is the first
+ * reference. If the host has only a single processor, no worker threads are
+ * started. Each call must be matched by a call to
+ * guac_common_encoder_pool_release() before the code of the calling plugin
+ * is unloaded.
+ */
+void guac_common_encoder_pool_acquire();
+
+/**
+ * Releases a reference acquired with guac_common_encoder_pool_acquire(). If
+ * this is the last reference, all worker threads are stopped, and this
+ * function blocks until they have exited. No encoder may be in use by the
+ * caller when the last reference is released.
+ */
+void guac_common_encoder_pool_release();
+
+/**
+ * Returns the number of worker threads available for encoding images in
+ * parallel. This will be zero if no reference to the pool is currently held
+ * (see guac_common_encoder_pool_acquire()), or if the host has only a single
+ * processor, in which case there is no benefit in using a
+ * guac_common_encoder.
+ *
+ * @return
+ *     The number of worker threads available, or zero if images cannot be
+ *     encoded in parallel.
+ */
+int guac_common_encoder_threads();
+
+/**
+ * Allocates a new encoder which buffers all output destined for the given
+ * socket until guac_common_encoder_flush() is invoked.
+ *
+ * @param client
+ *     The client that image streams should be allocated from.
+ *
+ * @param socket
+ *     The socket that all buffered instructions should be sent to.
+ *
+ * @return
+ *     A newly-allocated encoder.
+ */
+guac_common_encoder* guac_common_encoder_alloc(guac_client* client,
+        guac_socket* socket);
+
+/**
+ * Flushes and frees the given encoder.
+ *
+ * @param encoder
+ *     The encoder to free.
+ */
+void guac_common_encoder_free(guac_common_encoder* encoder);
+
+/**
+ * Streams the given image to the given layer using the given format, as
+ * would guac_client_stream_png(), guac_client_stream_jpeg(), or
+ * guac_client_stream_webp(). Sufficiently large images are encoded by a
+ * worker thread. The image data MUST remain unchanged until the encoder is
+ * next flushed, though the cairo surface itself may be destroyed as soon as
+ * this function returns. If GUAC_COMMON_ENCODER_MAX_IMAGES images are
+ * already buffered, the encoder is flushed first.
+ *
+ * @param encoder
+ *     The encoder which should buffer the resulting instructions.
+ *
+ * @param format
+ *     The format to encode the image as.
+ *
+ * @param mode
+ *     The composite mode to use when rendering the image.
+ *
+ * @param layer
+ *     The destination layer.
+ *
+ * @param x
+ *     The X coordinate of the upper-left corner of the destination rectangle.
+ *
+ * @param y
+ *     The Y coordinate of the upper-left corner of the destination rectangle.
+ *
+ * @param image
+ *     The image to encode. This MUST be an image surface.
+ *
+ * @param quality
+ *     The JPEG or WebP image quality, which must be an integer value between
+ *     0 and 100 inclusive. This is ignored for PNG.
+ *
+ * @param lossless
+ *     Zero if WebP lossy compression should be used, non-zero if lossless
+ *     compression should be used. This is ignored for formats other than
+ *     WebP.
+ */
+void guac_common_encoder_stream(guac_common_encoder* encoder,
+        guac_common_encoder_format format, guac_composite_mode mode,
+        const guac_layer* layer, int x, int y, cairo_surface_t* image,
+        int quality, int lossless);
+
+/**
+ * Waits for all images passed to the given encoder to be encoded, sending
+ * all buffered instructions to the underlying socket in the order they were
+ * produced. Each instruction is sent individually, exactly as if it had been
+ * written to the underlying socket directly.
+ *
+ * @param encoder
+ *     The encoder to flush.
+ */
+void guac_common_encoder_flush(guac_common_encoder* encoder);
+
+#endif
@@ -0,0 +1,343 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_COMMON_INPUT_H
+#define GUAC_COMMON_INPUT_H
+
+#include <guacamole/client.h>
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+
+/**
+ * The minimum amount of time between forwarded motion events, in
+ * milliseconds. Motion events received within this time of the previous
+ * forwarded motion event are combined, with only the most recent being
+ * forwarded once this time has elapsed.
+ */
+#define GUAC_COMMON_INPUT_MOTION_INTERVAL 10
+
+/**
+ * The maximum number of simultaneous touches whose motion can be combined.
+ * Events for touches beyond this number are forwarded as received.
+ */
+#define GUAC_COMMON_INPUT_MAX_TOUCHES 10
+
+/**
+ * The type of a guac_common_input_event.
+ */
+typedef enum guac_common_input_event_type {
+
+    /**
+     * A change in the position and/or button state of the mouse.
+     */
+    GUAC_COMMON_INPUT_EVENT_MOUSE,
+
+    /**
+     * A change in the position, size, or pressure of a touch.
+     */
+    GUAC_COMMON_INPUT_EVENT_TOUCH
+
+} guac_common_input_event_type;
+
+/**
+ * A single mouse or touch event, as received from a user.
+ */
+typedef struct guac_common_input_event {
+
+    /**
+     * The type of this event.
+     */
+    guac_common_input_event_type type;
+
+    /**
+     * The X coordinate of the mouse pointer or touch.
+     */
+    int x;
+
+    /**
+     * The Y coordinate of the mouse pointer or touch.
+     */
+    int y;
+
+    /**
+     * The mouse button mask. Only applicable to mouse events.
+     */
+    int mask;
+
+    /**
+     * An arbitrary integer ID which uniquely identifies the touch. Only
+     * applicable to touch events.
+     */
+    int id;
+
+    /**
+     * The X radius of the ellipse covering the general area of the touch, in
+     * pixels. Only applicable to touch events.
+     */
+    int x_radius;
+
+    /**
+     * The Y radius of the ellipse covering the general area of the touch, in
+     * pixels. Only applicable to touch events.
+     */
+    int y_radius;
+
+    /**
+     * The rough angle of clockwise rotation of the general area of the touch,
+     * in degrees. Only applicable to touch events.
+     */
+    double angle;
+
+    /**
+     * The relative force exerted by the touch, where 0 is no force (the touch
+     * has been lifted) and 1 is the maximum force. Only applicable to touch
+     * events.
+     */
+    double force;
+
+} guac_common_input_event;
+
+/**
+ * Handler which forwards a single mouse or touch event to the remote desktop.
+ * This handler is always invoked while the lock of the associated
+ * guac_common_input is held, and thus is never invoked concurrently.
+ *
+ * @param event
+ *     The event to forward.
+ *
+ * @param data
+ *     The arbitrary data provided when the guac_common_input was allocated.
+ */
+typedef void guac_common_input_handler(const guac_common_input_event* event,
+        void* data);
+
+/**
+ * The coalescing state of a single touch.
+ */
+typedef struct guac_common_input_touch_state {
+
+    /**
+     * Whether this touch is currently in contact with the screen.
+     */
+    int active;
+
+    /**
+     * Whether the motion event stored within this structure has yet to be
+     * forwarded.
+     */
+    int pending;
+
+    /**
+     * The most recent event received for this touch.
+     */
+    guac_common_input_event event;
+
+} guac_common_input_touch_state;
+
+/**
+ * Per-connection coalescer of mouse and touch events. Events which only move
+ * the mouse or an existing touch are combined if received faster than
+ * GUAC_COMMON_INPUT_MOTION_INTERVAL allows, with the most recent position
+ * forwarded once that interval has elapsed. All other events, including
+ * every change in button state and the start and end of every touch, are
+ * forwarded immediately, after any motion which preceded them.
+ */
+typedef struct guac_common_input {
+
+    /**
+     * The client associated with this coalescer.
+     */
+    guac_client* client;
+
+    /**
+     * The handler to invoke for each event that must be forwarded.
+     */
+    guac_common_input_handler* handler;
+
+    /**
+     * Arbitrary data to provide to the handler.
+     */
+    void* data;
+
+    /**
+     * Lock which is acquired whenever the state of this coalescer is read or
+     * modified, and while events are being forwarded.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Condition which is signalled whenever motion becomes pending or the
+     * coalescer is being freed.
+     */
+    pthread_cond_t modified;
+
+    /**
+     * Thread which forwards pending motion once the motion interval has
+     * elapsed.
+     */
+    pthread_t thread;
+
+    /**
+     * Whether guac_common_input_free() has been invoked.
+     */
+    int stopping;
+
+    /**
+     * The button mask of the most recent mouse event received.
+     */
+    int mouse_mask;
+
+    /**
+     * Whether the mouse motion event stored within mouse has yet to be
+     * forwarded.
+     */
+    int mouse_pending;
+
+    /**
+     * The most recent mouse event received.
+     */
+    guac_common_input_event mouse;
+
+    /**
+     * The coalescing state of each touch.
+     */
+    guac_common_input_touch_state touches[GUAC_COMMON_INPUT_MAX_TOUCHES];
+
+    /**
+     * The time that motion was last forwarded.
+     */
+    guac_timestamp last_motion;
+
+    /**
+     * The total number of mouse and touch events received.
+     */
+    unsigned long received;
+
+    /**
+     * The total number of mouse and touch events forwarded.
+     */
+    unsigned long forwarded;
+
+} guac_common_input;
+
+/**
+ * Allocates a new input coalescer which forwards events using the given
+ * handler.
+ *
+ * @param client
+ *     The client associated with the new coalescer.
+ *
+ * @param handler
+ *     The handler to invoke for each event that must be forwarded.
+ *
+ * @param data
+ *     Arbitrary data to provide to the handler.
+ *
+ * @return
+ *     A newly-allocated input coalescer.
+ */
+guac_common_input* guac_common_input_alloc(guac_client* client,
+        guac_common_input_handler* handler, void* data);
+
+/**
+ * Frees the given input coalescer, logging its statistics as with
+ * guac_common_input_dump(). Any pending motion is discarded.
+ *
+ * @param input
+ *     The input coalescer to free.
+ */
+void guac_common_input_free(guac_common_input* input);
+
+/**
+ * Handles a mouse event received from a user, forwarding the event as
+ * needed. If the button state is unchanged, the event may be combined with
+ * other motion.
+ *
+ * @param input
+ *     The input coalescer to provide the event to.
+ *
+ * @param x
+ *     The X coordinate of the mouse pointer.
+ *
+ * @param y
+ *     The Y coordinate of the mouse pointer.
+ *
+ * @param mask
+ *     The mouse button mask.
+ */
+void guac_common_input_mouse(guac_common_input* input, int x, int y,
+        int mask);
+
+/**
+ * Handles a touch event received from a user, forwarding the event as
+ * needed. If the touch is already in contact and remains in contact, the
+ * event may be combined with other motion.
+ *
+ * @param input
+ *     The input coalescer to provide the event to.
+ *
+ * @param id
+ *     An arbitrary integer ID which uniquely identifies the touch.
+ *
+ * @param x
+ *     The X coordinate of the center of the touch.
+ *
+ * @param y
+ *     The Y coordinate of the center of the touch.
+ *
+ * @param x_radius
+ *     The X radius of the ellipse covering the general area of the touch,
+ *     in pixels.
+ *
+ * @param y_radius
+ *     The Y radius of the ellipse covering the general area of the touch,
+ *     in pixels.
+ *
+ * @param angle
+ *     The rough angle of clockwise rotation of the general area of the
+ *     touch, in degrees.
+ *
+ * @param force
+ *     The relative force exerted by the touch, where 0 is no force (the
+ *     touch has been lifted) and 1 is the maximum force.
+ */
+void guac_common_input_touch(guac_common_input* input, int id, int x,
+        int y, int x_radius, int y_radius, double angle, double force);
+
+/**
+ * Forwards any pending motion immediately. This must be invoked before
+ * sending any other input to the remote desktop, such as key events, to
+ * ensure that input is received in the order it was sent by the user.
+ *
+ * @param input
+ *     The input coalescer to flush.
+ */
+void guac_common_input_flush(guac_common_input* input);
+
+/**
+ * Logs the number of events received and forwarded by the given input
+ * coalescer at the DEBUG level.
+ *
+ * @param input
+ *     The input coalescer to dump.
+ */
+void guac_common_input_dump(guac_common_input* input);
+
+#endif
@@ -0,0 +1,267 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_COMMON_QUALITY_H
+#define GUAC_COMMON_QUALITY_H
+
+#include <guacamole/client.h>
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+
+/**
+ * The lowest quality that will be used for lossy image formats, on a scale
+ * from 0 to 100.
+ */
+#define GUAC_COMMON_QUALITY_MIN 30
+
+/**
+ * The highest quality that will be used for lossy image formats, on a scale
+ * from 0 to 100.
+ */
+#define GUAC_COMMON_QUALITY_MAX 90
+
+/**
+ * The amount that the quality of lossy image formats is increased by each
+ * time the connection is determined to no longer be congested.
+ */
+#define GUAC_COMMON_QUALITY_INCREASE 5
+
+/**
+ * The smoothed processing lag, in milliseconds, above which the connection is
+ * considered congested.
+ */
+#define GUAC_COMMON_QUALITY_LAG_HIGH 60
+
+/**
+ * The smoothed processing lag, in milliseconds, below which (including its
+ * deviation) the connection is considered to no longer be congested. The gap
+ * between this and GUAC_COMMON_QUALITY_LAG_HIGH prevents the controller from
+ * oscillating when lag hovers around a single threshold.
+ */
+#define GUAC_COMMON_QUALITY_LAG_LOW 20
+
+/**
+ * The smoothed amount of time spent encoding and sending each frame, in
+ * milliseconds, above which encoding is considered to be the bottleneck.
+ */
+#define GUAC_COMMON_QUALITY_ENCODE_BUDGET 40
+
+/**
+ * The minimum amount of time between adjustments made by the controller, in
+ * milliseconds. Adjustments are additionally never made more than once per
+ * network round trip, such that the effect of each adjustment can be observed
+ * before the next is made.
+ */
+#define GUAC_COMMON_QUALITY_ADJUST_INTERVAL 100
+
+/**
+ * The framerate which, if exceeded by updates to a region, indicates that a
+ * lossy format is preferred for that region.
+ */
+#define GUAC_COMMON_QUALITY_LOSSY_FRAMERATE 3
+
+/**
+ * The framerate which, if exceeded by updates to a region, indicates that a
+ * lossy format is preferred for that region while the connection is
+ * congested.
+ */
+#define GUAC_COMMON_QUALITY_CONGESTED_LOSSY_FRAMERATE 1
+
+/**
+ * The encoding decisions made by a guac_common_quality controller, applied by
+ * surfaces as each of their updates are flushed.
+ */
+typedef struct guac_common_quality_decision {
+
+    /**
+     * The quality to use for lossy image formats, on a scale from 0 to 100.
+     */
+    int quality;
+
+    /**
+     * The framerate which, if exceeded by updates to a region, indicates that
+     * a lossy format is preferred for that region.
+     */
+    int lossy_framerate;
+
+    /**
+     * Non-zero if WebP may be used when supported by the client, zero if the
+     * cheaper JPEG encoder should be used instead.
+     */
+    int webp;
+
+    /**
+     * The minimum amount of time that should elapse between frames, in
+     * milliseconds. Updates received from the remote desktop within this
+     * time should be combined into a single frame rather than sent
+     * individually.
+     */
+    int frame_delay;
+
+} guac_common_quality_decision;
+
+/**
+ * Feedback controller which chooses the quality and format of lossy images,
+ * as well as the rate at which frames are sent, based on the lag, bandwidth,
+ * and round-trip time measured from the "sync" instructions of connected
+ * users and on the time spent encoding each frame. Quality is reduced
+ * multiplicatively while the connection is congested and restored additively
+ * once it recovers.
+ */
+typedef struct guac_common_quality {
+
+    /**
+     * The client whose connected users are being measured.
+     */
+    guac_client* client;
+
+    /**
+     * Lock which is acquired whenever the controller is updated or its
+     * decisions are read.
+     */
+    pthread_mutex_t _lock;
+
+    /**
+     * The current encoding decisions of this controller.
+     */
+    guac_common_quality_decision decision;
+
+    /**
+     * The most recent link estimate used by this controller.
+     */
+    guac_client_link_estimate link;
+
+    /**
+     * The time spent encoding and sending each frame, smoothed across frames,
+     * in milliseconds.
+     */
+    int encode_time;
+
+    /**
+     * Non-zero if the connection is currently considered congested, zero
+     * otherwise.
+     */
+    int congested;
+
+    /**
+     * The time of the last adjustment made by this controller.
+     */
+    guac_timestamp last_adjustment;
+
+    /**
+     * The total number of frames for which this controller was updated.
+     */
+    unsigned long frames;
+
+    /**
+     * The total number of times quality was decreased.
+     */
+    unsigned long decreases;
+
+    /**
+     * The total number of times quality was increased.
+     */
+    unsigned long increases;
+
+    /**
+     * The total number of frames which were sent while the connection was
+     * considered congested.
+     */
+    unsigned long congested_frames;
+
+    /**
+     * The lowest quality chosen by this controller.
+     */
+    int lowest_quality;
+
+} guac_common_quality;
+
+/**
+ * Allocates a new quality controller for the given client. Until updated, the
+ * controller chooses the highest quality and imposes no frame delay.
+ *
+ * @param client
+ *     The client whose connected users should be measured.
+ *
+ * @return
+ *     A newly-allocated quality controller.
+ */
+guac_common_quality* guac_common_quality_alloc(guac_client* client);
+
+/**
+ * Frees the given quality controller, logging its statistics as with
+ * guac_common_quality_dump().
+ *
+ * @param quality
+ *     The quality controller to free.
+ */
+void guac_common_quality_free(guac_common_quality* quality);
+
+/**
+ * Updates the given quality controller with the latest measurements of the
+ * connected users and the time spent on the frame just sent. This should be
+ * invoked once per frame. Any changed decisions are logged at the TRACE
+ * level.
+ *
+ * @param quality
+ *     The quality controller to update.
+ *
+ * @param encode_time
+ *     The time spent encoding and sending the frame just sent, in
+ *     milliseconds.
+ */
+void guac_common_quality_update(guac_common_quality* quality,
+        int encode_time);
+
+/**
+ * Retrieves the current encoding decisions of the given quality controller.
+ *
+ * @param quality
+ *     The quality controller to query.
+ *
+ * @param decision
+ *     The guac_common_quality_decision to populate.
+ */
+void guac_common_quality_get_decision(guac_common_quality* quality,
+        guac_common_quality_decision* decision);
+
+/**
+ * Returns the minimum amount of time that should elapse between frames, as
+ * currently decided by the given quality controller.
+ *
+ * @param quality
+ *     The quality controller to query.
+ *
+ * @return
+ *     The minimum amount of time that should elapse between frames, in
+ *     milliseconds.
+ */
+int guac_common_quality_get_frame_delay(guac_common_quality* quality);
+
+/**
+ * Logs the current decisions, measurements, and statistics of the given
+ * quality controller at the DEBUG level.
+ *
+ * @param quality
+ *     The quality controller to dump.
+ */
+void guac_common_quality_dump(guac_common_quality* quality);
+
+#endif
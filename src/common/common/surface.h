@@ -21,7 +21,10 @@
 #define __GUAC_COMMON_SURFACE_H
 
 #include "config.h"
+#include "encoder.h"
+#include "quality.h"
 #include "rect.h"
+#include "tile-cache.h"
 
 #include <cairo/cairo.h>
 #include <guacamole/client.h>
@@ -133,6 +136,28 @@ typedef struct guac_common_surface {
      */
     int lossless;
 
+    /**
+     * The cache of recently-sent images which should be used to avoid
+     * re-encoding repeated image content, or NULL if no such cache should be
+     * used.
+     */
+    guac_common_tile_cache* tile_cache;
+
+    /**
+     * The controller deciding the quality and format of lossy images sent
+     * for this surface, or NULL if quality should be decided based on the
+     * processing lag of the most recent frame alone.
+     */
+    guac_common_quality* quality;
+
+    /**
+     * The decisions of the quality controller in effect for the flush
+     * currently in progress. This is captured once at the beginning of each
+     * flush such that all images within the same flush are treated
+     * consistently.
+     */
+    guac_common_quality_decision quality_decision;
+
     /**
      * The X coordinate of the upper-left corner of this layer, in pixels,
      * relative to its parent layer. This is only applicable to visible
@@ -241,6 +266,13 @@ typedef struct guac_common_surface {
      */
     guac_common_surface_heat_cell* heat_map;
 
+    /**
+     * The encoder buffering all instructions sent while this surface is being
+     * flushed, such that images can be encoded in parallel, or NULL if the
+     * surface is not currently being flushed in parallel.
+     */
+    guac_common_encoder* encoder;
+
     /**
      * Mutex which is locked internally when access to the surface must be
      * synchronized. All public functions of guac_common_surface should be
@@ -315,7 +347,8 @@ void guac_common_surface_draw(guac_common_surface* surface, int x, int y,
 /**
  * Paints to the given guac_common_surface using the given data as a stencil,
  * filling opaque regions with the specified color, and leaving transparent
- * regions untouched.
+ * regions untouched. The stencil may be either CAIRO_FORMAT_ARGB32 or
+ * CAIRO_FORMAT_A8.
  *
  * @param surface The surface to draw to.
  * @param x The X coordinate of the draw location.
@@ -535,5 +568,36 @@ void guac_common_surface_set_multitouch(guac_common_surface* surface,
 void guac_common_surface_set_lossless(guac_common_surface* surface,
         int lossless);
 
+/**
+ * Sets the cache of recently-sent images which should be used by the given
+ * surface. Repeated image content within graphical updates is then sent as a
+ * copy from an off-screen buffer rather than being encoded again. By default,
+ * newly-created surfaces do not use any such cache.
+ *
+ * @param surface
+ *     The surface to modify.
+ *
+ * @param tile_cache
+ *     The cache of recently-sent images which should be used, or NULL if no
+ *     such cache should be used.
+ */
+void guac_common_surface_set_tile_cache(guac_common_surface* surface,
+        guac_common_tile_cache* tile_cache);
+
+/**
+ * Sets the controller which should decide the quality and format of lossy
+ * images sent for the given surface. By default, newly-created surfaces base
+ * this decision on the processing lag of the most recent frame alone.
+ *
+ * @param surface
+ *     The surface to modify.
+ *
+ * @param quality
+ *     The quality controller which should be used, or NULL if no such
+ *     controller should be used.
+ */
+void guac_common_surface_set_quality(guac_common_surface* surface,
+        guac_common_quality* quality);
+
 #endif
 
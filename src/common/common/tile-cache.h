@@ -0,0 +1,295 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_COMMON_TILE_CACHE_H
+#define GUAC_COMMON_TILE_CACHE_H
+
+#include <cairo/cairo.h>
+#include <guacamole/client.h>
+#include <guacamole/layer.h>
+#include <guacamole/socket.h>
+
+#include <pthread.h>
+#include <stddef.h>
+
+/**
+ * The default maximum number of bytes of image data which may be retained
+ * within a tile cache. The same amount of image data is retained by each
+ * connected client within off-screen buffers.
+ */
+#define GUAC_COMMON_TILE_CACHE_DEFAULT_SIZE 16777216
+
+/**
+ * The minimum number of pixels within an image for that image to be
+ * considered for caching. Smaller images are cheap enough to encode that
+ * tracking them would cost more than it saves.
+ */
+#define GUAC_COMMON_TILE_CACHE_MIN_PIXELS 256
+
+/**
+ * The maximum number of pixels within an image for that image to be
+ * considered for caching.
+ */
+#define GUAC_COMMON_TILE_CACHE_MAX_PIXELS 131072
+
+/**
+ * The number of hash buckets within a tile cache. This MUST be a power of
+ * two.
+ */
+#define GUAC_COMMON_TILE_CACHE_BUCKETS 1024
+
+/**
+ * The number of recently-seen image hashes which are remembered for the sake
+ * of deciding whether an image is worth caching. This MUST be a power of two.
+ */
+#define GUAC_COMMON_TILE_CACHE_CANDIDATES 4096
+
+/**
+ * A single image which has been sent to all connected clients and which is
+ * retained within an off-screen buffer such that it can be reused.
+ */
+typedef struct guac_common_tile guac_common_tile;
+
+struct guac_common_tile {
+
+    /**
+     * The hash of the image data of this tile, as produced by
+     * guac_hash_surface().
+     */
+    unsigned int hash;
+
+    /**
+     * The width of this tile, in pixels.
+     */
+    int width;
+
+    /**
+     * The height of this tile, in pixels.
+     */
+    int height;
+
+    /**
+     * A copy of the 32-bit ARGB image data of this tile, having a stride of
+     * exactly four bytes per pixel. This copy is used to verify that an image
+     * having the same hash is actually identical.
+     */
+    unsigned char* data;
+
+    /**
+     * The off-screen buffer which contains this tile within each connected
+     * client, at its upper-left corner.
+     */
+    guac_layer* buffer;
+
+    /**
+     * The next tile within the same hash bucket, or NULL if this is the last
+     * tile in the bucket.
+     */
+    guac_common_tile* bucket_next;
+
+    /**
+     * The tile which was used immediately more recently than this tile, or
+     * NULL if this is the most recently used tile.
+     */
+    guac_common_tile* prev;
+
+    /**
+     * The tile which was used immediately less recently than this tile, or
+     * NULL if this is the least recently used tile.
+     */
+    guac_common_tile* next;
+
+};
+
+/**
+ * A cache of recently-sent images, keyed by the content of those images and
+ * shared by all surfaces of a client. Images which are seen repeatedly are
+ * retained within off-screen buffers, and later draws of the same image are
+ * sent as "copy" instructions from those buffers rather than being encoded
+ * again. When the cache exceeds its size limit, the least recently used
+ * images are evicted.
+ */
+typedef struct guac_common_tile_cache {
+
+    /**
+     * The client which owns the off-screen buffers used by this cache.
+     */
+    guac_client* client;
+
+    /**
+     * Hash table of all cached tiles, indexed by the low-order bits of each
+     * tile's hash.
+     */
+    guac_common_tile* buckets[GUAC_COMMON_TILE_CACHE_BUCKETS];
+
+    /**
+     * The hashes of recently-seen images which have not yet been cached,
+     * indexed by the low-order bits of each hash. An image is cached only
+     * once it has been seen at least twice, such that one-off images do not
+     * consume off-screen buffers.
+     */
+    unsigned int candidates[GUAC_COMMON_TILE_CACHE_CANDIDATES];
+
+    /**
+     * The most recently used tile, or NULL if the cache is empty.
+     */
+    guac_common_tile* most_recent;
+
+    /**
+     * The least recently used tile, or NULL if the cache is empty.
+     */
+    guac_common_tile* least_recent;
+
+    /**
+     * The total number of bytes of image data within all cached tiles.
+     */
+    size_t size;
+
+    /**
+     * The maximum number of bytes of image data which may be cached.
+     */
+    size_t max_size;
+
+    /**
+     * The number of images which were found within the cache and sent as a
+     * copy from an off-screen buffer.
+     */
+    unsigned long hits;
+
+    /**
+     * The number of cacheable images which were not found within the cache.
+     */
+    unsigned long misses;
+
+    /**
+     * Mutex which is locked internally when access to the cache must be
+     * synchronized. All public functions of guac_common_tile_cache should be
+     * considered threadsafe.
+     */
+    pthread_mutex_t _lock;
+
+} guac_common_tile_cache;
+
+/**
+ * Allocates a new, empty tile cache which will retain at most the given
+ * number of bytes of image data.
+ *
+ * @param client
+ *     The client which will own the off-screen buffers used by the cache.
+ *
+ * @param max_size
+ *     The maximum number of bytes of image data which may be cached.
+ *
+ * @return
+ *     A newly-allocated tile cache.
+ */
+guac_common_tile_cache* guac_common_tile_cache_alloc(guac_client* client,
+        size_t max_size);
+
+/**
+ * Frees the given tile cache, returning all off-screen buffers to the pool
+ * of the owning client. No instructions are sent.
+ *
+ * @param cache
+ *     The tile cache to free.
+ */
+void guac_common_tile_cache_free(guac_common_tile_cache* cache);
+
+/**
+ * Attempts to draw the given image to the given layer by copying it from a
+ * previously-cached off-screen buffer. If the image is not cached, nothing is
+ * sent and the image must be sent by other means. The image MUST be 32-bit
+ * ARGB or RGB, and the copy replaces the contents of the destination
+ * rectangle entirely, including its alpha channel.
+ *
+ * @param cache
+ *     The tile cache to search.
+ *
+ * @param socket
+ *     The socket over which the copy should be sent.
+ *
+ * @param layer
+ *     The layer that the image should be drawn to.
+ *
+ * @param x
+ *     The X coordinate of the upper-left corner of the destination rectangle.
+ *
+ * @param y
+ *     The Y coordinate of the upper-left corner of the destination rectangle.
+ *
+ * @param image
+ *     The image to draw.
+ *
+ * @return
+ *     Non-zero if the image was found within the cache and a copy has been
+ *     sent, zero otherwise.
+ */
+int guac_common_tile_cache_copy(guac_common_tile_cache* cache,
+        guac_socket* socket, const guac_layer* layer, int x, int y,
+        cairo_surface_t* image);
+
+/**
+ * Notifies the given tile cache that the given image has just been sent
+ * losslessly to the given layer. If the same image has been seen recently,
+ * it is added to the cache, copying it from the layer to a new off-screen
+ * buffer. Least recently used tiles are evicted as needed to keep the cache
+ * within its size limit.
+ *
+ * @param cache
+ *     The tile cache to update.
+ *
+ * @param socket
+ *     The socket over which the image was sent, and over which any
+ *     instructions required to cache the image should be sent.
+ *
+ * @param layer
+ *     The layer that the image was drawn to.
+ *
+ * @param x
+ *     The X coordinate of the upper-left corner of the rectangle the image
+ *     was drawn to.
+ *
+ * @param y
+ *     The Y coordinate of the upper-left corner of the rectangle the image
+ *     was drawn to.
+ *
+ * @param image
+ *     The image that was drawn. This MUST be 32-bit ARGB or RGB.
+ */
+void guac_common_tile_cache_store(guac_common_tile_cache* cache,
+        guac_socket* socket, const guac_layer* layer, int x, int y,
+        cairo_surface_t* image);
+
+/**
+ * Sends the contents of all cached tiles to the given socket, such that a
+ * newly-joined user receives the same off-screen buffers as all other users.
+ *
+ * @param cache
+ *     The tile cache to synchronize.
+ *
+ * @param client
+ *     The client associated with the user receiving the tiles.
+ *
+ * @param socket
+ *     The socket over which the tiles should be sent.
+ */
+void guac_common_tile_cache_dup(guac_common_tile_cache* cache,
+        guac_client* client, guac_socket* socket);
+
+#endif
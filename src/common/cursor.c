@@ -34,8 +34,151 @@
 
 #include <pthread.h>
 #include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+/**
+ * The number of nanoseconds in one millisecond.
+ */
+#define NANOS_PER_MILLISECOND 1000000L
+
+/**
+ * The number of nanoseconds in one second.
+ */
+#define NANOS_PER_SECOND 1000000000L
+
+/**
+ * Callback for guac_client_foreach_user() which sends the current cursor
+ * position and button state to any given user except the user that moved the
+ * cursor last.
+ *
+ * @param data
+ *     A pointer to the guac_common_cursor whose state should be broadcast to
+ *     all users except the user that moved the cursor last.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_common_cursor_broadcast_state(guac_user* user,
+        void* data) {
+
+    guac_common_cursor* cursor = (guac_common_cursor*) data;
+
+    /* Send cursor state only if the user is not moving the cursor (the
+     * socket will be flushed at the end of the current frame) */
+    if (user != cursor->user)
+        guac_protocol_send_mouse(user->socket, cursor->x, cursor->y,
+                cursor->button_mask, cursor->timestamp);
+
+    return NULL;
+
+}
+
+/**
+ * Callback for guac_client_foreach_user() which sends the current cursor
+ * position and button state to any given user except the user that moved the
+ * cursor last, flushing that user's socket. This is used to send changes
+ * that were not sent along with a frame.
+ *
+ * @param data
+ *     A pointer to the guac_common_cursor whose state should be sent to all
+ *     users except the user that moved the cursor last.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_common_cursor_send_state(guac_user* user, void* data) {
+
+    guac_common_cursor* cursor = (guac_common_cursor*) data;
+
+    guac_common_cursor_broadcast_state(user, data);
+    if (user != cursor->user)
+        guac_socket_flush(user->socket);
+
+    return NULL;
+
+}
+
+/**
+ * Waits up to the given number of milliseconds for the modified condition of
+ * the given cursor to be signalled. The lock of the cursor must already be
+ * held.
+ *
+ * @param cursor
+ *     The cursor whose modified condition should be waited upon.
+ *
+ * @param msecs
+ *     The maximum number of milliseconds to wait.
+ */
+static void guac_common_cursor_wait(guac_common_cursor* cursor, int msecs) {
+
+    struct timespec timeout;
+    clock_gettime(CLOCK_REALTIME, &timeout);
+
+    uint64_t nsecs = timeout.tv_nsec + msecs * NANOS_PER_MILLISECOND;
+    timeout.tv_sec += nsecs / NANOS_PER_SECOND;
+    timeout.tv_nsec = nsecs % NANOS_PER_SECOND;
+
+    pthread_cond_timedwait(&cursor->_modified, &cursor->_lock, &timeout);
+
+}
+
+/**
+ * Sends any change in cursor state that has not been sent along with a frame
+ * within GUAC_COMMON_CURSOR_MAX_DELAY directly to all users except the user
+ * that moved the cursor last, respecting the update interval of the cursor,
+ * until the cursor is freed.
+ *
+ * @param data
+ *     The guac_common_cursor whose pending changes should be sent.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_common_cursor_thread(void* data) {
+
+    guac_common_cursor* cursor = (guac_common_cursor*) data;
+
+    pthread_mutex_lock(&cursor->_lock);
+
+    while (!cursor->stopping) {
+
+        /* Wait for a change in cursor state */
+        if (!cursor->update_pending) {
+            pthread_cond_wait(&cursor->_modified, &cursor->_lock);
+            continue;
+        }
+
+        /* Give the next frame a chance to carry the change, and never send
+         * changes more often than the update interval allows */
+        guac_timestamp now = guac_timestamp_current();
+        guac_timestamp due = cursor->pending_since
+                           + GUAC_COMMON_CURSOR_MAX_DELAY;
+
+        guac_timestamp allowed = cursor->last_update_sent
+                               + cursor->update_interval;
+        if (allowed > due)
+            due = allowed;
+
+        if (due > now) {
+            guac_common_cursor_wait(cursor, due - now);
+            continue;
+        }
+
+        guac_client_foreach_user(cursor->client,
+                guac_common_cursor_send_state, cursor);
+
+        cursor->update_pending = 0;
+        cursor->last_update_sent = now;
+
+    }
+
+    pthread_mutex_unlock(&cursor->_lock);
+    return NULL;
+
+}
 
 
 /**
@@ -75,8 +218,18 @@ guac_common_cursor* guac_common_cursor_alloc(guac_client* client) {
     /* Start cursor in upper-left */
     cursor->x = 0;
     cursor->y = 0;
+    cursor->button_mask = 0;
+    cursor->update_pending = 0;
+
+    /* Send changes with each frame until told otherwise */
+    cursor->update_interval = 0;
+    cursor->last_update_sent = 0;
+    cursor->stopping = 0;
 
     pthread_mutex_init(&(cursor->_lock), NULL);
+    pthread_cond_init(&(cursor->_modified), NULL);
+    pthread_create(&(cursor->_thread), NULL, guac_common_cursor_thread,
+            cursor);
 
     return cursor;
 
@@ -84,6 +237,15 @@ guac_common_cursor* guac_common_cursor_alloc(guac_client* client) {
 
 void guac_common_cursor_free(guac_common_cursor* cursor) {
 
+    /* Signal termination of the thread sending pending changes */
+    pthread_mutex_lock(&(cursor->_lock));
+    cursor->stopping = 1;
+    pthread_cond_broadcast(&(cursor->_modified));
+    pthread_mutex_unlock(&(cursor->_lock));
+
+    pthread_join(cursor->_thread, NULL);
+
+    pthread_cond_destroy(&(cursor->_modified));
     pthread_mutex_destroy(&(cursor->_lock));
 
     guac_client* client = cursor->client;
@@ -133,34 +295,6 @@ void guac_common_cursor_dup(
 
 }
 
-/**
- * Callback for guac_client_foreach_user() which sends the current cursor
- * position and button state to any given user except the user that moved the
- * cursor last.
- *
- * @param data
- *     A pointer to the guac_common_cursor whose state should be broadcast to
- *     all users except the user that moved the cursor last.
- *
- * @return
- *     Always NULL.
- */
-static void* guac_common_cursor_broadcast_state(guac_user* user,
-        void* data) {
-
-    guac_common_cursor* cursor = (guac_common_cursor*) data;
-
-    /* Send cursor state only if the user is not moving the cursor */
-    if (user != cursor->user) {
-        guac_protocol_send_mouse(user->socket, cursor->x, cursor->y,
-                cursor->button_mask, cursor->timestamp);
-        guac_socket_flush(user->socket);
-    }
-
-    return NULL;
-
-}
-
 void guac_common_cursor_update(guac_common_cursor* cursor, guac_user* user,
         int x, int y, int button_mask) {
 
@@ -177,10 +311,43 @@ void guac_common_cursor_update(guac_common_cursor* cursor, guac_user* user,
     /* Store time at which cursor was updated */
     cursor->timestamp = guac_timestamp_current();
 
-    /* Notify all other users of change in cursor state */
-    guac_client_foreach_user(cursor->client,
-            guac_common_cursor_broadcast_state, cursor);
+    /* Notify all other users of change in cursor state with next frame, or
+     * directly if no frame follows in time */
+    if (!cursor->update_pending) {
+        cursor->update_pending = 1;
+        cursor->pending_since = cursor->timestamp;
+        pthread_cond_signal(&(cursor->_modified));
+    }
+
+    pthread_mutex_unlock(&(cursor->_lock));
+
+}
+
+void guac_common_cursor_flush(guac_common_cursor* cursor) {
+
+    pthread_mutex_lock(&(cursor->_lock));
 
+    /* Notify all other users of only the latest cursor state, unless the
+     * update interval has not yet elapsed */
+    guac_timestamp now = guac_timestamp_current();
+    if (cursor->update_pending && now - cursor->last_update_sent
+                >= cursor->update_interval) {
+        guac_client_foreach_user(cursor->client,
+                guac_common_cursor_broadcast_state, cursor);
+        cursor->update_pending = 0;
+        cursor->last_update_sent = now;
+    }
+
+    pthread_mutex_unlock(&(cursor->_lock));
+
+}
+
+void guac_common_cursor_set_update_interval(guac_common_cursor* cursor,
+        int interval) {
+
+    pthread_mutex_lock(&(cursor->_lock));
+    cursor->update_interval = interval;
+    pthread_cond_signal(&(cursor->_modified));
     pthread_mutex_unlock(&(cursor->_lock));
 
 }
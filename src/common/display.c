@@ -19,11 +19,16 @@
 
 #include "common/cursor.h"
 #include "common/display.h"
+#include "common/encoder.h"
+#include "common/quality.h"
 #include "common/surface.h"
+#include "common/tile-cache.h"
 
 #include <guacamole/client.h>
 #include <guacamole/mem.h>
+#include <guacamole/recording.h>
 #include <guacamole/socket.h>
+#include <guacamole/timestamp.h>
 
 #include <pthread.h>
 #include <stdlib.h>
@@ -136,9 +141,24 @@ guac_common_display* guac_common_display_alloc(guac_client* client,
     /* Associate display with given client */
     display->client = client;
 
+    /* Allocate cache of recently-sent images */
+    display->tile_cache = guac_common_tile_cache_alloc(client,
+            GUAC_COMMON_TILE_CACHE_DEFAULT_SIZE);
+
     display->default_surface = guac_common_surface_alloc(client,
             client->socket, GUAC_DEFAULT_LAYER, width, height);
 
+    guac_common_surface_set_tile_cache(display->default_surface,
+            display->tile_cache);
+
+    /* Encode images in parallel for as long as this display exists */
+    guac_common_encoder_pool_acquire();
+
+    /* Decide quality of lossy images based on measured lag and cost */
+    display->quality = guac_common_quality_alloc(client);
+    guac_common_surface_set_quality(display->default_surface,
+            display->quality);
+
     /* No initial layers or buffers */
     display->layers = NULL;
     display->buffers = NULL;
@@ -159,6 +179,15 @@ void guac_common_display_free(guac_common_display* display) {
     guac_common_display_free_layers(display->buffers, display->client);
     guac_common_display_free_layers(display->layers, display->client);
 
+    /* Free cache of recently-sent images */
+    guac_common_tile_cache_free(display->tile_cache);
+
+    /* Free quality controller (logging its statistics) */
+    guac_common_quality_free(display->quality);
+
+    /* Stop parallel encoding if no other display needs it */
+    guac_common_encoder_pool_release();
+
     pthread_mutex_destroy(&display->_lock);
     guac_mem_free(display);
 
@@ -180,6 +209,9 @@ void guac_common_display_dup(
     guac_common_display_dup_layers(display->layers, client, socket);
     guac_common_display_dup_layers(display->buffers, client, socket);
 
+    /* Synchronize all buffers of recently-sent images */
+    guac_common_tile_cache_dup(display->tile_cache, client, socket);
+
     /* Sends a sync instruction to mark the boundary of the first frame */
     guac_protocol_send_sync(socket, client->last_sent_timestamp, 1);
 
@@ -215,6 +247,7 @@ void guac_common_display_flush(guac_common_display* display) {
 
     pthread_mutex_lock(&display->_lock);
 
+    guac_timestamp start = guac_timestamp_current();
     guac_common_display_layer* current = display->layers;
 
     /* Flush all surfaces */
@@ -225,6 +258,13 @@ void guac_common_display_flush(guac_common_display* display) {
 
     guac_common_surface_flush(display->default_surface);
 
+    /* Adjust quality based on the cost of this frame */
+    guac_common_quality_update(display->quality,
+            guac_timestamp_current() - start);
+
+    /* Send latest cursor position to other users along with this frame */
+    guac_common_cursor_flush(display->cursor);
+
     pthread_mutex_unlock(&display->_lock);
 
 }
@@ -319,6 +359,12 @@ guac_common_display_layer* guac_common_display_alloc_layer(
     /* Apply current display losslessness */
     guac_common_surface_set_lossless(surface, display->lossless);
 
+    /* Share cache of recently-sent images across all surfaces */
+    guac_common_surface_set_tile_cache(surface, display->tile_cache);
+
+    /* Share quality controller across all surfaces */
+    guac_common_surface_set_quality(surface, display->quality);
+
     /* Add layer and surface to list */
     guac_common_display_layer* display_layer =
         guac_common_display_add_layer(&display->layers, layer, surface);
@@ -343,6 +389,12 @@ guac_common_display_layer* guac_common_display_alloc_buffer(
     /* Apply current display losslessness */
     guac_common_surface_set_lossless(surface, display->lossless);
 
+    /* Share cache of recently-sent images across all surfaces */
+    guac_common_surface_set_tile_cache(surface, display->tile_cache);
+
+    /* Share quality controller across all surfaces */
+    guac_common_surface_set_quality(surface, display->quality);
+
     /* Add buffer and surface to list */
     guac_common_display_layer* display_layer =
         guac_common_display_add_layer(&display->buffers, buffer, surface);
@@ -389,3 +441,31 @@ void guac_common_display_free_buffer(guac_common_display* display,
     pthread_mutex_unlock(&display->_lock);
 
 }
+
+/**
+ * Keyframe callback which duplicates the state of the given display to the
+ * given recording socket.
+ *
+ * @param socket
+ *     The socket of the recording receiving the keyframe.
+ *
+ * @param data
+ *     The guac_common_display whose state should be written.
+ */
+static void guac_common_display_write_keyframe(guac_socket* socket,
+        void* data) {
+
+    guac_common_display* display = (guac_common_display*) data;
+    guac_common_display_dup(display, display->client, socket);
+
+}
+
+void guac_common_display_record_keyframe(guac_common_display* display,
+        guac_recording* recording) {
+    guac_recording_keyframe(recording, guac_common_display_write_keyframe,
+            display);
+}
+
+int guac_common_display_get_frame_delay(guac_common_display* display) {
+    return guac_common_quality_get_frame_delay(display->quality);
+}
@@ -0,0 +1,177 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/download.h"
+
+#include <guacamole/mem.h>
+#include <guacamole/protocol.h>
+#include <guacamole/socket.h>
+#include <guacamole/stream.h>
+#include <guacamole/timestamp.h>
+#include <guacamole/user.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+
+/**
+ * Logs the throughput of the given download, invokes its close handler, and
+ * frees the download along with its associated stream.
+ *
+ * @param user
+ *     The user that the file was being downloaded by.
+ *
+ * @param stream
+ *     The stream along which the file was being downloaded.
+ *
+ * @param download
+ *     The download to free.
+ */
+static void guac_common_download_free(guac_user* user, guac_stream* stream,
+        guac_common_download* download) {
+
+    guac_timestamp duration = guac_timestamp_current() - download->started;
+    if (duration <= 0)
+        duration = 1;
+
+    guac_user_log(user, GUAC_LOG_DEBUG, "Download %s: %" PRIu64 " bytes in "
+            "%" PRIu64 " ms (%" PRIu64 " KiB/s).",
+            download->failed ? "failed" : "complete",
+            download->bytes_sent, (uint64_t) duration,
+            download->bytes_sent * 1000 / 1024 / (uint64_t) duration);
+
+    download->close_handler(download->data);
+
+    guac_user_free_stream(user, stream);
+    guac_mem_free(download);
+
+}
+
+/**
+ * Handler for ack messages which continue a download, refilling the window
+ * of unacknowledged blobs and ending the stream once all data has been sent
+ * and acknowledged.
+ *
+ * @param user
+ *     The user receiving the ack message.
+ *
+ * @param stream
+ *     The Guacamole protocol stream associated with the received ack message.
+ *
+ * @param message
+ *     An arbitrary human-readable message describing the nature of the
+ *     success or failure denoted by the ack message.
+ *
+ * @param status
+ *     The status code associated with the ack message, which may indicate
+ *     success or an error.
+ *
+ * @return
+ *     Always zero.
+ */
+static int guac_common_download_ack_handler(guac_user* user,
+        guac_stream* stream, char* message, guac_protocol_status status) {
+
+    guac_common_download* download = (guac_common_download*) stream->data;
+
+    /* Abort download if the user reports an error */
+    if (status != GUAC_PROTOCOL_STATUS_SUCCESS) {
+        guac_user_log(user, GUAC_LOG_DEBUG, "Download aborted by user: %s "
+                "(0x%X)", message, status);
+        download->failed = 1;
+        guac_common_download_free(user, stream, download);
+        return 0;
+    }
+
+    if (download->in_flight > 0)
+        download->in_flight--;
+
+    /* Send blobs until the window is full */
+    while (!download->complete && download->in_flight < download->window) {
+
+        /* Read ahead once all buffered data has been sent */
+        if (download->offset == download->length) {
+
+            int bytes_read = download->read_handler(download->data,
+                    download->buffer, sizeof(download->buffer));
+
+            if (bytes_read <= 0) {
+
+                if (bytes_read < 0) {
+                    guac_user_log(user, GUAC_LOG_INFO, "Error reading file "
+                            "for download");
+                    download->failed = 1;
+                }
+
+                download->complete = 1;
+                break;
+
+            }
+
+            download->length = bytes_read;
+            download->offset = 0;
+
+        }
+
+        int length = download->length - download->offset;
+        if (length > GUAC_PROTOCOL_BLOB_MAX_LENGTH)
+            length = GUAC_PROTOCOL_BLOB_MAX_LENGTH;
+
+        guac_protocol_send_blob(user->socket, stream,
+                download->buffer + download->offset, length);
+
+        download->offset += length;
+        download->bytes_sent += length;
+        download->in_flight++;
+
+    }
+
+    /* End stream only once all blobs have been acknowledged, such that late
+     * acks cannot be received by a different stream reusing the same index */
+    if (download->complete && download->in_flight == 0) {
+        guac_protocol_send_end(user->socket, stream);
+        guac_common_download_free(user, stream, download);
+    }
+
+    guac_socket_flush(user->socket);
+    return 0;
+
+}
+
+void guac_common_download_begin(guac_stream* stream,
+        guac_common_download_read_handler* read_handler,
+        guac_common_download_close_handler* close_handler,
+        void* data, int window) {
+
+    guac_common_download* download =
+        guac_mem_zalloc(sizeof(guac_common_download));
+
+    download->read_handler = read_handler;
+    download->close_handler = close_handler;
+    download->data = data;
+    download->window = window > 0 ? window : GUAC_COMMON_DOWNLOAD_DEFAULT_WINDOW;
+    download->started = guac_timestamp_current();
+
+    /* The "file" or "body" instruction beginning the stream is itself
+     * acknowledged before any data is sent */
+    download->in_flight = 1;
+
+    stream->data = download;
+    stream->ack_handler = guac_common_download_ack_handler;
+
+}
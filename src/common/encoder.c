@@ -0,0 +1,666 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/encoder.h"
+
+#include <cairo/cairo.h>
+#include <guacamole/client.h>
+#include <guacamole/layer.h>
+#include <guacamole/mem.h>
+#include <guacamole/protocol-types.h>
+#include <guacamole/socket.h>
+#include <guacamole/stream.h>
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+struct guac_common_encoder_segment {
+
+    /**
+     * The instruction data within this segment.
+     */
+    unsigned char* data;
+
+    /**
+     * The number of bytes of instruction data within this segment.
+     */
+    size_t length;
+
+    /**
+     * The number of bytes allocated for the instruction data buffer.
+     */
+    size_t size;
+
+    /**
+     * The offset just past the end of each complete instruction within the
+     * instruction data buffer, in order.
+     */
+    size_t* ends;
+
+    /**
+     * The number of complete instructions within this segment.
+     */
+    int instructions;
+
+    /**
+     * The number of offsets allocated for the ends array.
+     */
+    int ends_size;
+
+    /**
+     * Non-zero if this segment contains the instructions for a single image
+     * encoded by a worker thread, zero if this segment contains instructions
+     * written to the encoder's socket.
+     */
+    int image;
+
+    /**
+     * Non-zero if this segment is an image segment which has not yet been
+     * fully encoded. This is only accessed while the pool lock is held.
+     */
+    int pending;
+
+    /**
+     * The client that the image stream was allocated from.
+     */
+    guac_client* client;
+
+    /**
+     * The stream over which the image will be sent. This stream remains
+     * allocated until the image segment has been sent, such that its index
+     * cannot be reused by instructions sent before the image.
+     */
+    guac_stream* stream;
+
+    /**
+     * The format that the image should be encoded as.
+     */
+    guac_common_encoder_format format;
+
+    /**
+     * The composite mode to use when rendering the image.
+     */
+    guac_composite_mode mode;
+
+    /**
+     * The destination layer of the image.
+     */
+    const guac_layer* layer;
+
+    /**
+     * The X coordinate of the destination of the image.
+     */
+    int x;
+
+    /**
+     * The Y coordinate of the destination of the image.
+     */
+    int y;
+
+    /**
+     * The pixel format of the image data.
+     */
+    cairo_format_t image_format;
+
+    /**
+     * The image data to encode.
+     */
+    unsigned char* image_data;
+
+    /**
+     * The width of the image, in pixels.
+     */
+    int width;
+
+    /**
+     * The height of the image, in pixels.
+     */
+    int height;
+
+    /**
+     * The size of each row of image data, in bytes.
+     */
+    int stride;
+
+    /**
+     * The JPEG or WebP image quality.
+     */
+    int quality;
+
+    /**
+     * Whether WebP lossless compression should be used.
+     */
+    int lossless;
+
+    /**
+     * The next segment of the encoder's output, or NULL if this is the last
+     * segment.
+     */
+    guac_common_encoder_segment* next;
+
+    /**
+     * The next image segment awaiting a worker thread, or NULL if this is
+     * the last segment in the queue.
+     */
+    guac_common_encoder_segment* next_queued;
+
+};
+
+/**
+ * The number of worker threads within the pool, or zero if the pool is not
+ * currently running. This is only accessed while the pool lock is held.
+ */
+static int guac_common_encoder_pool_size = 0;
+
+/**
+ * The worker threads within the pool.
+ */
+static pthread_t
+    guac_common_encoder_pool_threads[GUAC_COMMON_ENCODER_MAX_THREADS];
+
+/**
+ * The number of outstanding calls to guac_common_encoder_pool_acquire()
+ * which have not yet been matched by guac_common_encoder_pool_release(). The
+ * worker threads run only while this is non-zero. This is only accessed
+ * while the pool lock is held.
+ */
+static int guac_common_encoder_pool_refs = 0;
+
+/**
+ * The generation of the currently-running worker threads. Each time the pool
+ * is stopped, this value is incremented, and any worker threads of an older
+ * generation exit. This is only accessed while the pool lock is held.
+ */
+static int guac_common_encoder_pool_generation = 0;
+
+/**
+ * Lock which guards the state of the worker thread pool, the queue of image
+ * segments awaiting a worker thread, and the pending flag of all image
+ * segments.
+ */
+static pthread_mutex_t guac_common_encoder_pool_lock =
+    PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Condition which is signalled whenever an image segment is added to the
+ * queue.
+ */
+static pthread_cond_t guac_common_encoder_pool_queued =
+    PTHREAD_COND_INITIALIZER;
+
+/**
+ * Condition which is signalled whenever an image segment has been fully
+ * encoded.
+ */
+static pthread_cond_t guac_common_encoder_pool_completed =
+    PTHREAD_COND_INITIALIZER;
+
+/**
+ * The first image segment awaiting a worker thread, or NULL if the queue is
+ * empty.
+ */
+static guac_common_encoder_segment* guac_common_encoder_queue_head = NULL;
+
+/**
+ * The last image segment awaiting a worker thread, or NULL if the queue is
+ * empty.
+ */
+static guac_common_encoder_segment* guac_common_encoder_queue_tail = NULL;
+
+/**
+ * Appends the given data to the instruction data of the given segment,
+ * growing its buffer as necessary.
+ *
+ * @param segment
+ *     The segment to append to.
+ *
+ * @param buf
+ *     The data to append.
+ *
+ * @param count
+ *     The number of bytes to append.
+ */
+static void guac_common_encoder_segment_append(
+        guac_common_encoder_segment* segment, const void* buf, size_t count) {
+
+    if (segment->length + count > segment->size) {
+
+        size_t size = segment->size ? segment->size : 4096;
+        while (size < segment->length + count)
+            size = guac_mem_ckd_mul_or_die(size, 2);
+
+        segment->data = guac_mem_realloc(segment->data, size);
+        segment->size = size;
+
+    }
+
+    memcpy(segment->data + segment->length, buf, count);
+    segment->length += count;
+
+}
+
+/**
+ * Records that all instruction data within the given segment forms complete
+ * instructions, such that each instruction can later be sent individually.
+ *
+ * @param segment
+ *     The segment to update.
+ */
+static void guac_common_encoder_segment_end_instruction(
+        guac_common_encoder_segment* segment) {
+
+    /* Ignore if no data has been written since the last instruction */
+    if (segment->instructions > 0
+            && segment->ends[segment->instructions - 1] == segment->length)
+        return;
+
+    if (segment->instructions == segment->ends_size) {
+        segment->ends_size = segment->ends_size ? segment->ends_size * 2 : 16;
+        segment->ends = guac_mem_realloc(segment->ends,
+                segment->ends_size, sizeof(size_t));
+    }
+
+    segment->ends[segment->instructions++] = segment->length;
+
+}
+
+/**
+ * Write handler for the sockets used by worker threads to encode image
+ * segments, appending all data to the segment.
+ */
+static ssize_t guac_common_encoder_image_write_handler(guac_socket* socket,
+        const void* buf, size_t count) {
+
+    guac_common_encoder_segment_append(
+            (guac_common_encoder_segment*) socket->data, buf, count);
+
+    return count;
+
+}
+
+/**
+ * Unlock handler for the sockets used by worker threads to encode image
+ * segments, recording the end of each instruction.
+ */
+static void guac_common_encoder_image_unlock_handler(guac_socket* socket) {
+    guac_common_encoder_segment_end_instruction(
+            (guac_common_encoder_segment*) socket->data);
+}
+
+/**
+ * Returns the segment which should receive instructions written to the
+ * buffered socket of the given encoder, adding a new segment if the last
+ * segment is an image segment or there are no segments.
+ *
+ * @param encoder
+ *     The encoder whose output is being buffered.
+ *
+ * @return
+ *     The segment which should receive buffered instructions.
+ */
+static guac_common_encoder_segment* guac_common_encoder_add_segment(
+        guac_common_encoder* encoder) {
+
+    guac_common_encoder_segment* segment =
+        guac_mem_zalloc(sizeof(guac_common_encoder_segment));
+
+    if (encoder->tail != NULL)
+        encoder->tail->next = segment;
+    else
+        encoder->head = segment;
+
+    encoder->tail = segment;
+    return segment;
+
+}
+
+/**
+ * Write handler for the buffered socket of each encoder, appending all data
+ * to the last segment of the encoder's output.
+ */
+static ssize_t guac_common_encoder_write_handler(guac_socket* socket,
+        const void* buf, size_t count) {
+
+    guac_common_encoder* encoder = (guac_common_encoder*) socket->data;
+
+    guac_common_encoder_segment* segment = encoder->tail;
+    if (segment == NULL || segment->image)
+        segment = guac_common_encoder_add_segment(encoder);
+
+    guac_common_encoder_segment_append(segment, buf, count);
+    return count;
+
+}
+
+/**
+ * Unlock handler for the buffered socket of each encoder, recording the end
+ * of each instruction.
+ */
+static void guac_common_encoder_unlock_handler(guac_socket* socket) {
+
+    guac_common_encoder* encoder = (guac_common_encoder*) socket->data;
+
+    if (encoder->tail != NULL && !encoder->tail->image)
+        guac_common_encoder_segment_end_instruction(encoder->tail);
+
+}
+
+/**
+ * Encodes the image described by the given image segment, storing the
+ * instructions which stream that image within the segment.
+ *
+ * @param segment
+ *     The image segment to encode.
+ */
+static void guac_common_encoder_encode(guac_common_encoder_segment* segment) {
+
+    guac_socket* socket = guac_socket_alloc();
+    socket->data = segment;
+    socket->write_handler = guac_common_encoder_image_write_handler;
+    socket->unlock_handler = guac_common_encoder_image_unlock_handler;
+
+    cairo_surface_t* image = cairo_image_surface_create_for_data(
+            segment->image_data, segment->image_format,
+            segment->width, segment->height, segment->stride);
+
+    switch (segment->format) {
+
+        case GUAC_COMMON_ENCODER_PNG:
+            guac_client_write_png(segment->client, socket, segment->stream,
+                    segment->mode, segment->layer, segment->x, segment->y,
+                    image);
+            break;
+
+        case GUAC_COMMON_ENCODER_JPEG:
+            guac_client_write_jpeg(segment->client, socket, segment->stream,
+                    segment->mode, segment->layer, segment->x, segment->y,
+                    image, segment->quality);
+            break;
+
+        case GUAC_COMMON_ENCODER_WEBP:
+            guac_client_write_webp(segment->client, socket, segment->stream,
+                    segment->mode, segment->layer, segment->x, segment->y,
+                    image, segment->quality, segment->lossless);
+            break;
+
+    }
+
+    cairo_surface_destroy(image);
+    guac_socket_free(socket);
+
+}
+
+/**
+ * Worker thread which repeatedly encodes the next image segment within the
+ * queue until the pool is stopped.
+ *
+ * @param data
+ *     The generation of the pool which started this thread, cast to a
+ *     pointer.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_common_encoder_worker_thread(void* data) {
+
+    int generation = (int) (intptr_t) data;
+
+    pthread_mutex_lock(&guac_common_encoder_pool_lock);
+
+    for (;;) {
+
+        /* Wait for next image, unless the pool is stopping */
+        while (guac_common_encoder_queue_head == NULL
+                && guac_common_encoder_pool_generation == generation)
+            pthread_cond_wait(&guac_common_encoder_pool_queued,
+                    &guac_common_encoder_pool_lock);
+
+        if (guac_common_encoder_pool_generation != generation)
+            break;
+
+        guac_common_encoder_segment* segment = guac_common_encoder_queue_head;
+        guac_common_encoder_queue_head = segment->next_queued;
+        if (guac_common_encoder_queue_head == NULL)
+            guac_common_encoder_queue_tail = NULL;
+
+        /* Encode without holding the lock */
+        pthread_mutex_unlock(&guac_common_encoder_pool_lock);
+        guac_common_encoder_encode(segment);
+        pthread_mutex_lock(&guac_common_encoder_pool_lock);
+
+        segment->pending = 0;
+        pthread_cond_broadcast(&guac_common_encoder_pool_completed);
+
+    }
+
+    pthread_mutex_unlock(&guac_common_encoder_pool_lock);
+    return NULL;
+
+}
+
+void guac_common_encoder_pool_acquire() {
+
+    pthread_mutex_lock(&guac_common_encoder_pool_lock);
+
+    /* Start worker threads only for the first reference, using one fewer
+     * thread than the number of available processors */
+    if (guac_common_encoder_pool_refs++ == 0) {
+
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+        int threads = processors - 1;
+        if (threads > GUAC_COMMON_ENCODER_MAX_THREADS)
+            threads = GUAC_COMMON_ENCODER_MAX_THREADS;
+
+        void* generation =
+            (void*) (intptr_t) guac_common_encoder_pool_generation;
+        for (int i = 0; i < threads; i++) {
+
+            if (pthread_create(&guac_common_encoder_pool_threads[i], NULL,
+                        guac_common_encoder_worker_thread, generation))
+                break;
+
+            guac_common_encoder_pool_size++;
+
+        }
+
+    }
+
+    pthread_mutex_unlock(&guac_common_encoder_pool_lock);
+
+}
+
+void guac_common_encoder_pool_release() {
+
+    pthread_mutex_lock(&guac_common_encoder_pool_lock);
+
+    /* Stop worker threads only once the last reference is released */
+    if (--guac_common_encoder_pool_refs > 0) {
+        pthread_mutex_unlock(&guac_common_encoder_pool_lock);
+        return;
+    }
+
+    pthread_t threads[GUAC_COMMON_ENCODER_MAX_THREADS];
+    int size = guac_common_encoder_pool_size;
+    memcpy(threads, guac_common_encoder_pool_threads,
+            sizeof(pthread_t) * size);
+
+    /* Signal all current workers to exit. Any workers started by a later
+     * call to guac_common_encoder_pool_acquire() will belong to the next
+     * generation and are unaffected. */
+    guac_common_encoder_pool_size = 0;
+    guac_common_encoder_pool_generation++;
+    pthread_cond_broadcast(&guac_common_encoder_pool_queued);
+
+    pthread_mutex_unlock(&guac_common_encoder_pool_lock);
+
+    /* Wait for workers to exit, such that no worker thread can outlive the
+     * code it is running (this code is statically linked into plugins which
+     * are unloaded once their connection ends) */
+    for (int i = 0; i < size; i++)
+        pthread_join(threads[i], NULL);
+
+}
+
+int guac_common_encoder_threads() {
+
+    pthread_mutex_lock(&guac_common_encoder_pool_lock);
+    int size = guac_common_encoder_pool_size;
+    pthread_mutex_unlock(&guac_common_encoder_pool_lock);
+
+    return size;
+
+}
+
+guac_common_encoder* guac_common_encoder_alloc(guac_client* client,
+        guac_socket* socket) {
+
+    guac_common_encoder* encoder = guac_mem_zalloc(sizeof(guac_common_encoder));
+    encoder->client = client;
+    encoder->socket = socket;
+
+    encoder->buffered_socket = guac_socket_alloc();
+    encoder->buffered_socket->data = encoder;
+    encoder->buffered_socket->write_handler = guac_common_encoder_write_handler;
+    encoder->buffered_socket->unlock_handler = guac_common_encoder_unlock_handler;
+
+    return encoder;
+
+}
+
+void guac_common_encoder_free(guac_common_encoder* encoder) {
+    guac_common_encoder_flush(encoder);
+    guac_socket_free(encoder->buffered_socket);
+    guac_mem_free(encoder);
+}
+
+void guac_common_encoder_stream(guac_common_encoder* encoder,
+        guac_common_encoder_format format, guac_composite_mode mode,
+        const guac_layer* layer, int x, int y, cairo_surface_t* image,
+        int quality, int lossless) {
+
+    /* Limit the number of image streams held open at any one time */
+    if (encoder->images == GUAC_COMMON_ENCODER_MAX_IMAGES)
+        guac_common_encoder_flush(encoder);
+
+    int width = cairo_image_surface_get_width(image);
+    int height = cairo_image_surface_get_height(image);
+
+    guac_common_encoder_segment* segment =
+        guac_common_encoder_add_segment(encoder);
+
+    segment->image = 1;
+    segment->client = encoder->client;
+    segment->stream = guac_client_alloc_stream(encoder->client);
+    segment->format = format;
+    segment->mode = mode;
+    segment->layer = layer;
+    segment->x = x;
+    segment->y = y;
+    segment->image_format = cairo_image_surface_get_format(image);
+    segment->image_data = cairo_image_surface_get_data(image);
+    segment->width = width;
+    segment->height = height;
+    segment->stride = cairo_image_surface_get_stride(image);
+    segment->quality = quality;
+    segment->lossless = lossless;
+
+    encoder->images++;
+
+    /* Encode small images immediately */
+    if (width * height < GUAC_COMMON_ENCODER_MIN_PIXELS
+            || guac_common_encoder_threads() == 0) {
+        guac_common_encoder_encode(segment);
+        return;
+    }
+
+    /* Hand off to worker threads */
+    pthread_mutex_lock(&guac_common_encoder_pool_lock);
+    segment->pending = 1;
+
+    if (guac_common_encoder_queue_tail != NULL)
+        guac_common_encoder_queue_tail->next_queued = segment;
+    else
+        guac_common_encoder_queue_head = segment;
+
+    guac_common_encoder_queue_tail = segment;
+
+    /* Wake all workers, as the wakeup may otherwise be absorbed by a worker
+     * of a previous generation which is exiting */
+    pthread_cond_broadcast(&guac_common_encoder_pool_queued);
+    pthread_mutex_unlock(&guac_common_encoder_pool_lock);
+
+}
+
+void guac_common_encoder_flush(guac_common_encoder* encoder) {
+
+    guac_socket* socket = encoder->socket;
+
+    guac_common_encoder_segment* segment = encoder->head;
+    while (segment != NULL) {
+
+        /* Wait for image to be encoded, if still pending */
+        if (segment->image) {
+            pthread_mutex_lock(&guac_common_encoder_pool_lock);
+            while (segment->pending)
+                pthread_cond_wait(&guac_common_encoder_pool_completed,
+                        &guac_common_encoder_pool_lock);
+            pthread_mutex_unlock(&guac_common_encoder_pool_lock);
+        }
+
+        /* Send each instruction individually, followed by any trailing data
+         * which was not written as part of a complete instruction */
+        size_t start = 0;
+        for (int i = 0; i <= segment->instructions; i++) {
+
+            size_t end = (i < segment->instructions)
+                       ? segment->ends[i] : segment->length;
+
+            if (end > start) {
+                guac_socket_instruction_begin(socket);
+                guac_socket_write(socket, segment->data + start, end - start);
+                guac_socket_instruction_end(socket);
+            }
+
+            start = end;
+
+        }
+
+        /* Image stream can be reused only after all its data is sent */
+        if (segment->image)
+            guac_client_free_stream(encoder->client, segment->stream);
+
+        guac_common_encoder_segment* next = segment->next;
+
+        guac_mem_free(segment->data);
+        guac_mem_free(segment->ends);
+        guac_mem_free(segment);
+
+        segment = next;
+
+    }
+
+    encoder->head = NULL;
+    encoder->tail = NULL;
+    encoder->images = 0;
+
+}
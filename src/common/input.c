@@ -0,0 +1,353 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/input.h"
+
+#include <guacamole/client.h>
+#include <guacamole/mem.h>
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * The number of nanoseconds in one millisecond.
+ */
+#define NANOS_PER_MILLISECOND 1000000L
+
+/**
+ * The number of nanoseconds in one second.
+ */
+#define NANOS_PER_SECOND 1000000000L
+
+/**
+ * Forwards the given event using the handler of the given input coalescer.
+ * The lock of the input coalescer must already be held.
+ *
+ * @param input
+ *     The input coalescer forwarding the event.
+ *
+ * @param event
+ *     The event to forward.
+ */
+static void guac_common_input_forward(guac_common_input* input,
+        const guac_common_input_event* event) {
+
+    input->forwarded++;
+    input->handler(event, input->data);
+
+}
+
+/**
+ * Returns whether the given input coalescer has any motion which has not yet
+ * been forwarded. The lock of the input coalescer must already be held.
+ *
+ * @param input
+ *     The input coalescer to check.
+ *
+ * @return
+ *     Non-zero if motion is pending, zero otherwise.
+ */
+static int guac_common_input_is_pending(guac_common_input* input) {
+
+    if (input->mouse_pending)
+        return 1;
+
+    for (int i = 0; i < GUAC_COMMON_INPUT_MAX_TOUCHES; i++) {
+        if (input->touches[i].pending)
+            return 1;
+    }
+
+    return 0;
+
+}
+
+/**
+ * Forwards all pending motion of the given input coalescer. The lock of the
+ * input coalescer must already be held.
+ *
+ * @param input
+ *     The input coalescer whose pending motion should be forwarded.
+ */
+static void guac_common_input_flush_pending(guac_common_input* input) {
+
+    int flushed = 0;
+
+    if (input->mouse_pending) {
+        guac_common_input_forward(input, &input->mouse);
+        input->mouse_pending = 0;
+        flushed = 1;
+    }
+
+    for (int i = 0; i < GUAC_COMMON_INPUT_MAX_TOUCHES; i++) {
+        guac_common_input_touch_state* touch = &input->touches[i];
+        if (touch->pending) {
+            guac_common_input_forward(input, &touch->event);
+            touch->pending = 0;
+            flushed = 1;
+        }
+    }
+
+    if (flushed)
+        input->last_motion = guac_timestamp_current();
+
+}
+
+/**
+ * Handles newly-pending motion, forwarding that motion immediately if enough
+ * time has elapsed since motion was last forwarded, or waking the coalescer's
+ * thread to forward the motion later otherwise. The lock of the input
+ * coalescer must already be held.
+ *
+ * @param input
+ *     The input coalescer having newly-pending motion.
+ */
+static void guac_common_input_motion(guac_common_input* input) {
+
+    guac_timestamp elapsed = guac_timestamp_current() - input->last_motion;
+
+    if (elapsed >= GUAC_COMMON_INPUT_MOTION_INTERVAL)
+        guac_common_input_flush_pending(input);
+    else
+        pthread_cond_signal(&input->modified);
+
+}
+
+/**
+ * Waits up to the given number of milliseconds for the modified condition of
+ * the given input coalescer to be signalled. The lock of the input coalescer
+ * must already be held.
+ *
+ * @param input
+ *     The input coalescer whose modified condition should be waited upon.
+ *
+ * @param msecs
+ *     The maximum number of milliseconds to wait.
+ */
+static void guac_common_input_wait(guac_common_input* input, int msecs) {
+
+    struct timespec timeout;
+    clock_gettime(CLOCK_REALTIME, &timeout);
+
+    uint64_t nsecs = timeout.tv_nsec + msecs * NANOS_PER_MILLISECOND;
+    timeout.tv_sec += nsecs / NANOS_PER_SECOND;
+    timeout.tv_nsec = nsecs % NANOS_PER_SECOND;
+
+    pthread_cond_timedwait(&input->modified, &input->lock, &timeout);
+
+}
+
+/**
+ * Forwards pending motion once GUAC_COMMON_INPUT_MOTION_INTERVAL has elapsed
+ * since motion was last forwarded, until the input coalescer is freed.
+ *
+ * @param data
+ *     The guac_common_input whose pending motion should be forwarded.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_common_input_thread(void* data) {
+
+    guac_common_input* input = (guac_common_input*) data;
+
+    pthread_mutex_lock(&input->lock);
+
+    while (!input->stopping) {
+
+        /* Wait for motion */
+        if (!guac_common_input_is_pending(input)) {
+            pthread_cond_wait(&input->modified, &input->lock);
+            continue;
+        }
+
+        /* Wait for remainder of interval (more motion may arrive) */
+        int remaining = input->last_motion + GUAC_COMMON_INPUT_MOTION_INTERVAL
+                      - guac_timestamp_current();
+
+        if (remaining > 0) {
+            guac_common_input_wait(input, remaining);
+            continue;
+        }
+
+        guac_common_input_flush_pending(input);
+
+    }
+
+    pthread_mutex_unlock(&input->lock);
+    return NULL;
+
+}
+
+guac_common_input* guac_common_input_alloc(guac_client* client,
+        guac_common_input_handler* handler, void* data) {
+
+    guac_common_input* input = guac_mem_zalloc(sizeof(guac_common_input));
+    input->client = client;
+    input->handler = handler;
+    input->data = data;
+
+    pthread_mutex_init(&input->lock, NULL);
+    pthread_cond_init(&input->modified, NULL);
+    pthread_create(&input->thread, NULL, guac_common_input_thread, input);
+
+    return input;
+
+}
+
+void guac_common_input_free(guac_common_input* input) {
+
+    /* Signal termination of forwarding thread */
+    pthread_mutex_lock(&input->lock);
+    input->stopping = 1;
+    pthread_cond_broadcast(&input->modified);
+    pthread_mutex_unlock(&input->lock);
+
+    pthread_join(input->thread, NULL);
+
+    guac_common_input_dump(input);
+
+    pthread_cond_destroy(&input->modified);
+    pthread_mutex_destroy(&input->lock);
+    guac_mem_free(input);
+
+}
+
+void guac_common_input_mouse(guac_common_input* input, int x, int y,
+        int mask) {
+
+    guac_common_input_event event = {
+        .type = GUAC_COMMON_INPUT_EVENT_MOUSE,
+        .x = x,
+        .y = y,
+        .mask = mask
+    };
+
+    pthread_mutex_lock(&input->lock);
+
+    input->received++;
+
+    /* Combine events which only move the mouse */
+    if (mask == input->mouse_mask) {
+        input->mouse = event;
+        input->mouse_pending = 1;
+        guac_common_input_motion(input);
+    }
+
+    /* Forward button changes immediately, after any preceding motion */
+    else {
+        guac_common_input_flush_pending(input);
+        guac_common_input_forward(input, &event);
+        input->mouse = event;
+        input->mouse_mask = mask;
+    }
+
+    pthread_mutex_unlock(&input->lock);
+
+}
+
+void guac_common_input_touch(guac_common_input* input, int id, int x,
+        int y, int x_radius, int y_radius, double angle, double force) {
+
+    guac_common_input_event event = {
+        .type = GUAC_COMMON_INPUT_EVENT_TOUCH,
+        .x = x,
+        .y = y,
+        .id = id,
+        .x_radius = x_radius,
+        .y_radius = y_radius,
+        .angle = angle,
+        .force = force
+    };
+
+    pthread_mutex_lock(&input->lock);
+
+    input->received++;
+
+    /* Locate state of touch (if already in contact) and a free slot for
+     * tracking the touch (if not) */
+    guac_common_input_touch_state* touch = NULL;
+    guac_common_input_touch_state* available = NULL;
+    for (int i = 0; i < GUAC_COMMON_INPUT_MAX_TOUCHES; i++) {
+
+        guac_common_input_touch_state* current = &input->touches[i];
+
+        if (!current->active) {
+            if (available == NULL)
+                available = current;
+        }
+
+        else if (current->event.id == id) {
+            touch = current;
+            break;
+        }
+
+    }
+
+    /* Combine events which only move a touch that remains in contact */
+    if (touch != NULL && force > 0) {
+        touch->event = event;
+        touch->pending = 1;
+        guac_common_input_motion(input);
+    }
+
+    /* Forward the start and end of each touch immediately, after any
+     * preceding motion */
+    else {
+
+        guac_common_input_flush_pending(input);
+
+        /* Stop tracking lifted touches */
+        if (touch != NULL)
+            touch->active = 0;
+
+        /* Begin tracking new touches */
+        else if (force > 0 && available != NULL) {
+            available->active = 1;
+            available->event = event;
+        }
+
+        guac_common_input_forward(input, &event);
+
+    }
+
+    pthread_mutex_unlock(&input->lock);
+
+}
+
+void guac_common_input_flush(guac_common_input* input) {
+
+    pthread_mutex_lock(&input->lock);
+    guac_common_input_flush_pending(input);
+    pthread_mutex_unlock(&input->lock);
+
+}
+
+void guac_common_input_dump(guac_common_input* input) {
+
+    pthread_mutex_lock(&input->lock);
+
+    guac_client_log(input->client, GUAC_LOG_DEBUG, "Input coalescer: %lu "
+            "mouse/touch events received, %lu forwarded.", input->received,
+            input->forwarded);
+
+    pthread_mutex_unlock(&input->lock);
+
+}
@@ -0,0 +1,225 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/quality.h"
+
+#include <guacamole/client.h>
+#include <guacamole/mem.h>
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+
+guac_common_quality* guac_common_quality_alloc(guac_client* client) {
+
+    guac_common_quality* quality = guac_mem_zalloc(sizeof(guac_common_quality));
+    quality->client = client;
+
+    /* Assume an uncongested connection until measured otherwise */
+    quality->decision.quality = GUAC_COMMON_QUALITY_MAX;
+    quality->decision.lossy_framerate = GUAC_COMMON_QUALITY_LOSSY_FRAMERATE;
+    quality->decision.webp = 1;
+    quality->decision.frame_delay = 0;
+    quality->lowest_quality = GUAC_COMMON_QUALITY_MAX;
+
+    pthread_mutex_init(&quality->_lock, NULL);
+
+    return quality;
+
+}
+
+void guac_common_quality_free(guac_common_quality* quality) {
+
+    guac_common_quality_dump(quality);
+
+    pthread_mutex_destroy(&quality->_lock);
+    guac_mem_free(quality);
+
+}
+
+/**
+ * Decides whether the connection is congested given the latest measurements
+ * held by the given quality controller. Separate thresholds are used for
+ * entering and leaving the congested state, such that lag hovering around a
+ * single threshold does not cause the decision to oscillate.
+ *
+ * @param quality
+ *     The quality controller whose measurements should be checked.
+ *
+ * @return
+ *     Non-zero if the connection should be considered congested, zero
+ *     otherwise.
+ */
+static int guac_common_quality_is_congested(guac_common_quality* quality) {
+
+    guac_client_link_estimate* link = &quality->link;
+
+    /* Become congested once lag or encoding time clearly exceed targets */
+    if (link->processing_lag > GUAC_COMMON_QUALITY_LAG_HIGH
+            || quality->encode_time > GUAC_COMMON_QUALITY_ENCODE_BUDGET)
+        return 1;
+
+    /* Remain congested until lag (including its variation) and encoding
+     * time are well below those targets */
+    if (quality->congested)
+        return link->processing_lag + link->processing_lag_deviation
+                    >= GUAC_COMMON_QUALITY_LAG_LOW
+            || quality->encode_time > GUAC_COMMON_QUALITY_ENCODE_BUDGET / 2;
+
+    return 0;
+
+}
+
+void guac_common_quality_update(guac_common_quality* quality,
+        int encode_time) {
+
+    guac_client_link_estimate link;
+    guac_client_get_link_estimate(quality->client, &link);
+
+    guac_timestamp now = guac_timestamp_current();
+
+    pthread_mutex_lock(&quality->_lock);
+
+    quality->link = link;
+
+    /* Smooth encoding time across frames, rounding to nearest */
+    if (quality->frames == 0)
+        quality->encode_time = encode_time;
+    else
+        quality->encode_time = guac_client_smooth_estimate(
+                quality->encode_time, encode_time, 8);
+
+    quality->frames++;
+    quality->congested = guac_common_quality_is_congested(quality);
+
+    if (quality->congested)
+        quality->congested_frames++;
+
+    guac_common_quality_decision* decision = &quality->decision;
+    guac_common_quality_decision previous = *decision;
+
+    /* Combine updates into frames no faster than users are able to process
+     * them, and no faster than frames can be encoded */
+    decision->frame_delay = link.processing_lag + link.processing_lag_deviation;
+    if (quality->encode_time > GUAC_COMMON_QUALITY_ENCODE_BUDGET
+            && quality->encode_time > decision->frame_delay)
+        decision->frame_delay = quality->encode_time;
+
+    /* Adjust at most once per round trip, such that the effect of each
+     * adjustment is observed before the next is made */
+    int interval = GUAC_COMMON_QUALITY_ADJUST_INTERVAL;
+    if (link.rtt > interval)
+        interval = link.rtt;
+
+    if (now - quality->last_adjustment >= interval) {
+
+        /* Back off quickly while congested, preferring lossy formats for
+         * anything that changes at all, and falling back to JPEG if encoding
+         * itself is the bottleneck */
+        if (quality->congested) {
+
+            decision->quality = GUAC_COMMON_QUALITY_MIN
+                + (decision->quality - GUAC_COMMON_QUALITY_MIN) / 2;
+
+            decision->lossy_framerate =
+                GUAC_COMMON_QUALITY_CONGESTED_LOSSY_FRAMERATE;
+
+            if (quality->encode_time > GUAC_COMMON_QUALITY_ENCODE_BUDGET)
+                decision->webp = 0;
+
+        }
+
+        /* Recover gradually once no longer congested */
+        else if (decision->quality < GUAC_COMMON_QUALITY_MAX) {
+
+            decision->quality += GUAC_COMMON_QUALITY_INCREASE;
+            if (decision->quality >= GUAC_COMMON_QUALITY_MAX) {
+                decision->quality = GUAC_COMMON_QUALITY_MAX;
+                decision->lossy_framerate = GUAC_COMMON_QUALITY_LOSSY_FRAMERATE;
+                decision->webp = 1;
+            }
+
+        }
+
+        if (decision->quality < previous.quality)
+            quality->decreases++;
+        else if (decision->quality > previous.quality)
+            quality->increases++;
+
+        if (decision->quality < quality->lowest_quality)
+            quality->lowest_quality = decision->quality;
+
+        quality->last_adjustment = now;
+
+    }
+
+    /* Log changes in the encoding strategy (at TRACE level only) */
+    if (decision->quality != previous.quality
+            || decision->lossy_framerate != previous.lossy_framerate
+            || decision->webp != previous.webp)
+        guac_client_log(quality->client, GUAC_LOG_TRACE, "Quality: "
+                "processing_lag=%ims (deviation=%ims), rtt=%ims, "
+                "bandwidth=%iB/s, encode_time=%ims, congested=%i: "
+                "quality=%i, lossy_framerate=%i, webp=%i, frame_delay=%ims",
+                link.processing_lag, link.processing_lag_deviation, link.rtt,
+                link.bandwidth, quality->encode_time, quality->congested,
+                decision->quality, decision->lossy_framerate, decision->webp,
+                decision->frame_delay);
+
+    pthread_mutex_unlock(&quality->_lock);
+
+}
+
+void guac_common_quality_get_decision(guac_common_quality* quality,
+        guac_common_quality_decision* decision) {
+
+    pthread_mutex_lock(&quality->_lock);
+    *decision = quality->decision;
+    pthread_mutex_unlock(&quality->_lock);
+
+}
+
+int guac_common_quality_get_frame_delay(guac_common_quality* quality) {
+
+    pthread_mutex_lock(&quality->_lock);
+    int frame_delay = quality->decision.frame_delay;
+    pthread_mutex_unlock(&quality->_lock);
+
+    return frame_delay;
+
+}
+
+void guac_common_quality_dump(guac_common_quality* quality) {
+
+    pthread_mutex_lock(&quality->_lock);
+
+    guac_client_log(quality->client, GUAC_LOG_DEBUG, "Quality controller: "
+            "%lu frames (%lu congested), %lu decreases, %lu increases, "
+            "lowest quality %i. Currently quality=%i, lossy_framerate=%i, "
+            "webp=%i, frame_delay=%ims, processing_lag=%ims (deviation=%ims), "
+            "rtt=%ims, bandwidth=%iB/s, encode_time=%ims.", quality->frames,
+            quality->congested_frames, quality->decreases, quality->increases,
+            quality->lowest_quality, quality->decision.quality,
+            quality->decision.lossy_framerate, quality->decision.webp,
+            quality->decision.frame_delay, quality->link.processing_lag,
+            quality->link.processing_lag_deviation, quality->link.rtt,
+            quality->link.bandwidth, quality->encode_time);
+
+    pthread_mutex_unlock(&quality->_lock);
+
+}
@@ -18,8 +18,10 @@
  */
 
 #include "config.h"
+#include "common/encoder.h"
 #include "common/rect.h"
 #include "common/surface.h"
+#include "common/tile-cache.h"
 
 #include <cairo/cairo.h>
 #include <guacamole/client.h>
@@ -35,6 +37,10 @@
 #include <stdint.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 /**
  * The width of an update which should be considered negible and thus
  * trivial overhead compared ot the cost of two updates.
@@ -79,11 +85,6 @@
 #define cairo_format_stride_for_width(format, width) (width*4)
 #endif
 
-/**
- * The framerate which, if exceeded, indicates that JPEG is preferred.
- */
-#define GUAC_COMMON_SURFACE_JPEG_FRAMERATE 3
-
 /**
  * Minimum JPEG bitmap size (area). If the bitmap is smaller than this threshold,
  * it should be compressed as a PNG image to avoid the JPEG compression tax.
@@ -126,6 +127,24 @@ void guac_common_surface_set_lossless(guac_common_surface* surface,
 
 }
 
+void guac_common_surface_set_tile_cache(guac_common_surface* surface,
+        guac_common_tile_cache* tile_cache) {
+
+    pthread_mutex_lock(&surface->_lock);
+    surface->tile_cache = tile_cache;
+    pthread_mutex_unlock(&surface->_lock);
+
+}
+
+void guac_common_surface_set_quality(guac_common_surface* surface,
+        guac_common_quality* quality) {
+
+    pthread_mutex_lock(&surface->_lock);
+    surface->quality = quality;
+    pthread_mutex_unlock(&surface->_lock);
+
+}
+
 void guac_common_surface_move(guac_common_surface* surface, int x, int y) {
 
     pthread_mutex_lock(&surface->_lock);
@@ -233,54 +252,6 @@ static void __guac_common_clip_rect(guac_common_surface* surface,
 
 }
 
-/**
- * Returns whether a rectangle within the given surface contains only fully
- * opaque pixels.
- *
- * @param surface
- *     The surface to check.
- *
- * @param rect
- *     The rectangle to check.
- *
- * @return
- *     Non-zero if the rectangle contains only fully opaque pixels, zero
- *     otherwise.
- */
-static int __guac_common_surface_is_opaque(guac_common_surface* surface,
-        guac_common_rect* rect) {
-
-    int x, y;
-
-    int stride = surface ->stride;
-    unsigned char* buffer =
-        surface->buffer + (stride * rect->y) + (4 * rect->x);
-
-    /* For each row */
-    for (y = 0; y < rect->height; y++) {
-
-        /* Search for a non-opaque pixel */
-        uint32_t* current = (uint32_t*) buffer;
-        for (x=0; x < rect->width; x++) {
-
-            /* Rectangle is non-opaque if a single non-opaque pixel is found */
-            uint32_t color = *(current++);
-            if ((color & 0xFF000000) != 0xFF000000)
-                return 0;
-
-        }
-
-        /* Next row */
-        buffer += stride;
-
-    }
-
-    /* Rectangle is opaque */
-    return 1;
-
-}
-
-
 /**
  * Returns whether the given rectangle should be combined into the existing
  * dirty rectangle, to be eventually flushed as image data, or would be best
@@ -458,11 +429,126 @@ static unsigned int __guac_common_surface_calculate_framerate(
 
 }
 
- /**
- * Guesses whether a rectangle within a particular surface would be better
- * compressed as PNG or using a lossy format like JPEG. Positive values
- * indicate PNG is likely to be superior, while negative values indicate the
- * opposite.
+/**
+ * The results of analyzing the contents of a rectangle within a surface,
+ * used to choose the format that rectangle should be encoded as.
+ */
+typedef struct guac_common_surface_analysis {
+
+    /**
+     * Non-zero if the rectangle contains only fully opaque pixels, zero
+     * otherwise.
+     */
+    int opaque;
+
+    /**
+     * Non-zero if PNG compression is likely to perform better than lossy
+     * alternatives based on the contents of the rectangle, zero otherwise.
+     * This is only meaningful if the analysis was requested to check
+     * optimality.
+     */
+    int png_optimal;
+
+} guac_common_surface_analysis;
+
+/**
+ * Returns whether all of the given pixels are fully opaque.
+ *
+ * @param row
+ *     The pixels to check.
+ *
+ * @param width
+ *     The number of pixels to check.
+ *
+ * @return
+ *     Non-zero if all given pixels are fully opaque, zero otherwise.
+ */
+static int __guac_common_surface_row_is_opaque(const uint32_t* row,
+        int width) {
+
+    int x = 0;
+
+#ifdef __SSE2__
+    const __m128i alpha = _mm_set1_epi32(0xFF000000);
+
+    /* Check four pixels at a time */
+    for (; x + 4 <= width; x += 4) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*) (row + x));
+        __m128i opaque = _mm_cmpeq_epi32(_mm_and_si128(pixels, alpha), alpha);
+        if (_mm_movemask_epi8(opaque) != 0xFFFF)
+            return 0;
+    }
+#endif
+
+    /* Check any remaining pixels individually */
+    for (; x < width; x++) {
+        if ((row[x] & 0xFF000000) != 0xFF000000)
+            return 0;
+    }
+
+    return 1;
+
+}
+
+/**
+ * Returns the number of pixels within the given row which have the same
+ * color as the pixel immediately preceding them, ignoring alpha. The first
+ * pixel of the row is not counted, as it has no preceding pixel.
+ *
+ * @param row
+ *     The pixels to check.
+ *
+ * @param width
+ *     The number of pixels within the row.
+ *
+ * @return
+ *     The number of pixels within the row, excluding the first, which are
+ *     identical to their preceding pixel.
+ */
+static int __guac_common_surface_row_count_same(const uint32_t* row,
+        int width) {
+
+    int num_same = 0;
+    int x = 1;
+
+#ifdef __SSE2__
+    const __m128i alpha = _mm_set1_epi32(0xFF000000);
+
+    /* Compare four pixels at a time against their predecessors, such that
+     * solid spans are counted without examining each pixel individually */
+    for (; x + 4 <= width; x += 4) {
+
+        __m128i current = _mm_or_si128(alpha,
+                _mm_loadu_si128((const __m128i*) (row + x)));
+
+        __m128i previous = _mm_or_si128(alpha,
+                _mm_loadu_si128((const __m128i*) (row + x - 1)));
+
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(
+                    _mm_cmpeq_epi32(current, previous)));
+
+        num_same += __builtin_popcount(mask);
+
+    }
+#endif
+
+    /* Compare any remaining pixels individually */
+    for (; x < width; x++) {
+        if ((row[x] | 0xFF000000) == (row[x - 1] | 0xFF000000))
+            num_same++;
+    }
+
+    return num_same;
+
+}
+
+/**
+ * Analyzes the contents of a rectangle within the given surface in a single
+ * pass, determining whether the rectangle is opaque and, if requested,
+ * guessing whether the rectangle would be better compressed as PNG or using
+ * a lossy format like JPEG. PNG is guessed to be superior if at least four
+ * of every five pixels match the pixel preceding them. The analysis stops
+ * as soon as all requested results are known.
  *
  * @param surface
  *     The surface containing the image data to check.
@@ -470,18 +556,18 @@ static unsigned int __guac_common_surface_calculate_framerate(
  * @param rect
  *     The rect to check within the given surface.
  *
- * @return
- *     Positive values if PNG compression is likely to perform better than
- *     lossy alternatives, or negative values if PNG is likely to perform
- *     worse.
+ * @param check_optimality
+ *     Non-zero if the analysis should determine whether PNG is likely to be
+ *     superior, zero if only opacity is needed.
+ *
+ * @param analysis
+ *     The analysis structure to populate with the results.
  */
-static int __guac_common_surface_png_optimality(guac_common_surface* surface,
-        const guac_common_rect* rect) {
+static void __guac_common_surface_analyze(guac_common_surface* surface,
+        const guac_common_rect* rect, int check_optimality,
+        guac_common_surface_analysis* analysis) {
 
-    int x, y;
-
-    int num_same = 0;
-    int num_different = 1;
+    int y;
 
     /* Get image/buffer metrics */
     int width = rect->width;
@@ -491,40 +577,59 @@ static int __guac_common_surface_png_optimality(guac_common_surface* surface,
     /* Get buffer from surface */
     unsigned char* buffer = surface->buffer + rect->y * stride + rect->x * 4;
 
+    analysis->opaque = 1;
+    analysis->png_optimal = 1;
+
     /* Image must be at least 1x1 */
     if (width < 1 || height < 1)
-        return 0;
+        return;
+
+    int num_same = 0;
+    int num_different = 1;
+
+    /* The number of pairs of adjacent pixels not yet compared */
+    int remaining = (width - 1) * height;
 
     /* For each row */
     for (y = 0; y < height; y++) {
 
-        uint32_t* row = (uint32_t*) buffer;
-        uint32_t last_pixel = *(row++) | 0xFF000000;
+        const uint32_t* row = (const uint32_t*) buffer;
 
-        /* For each pixel in current row */
-        for (x = 1; x < width; x++) {
+        /* Search for a non-opaque pixel */
+        if (analysis->opaque)
+            analysis->opaque = __guac_common_surface_row_is_opaque(row, width);
 
-            /* Get next pixel */
-            uint32_t current_pixel = *(row++) | 0xFF000000;
+        /* Update same/different counts */
+        if (check_optimality) {
 
-            /* Update same/different counts according to pixel value */
-            if (current_pixel == last_pixel)
-                num_same++;
-            else
-                num_different++;
+            int same = __guac_common_surface_row_count_same(row, width);
+            num_same += same;
+            num_different += width - 1 - same;
+            remaining -= width - 1;
 
-            last_pixel = current_pixel;
+            /* PNG is optimal even if all remaining pixels differ */
+            if (num_same >= 4 * (num_different + remaining)) {
+                analysis->png_optimal = 1;
+                check_optimality = 0;
+            }
+
+            /* PNG is not optimal even if all remaining pixels are the same */
+            else if (num_same + remaining < 4 * num_different) {
+                analysis->png_optimal = 0;
+                check_optimality = 0;
+            }
 
         }
 
+        /* Stop once nothing remains to be determined */
+        if (!analysis->opaque && !check_optimality)
+            break;
+
         /* Advance to next row */
         buffer += stride;
 
     }
 
-    /* Return rough approximation of optimality for PNG compression */
-    return 0x100 * num_same / num_different - 0x400;
-
 }
 
 /**
@@ -537,29 +642,36 @@ static int __guac_common_surface_png_optimality(guac_common_surface* surface,
  * @param rect
  *     The rectangle to check.
  *
+ * @param framerate
+ *     The average framerate of updates to the given rectangle, as returned
+ *     by __guac_common_surface_calculate_framerate().
+ *
+ * @param analysis
+ *     The analysis of the contents of the given rectangle, which must have
+ *     checked optimality if the framerate is at least the lossy framerate
+ *     decided for the current flush.
+ *
  * @return
  *     Non-zero if the rectangle would be optimally encoded as JPEG, zero
  *     otherwise.
  */
 static int __guac_common_surface_should_use_jpeg(guac_common_surface* surface,
-        const guac_common_rect* rect) {
+        const guac_common_rect* rect, int framerate,
+        const guac_common_surface_analysis* analysis) {
 
     /* Do not use JPEG if lossless quality is required */
     if (surface->lossless)
         return 0;
 
-    /* Calculate the average framerate for the given rect */
-    int framerate = __guac_common_surface_calculate_framerate(surface, rect);
-
     int rect_size = rect->width * rect->height;
 
     /* JPEG is preferred if:
      * - frame rate is high enough
      * - image size is large enough
      * - PNG is not more optimal based on image contents */
-    return framerate >= GUAC_COMMON_SURFACE_JPEG_FRAMERATE
+    return framerate >= surface->quality_decision.lossy_framerate
         && rect_size > GUAC_SURFACE_JPEG_MIN_BITMAP_SIZE
-        && __guac_common_surface_png_optimality(surface, rect) < 0;
+        && !analysis->png_optimal;
 
 }
 
@@ -573,25 +685,34 @@ static int __guac_common_surface_should_use_jpeg(guac_common_surface* surface,
  * @param rect
  *     The rectangle to check.
  *
+ * @param framerate
+ *     The average framerate of updates to the given rectangle, as returned
+ *     by __guac_common_surface_calculate_framerate().
+ *
+ * @param analysis
+ *     The analysis of the contents of the given rectangle, which must have
+ *     checked optimality if the framerate is at least the lossy framerate
+ *     decided for the current flush.
+ *
  * @return
  *     Non-zero if the rectangle would be optimally encoded as WebP, zero
  *     otherwise.
  */
 static int __guac_common_surface_should_use_webp(guac_common_surface* surface,
-        const guac_common_rect* rect) {
+        const guac_common_rect* rect, int framerate,
+        const guac_common_surface_analysis* analysis) {
 
-    /* Do not use WebP if not supported */
-    if (!guac_client_supports_webp(surface->client))
+    /* Do not use WebP if not supported, or if encoding has been determined
+     * to be too costly */
+    if (!surface->quality_decision.webp
+            || !guac_client_supports_webp(surface->client))
         return 0;
 
-    /* Calculate the average framerate for the given rect */
-    int framerate = __guac_common_surface_calculate_framerate(surface, rect);
-
     /* WebP is preferred if:
      * - frame rate is high enough
      * - PNG is not more optimal based on image contents */
-    return framerate >= GUAC_COMMON_SURFACE_JPEG_FRAMERATE
-        && __guac_common_surface_png_optimality(surface, rect) < 0;
+    return framerate >= surface->quality_decision.lossy_framerate
+        && !analysis->png_optimal;
 
 }
 
@@ -1070,6 +1191,8 @@ static void __guac_common_surface_put(unsigned char* src_buffer, int src_stride,
  *
  * @param src_buffer The buffer to use as a mask.
  * @param src_stride The number of bytes in each row of the source buffer.
+ * @param src_format The format of the source buffer, which must be either
+ *                   CAIRO_FORMAT_ARGB32 or CAIRO_FORMAT_A8.
  * @param sx The X coordinate of the source rectangle.
  * @param sy The Y coordinate of the source rectangle.
  * @param dst The destination surface.
@@ -1079,6 +1202,7 @@ static void __guac_common_surface_put(unsigned char* src_buffer, int src_stride,
  * @param blue The blue component of the color of the fill.
  */
 static void __guac_common_surface_fill_mask(unsigned char* src_buffer, int src_stride,
+                                            cairo_format_t src_format,
                                             int sx, int sy,
                                             guac_common_surface* dst, guac_common_rect* rect,
                                             int red, int green, int blue) {
@@ -1089,6 +1213,39 @@ static void __guac_common_surface_fill_mask(unsigned char* src_buffer, int src_s
     uint32_t color = 0xFF000000 | (red << 16) | (green << 8) | blue;
     int x, y;
 
+    /* Masks consisting only of alpha require one byte per pixel */
+    if (src_format == CAIRO_FORMAT_A8) {
+
+        src_buffer += src_stride*sy + sx;
+        dst_buffer += (dst_stride * rect->y) + (4 * rect->x);
+
+        /* For each row */
+        for (y=0; y < rect->height; y++) {
+
+            unsigned char* src_current = src_buffer;
+            uint32_t* dst_current = (uint32_t*) dst_buffer;
+
+            /* Stencil row */
+            for (x=0; x < rect->width; x++) {
+
+                /* Fill with color if opaque */
+                if (*src_current)
+                    *dst_current = color;
+
+                src_current++;
+                dst_current++;
+            }
+
+            /* Next row */
+            src_buffer += src_stride;
+            dst_buffer += dst_stride;
+
+        }
+
+        return;
+
+    }
+
     src_buffer += src_stride*sy + 4*sx;
     dst_buffer += (dst_stride * rect->y) + (4 * rect->x);
 
@@ -1407,7 +1564,9 @@ void guac_common_surface_paint(guac_common_surface* surface, int x, int y,
         goto complete;
 
     /* Update backing surface */
-    __guac_common_surface_fill_mask(buffer, stride, sx, sy, surface, &rect, red, green, blue);
+    __guac_common_surface_fill_mask(buffer, stride,
+            cairo_image_surface_get_format(src), sx, sy, surface, &rect,
+            red, green, blue);
 
     /* Flush if not combining */
     if (!__guac_common_should_combine(surface, &rect, 0))
@@ -1629,6 +1788,69 @@ void guac_common_surface_reset_clip(guac_common_surface* surface) {
     pthread_mutex_unlock(&surface->_lock);
 }
 
+/**
+ * Streams the given image to the upper-left corner of the dirty rectangle of
+ * the given surface using the given format. If the surface is currently
+ * being flushed with the help of an encoder, the image may be encoded by
+ * another thread, and the resulting instructions will be sent once the
+ * encoder is flushed. Otherwise, the image is encoded and sent immediately.
+ *
+ * @param surface
+ *     The surface being flushed.
+ *
+ * @param format
+ *     The format to encode the image as.
+ *
+ * @param rect
+ *     The image to stream, which MUST refer to data within the surface's
+ *     buffer.
+ *
+ * @param quality
+ *     The JPEG or WebP image quality, which must be an integer value between
+ *     0 and 100 inclusive. This is ignored for PNG.
+ *
+ * @param lossless
+ *     Zero if WebP lossy compression should be used, non-zero if lossless
+ *     compression should be used. This is ignored for formats other than
+ *     WebP.
+ */
+static void __guac_common_surface_stream(guac_common_surface* surface,
+        guac_common_encoder_format format, cairo_surface_t* rect,
+        int quality, int lossless) {
+
+    guac_socket* socket = surface->socket;
+    const guac_layer* layer = surface->layer;
+    int x = surface->dirty_rect.x;
+    int y = surface->dirty_rect.y;
+
+    /* Defer to encoder if flushing in parallel */
+    if (surface->encoder != NULL) {
+        guac_common_encoder_stream(surface->encoder, format, GUAC_COMP_OVER,
+                layer, x, y, rect, quality, lossless);
+        return;
+    }
+
+    switch (format) {
+
+        case GUAC_COMMON_ENCODER_PNG:
+            guac_client_stream_png(surface->client, socket, GUAC_COMP_OVER,
+                    layer, x, y, rect);
+            break;
+
+        case GUAC_COMMON_ENCODER_JPEG:
+            guac_client_stream_jpeg(surface->client, socket, GUAC_COMP_OVER,
+                    layer, x, y, rect, quality);
+            break;
+
+        case GUAC_COMMON_ENCODER_WEBP:
+            guac_client_stream_webp(surface->client, socket, GUAC_COMP_OVER,
+                    layer, x, y, rect, quality, lossless);
+            break;
+
+    }
+
+}
+
 /**
  * Flushes the bitmap update currently described by the dirty rectangle within
  * the given surface directly via an "img" instruction as PNG data. The
@@ -1679,10 +1901,25 @@ static void __guac_common_surface_flush_to_png(guac_common_surface* surface,
         }
 
         /* Send PNG for rect */
-        guac_client_stream_png(surface->client, socket, GUAC_COMP_OVER,
-                layer, surface->dirty_rect.x, surface->dirty_rect.y, rect);
+        __guac_common_surface_stream(surface, GUAC_COMMON_ENCODER_PNG,
+                rect, 0, 0);
 
         cairo_surface_destroy(rect);
+
+        /* Retain rect for reuse if it is being sent repeatedly */
+        if (surface->tile_cache != NULL) {
+
+            rect = cairo_image_surface_create_for_data(buffer,
+                    CAIRO_FORMAT_ARGB32, surface->dirty_rect.width,
+                    surface->dirty_rect.height, surface->stride);
+
+            guac_common_tile_cache_store(surface->tile_cache, socket, layer,
+                    surface->dirty_rect.x, surface->dirty_rect.y, rect);
+
+            cairo_surface_destroy(rect);
+
+        }
+
         surface->realized = 1;
 
         /* Surface is no longer dirty */
@@ -1693,32 +1930,85 @@ static void __guac_common_surface_flush_to_png(guac_common_surface* surface,
 }
 
 /**
- * Returns an appropriate quality between 0 and 100 for lossy encoding
- * depending on the current processing lag calculated for the given client.
+ * Flushes the bitmap update currently described by the dirty rectangle within
+ * the given surface as a "copy" instruction from an off-screen buffer, if the
+ * contents of the dirty rectangle were previously sent and are still retained
+ * within the surface's tile cache. If the surface has no tile cache, or the
+ * contents of the dirty rectangle are not cached, nothing is sent.
  *
- * @param client
- *     The client for which the lossy quality is being calculated.
+ * @param surface
+ *     The surface to flush.
  *
  * @return
- *     A value between 0 and 100 inclusive which seems appropriate for the
- *     client based on lag measurements.
+ *     Non-zero if the dirty rectangle was flushed from the tile cache, zero
+ *     if the dirty rectangle must be flushed by other means.
  */
-static int guac_common_surface_suggest_quality(guac_client* client) {
+static int __guac_common_surface_flush_from_cache(
+        guac_common_surface* surface) {
+
+    if (surface->tile_cache == NULL)
+        return 0;
+
+    /* Get Cairo surface for specified rect */
+    unsigned char* buffer = surface->buffer
+                          + surface->dirty_rect.y * surface->stride
+                          + surface->dirty_rect.x * 4;
+
+    cairo_surface_t* rect = cairo_image_surface_create_for_data(buffer,
+            CAIRO_FORMAT_ARGB32, surface->dirty_rect.width,
+            surface->dirty_rect.height, surface->stride);
+
+    int copied = guac_common_tile_cache_copy(surface->tile_cache,
+            surface->socket, surface->layer,
+            surface->dirty_rect.x, surface->dirty_rect.y, rect);
+
+    cairo_surface_destroy(rect);
 
-    int lag = guac_client_get_processing_lag(client);
+    if (copied) {
+        surface->realized = 1;
+        surface->dirty = 0;
+    }
+
+    return copied;
+
+}
+
+/**
+ * Decides the quality and format of lossy images sent during the flush about
+ * to begin, storing the decision within the quality_decision member of the
+ * given surface. If the surface has a quality controller, its decision is
+ * used. Otherwise, quality is based on the current processing lag alone.
+ *
+ * @param surface
+ *     The surface about to be flushed.
+ */
+static void __guac_common_surface_decide_quality(
+        guac_common_surface* surface) {
+
+    guac_common_quality_decision* decision = &surface->quality_decision;
+
+    if (surface->quality != NULL) {
+        guac_common_quality_get_decision(surface->quality, decision);
+        return;
+    }
+
+    int lag = guac_client_get_processing_lag(surface->client);
 
     /* Scale quality linearly from 90 to 30 as lag varies from 20ms to 80ms */
     int quality = 90 - (lag - 20);
 
     /* Do not exceed 90 for quality */
-    if (quality > 90)
-        return 90;
+    if (quality > GUAC_COMMON_QUALITY_MAX)
+        quality = GUAC_COMMON_QUALITY_MAX;
 
     /* Do not go below 30 for quality */
-    if (quality < 30)
-        return 30;
+    else if (quality < GUAC_COMMON_QUALITY_MIN)
+        quality = GUAC_COMMON_QUALITY_MIN;
 
-    return quality;
+    decision->quality = quality;
+    decision->lossy_framerate = GUAC_COMMON_QUALITY_LOSSY_FRAMERATE;
+    decision->webp = 1;
+    decision->frame_delay = lag;
 
 }
 
@@ -1735,9 +2025,6 @@ static void __guac_common_surface_flush_to_jpeg(guac_common_surface* surface) {
 
     if (surface->dirty) {
 
-        guac_socket* socket = surface->socket;
-        const guac_layer* layer = surface->layer;
-
         guac_common_rect max;
         guac_common_rect_init(&max, 0, 0, surface->width, surface->height);
 
@@ -1756,9 +2043,8 @@ static void __guac_common_surface_flush_to_jpeg(guac_common_surface* surface) {
                 surface->dirty_rect.height, surface->stride);
 
         /* Send JPEG for rect */
-        guac_client_stream_jpeg(surface->client, socket, GUAC_COMP_OVER, layer,
-                surface->dirty_rect.x, surface->dirty_rect.y, rect,
-                guac_common_surface_suggest_quality(surface->client));
+        __guac_common_surface_stream(surface, GUAC_COMMON_ENCODER_JPEG, rect,
+                surface->quality_decision.quality, 0);
 
         cairo_surface_destroy(rect);
         surface->realized = 1;
@@ -1787,9 +2073,6 @@ static void __guac_common_surface_flush_to_webp(guac_common_surface* surface,
 
     if (surface->dirty) {
 
-        guac_socket* socket = surface->socket;
-        const guac_layer* layer = surface->layer;
-
         guac_common_rect max;
         guac_common_rect_init(&max, 0, 0, surface->width, surface->height);
 
@@ -1818,9 +2101,8 @@ static void __guac_common_surface_flush_to_webp(guac_common_surface* surface,
                     surface->dirty_rect.height, surface->stride);
 
         /* Send WebP for rect */
-        guac_client_stream_webp(surface->client, socket, GUAC_COMP_OVER, layer,
-                surface->dirty_rect.x, surface->dirty_rect.y, rect,
-                guac_common_surface_suggest_quality(surface->client),
+        __guac_common_surface_stream(surface, GUAC_COMMON_ENCODER_WEBP, rect,
+                surface->quality_decision.quality,
                 surface->lossless ? 1 : 0);
 
         cairo_surface_destroy(rect);
@@ -1893,6 +2175,17 @@ static void __guac_common_surface_flush(guac_common_surface* surface) {
     /* Flush final dirty rectangle to queue. */
     __guac_common_surface_flush_to_queue(surface);
 
+    /* Treat all images within this flush consistently */
+    __guac_common_surface_decide_quality(surface);
+
+    /* Encode images in parallel if more than one may need to be sent, with
+     * all instructions buffered such that their order is preserved */
+    guac_socket* socket = surface->socket;
+    if (surface->bitmap_queue_length > 1 && guac_common_encoder_threads() > 0) {
+        surface->encoder = guac_common_encoder_alloc(surface->client, socket);
+        surface->socket = surface->encoder->buffered_socket;
+    }
+
     guac_common_surface_bitmap_rect* current = surface->bitmap_queue;
     int i, j;
     int original_queue_length;
@@ -1946,22 +2239,38 @@ static void __guac_common_surface_flush(guac_common_surface* surface) {
 
                 flushed++;
 
-                int opaque = __guac_common_surface_is_opaque(surface,
-                            &surface->dirty_rect);
+                /* Reuse previously-sent image data if possible */
+                if (!__guac_common_surface_flush_from_cache(surface)) {
+
+                    int framerate = __guac_common_surface_calculate_framerate(
+                                surface, &surface->dirty_rect);
 
-                /* Prefer WebP when reasonable */
-                if (__guac_common_surface_should_use_webp(surface,
-                            &surface->dirty_rect))
-                    __guac_common_surface_flush_to_webp(surface, opaque);
+                    /* Analyze image contents only if a lossy format may be
+                     * chosen, in a single pass */
+                    guac_common_surface_analysis analysis;
+                    __guac_common_surface_analyze(surface, &surface->dirty_rect,
+                            framerate
+                                >= surface->quality_decision.lossy_framerate,
+                            &analysis);
 
-                /* If not WebP, JPEG is the next best (lossy) choice */
-                else if (opaque && __guac_common_surface_should_use_jpeg(
-                            surface, &surface->dirty_rect))
-                    __guac_common_surface_flush_to_jpeg(surface);
+                    int opaque = analysis.opaque;
 
-                /* Use PNG if no lossy formats are appropriate */
-                else
-                    __guac_common_surface_flush_to_png(surface, opaque);
+                    /* Prefer WebP when reasonable */
+                    if (__guac_common_surface_should_use_webp(surface,
+                                &surface->dirty_rect, framerate, &analysis))
+                        __guac_common_surface_flush_to_webp(surface, opaque);
+
+                    /* If not WebP, JPEG is the next best (lossy) choice */
+                    else if (opaque && __guac_common_surface_should_use_jpeg(
+                                surface, &surface->dirty_rect, framerate,
+                                &analysis))
+                        __guac_common_surface_flush_to_jpeg(surface);
+
+                    /* Use PNG if no lossy formats are appropriate */
+                    else
+                        __guac_common_surface_flush_to_png(surface, opaque);
+
+                }
 
             }
 
@@ -1971,6 +2280,13 @@ static void __guac_common_surface_flush(guac_common_surface* surface) {
 
     }
 
+    /* Send all buffered instructions once all images are encoded */
+    if (surface->encoder != NULL) {
+        guac_common_encoder_free(surface->encoder);
+        surface->encoder = NULL;
+        surface->socket = socket;
+    }
+
     /* Flush complete */
     surface->bitmap_queue_length = 0;
 
@@ -0,0 +1,195 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/cursor.h"
+
+#include <CUnit/CUnit.h>
+#include <guacamole/client.h>
+#include <guacamole/socket.h>
+#include <guacamole/timestamp.h>
+#include <guacamole/user.h>
+
+#include <pthread.h>
+#include <string.h>
+#include <sys/types.h>
+
+/**
+ * The maximum amount of time to wait for pending users to be promoted, in
+ * milliseconds.
+ */
+#define TEST_PROMOTION_TIMEOUT 5000
+
+/**
+ * The update interval set on the cursor under test, in milliseconds.
+ */
+#define TEST_UPDATE_INTERVAL 200
+
+/**
+ * The opcode of the instruction sent for each cursor update, as it appears
+ * within the Guacamole protocol.
+ */
+#define TEST_MOUSE_OPCODE "5.mouse,"
+
+/**
+ * Lock guarding the mouse instruction counts of all test sockets.
+ */
+static pthread_mutex_t test_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Socket write handler which counts the mouse instructions written to the
+ * socket, storing the count within the int pointed to by the socket data.
+ * Each instruction is assumed to be written in full by a single write.
+ */
+static ssize_t test_write_handler(guac_socket* socket,
+        const void* buf, size_t count) {
+
+    const char* data = (const char*) buf;
+    size_t length = strlen(TEST_MOUSE_OPCODE);
+
+    pthread_mutex_lock(&test_lock);
+
+    for (size_t i = 0; i + length <= count; i++) {
+        if (memcmp(data + i, TEST_MOUSE_OPCODE, length) == 0)
+            (*((int*) socket->data))++;
+    }
+
+    pthread_mutex_unlock(&test_lock);
+
+    return count;
+
+}
+
+/**
+ * Returns the number of mouse instructions written to the socket of the
+ * given user so far.
+ */
+static int test_mouse_count(guac_user* user) {
+
+    pthread_mutex_lock(&test_lock);
+    int count = *((int*) user->socket->data);
+    pthread_mutex_unlock(&test_lock);
+
+    return count;
+
+}
+
+/**
+ * Allocates a new user of the given client with a socket which counts the
+ * mouse instructions written to it within the given int.
+ */
+static guac_user* test_user_alloc(guac_client* client, int* count,
+        int owner) {
+
+    guac_user* user = guac_user_alloc();
+    user->client = client;
+    user->owner = owner;
+
+    user->socket = guac_socket_alloc();
+    user->socket->data = count;
+    user->socket->write_handler = test_write_handler;
+
+    return user;
+
+}
+
+/**
+ * Frees a user allocated with test_user_alloc().
+ */
+static void test_user_free(guac_user* user) {
+    guac_socket_free(user->socket);
+    guac_user_free(user);
+}
+
+/**
+ * Waits for the given number of users to be promoted from pending users to
+ * full users of the given client.
+ */
+static void test_wait_for_users(guac_client* client, int users) {
+
+    guac_client_capabilities capabilities;
+    guac_timestamp start = guac_timestamp_current();
+
+    guac_client_get_capabilities(client, &capabilities);
+    while (capabilities.users != users
+            && guac_timestamp_current() - start < TEST_PROMOTION_TIMEOUT) {
+        guac_timestamp_msleep(10);
+        guac_client_get_capabilities(client, &capabilities);
+    }
+
+}
+
+/**
+ * Test which verifies that changes to the shared cursor reach users other
+ * than the user moving the cursor within a bounded delay even if no frame
+ * follows, and that the update interval of the cursor limits how often those
+ * users receive changes without losing the latest state.
+ */
+void test_cursor__update() {
+
+    int owner_count = 0;
+    int viewer_count = 0;
+
+    guac_client* client = guac_client_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(client);
+
+    guac_user* owner = test_user_alloc(client, &owner_count, 1);
+    guac_user* viewer = test_user_alloc(client, &viewer_count, 0);
+
+    CU_ASSERT_EQUAL_FATAL(guac_client_add_user(client, owner, 0, NULL), 0);
+    CU_ASSERT_EQUAL_FATAL(guac_client_add_user(client, viewer, 0, NULL), 0);
+    test_wait_for_users(client, 2);
+
+    guac_common_cursor* cursor = guac_common_cursor_alloc(client);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(cursor);
+
+    /* A change that is not followed by a frame is still sent, but only to
+     * the users not moving the cursor */
+    guac_common_cursor_update(cursor, owner, 10, 10, 0);
+    guac_timestamp_msleep(GUAC_COMMON_CURSOR_MAX_DELAY * 10);
+    CU_ASSERT_EQUAL(test_mouse_count(viewer), 1);
+    CU_ASSERT_EQUAL(test_mouse_count(owner), 0);
+
+    /* Changes flushed with frames within the update interval are combined */
+    guac_common_cursor_set_update_interval(cursor, TEST_UPDATE_INTERVAL);
+    for (int i = 0; i < 10; i++) {
+        guac_common_cursor_update(cursor, owner, 20 + i, 20, 0);
+        guac_common_cursor_flush(cursor);
+        guac_socket_flush(viewer->socket);
+        guac_timestamp_msleep(10);
+    }
+
+    CU_ASSERT_EQUAL(test_mouse_count(viewer), 2);
+    CU_ASSERT_EQUAL(cursor->x, 29);
+
+    /* The latest change is sent once the update interval elapses, even
+     * without a further frame */
+    guac_timestamp_msleep(TEST_UPDATE_INTERVAL * 2);
+    CU_ASSERT_EQUAL(test_mouse_count(viewer), 3);
+    CU_ASSERT_EQUAL(test_mouse_count(owner), 0);
+
+    guac_common_cursor_free(cursor);
+
+    guac_client_remove_user(client, viewer);
+    guac_client_remove_user(client, owner);
+    guac_client_free(client);
+
+    test_user_free(viewer);
+    test_user_free(owner);
+
+}
@@ -0,0 +1,135 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/download.h"
+
+#include <CUnit/CUnit.h>
+#include <guacamole/client.h>
+#include <guacamole/protocol.h>
+#include <guacamole/socket.h>
+#include <guacamole/stream.h>
+#include <guacamole/user.h>
+
+/**
+ * The number of bytes within the test file. This is deliberately not a
+ * multiple of the maximum blob size.
+ */
+#define TEST_FILE_SIZE 100000
+
+/**
+ * The number of blobs which may be in flight during the test.
+ */
+#define TEST_WINDOW 4
+
+/**
+ * The state of the simulated file being downloaded.
+ */
+typedef struct test_file {
+
+    /**
+     * The number of bytes remaining to be read.
+     */
+    int remaining;
+
+    /**
+     * Whether the file has been closed.
+     */
+    int closed;
+
+} test_file;
+
+/**
+ * Read handler which reads zeroes from a test_file until no bytes remain.
+ */
+static int test_read_handler(void* data, char* buffer, int length) {
+
+    test_file* file = (test_file*) data;
+
+    if (length > file->remaining)
+        length = file->remaining;
+
+    for (int i = 0; i < length; i++)
+        buffer[i] = 0;
+
+    file->remaining -= length;
+    return length;
+
+}
+
+/**
+ * Close handler which marks a test_file as closed.
+ */
+static void test_close_handler(void* data) {
+    ((test_file*) data)->closed = 1;
+}
+
+/**
+ * Verifies that guac_common_download keeps no more than the configured
+ * number of blobs in flight, sends the entire file, and ends the stream only
+ * once every blob has been acknowledged.
+ */
+void test_download__window() {
+
+    guac_client* client = guac_client_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(client);
+
+    guac_user* user = guac_user_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(user);
+    user->client = client;
+
+    /* Instructions sent by the download are simply discarded */
+    user->socket = guac_socket_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(user->socket);
+
+    test_file file = { .remaining = TEST_FILE_SIZE, .closed = 0 };
+
+    guac_stream* stream = guac_user_alloc_stream(user);
+    guac_common_download_begin(stream, test_read_handler, test_close_handler,
+            &file, TEST_WINDOW);
+
+    guac_common_download* download = (guac_common_download*) stream->data;
+    CU_ASSERT_EQUAL(download->in_flight, 1);
+
+    /* Acknowledging the start of the stream fills the window */
+    stream->ack_handler(user, stream, "OK", GUAC_PROTOCOL_STATUS_SUCCESS);
+    CU_ASSERT_EQUAL(download->in_flight, TEST_WINDOW);
+    CU_ASSERT_EQUAL(download->bytes_sent,
+            TEST_WINDOW * GUAC_PROTOCOL_BLOB_MAX_LENGTH);
+
+    /* Each ack allows exactly one more blob to be sent */
+    stream->ack_handler(user, stream, "OK", GUAC_PROTOCOL_STATUS_SUCCESS);
+    CU_ASSERT_EQUAL(download->in_flight, TEST_WINDOW);
+
+    /* Acknowledge blobs until the stream has ended */
+    int acks = 0;
+    while (stream->index != GUAC_USER_CLOSED_STREAM_INDEX) {
+        CU_ASSERT_FALSE_FATAL(file.closed);
+        CU_ASSERT_FATAL(acks < TEST_FILE_SIZE);
+        acks++;
+        stream->ack_handler(user, stream, "OK", GUAC_PROTOCOL_STATUS_SUCCESS);
+    }
+
+    CU_ASSERT_TRUE(file.closed);
+    CU_ASSERT_EQUAL(file.remaining, 0);
+
+    guac_socket_free(user->socket);
+    guac_user_free(user);
+    guac_client_free(client);
+
+}
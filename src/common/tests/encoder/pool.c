@@ -0,0 +1,56 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "common/encoder.h"
+
+#include <CUnit/CUnit.h>
+
+/**
+ * Verifies that the worker threads of the encoder pool run only while a
+ * reference to the pool is held, and that they are stopped once the last
+ * reference is released, such that the pool can be started again.
+ */
+void test_encoder__pool() {
+
+    /* No workers run until the pool is acquired */
+    CU_ASSERT_EQUAL(guac_common_encoder_threads(), 0);
+
+    guac_common_encoder_pool_acquire();
+    int threads = guac_common_encoder_threads();
+    CU_ASSERT(threads >= 0);
+    CU_ASSERT(threads <= GUAC_COMMON_ENCODER_MAX_THREADS);
+
+    /* Additional references share the same workers */
+    guac_common_encoder_pool_acquire();
+    CU_ASSERT_EQUAL(guac_common_encoder_threads(), threads);
+
+    guac_common_encoder_pool_release();
+    CU_ASSERT_EQUAL(guac_common_encoder_threads(), threads);
+
+    /* Workers are stopped once the last reference is released */
+    guac_common_encoder_pool_release();
+    CU_ASSERT_EQUAL(guac_common_encoder_threads(), 0);
+
+    /* The pool can be started again after being stopped */
+    guac_common_encoder_pool_acquire();
+    CU_ASSERT_EQUAL(guac_common_encoder_threads(), threads);
+
+    guac_common_encoder_pool_release();
+    CU_ASSERT_EQUAL(guac_common_encoder_threads(), 0);
+
+}
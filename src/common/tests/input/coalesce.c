@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/input.h"
+
+#include <CUnit/CUnit.h>
+#include <guacamole/client.h>
+#include <guacamole/timestamp.h>
+
+/**
+ * The maximum number of forwarded events recorded by the test handler.
+ */
+#define TEST_MAX_EVENTS 1024
+
+/**
+ * All events forwarded by the input coalescer under test, in order.
+ */
+static guac_common_input_event test_events[TEST_MAX_EVENTS];
+
+/**
+ * The number of events within test_events.
+ */
+static int test_event_count;
+
+/**
+ * Handler which records each forwarded event within test_events.
+ */
+static void test_handler(const guac_common_input_event* event, void* data) {
+    if (test_event_count < TEST_MAX_EVENTS)
+        test_events[test_event_count++] = *event;
+}
+
+/**
+ * Returns the most recently forwarded event, acquiring the lock of the given
+ * input coalescer such that events forwarded by its thread are visible.
+ */
+static guac_common_input_event test_last_event(guac_common_input* input) {
+
+    pthread_mutex_lock(&input->lock);
+    guac_common_input_event event = test_events[test_event_count - 1];
+    pthread_mutex_unlock(&input->lock);
+
+    return event;
+
+}
+
+/**
+ * Test which verifies that motion-only mouse and touch events are combined
+ * while button changes and the start and end of touches are all forwarded
+ * in order, and that the final position of combined motion is always
+ * forwarded.
+ */
+void test_input__coalesce() {
+
+    guac_client* client = guac_client_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(client);
+
+    guac_common_input* input = guac_common_input_alloc(client,
+            test_handler, NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(input);
+
+    /* Move mouse rapidly, then press a button */
+    for (int i = 0; i < 100; i++)
+        guac_common_input_mouse(input, i, i, 0);
+    guac_common_input_mouse(input, 100, 100, 1);
+
+    /* Motion is combined, but the final position before the button change
+     * is forwarded prior to the button change itself */
+    guac_common_input_flush(input);
+    CU_ASSERT_FATAL(test_event_count >= 3);
+    CU_ASSERT(test_event_count < 101);
+    CU_ASSERT_EQUAL(test_events[0].x, 0);
+    CU_ASSERT_EQUAL(test_events[test_event_count - 2].x, 99);
+    CU_ASSERT_EQUAL(test_events[test_event_count - 2].mask, 0);
+    CU_ASSERT_EQUAL(test_events[test_event_count - 1].x, 100);
+    CU_ASSERT_EQUAL(test_events[test_event_count - 1].mask, 1);
+
+    /* Button release and press are never combined */
+    int count = test_event_count;
+    guac_common_input_mouse(input, 100, 100, 0);
+    guac_common_input_mouse(input, 100, 100, 1);
+    guac_common_input_mouse(input, 100, 100, 0);
+    CU_ASSERT_EQUAL(test_event_count, count + 3);
+
+    /* The final position of combined motion is eventually forwarded without
+     * any further events */
+    for (int i = 0; i < 100; i++)
+        guac_common_input_mouse(input, 200 + i, 200, 0);
+    guac_timestamp_msleep(GUAC_COMMON_INPUT_MOTION_INTERVAL * 10);
+    CU_ASSERT_EQUAL(test_last_event(input).x, 299);
+
+    /* Touch motion is combined, with the end of the touch forwarded after
+     * its final position */
+    guac_common_input_touch(input, 5, 10, 10, 1, 1, 0, 1.0);
+    CU_ASSERT_EQUAL(test_last_event(input).type, GUAC_COMMON_INPUT_EVENT_TOUCH);
+    CU_ASSERT_EQUAL(test_last_event(input).id, 5);
+
+    for (int i = 0; i < 100; i++)
+        guac_common_input_touch(input, 5, 10 + i, 10, 1, 1, 0, 1.0);
+    guac_common_input_touch(input, 5, 110, 10, 1, 1, 0, 0.0);
+
+    guac_common_input_flush(input);
+    CU_ASSERT_EQUAL(test_events[test_event_count - 2].x, 109);
+    CU_ASSERT_EQUAL(test_events[test_event_count - 2].force, 1.0);
+    CU_ASSERT_EQUAL(test_events[test_event_count - 1].x, 110);
+    CU_ASSERT_EQUAL(test_events[test_event_count - 1].force, 0.0);
+
+    /* All received events are counted */
+    CU_ASSERT_EQUAL(input->received, 101 + 3 + 100 + 1 + 100 + 1);
+    CU_ASSERT_EQUAL(input->forwarded, test_event_count);
+    CU_ASSERT(input->forwarded < input->received);
+
+    guac_common_input_free(input);
+    guac_client_free(client);
+
+}
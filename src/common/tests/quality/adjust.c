@@ -0,0 +1,107 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/quality.h"
+
+#include <CUnit/CUnit.h>
+#include <guacamole/client.h>
+
+/**
+ * The maximum number of frames that the quality controller is given to
+ * recover from congestion before the test fails.
+ */
+#define TEST_MAX_FRAMES 1000
+
+/**
+ * Verifies that the quality controller backs off when frames are too costly
+ * to encode, does not recover while encoding remains within the hysteresis
+ * band, and recovers fully once frames become cheap again.
+ */
+void test_quality__adjust() {
+
+    guac_client* client = guac_client_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(client);
+
+    guac_common_quality* quality = guac_common_quality_alloc(client);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(quality);
+
+    guac_common_quality_decision decision;
+
+    /* No congestion is assumed initially */
+    guac_common_quality_get_decision(quality, &decision);
+    CU_ASSERT_EQUAL(decision.quality, GUAC_COMMON_QUALITY_MAX);
+    CU_ASSERT_EQUAL(decision.lossy_framerate,
+            GUAC_COMMON_QUALITY_LOSSY_FRAMERATE);
+    CU_ASSERT_TRUE(decision.webp);
+    CU_ASSERT_EQUAL(decision.frame_delay, 0);
+
+    /* A frame far exceeding the encoding budget causes an immediate back-off,
+     * including avoiding the more expensive WebP encoder */
+    guac_common_quality_update(quality, GUAC_COMMON_QUALITY_ENCODE_BUDGET * 2);
+    guac_common_quality_get_decision(quality, &decision);
+    CU_ASSERT(decision.quality < GUAC_COMMON_QUALITY_MAX);
+    CU_ASSERT(decision.quality >= GUAC_COMMON_QUALITY_MIN);
+    CU_ASSERT_EQUAL(decision.lossy_framerate,
+            GUAC_COMMON_QUALITY_CONGESTED_LOSSY_FRAMERATE);
+    CU_ASSERT_FALSE(decision.webp);
+    CU_ASSERT_EQUAL(decision.frame_delay,
+            GUAC_COMMON_QUALITY_ENCODE_BUDGET * 2);
+
+    /* Further adjustments are not made until the adjustment interval has
+     * elapsed */
+    int backed_off = decision.quality;
+    guac_common_quality_update(quality, GUAC_COMMON_QUALITY_ENCODE_BUDGET * 2);
+    guac_common_quality_get_decision(quality, &decision);
+    CU_ASSERT_EQUAL(decision.quality, backed_off);
+
+    /* Feed cheap frames, pretending the adjustment interval has always
+     * elapsed, until quality is fully restored */
+    int frames = 0;
+    int previous_quality = decision.quality;
+    while (decision.quality < GUAC_COMMON_QUALITY_MAX) {
+
+        CU_ASSERT_FATAL(frames < TEST_MAX_FRAMES);
+
+        quality->last_adjustment = 0;
+        guac_common_quality_update(quality, 0);
+        guac_common_quality_get_decision(quality, &decision);
+
+        /* Recovery must wait until the smoothed encoding time is well below
+         * budget */
+        if (decision.quality > previous_quality)
+            CU_ASSERT(quality->encode_time
+                    <= GUAC_COMMON_QUALITY_ENCODE_BUDGET / 2);
+
+        previous_quality = decision.quality;
+        frames++;
+
+    }
+
+    /* All decisions are restored once recovered */
+    CU_ASSERT_EQUAL(decision.lossy_framerate,
+            GUAC_COMMON_QUALITY_LOSSY_FRAMERATE);
+    CU_ASSERT_TRUE(decision.webp);
+    CU_ASSERT_EQUAL(decision.frame_delay, 0);
+    CU_ASSERT(quality->decreases >= 1);
+    CU_ASSERT(quality->increases >= 1);
+
+    guac_common_quality_free(quality);
+    guac_client_free(client);
+
+}
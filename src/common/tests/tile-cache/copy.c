@@ -0,0 +1,116 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/tile-cache.h"
+
+#include <CUnit/CUnit.h>
+#include <cairo/cairo.h>
+#include <guacamole/client.h>
+#include <guacamole/socket.h>
+
+#include <stdint.h>
+
+/**
+ * The width and height of each test image, in pixels.
+ */
+#define TEST_IMAGE_SIZE 32
+
+/**
+ * Fills the given image with a simple pattern derived from the given seed,
+ * such that images filled using different seeds differ.
+ *
+ * @param image
+ *     The image to fill.
+ *
+ * @param seed
+ *     An arbitrary value determining the contents of the image.
+ */
+static void fill_image(cairo_surface_t* image, unsigned int seed) {
+
+    unsigned char* data = cairo_image_surface_get_data(image);
+    int stride = cairo_image_surface_get_stride(image);
+
+    for (int y = 0; y < TEST_IMAGE_SIZE; y++) {
+        uint32_t* row = (uint32_t*) (data + y * stride);
+        for (int x = 0; x < TEST_IMAGE_SIZE; x++)
+            row[x] = 0xFF000000 | ((x * seed + y) & 0xFFFFFF);
+    }
+
+    cairo_surface_mark_dirty(image);
+
+}
+
+/**
+ * Verifies that guac_common_tile_cache_copy() finds only images which have
+ * been stored at least twice, that images are compared by content, and that
+ * the least recently used image is evicted once the cache is full.
+ */
+void test_tile_cache__copy() {
+
+    guac_client* client = guac_client_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(client);
+
+    /* Instructions sent by the cache are simply discarded */
+    guac_socket* socket = guac_socket_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(socket);
+
+    /* Allow exactly two test images to be cached */
+    guac_common_tile_cache* cache = guac_common_tile_cache_alloc(client,
+            TEST_IMAGE_SIZE * TEST_IMAGE_SIZE * 4 * 2);
+
+    cairo_surface_t* images[3];
+    for (int i = 0; i < 3; i++) {
+        images[i] = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                TEST_IMAGE_SIZE, TEST_IMAGE_SIZE);
+        fill_image(images[i], i + 1);
+    }
+
+    /* Images seen only once are not cached */
+    guac_common_tile_cache_store(cache, socket, GUAC_DEFAULT_LAYER, 0, 0, images[0]);
+    CU_ASSERT_FALSE(guac_common_tile_cache_copy(cache, socket, GUAC_DEFAULT_LAYER, 0, 0, images[0]));
+
+    /* Images seen twice are cached */
+    guac_common_tile_cache_store(cache, socket, GUAC_DEFAULT_LAYER, 0, 0, images[0]);
+    CU_ASSERT_TRUE(guac_common_tile_cache_copy(cache, socket, GUAC_DEFAULT_LAYER, 0, 0, images[0]));
+    CU_ASSERT_FALSE(guac_common_tile_cache_copy(cache, socket, GUAC_DEFAULT_LAYER, 0, 0, images[1]));
+
+    guac_common_tile_cache_store(cache, socket, GUAC_DEFAULT_LAYER, 0, 0, images[1]);
+    guac_common_tile_cache_store(cache, socket, GUAC_DEFAULT_LAYER, 0, 0, images[1]);
+    CU_ASSERT_TRUE(guac_common_tile_cache_copy(cache, socket, GUAC_DEFAULT_LAYER, 0, 0, images[1]));
+
+    /* Caching a third image evicts the least recently used */
+    CU_ASSERT_TRUE(guac_common_tile_cache_copy(cache, socket, GUAC_DEFAULT_LAYER, 0, 0, images[0]));
+    guac_common_tile_cache_store(cache, socket, GUAC_DEFAULT_LAYER, 0, 0, images[2]);
+    guac_common_tile_cache_store(cache, socket, GUAC_DEFAULT_LAYER, 0, 0, images[2]);
+
+    CU_ASSERT_TRUE(guac_common_tile_cache_copy(cache, socket, GUAC_DEFAULT_LAYER, 0, 0, images[0]));
+    CU_ASSERT_FALSE(guac_common_tile_cache_copy(cache, socket, GUAC_DEFAULT_LAYER, 0, 0, images[1]));
+    CU_ASSERT_TRUE(guac_common_tile_cache_copy(cache, socket, GUAC_DEFAULT_LAYER, 0, 0, images[2]));
+
+    CU_ASSERT_EQUAL(cache->hits, 5);
+    CU_ASSERT(cache->size <= cache->max_size);
+
+    for (int i = 0; i < 3; i++)
+        cairo_surface_destroy(images[i]);
+
+    guac_common_tile_cache_free(cache);
+    guac_socket_free(socket);
+    guac_client_free(client);
+
+}
@@ -0,0 +1,374 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "common/tile-cache.h"
+
+#include <cairo/cairo.h>
+#include <guacamole/client.h>
+#include <guacamole/hash.h>
+#include <guacamole/layer.h>
+#include <guacamole/mem.h>
+#include <guacamole/protocol.h>
+#include <guacamole/socket.h>
+
+#include <pthread.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * Returns whether the given image is of a size that may be cached.
+ *
+ * @param image
+ *     The image to test.
+ *
+ * @return
+ *     Non-zero if the image may be cached, zero otherwise.
+ */
+static int guac_common_tile_cache_is_cacheable(cairo_surface_t* image) {
+
+    int pixels = cairo_image_surface_get_width(image)
+               * cairo_image_surface_get_height(image);
+
+    return pixels >= GUAC_COMMON_TILE_CACHE_MIN_PIXELS
+        && pixels <= GUAC_COMMON_TILE_CACHE_MAX_PIXELS;
+
+}
+
+/**
+ * Returns the number of bytes of image data within the given tile.
+ *
+ * @param tile
+ *     The tile to measure.
+ *
+ * @return
+ *     The number of bytes of image data within the given tile.
+ */
+static size_t guac_common_tile_size(guac_common_tile* tile) {
+    return (size_t) tile->width * tile->height * 4;
+}
+
+/**
+ * Searches the given tile cache for a tile identical to the given image,
+ * comparing the image data itself for any tile having a matching hash.
+ * The cache must already be locked.
+ *
+ * @param cache
+ *     The tile cache to search.
+ *
+ * @param hash
+ *     The hash of the given image, as produced by guac_hash_surface().
+ *
+ * @param image
+ *     The image to search for.
+ *
+ * @return
+ *     The cached tile identical to the given image, or NULL if no such tile
+ *     is cached.
+ */
+static guac_common_tile* guac_common_tile_cache_find(
+        guac_common_tile_cache* cache, unsigned int hash,
+        cairo_surface_t* image) {
+
+    int width = cairo_image_surface_get_width(image);
+    int height = cairo_image_surface_get_height(image);
+
+    guac_common_tile* current =
+        cache->buckets[hash & (GUAC_COMMON_TILE_CACHE_BUCKETS - 1)];
+
+    while (current != NULL) {
+
+        if (current->hash == hash && current->width == width
+                && current->height == height) {
+
+            cairo_surface_t* tile_image = cairo_image_surface_create_for_data(
+                    current->data, CAIRO_FORMAT_ARGB32, width, height,
+                    width * 4);
+
+            int cmp = guac_surface_cmp(tile_image, image);
+            cairo_surface_destroy(tile_image);
+
+            if (cmp == 0)
+                return current;
+
+        }
+
+        current = current->bucket_next;
+
+    }
+
+    return NULL;
+
+}
+
+/**
+ * Removes the given tile from the usage ordering of the given tile cache,
+ * without otherwise removing the tile from the cache. The cache must already
+ * be locked.
+ *
+ * @param cache
+ *     The tile cache containing the tile.
+ *
+ * @param tile
+ *     The tile to unlink.
+ */
+static void guac_common_tile_cache_unlink(guac_common_tile_cache* cache,
+        guac_common_tile* tile) {
+
+    if (tile->prev != NULL)
+        tile->prev->next = tile->next;
+    else
+        cache->most_recent = tile->next;
+
+    if (tile->next != NULL)
+        tile->next->prev = tile->prev;
+    else
+        cache->least_recent = tile->prev;
+
+}
+
+/**
+ * Marks the given tile as the most recently used tile within the given tile
+ * cache. The tile must not currently be within the usage ordering of the
+ * cache, and the cache must already be locked.
+ *
+ * @param cache
+ *     The tile cache containing the tile.
+ *
+ * @param tile
+ *     The tile to mark as most recently used.
+ */
+static void guac_common_tile_cache_touch(guac_common_tile_cache* cache,
+        guac_common_tile* tile) {
+
+    tile->prev = NULL;
+    tile->next = cache->most_recent;
+
+    if (cache->most_recent != NULL)
+        cache->most_recent->prev = tile;
+    else
+        cache->least_recent = tile;
+
+    cache->most_recent = tile;
+
+}
+
+/**
+ * Removes the least recently used tile from the given tile cache, disposing
+ * of its off-screen buffer. The cache must already be locked and must not be
+ * empty.
+ *
+ * @param cache
+ *     The tile cache to evict a tile from.
+ *
+ * @param socket
+ *     The socket over which the off-screen buffer should be disposed.
+ */
+static void guac_common_tile_cache_evict(guac_common_tile_cache* cache,
+        guac_socket* socket) {
+
+    guac_common_tile* tile = cache->least_recent;
+    guac_common_tile_cache_unlink(cache, tile);
+
+    /* Remove from hash bucket */
+    guac_common_tile** current =
+        &cache->buckets[tile->hash & (GUAC_COMMON_TILE_CACHE_BUCKETS - 1)];
+
+    while (*current != tile)
+        current = &(*current)->bucket_next;
+
+    *current = tile->bucket_next;
+
+    /* Release buffer within remote clients */
+    guac_protocol_send_dispose(socket, tile->buffer);
+    guac_client_free_buffer(cache->client, tile->buffer);
+
+    cache->size -= guac_common_tile_size(tile);
+    guac_mem_free(tile->data);
+    guac_mem_free(tile);
+
+}
+
+guac_common_tile_cache* guac_common_tile_cache_alloc(guac_client* client,
+        size_t max_size) {
+
+    guac_common_tile_cache* cache =
+        guac_mem_zalloc(sizeof(guac_common_tile_cache));
+
+    cache->client = client;
+    cache->max_size = max_size;
+    pthread_mutex_init(&cache->_lock, NULL);
+
+    return cache;
+
+}
+
+void guac_common_tile_cache_free(guac_common_tile_cache* cache) {
+
+    guac_client_log(cache->client, GUAC_LOG_DEBUG, "Tile cache: %lu hits, "
+            "%lu misses, %zu bytes cached.", cache->hits, cache->misses,
+            cache->size);
+
+    guac_common_tile* current = cache->most_recent;
+    while (current != NULL) {
+
+        guac_common_tile* next = current->next;
+
+        guac_client_free_buffer(cache->client, current->buffer);
+        guac_mem_free(current->data);
+        guac_mem_free(current);
+
+        current = next;
+
+    }
+
+    pthread_mutex_destroy(&cache->_lock);
+    guac_mem_free(cache);
+
+}
+
+int guac_common_tile_cache_copy(guac_common_tile_cache* cache,
+        guac_socket* socket, const guac_layer* layer, int x, int y,
+        cairo_surface_t* image) {
+
+    if (!guac_common_tile_cache_is_cacheable(image))
+        return 0;
+
+    unsigned int hash = guac_hash_surface(image);
+
+    pthread_mutex_lock(&cache->_lock);
+
+    guac_common_tile* tile = guac_common_tile_cache_find(cache, hash, image);
+    if (tile == NULL) {
+        cache->misses++;
+        pthread_mutex_unlock(&cache->_lock);
+        return 0;
+    }
+
+    /* Replace destination rectangle with cached tile */
+    guac_protocol_send_copy(socket, tile->buffer, 0, 0,
+            tile->width, tile->height, GUAC_COMP_SRC, layer, x, y);
+
+    guac_common_tile_cache_unlink(cache, tile);
+    guac_common_tile_cache_touch(cache, tile);
+
+    cache->hits++;
+    pthread_mutex_unlock(&cache->_lock);
+    return 1;
+
+}
+
+void guac_common_tile_cache_store(guac_common_tile_cache* cache,
+        guac_socket* socket, const guac_layer* layer, int x, int y,
+        cairo_surface_t* image) {
+
+    if (!guac_common_tile_cache_is_cacheable(image))
+        return;
+
+    int width = cairo_image_surface_get_width(image);
+    int height = cairo_image_surface_get_height(image);
+    size_t size = (size_t) width * height * 4;
+
+    if (size > cache->max_size)
+        return;
+
+    unsigned int hash = guac_hash_surface(image);
+
+    pthread_mutex_lock(&cache->_lock);
+
+    /* Cache only images which have been seen before */
+    unsigned int* candidate =
+        &cache->candidates[hash & (GUAC_COMMON_TILE_CACHE_CANDIDATES - 1)];
+
+    if (*candidate != hash + 1) {
+        *candidate = hash + 1;
+        pthread_mutex_unlock(&cache->_lock);
+        return;
+    }
+
+    /* Ignore if already cached */
+    if (guac_common_tile_cache_find(cache, hash, image) != NULL) {
+        pthread_mutex_unlock(&cache->_lock);
+        return;
+    }
+
+    /* Make room for new tile */
+    while (cache->size + size > cache->max_size)
+        guac_common_tile_cache_evict(cache, socket);
+
+    guac_common_tile* tile = guac_mem_alloc(sizeof(guac_common_tile));
+    tile->hash = hash;
+    tile->width = width;
+    tile->height = height;
+    tile->data = guac_mem_alloc(size);
+    tile->bucket_next = NULL;
+
+    /* Copy image data, removing any row padding */
+    unsigned char* src = cairo_image_surface_get_data(image);
+    unsigned char* dst = tile->data;
+    int src_stride = cairo_image_surface_get_stride(image);
+    for (int row = 0; row < height; row++) {
+        memcpy(dst, src, width * 4);
+        src += src_stride;
+        dst += width * 4;
+    }
+
+    /* Copy image from where it was just drawn into a new buffer */
+    tile->buffer = guac_client_alloc_buffer(cache->client);
+    guac_protocol_send_size(socket, tile->buffer, width, height);
+    guac_protocol_send_copy(socket, layer, x, y, width, height,
+            GUAC_COMP_SRC, tile->buffer, 0, 0);
+
+    /* Add to cache */
+    guac_common_tile** bucket =
+        &cache->buckets[hash & (GUAC_COMMON_TILE_CACHE_BUCKETS - 1)];
+    tile->bucket_next = *bucket;
+    *bucket = tile;
+
+    guac_common_tile_cache_touch(cache, tile);
+    cache->size += size;
+
+    pthread_mutex_unlock(&cache->_lock);
+
+}
+
+void guac_common_tile_cache_dup(guac_common_tile_cache* cache,
+        guac_client* client, guac_socket* socket) {
+
+    pthread_mutex_lock(&cache->_lock);
+
+    guac_common_tile* current = cache->most_recent;
+    while (current != NULL) {
+
+        cairo_surface_t* tile_image = cairo_image_surface_create_for_data(
+                current->data, CAIRO_FORMAT_ARGB32, current->width,
+                current->height, current->width * 4);
+
+        guac_protocol_send_size(socket, current->buffer,
+                current->width, current->height);
+        guac_client_stream_png(client, socket, GUAC_COMP_SRC,
+                current->buffer, 0, 0, tile_image);
+
+        cairo_surface_destroy(tile_image);
+        current = current->next;
+
+    }
+
+    pthread_mutex_unlock(&cache->_lock);
+
+}
@@ -22,6 +22,7 @@
 #include "conf.h"
 #include "conf-file.h"
 #include "conf-parse.h"
+#include "proc-pool.h"
 
 #include <guacamole/client.h>
 #include <guacamole/mem.h>
@@ -91,6 +92,57 @@ static int guacd_conf_callback(const char* section, const char* param, const cha
 
         }
 
+        /* Size of buffer shared by all users for broadcast data */
+        else if (strcmp(param, "broadcast_buffer_size") == 0) {
+
+            char* end;
+            errno = 0;
+            unsigned long size = strtoul(value, &end, 10);
+
+            /* Invalid buffer size */
+            if (*value == '\0' || *value == '-' || *end != '\0'
+                    || errno == ERANGE) {
+                guacd_conf_parse_error = "Invalid broadcast buffer size. The buffer size must be a non-negative number of bytes.";
+                return 1;
+            }
+
+            /* Valid buffer size */
+            config->broadcast_buffer_size = size;
+            return 0;
+
+        }
+
+    }
+
+    /* Pre-started processes for each protocol */
+    else if (strcmp(section, "pool") == 0) {
+
+        char* end;
+        errno = 0;
+        long size = strtol(value, &end, 10);
+
+        /* Invalid pool size */
+        if (*value == '\0' || *end != '\0' || errno == ERANGE
+                || size < 0 || size > GUACD_PROC_POOL_MAX_SIZE) {
+            guacd_conf_parse_error = "Invalid pool size. The number of pre-started processes must be between 0 and 64.";
+            return 1;
+        }
+
+        /* Update existing entry for protocol, if any */
+        guacd_config_pool* pool = config->pools;
+        while (pool != NULL && strcmp(pool->protocol, param) != 0)
+            pool = pool->next;
+
+        if (pool == NULL) {
+            pool = guac_mem_alloc(sizeof(guacd_config_pool));
+            pool->protocol = guac_strdup(param);
+            pool->next = config->pools;
+            config->pools = pool;
+        }
+
+        pool->size = size;
+        return 0;
+
     }
 
     /* SSL-specific options */
@@ -184,6 +236,8 @@ guacd_config* guacd_conf_load() {
     conf->foreground = 0;
     conf->print_version = 0;
     conf->max_log_level = GUAC_LOG_INFO;
+    conf->broadcast_buffer_size = 0;
+    conf->pools = NULL;
 
 #ifdef ENABLE_SSL
     conf->cert_file = NULL;
@@ -36,6 +36,30 @@
  */
 #define GUACD_DEFAULT_BIND_PORT "4822"
 
+/**
+ * The number of idle processes to pre-start for a particular protocol, as
+ * given within the "pool" section of a guacd configuration file.
+ */
+typedef struct guacd_config_pool {
+
+    /**
+     * The name of the protocol whose processes should be pre-started.
+     */
+    char* protocol;
+
+    /**
+     * The number of idle processes to keep for the protocol.
+     */
+    int size;
+
+    /**
+     * The next protocol to pre-start processes for, or NULL if there are no
+     * further protocols.
+     */
+    struct guacd_config_pool* next;
+
+} guacd_config_pool;
+
 /**
  * The contents of a guacd configuration file.
  */
@@ -83,6 +107,19 @@ typedef struct guacd_config {
      */
     guac_client_log_level max_log_level;
 
+    /**
+     * The size of the buffer shared by all users of each connection for
+     * broadcast data, in bytes, or zero if broadcast data should be written
+     * directly to each user in turn.
+     */
+    size_t broadcast_buffer_size;
+
+    /**
+     * The protocols whose processes should be pre-started, or NULL if no
+     * processes should be pre-started.
+     */
+    guacd_config_pool* pools;
+
 } guacd_config;
 
 #endif
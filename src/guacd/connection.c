@@ -24,6 +24,7 @@
 #include "move-fd.h"
 #include "proc.h"
 #include "proc-map.h"
+#include "proc-pool.h"
 
 #include <guacamole/client.h>
 #include <guacamole/error.h>
@@ -32,6 +33,7 @@
 #include <guacamole/plugin.h>
 #include <guacamole/protocol.h>
 #include <guacamole/socket.h>
+#include <guacamole/string.h>
 #include <guacamole/user.h>
 
 #ifdef ENABLE_SSL
@@ -229,6 +231,10 @@ static int guacd_add_user(guacd_proc* proc, guac_parser* parser, guac_socket* so
  * @param map
  *     The map of existing client processes.
  *
+ * @param pool
+ *     The pool of idle, pre-started processes from which the process for a
+ *     new connection should be taken, if available.
+ *
  * @param socket
  *     The socket associated with the new connection that must be routed to
  *     a new or existing process within the given map.
@@ -237,7 +243,8 @@ static int guacd_add_user(guacd_proc* proc, guac_parser* parser, guac_socket* so
  *     Zero if the connection was successfully routed, non-zero if routing has
  *     failed.
  */
-static int guacd_route_connection(guacd_proc_map* map, guac_socket* socket) {
+static int guacd_route_connection(guacd_proc_map* map, guacd_proc_pool* pool,
+        guac_socket* socket) {
 
     guac_parser* parser = guac_parser_alloc();
 
@@ -272,6 +279,10 @@ static int guacd_route_connection(guacd_proc_map* map, guac_socket* socket) {
     guacd_proc* proc;
     int new_process;
 
+    /* The protocol of any new process (the parser, and thus the identifier
+     * below, may be freed once the user has been added) */
+    char* protocol = NULL;
+
     const char* identifier = parser->argv[0];
 
     /* If connection ID, retrieve existing process */
@@ -299,8 +310,9 @@ static int guacd_route_connection(guacd_proc_map* map, guac_socket* socket) {
         guacd_log(GUAC_LOG_INFO, "Creating new client for protocol \"%s\"",
                 identifier);
 
-        /* Create new process */
-        proc = guacd_create_proc(identifier);
+        /* Use pre-started process if available, creating one otherwise */
+        protocol = guac_strdup(identifier);
+        proc = guacd_proc_pool_take(pool, protocol);
         new_process = 1;
 
     }
@@ -309,6 +321,7 @@ static int guacd_route_connection(guacd_proc_map* map, guac_socket* socket) {
     if (proc == NULL) {
         guacd_log_guac_error(GUAC_LOG_INFO, "Connection did not succeed");
         guac_parser_free(parser);
+        guac_mem_free(protocol);
         return 1;
     }
 
@@ -328,6 +341,9 @@ static int guacd_route_connection(guacd_proc_map* map, guac_socket* socket) {
             /* Store process, allowing other users to join */
             guacd_proc_map_add(map, proc);
 
+            /* Replace any pre-started process now that the user is added */
+            guacd_proc_pool_fill(pool, protocol);
+
             /* Wait for child to finish */
             waitpid(proc->pid, NULL, 0);
 
@@ -355,6 +371,7 @@ static int guacd_route_connection(guacd_proc_map* map, guac_socket* socket) {
         /* Clean up */
         close(proc->fd_socket);
         guac_mem_free(proc);
+        guac_mem_free(protocol);
 
     }
 
@@ -368,6 +385,7 @@ void* guacd_connection_thread(void* data) {
     guacd_connection_thread_params* params = (guacd_connection_thread_params*) data;
 
     guacd_proc_map* map = params->map;
+    guacd_proc_pool* pool = params->pool;
     int connected_socket_fd = params->connected_socket_fd;
 
     guac_socket* socket;
@@ -395,7 +413,7 @@ void* guacd_connection_thread(void* data) {
 #endif
 
     /* Route connection according to Guacamole, creating a new process if needed */
-    if (guacd_route_connection(map, socket))
+    if (guacd_route_connection(map, pool, socket))
         guac_socket_free(socket);
 
     guac_mem_free(params);
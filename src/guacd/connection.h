@@ -23,6 +23,7 @@
 #include "config.h"
 
 #include "proc-map.h"
+#include "proc-pool.h"
 
 #ifdef ENABLE_SSL
 #include <openssl/ssl.h>
@@ -38,6 +39,11 @@ typedef struct guacd_connection_thread_params {
      */
     guacd_proc_map* map;
 
+    /**
+     * The shared pool of idle, pre-started processes.
+     */
+    guacd_proc_pool* pool;
+
 #ifdef ENABLE_SSL
     /**
      * SSL context for encrypted connections to guacd. If SSL is not active,
@@ -25,6 +25,7 @@
 #include "connection.h"
 #include "log.h"
 #include "proc-map.h"
+#include "proc-pool.h"
 
 #include <guacamole/mem.h>
 
@@ -316,6 +317,7 @@ int main(int argc, char* argv[]) {
 #endif
 
     guacd_proc_map* map = guacd_proc_map_alloc();
+    guacd_proc_pool* pool = guacd_proc_pool_alloc();
 
     /* General */
     int retval;
@@ -334,6 +336,7 @@ int main(int argc, char* argv[]) {
 
     /* Init logging as early as possible */
     guacd_log_level = config->max_log_level;
+    guacd_broadcast_buffer_size = config->broadcast_buffer_size;
     openlog(GUACD_LOG_NAME, LOG_PID, LOG_DAEMON);
 
     /* Log start */
@@ -507,6 +510,24 @@ int main(int argc, char* argv[]) {
     sigaction(SIGINT, &signal_stop_action, NULL);
     sigaction(SIGTERM, &signal_stop_action, NULL);
 
+    /* Pre-start processes for each configured protocol */
+    guacd_config_pool* pool_config = config->pools;
+    while (pool_config != NULL) {
+
+        if (pool_config->size > 0)
+            guacd_log(GUAC_LOG_INFO, "Pre-starting %i process(es) for "
+                    "protocol \"%s\"", pool_config->size,
+                    pool_config->protocol);
+
+        guacd_proc_pool_set_size(pool, pool_config->protocol,
+                pool_config->size);
+
+        pool_config = pool_config->next;
+
+    }
+
+    guacd_proc_pool_fill(pool, NULL);
+
     /* Log listening status */
     guacd_log(GUAC_LOG_INFO, "Listening on host %s, port %s", bound_address, bound_port);
 
@@ -545,6 +566,7 @@ int main(int argc, char* argv[]) {
         }
 
         params->map = map;
+        params->pool = pool;
         params->connected_socket_fd = connected_socket_fd;
 
 #ifdef ENABLE_SSL
@@ -557,6 +579,9 @@ int main(int argc, char* argv[]) {
 
     }
 
+    /* Stop all idle, pre-started processes */
+    guacd_proc_pool_stop(pool);
+
     /* Stop all connections */
     if (map != NULL) {
 
@@ -0,0 +1,314 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "log.h"
+#include "proc.h"
+#include "proc-pool.h"
+
+#include <guacamole/client.h>
+#include <guacamole/mem.h>
+#include <guacamole/string.h>
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/**
+ * Stops the given process, which must never have been given a user, and
+ * frees all resources associated with it in the parent.
+ *
+ * @param proc
+ *     The process to destroy.
+ */
+static void guacd_proc_pool_destroy_proc(guacd_proc* proc) {
+
+    /* Force process to stop and clean up */
+    guacd_proc_stop(proc);
+
+    /* Free skeleton client */
+    guac_client_free(proc->client);
+
+    /* Clean up */
+    close(proc->fd_socket);
+    guac_mem_free(proc);
+
+}
+
+/**
+ * Returns the pooled protocol having the given name. The pool lock must be
+ * held while this function is invoked.
+ *
+ * @param pool
+ *     The pool to search.
+ *
+ * @param protocol
+ *     The name of the protocol to locate.
+ *
+ * @return
+ *     The pooled protocol having the given name, or NULL if the protocol is
+ *     not pooled.
+ */
+static guacd_proc_pool_protocol* guacd_proc_pool_find(guacd_proc_pool* pool,
+        const char* protocol) {
+
+    guacd_proc_pool_protocol* current = pool->protocols;
+    while (current != NULL) {
+
+        if (strcmp(current->protocol, protocol) == 0)
+            return current;
+
+        current = current->next;
+
+    }
+
+    return NULL;
+
+}
+
+/**
+ * Records that a pre-started process for the given pooled protocol could not
+ * be started or exited before it could be used, delaying any further attempts
+ * to pre-start processes for that protocol. The delay is doubled with each
+ * consecutive failure, such that a protocol whose plugin cannot be loaded is
+ * not repeatedly started for each new connection. The pool lock must be held
+ * while this function is invoked.
+ *
+ * @param pooled
+ *     The pooled protocol whose process has failed.
+ */
+static void guacd_proc_pool_failed(guacd_proc_pool_protocol* pooled) {
+
+    if (pooled->retry_delay == 0)
+        pooled->retry_delay = GUACD_PROC_POOL_RETRY_DELAY;
+    else if (pooled->retry_delay < GUACD_PROC_POOL_MAX_RETRY_DELAY / 2)
+        pooled->retry_delay *= 2;
+    else
+        pooled->retry_delay = GUACD_PROC_POOL_MAX_RETRY_DELAY;
+
+    pooled->retry_after = guac_timestamp_current() + pooled->retry_delay;
+
+    guacd_log(GUAC_LOG_WARNING, "Pre-started processes for protocol \"%s\" "
+            "are failing. Not pre-starting further processes for %ims.",
+            pooled->protocol, pooled->retry_delay);
+
+}
+
+guacd_proc_pool* guacd_proc_pool_alloc() {
+
+    guacd_proc_pool* pool = guac_mem_zalloc(sizeof(guacd_proc_pool));
+    pthread_mutex_init(&(pool->lock), NULL);
+
+    return pool;
+
+}
+
+void guacd_proc_pool_set_size(guacd_proc_pool* pool, const char* protocol,
+        int size) {
+
+    if (size < 0)
+        size = 0;
+    else if (size > GUACD_PROC_POOL_MAX_SIZE)
+        size = GUACD_PROC_POOL_MAX_SIZE;
+
+    pthread_mutex_lock(&(pool->lock));
+
+    /* Add protocol if not yet pooled */
+    guacd_proc_pool_protocol* pooled = guacd_proc_pool_find(pool, protocol);
+    if (pooled == NULL) {
+        pooled = guac_mem_zalloc(sizeof(guacd_proc_pool_protocol));
+        pooled->protocol = guac_strdup(protocol);
+        pooled->next = pool->protocols;
+        pool->protocols = pooled;
+    }
+
+    pooled->size = size;
+
+    pthread_mutex_unlock(&(pool->lock));
+
+}
+
+/**
+ * Starts new processes for the given pooled protocol until the configured
+ * number of idle processes is reached. The pool lock must be held while this
+ * function is invoked, but is released while each process is started.
+ *
+ * @param pool
+ *     The pool containing the given protocol.
+ *
+ * @param pooled
+ *     The pooled protocol whose idle processes should be replenished.
+ */
+static void guacd_proc_pool_fill_protocol(guacd_proc_pool* pool,
+        guacd_proc_pool_protocol* pooled) {
+
+    /* Do not retry too soon after a failure */
+    if (guac_timestamp_current() < pooled->retry_after)
+        return;
+
+    while (pooled->idle_count + pooled->starting < pooled->size) {
+
+        /* Start process without holding the lock, as this involves fork() */
+        pooled->starting++;
+        pthread_mutex_unlock(&(pool->lock));
+
+        guacd_proc* proc = guacd_create_proc(pooled->protocol);
+
+        pthread_mutex_lock(&(pool->lock));
+        pooled->starting--;
+
+        /* Stop trying if processes cannot be started at all */
+        if (proc == NULL) {
+            guacd_log(GUAC_LOG_WARNING, "Unable to pre-start process for "
+                    "protocol \"%s\".", pooled->protocol);
+            guacd_proc_pool_failed(pooled);
+            break;
+        }
+
+        /* Keep process only if there is still room */
+        if (pooled->idle_count < pooled->size) {
+            pooled->idle[pooled->idle_count++] = proc;
+            guacd_log(GUAC_LOG_DEBUG, "Pre-started process for protocol "
+                    "\"%s\" (%i idle).", pooled->protocol, pooled->idle_count);
+        }
+
+        else {
+            pthread_mutex_unlock(&(pool->lock));
+            guacd_proc_pool_destroy_proc(proc);
+            pthread_mutex_lock(&(pool->lock));
+        }
+
+    }
+
+}
+
+void guacd_proc_pool_fill(guacd_proc_pool* pool, const char* protocol) {
+
+    pthread_mutex_lock(&(pool->lock));
+
+    /* Replenish only the requested protocol, if specified */
+    if (protocol != NULL) {
+        guacd_proc_pool_protocol* pooled = guacd_proc_pool_find(pool, protocol);
+        if (pooled != NULL)
+            guacd_proc_pool_fill_protocol(pool, pooled);
+    }
+
+    /* Otherwise, replenish all protocols */
+    else {
+        guacd_proc_pool_protocol* current = pool->protocols;
+        while (current != NULL) {
+            guacd_proc_pool_fill_protocol(pool, current);
+            current = current->next;
+        }
+    }
+
+    pthread_mutex_unlock(&(pool->lock));
+
+}
+
+guacd_proc* guacd_proc_pool_take(guacd_proc_pool* pool, const char* protocol) {
+
+    pthread_mutex_lock(&(pool->lock));
+
+    guacd_proc_pool_protocol* pooled = guacd_proc_pool_find(pool, protocol);
+    if (pooled != NULL) {
+
+        int failed = 0;
+
+        /* Use the most recently started idle process that is still alive */
+        while (pooled->idle_count > 0) {
+
+            guacd_proc* proc = pooled->idle[--pooled->idle_count];
+
+            /* Processes which have already exited (such as those which failed
+             * to load their plugin) cannot be used */
+            if (waitpid(proc->pid, NULL, WNOHANG) != 0) {
+                pthread_mutex_unlock(&(pool->lock));
+                guacd_log(GUAC_LOG_DEBUG, "Discarding pre-started process "
+                        "for protocol \"%s\" which is no longer running.",
+                        protocol);
+                guacd_proc_pool_destroy_proc(proc);
+                pthread_mutex_lock(&(pool->lock));
+                failed = 1;
+                continue;
+            }
+
+            /* Pre-started processes are working again */
+            pooled->retry_delay = 0;
+
+            pooled->hits++;
+            guacd_log(GUAC_LOG_DEBUG, "Using pre-started process for protocol "
+                    "\"%s\" (pool hits: %lu, misses: %lu).", protocol,
+                    pooled->hits, pooled->misses);
+
+            pthread_mutex_unlock(&(pool->lock));
+            return proc;
+
+        }
+
+        /* Back off if every idle process had exited */
+        if (failed)
+            guacd_proc_pool_failed(pooled);
+
+        pooled->misses++;
+        guacd_log(GUAC_LOG_DEBUG, "No pre-started process available for "
+                "protocol \"%s\" (pool hits: %lu, misses: %lu).", protocol,
+                pooled->hits, pooled->misses);
+
+    }
+
+    pthread_mutex_unlock(&(pool->lock));
+
+    /* Start new process if none are available */
+    return guacd_create_proc(protocol);
+
+}
+
+void guacd_proc_pool_stop(guacd_proc_pool* pool) {
+
+    pthread_mutex_lock(&(pool->lock));
+
+    guacd_proc_pool_protocol* current = pool->protocols;
+    while (current != NULL) {
+
+        guacd_log(GUAC_LOG_INFO, "Process pool for protocol \"%s\": "
+                "%lu hits, %lu misses.", current->protocol, current->hits,
+                current->misses);
+
+        /* Prevent any further processes from being pre-started */
+        current->size = 0;
+
+        /* Stop all idle processes */
+        while (current->idle_count > 0) {
+            guacd_proc* proc = current->idle[--current->idle_count];
+            pthread_mutex_unlock(&(pool->lock));
+            guacd_proc_pool_destroy_proc(proc);
+            pthread_mutex_lock(&(pool->lock));
+        }
+
+        current = current->next;
+
+    }
+
+    pthread_mutex_unlock(&(pool->lock));
+
+}
@@ -0,0 +1,211 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUACD_PROC_POOL_H
+#define GUACD_PROC_POOL_H
+
+#include "config.h"
+#include "proc.h"
+
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+
+/**
+ * The maximum number of idle, pre-started processes that may be kept for any
+ * one protocol.
+ */
+#define GUACD_PROC_POOL_MAX_SIZE 64
+
+/**
+ * The amount of time to wait before again pre-starting processes for a
+ * protocol whose pre-started processes could not be started or have exited
+ * (such as when the client plugin for the protocol cannot be loaded), in
+ * milliseconds. This delay is doubled with each consecutive failure.
+ */
+#define GUACD_PROC_POOL_RETRY_DELAY 1000
+
+/**
+ * The maximum amount of time to wait before again pre-starting processes for
+ * a protocol whose pre-started processes repeatedly fail, in milliseconds.
+ */
+#define GUACD_PROC_POOL_MAX_RETRY_DELAY 60000
+
+/**
+ * Idle, pre-started processes for a single protocol. Each process has already
+ * loaded the client plugin for the protocol and is waiting to receive the
+ * file descriptor of its first user.
+ */
+typedef struct guacd_proc_pool_protocol {
+
+    /**
+     * The name of the protocol, as would be given in the "select"
+     * instruction.
+     */
+    char* protocol;
+
+    /**
+     * The number of idle processes that should be maintained.
+     */
+    int size;
+
+    /**
+     * The idle processes currently available.
+     */
+    guacd_proc* idle[GUACD_PROC_POOL_MAX_SIZE];
+
+    /**
+     * The number of processes within the idle array.
+     */
+    int idle_count;
+
+    /**
+     * The number of processes currently being started to replenish the idle
+     * array.
+     */
+    int starting;
+
+    /**
+     * The number of connections which were given an idle, pre-started
+     * process.
+     */
+    unsigned long hits;
+
+    /**
+     * The number of connections which required a new process to be started
+     * because no idle process was available.
+     */
+    unsigned long misses;
+
+    /**
+     * The amount of time to wait after the most recent failure before again
+     * pre-starting processes, in milliseconds, or zero if the most recently
+     * used pre-started process did not fail.
+     */
+    int retry_delay;
+
+    /**
+     * The time before which no further processes should be pre-started, due
+     * to the failure of previously pre-started processes.
+     */
+    guac_timestamp retry_after;
+
+    /**
+     * The next protocol within the pool, or NULL if this is the last.
+     */
+    struct guacd_proc_pool_protocol* next;
+
+} guacd_proc_pool_protocol;
+
+/**
+ * A pool of idle, pre-started processes for each of any number of protocols,
+ * allowing new connections to skip the delay of starting a process and
+ * loading the client plugin.
+ */
+typedef struct guacd_proc_pool {
+
+    /**
+     * Lock which guards all members of the pool and of each of its
+     * protocols.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * All protocols having pre-started processes, or NULL if no processes
+     * are pre-started.
+     */
+    guacd_proc_pool_protocol* protocols;
+
+} guacd_proc_pool;
+
+/**
+ * Allocates a new, empty pool of pre-started processes. No processes will be
+ * pre-started until guacd_proc_pool_set_size() is invoked.
+ *
+ * @return
+ *     A newly-allocated, empty process pool.
+ */
+guacd_proc_pool* guacd_proc_pool_alloc();
+
+/**
+ * Sets the number of idle processes that should be pre-started for the given
+ * protocol. Processes are not started until guacd_proc_pool_fill() is
+ * invoked.
+ *
+ * @param pool
+ *     The pool to modify.
+ *
+ * @param protocol
+ *     The name of the protocol whose processes should be pre-started.
+ *
+ * @param size
+ *     The number of idle processes to keep for the given protocol. This
+ *     value is clamped to GUACD_PROC_POOL_MAX_SIZE.
+ */
+void guacd_proc_pool_set_size(guacd_proc_pool* pool, const char* protocol,
+        int size);
+
+/**
+ * Starts new processes for the given protocol until the pool contains the
+ * configured number of idle processes for that protocol. If the protocol is
+ * not pooled, or if previously pre-started processes for the protocol have
+ * recently failed, this function has no effect.
+ *
+ * @param pool
+ *     The pool to replenish.
+ *
+ * @param protocol
+ *     The name of the protocol whose idle processes should be replenished,
+ *     or NULL to replenish the idle processes of all protocols.
+ */
+void guacd_proc_pool_fill(guacd_proc_pool* pool, const char* protocol);
+
+/**
+ * Returns a process for a new connection using the given protocol. If an
+ * idle, pre-started process is available for that protocol, that process is
+ * removed from the pool and returned. Otherwise, a new process is started
+ * exactly as guacd_create_proc() would. The pool is not replenished by this
+ * function; guacd_proc_pool_fill() should be invoked once the returned
+ * process has been handed its first user.
+ *
+ * @param pool
+ *     The pool to take a process from.
+ *
+ * @param protocol
+ *     The name of the protocol that the process must use.
+ *
+ * @return
+ *     A process for the given protocol, or NULL if no idle process is
+ *     available and a new process could not be started.
+ */
+guacd_proc* guacd_proc_pool_take(guacd_proc_pool* pool, const char* protocol);
+
+/**
+ * Stops all idle processes within the given pool and logs the number of pool
+ * hits and misses for each protocol. No further processes will be
+ * pre-started. The pool itself is not freed, as connection threads may still
+ * be using it.
+ *
+ * @param pool
+ *     The pool to stop.
+ */
+void guacd_proc_pool_stop(guacd_proc_pool* pool);
+
+#endif
+
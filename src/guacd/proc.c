@@ -33,6 +33,7 @@
 #include <guacamole/socket.h>
 #include <guacamole/user.h>
 
+#include <dirent.h>
 #include <errno.h>
 #include <pthread.h>
 #include <signal.h>
@@ -43,6 +44,9 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/wait.h>
+#include <syslog.h>
+
+size_t guacd_broadcast_buffer_size = 0;
 
 /**
  * Parameters for the user thread.
@@ -308,6 +312,59 @@ static void signal_stop_handler(int signal) {
 
 }
 
+/**
+ * Closes every file descriptor inherited from the parent guacd process except
+ * standard input, output, and error and the given file descriptor. File
+ * descriptors are shared by all threads of guacd, so a newly-forked process
+ * otherwise holds open the sockets of every other connection in progress at
+ * the time of the fork, including the sockets of connections which end
+ * while the process continues to run (such as an idle, pre-started process).
+ * The connection to the system log is reopened, as its file descriptor is
+ * closed as well.
+ *
+ * @param keep_fd
+ *     The file descriptor which should remain open.
+ */
+static void guacd_close_inherited_fds(int keep_fd) {
+
+    closelog();
+
+    /* Close only the file descriptors actually open, if they can be listed */
+    DIR* fds = opendir("/proc/self/fd");
+    if (fds != NULL) {
+
+        int dir_fd = dirfd(fds);
+
+        struct dirent* entry;
+        while ((entry = readdir(fds)) != NULL) {
+
+            /* Skip "." and ".." */
+            if (entry->d_name[0] == '.')
+                continue;
+
+            int fd = atoi(entry->d_name);
+            if (fd > STDERR_FILENO && fd != keep_fd && fd != dir_fd)
+                close(fd);
+
+        }
+
+        closedir(fds);
+
+    }
+
+    /* Otherwise, attempt to close every possible file descriptor */
+    else {
+        long max_fd = sysconf(_SC_OPEN_MAX);
+        for (int fd = STDERR_FILENO + 1; fd < max_fd; fd++) {
+            if (fd != keep_fd)
+                close(fd);
+        }
+    }
+
+    openlog(GUACD_LOG_NAME, LOG_PID, LOG_DAEMON);
+
+}
+
 /**
  * Starts protocol-specific handling on the given process by loading the client
  * plugin for that protocol. This function does NOT return. It initializes the
@@ -325,6 +382,9 @@ static void signal_stop_handler(int signal) {
 static void guacd_exec_proc(guacd_proc* proc, const char* protocol) {
 
     int result = 1;
+
+    /* Release the sockets of any other connections */
+    guacd_close_inherited_fds(proc->fd_socket);
    
     /* Set process group ID to match PID */ 
     if (setpgid(0, 0)) {
@@ -348,6 +408,14 @@ static void guacd_exec_proc(guacd_proc* proc, const char* protocol) {
         goto cleanup_client;
     }
 
+    /* Deliver broadcast data to each user independently, if enabled */
+    if (guacd_broadcast_buffer_size != 0
+            && guac_client_enable_async_broadcast(client,
+                guacd_broadcast_buffer_size))
+        guacd_log_guac_error(GUAC_LOG_WARNING, "Unable to enable "
+                "asynchronous broadcast. Data will be written to each user "
+                "in turn");
+
     /* The first file descriptor is the owner */
     int owner = 1;
 
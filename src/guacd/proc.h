@@ -25,6 +25,7 @@
 #include <guacamole/client.h>
 #include <guacamole/parser.h>
 
+#include <stddef.h>
 #include <unistd.h>
 
 /**
@@ -48,6 +49,13 @@
  */
 #define GUACD_CLIENT_FREE_TIMEOUT 5
 
+/**
+ * The size of the buffer shared by all users of each connection for
+ * broadcast data, in bytes, or zero if broadcast data should be written
+ * directly to each user in turn. See guac_client_enable_async_broadcast().
+ */
+extern size_t guacd_broadcast_buffer_size;
+
 /**
  * Process information of the internal remote desktop client.
  */
@@ -19,6 +19,7 @@
 
 #include "config.h"
 #include "buffer.h"
+#include "rect.h"
 
 #include <cairo/cairo.h>
 #include <guacamole/mem.h>
@@ -82,6 +83,7 @@ int guacenc_buffer_resize(guacenc_buffer* buffer, int width, int height) {
         buffer->width = width;
         buffer->height = height;
         buffer->stride = 0;
+        guacenc_buffer_clear_dirty(buffer);
         return 0;
     }
 
@@ -115,6 +117,9 @@ int guacenc_buffer_resize(guacenc_buffer* buffer, int width, int height) {
     buffer->surface = surface;
     buffer->cairo = cairo;
 
+    /* Any part of a resized buffer may be new */
+    guacenc_buffer_mark_all_dirty(buffer);
+
     return 0;
 
 }
@@ -170,3 +175,67 @@ int guacenc_buffer_copy(guacenc_buffer* dst, guacenc_buffer* src) {
 
 }
 
+void guacenc_buffer_copy_rect(guacenc_buffer* dst, guacenc_buffer* src,
+        const guacenc_rect* rect) {
+
+    /* Nothing to copy if source or rectangle have no pixels */
+    if (src->surface == NULL || guacenc_rect_is_empty(rect))
+        return;
+
+    /* Destination must be non-NULL as its size is that of the source */
+    assert(dst->cairo != NULL);
+    assert(dst->width == src->width && dst->height == src->height);
+
+    /* Reset state of destination */
+    cairo_t* cairo = dst->cairo;
+    cairo_reset_clip(cairo);
+
+    /* Overwrite rectangle of destination with contents of source */
+    cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_surface(cairo, src->surface, 0, 0);
+    cairo_rectangle(cairo, rect->left, rect->top,
+            rect->right - rect->left, rect->bottom - rect->top);
+    cairo_fill(cairo);
+
+    /* Reset operator of destination to default */
+    cairo_set_operator(cairo, CAIRO_OPERATOR_OVER);
+
+}
+
+void guacenc_buffer_mark_dirty(guacenc_buffer* buffer, cairo_operator_t op,
+        int x, int y, int width, int height) {
+
+    /* Operators not bounded by the source may alter the entire buffer */
+    switch (op) {
+
+        case CAIRO_OPERATOR_IN:
+        case CAIRO_OPERATOR_OUT:
+        case CAIRO_OPERATOR_DEST_IN:
+        case CAIRO_OPERATOR_DEST_ATOP:
+            guacenc_buffer_mark_all_dirty(buffer);
+            return;
+
+        default:
+            break;
+
+    }
+
+    /* Ignore any part of the rectangle outside the buffer */
+    guacenc_rect bounds;
+    guacenc_rect_init(&bounds, 0, 0, buffer->width, buffer->height);
+
+    guacenc_rect changed;
+    guacenc_rect_init(&changed, x, y, width, height);
+    guacenc_rect_intersect(&changed, &bounds);
+
+    guacenc_rect_extend(&buffer->dirty, &changed);
+
+}
+
+void guacenc_buffer_mark_all_dirty(guacenc_buffer* buffer) {
+    guacenc_rect_init(&buffer->dirty, 0, 0, buffer->width, buffer->height);
+}
+
+void guacenc_buffer_clear_dirty(guacenc_buffer* buffer) {
+    guacenc_rect_clear(&buffer->dirty);
+}
@@ -21,6 +21,7 @@
 #define GUACENC_BUFFER_H
 
 #include "config.h"
+#include "rect.h"
 
 #include <cairo/cairo.h>
 
@@ -71,6 +72,13 @@ typedef struct guacenc_buffer {
      */
     cairo_t* cairo;
 
+    /**
+     * The smallest rectangle containing every pixel of this buffer which may
+     * have changed since guacenc_buffer_clear_dirty() was last invoked. If
+     * nothing has changed, this rectangle is empty.
+     */
+    guacenc_rect dirty;
+
 } guacenc_buffer;
 
 /**
@@ -150,5 +158,68 @@ int guacenc_buffer_fit(guacenc_buffer* buffer, int x, int y);
  */
 int guacenc_buffer_copy(guacenc_buffer* dst, guacenc_buffer* src);
 
+/**
+ * Copies the contents of the given rectangle within the given source buffer to
+ * the same rectangle within the destination buffer, ignoring the current
+ * contents of that rectangle within the destination. The destination buffer
+ * must already be the same size as the source buffer.
+ *
+ * @param dst
+ *     The destination buffer whose contents should be partially replaced.
+ *
+ * @param src
+ *     The source buffer whose contents should replace those of the destination
+ *     buffer.
+ *
+ * @param rect
+ *     The rectangle to copy.
+ */
+void guacenc_buffer_copy_rect(guacenc_buffer* dst, guacenc_buffer* src,
+        const guacenc_rect* rect);
+
+/**
+ * Records that the given rectangle of the given buffer has been drawn to
+ * using the given Cairo operator. Operators which are not bounded by the
+ * source (such as CAIRO_OPERATOR_IN) may affect the entire buffer, in which
+ * case the entire buffer is recorded as changed.
+ *
+ * @param buffer
+ *     The buffer that was drawn to.
+ *
+ * @param op
+ *     The Cairo operator used for the draw operation.
+ *
+ * @param x
+ *     The X coordinate of the upper-left corner of the rectangle drawn.
+ *
+ * @param y
+ *     The Y coordinate of the upper-left corner of the rectangle drawn.
+ *
+ * @param width
+ *     The width of the rectangle drawn, in pixels.
+ *
+ * @param height
+ *     The height of the rectangle drawn, in pixels.
+ */
+void guacenc_buffer_mark_dirty(guacenc_buffer* buffer, cairo_operator_t op,
+        int x, int y, int width, int height);
+
+/**
+ * Records that the entire contents of the given buffer may have changed.
+ *
+ * @param buffer
+ *     The buffer that changed.
+ */
+void guacenc_buffer_mark_all_dirty(guacenc_buffer* buffer);
+
+/**
+ * Resets the record of which parts of the given buffer have changed, such
+ * that the buffer is considered unchanged.
+ *
+ * @param buffer
+ *     The buffer whose changes have been handled.
+ */
+void guacenc_buffer_clear_dirty(guacenc_buffer* buffer);
+
 #endif
 
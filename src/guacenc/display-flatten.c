@@ -26,6 +26,7 @@
 #include <guacamole/client.h>
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -37,6 +38,13 @@
  */
 guacenc_display* __qsort_display;
 
+/**
+ * Lock which must be held while __qsort_display is set and the associated
+ * qsort() operation is in progress, as multiple displays may be flattened
+ * concurrently when several files are encoded in parallel.
+ */
+static pthread_mutex_t __qsort_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /**
  * Comparator which orders layer pointers such that (1) NULL pointers are last,
  * (2) layers with the same parent_index are adjacent, and (3) layers with the
@@ -78,6 +86,37 @@ static int guacenc_display_layer_comparator(const void* a, const void* b) {
 
 }
 
+/**
+ * Determines the region of the frame buffer of the default layer which would
+ * be covered by the mouse cursor of the given display, if rendered.
+ *
+ * @param display
+ *     The display whose mouse cursor should be located.
+ *
+ * @param rect
+ *     The rectangle to populate with the region covered by the mouse cursor.
+ *     This will be empty if the mouse cursor would not be rendered.
+ */
+static void guacenc_display_get_cursor_rect(guacenc_display* display,
+        guacenc_rect* rect) {
+
+    guacenc_cursor* cursor = display->cursor;
+    guacenc_buffer* buffer = cursor->buffer;
+
+    /* Cursor is not rendered if coordinates are negative or it is empty */
+    if (cursor->x < 0 || cursor->y < 0
+            || buffer->width <= 0 || buffer->height <= 0) {
+        guacenc_rect_clear(rect);
+        return;
+    }
+
+    guacenc_rect_init(rect,
+            cursor->x - cursor->hotspot_x,
+            cursor->y - cursor->hotspot_y,
+            buffer->width, buffer->height);
+
+}
+
 /**
  * Renders the mouse cursor on top of the frame buffer of the default layer of
  * the given display.
@@ -106,7 +145,8 @@ static int guacenc_display_render_cursor(guacenc_display* display) {
     guacenc_buffer* dst = def_layer->frame;
 
     /* Render cursor to layer */
-    if (src->width > 0 && src->height > 0) {
+    if (src->width > 0 && src->height > 0 && dst->cairo != NULL) {
+        cairo_reset_clip(dst->cairo);
         cairo_set_source_surface(dst->cairo, src->surface,
                 cursor->x - cursor->hotspot_x,
                 cursor->y - cursor->hotspot_y);
@@ -122,20 +162,66 @@ static int guacenc_display_render_cursor(guacenc_display* display) {
 
 }
 
+/**
+ * Returns the parent layer that the given layer is rendered to, or NULL if
+ * the given layer is not rendered at all.
+ *
+ * @param display
+ *     The display containing the layer.
+ *
+ * @param layer
+ *     The layer whose parent should be retrieved.
+ *
+ * @return
+ *     The parent layer that the given layer is rendered to, or NULL if the
+ *     layer is fully transparent, has no parent, or has an invalid parent.
+ */
+static guacenc_layer* guacenc_display_get_render_parent(
+        guacenc_display* display, guacenc_layer* layer) {
+
+    /* Skip fully-transparent layers */
+    if (layer->opacity == 0)
+        return NULL;
+
+    /* Ignore layers without a parent */
+    int parent_index = layer->parent_index;
+    if (parent_index == GUACENC_LAYER_NO_PARENT)
+        return NULL;
+
+    /* Retrieve parent layer, ignoring layers with invalid parents */
+    return guacenc_display_get_layer(display, parent_index);
+
+}
+
 int guacenc_display_flatten(guacenc_display* display) {
 
     int i;
-    guacenc_layer* render_order[GUACENC_DISPLAY_MAX_LAYERS];
+    guacenc_layer** render_order = display->render_order;
+
+    /* Re-render everything if the composition of layers has changed, sorting
+     * layers by depth, parent, and Z */
+    bool rebuild = display->layers_changed;
+    while (display->layers_changed) {
 
-    /* Copy list of layers within display */
-    memcpy(render_order, display->layers, sizeof(render_order));
+        /* Sorting may itself allocate layers (the missing parent of a layer
+         * is allocated when its depth is determined), in which case the
+         * composition must be rebuilt again to include those layers */
+        display->layers_changed = false;
 
-    /* Sort layers by depth, parent, and Z */
-    __qsort_display = display;
-    qsort(render_order, GUACENC_DISPLAY_MAX_LAYERS, sizeof(guacenc_layer*),
-            guacenc_display_layer_comparator);
+        /* Copy list of layers within display */
+        memcpy(render_order, display->layers, sizeof(display->render_order));
 
-    /* Reset layer frame buffers */
+        pthread_mutex_lock(&__qsort_lock);
+        __qsort_display = display;
+        qsort(render_order, GUACENC_DISPLAY_MAX_LAYERS, sizeof(guacenc_layer*),
+                guacenc_display_layer_comparator);
+        pthread_mutex_unlock(&__qsort_lock);
+
+    }
+
+    /* Determine the damaged region of each layer. As the deepest layers are
+     * first, the damage of each layer is complete before it is propagated to
+     * that layer's parent. */
     for (i = 0; i < GUACENC_DISPLAY_MAX_LAYERS; i++) {
 
         /* Pull current layer, ignoring unallocated layers */
@@ -147,12 +233,94 @@ int guacenc_display_flatten(guacenc_display* display) {
         guacenc_buffer* buffer = layer->buffer;
         guacenc_buffer* frame = layer->frame;
 
-        /* Reset frame contents */
-        guacenc_buffer_copy(frame, buffer);
+        guacenc_rect bounds;
+        guacenc_rect_init(&bounds, 0, 0, buffer->width, buffer->height);
+
+        /* The region last rendered to the parent, which must be rendered
+         * again if the layer has since been resized (the parent would
+         * otherwise retain the old contents of any area no longer covered
+         * by a layer which has shrunk) */
+        guacenc_rect previous_bounds;
+        guacenc_rect_clear(&previous_bounds);
+
+        /* Entire frame must be rendered if it cannot be reused */
+        if (rebuild || frame->width != buffer->width
+                || frame->height != buffer->height) {
+
+            guacenc_rect_init(&previous_bounds, 0, 0,
+                    frame->width, frame->height);
+
+            if (guacenc_buffer_resize(frame, buffer->width, buffer->height))
+                return 1;
+
+            layer->damage = bounds;
+
+        }
+
+        /* Otherwise, only changes to the layer and its children matter */
+        else {
+            guacenc_rect_extend(&layer->damage, &buffer->dirty);
+            guacenc_rect_intersect(&layer->damage, &bounds);
+        }
+
+        guacenc_buffer_clear_dirty(buffer);
+
+        /* Propagate damage to the parent layer, if rendered there */
+        guacenc_layer* parent = guacenc_display_get_render_parent(display,
+                layer);
+        if (parent != NULL) {
+
+            guacenc_rect damage = layer->damage;
+            guacenc_rect_extend(&damage, &previous_bounds);
+
+            if (!guacenc_rect_is_empty(&damage)) {
+
+                guacenc_rect parent_damage;
+                guacenc_rect_init(&parent_damage,
+                        layer->x + damage.left,
+                        layer->y + damage.top,
+                        damage.right - damage.left,
+                        damage.bottom - damage.top);
+
+                guacenc_rect_extend(&parent->damage, &parent_damage);
+
+            }
+
+        }
 
     }
 
-    /* Render each layer, in order */
+    /* Retrieve default layer (guaranteed to not be NULL) */
+    guacenc_layer* def_layer = guacenc_display_get_layer(display, 0);
+    assert(def_layer != NULL);
+
+    /* Re-render the cursor if it has changed, or if anything beneath it is
+     * being re-rendered (which would otherwise erase it) */
+    guacenc_rect cursor_rect;
+    guacenc_display_get_cursor_rect(display, &cursor_rect);
+
+    guacenc_buffer* cursor_buffer = display->cursor->buffer;
+    bool render_cursor =
+           !guacenc_rect_is_empty(&cursor_buffer->dirty)
+        || memcmp(&cursor_rect, &display->cursor_rect, sizeof(guacenc_rect))
+        || guacenc_rect_intersects(&def_layer->damage, &display->cursor_rect);
+
+    guacenc_buffer_clear_dirty(cursor_buffer);
+
+    /* The cursor is removed by rendering the area it covered once again */
+    if (render_cursor) {
+
+        guacenc_rect bounds;
+        guacenc_rect_init(&bounds, 0, 0, def_layer->buffer->width,
+                def_layer->buffer->height);
+
+        guacenc_rect_extend(&def_layer->damage, &display->cursor_rect);
+        guacenc_rect_extend(&def_layer->damage, &cursor_rect);
+        guacenc_rect_intersect(&def_layer->damage, &bounds);
+
+    }
+
+    /* Reset damaged regions of layer frame buffers */
     for (i = 0; i < GUACENC_DISPLAY_MAX_LAYERS; i++) {
 
         /* Pull current layer, ignoring unallocated layers */
@@ -160,17 +328,22 @@ int guacenc_display_flatten(guacenc_display* display) {
         if (layer == NULL)
             continue;
 
-        /* Skip fully-transparent layers */
-        if (layer->opacity == 0)
-            continue;
+        /* Reset frame contents within damaged region */
+        guacenc_buffer_copy_rect(layer->frame, layer->buffer, &layer->damage);
+
+    }
+
+    /* Render each layer, in order, within the damaged region of its parent */
+    for (i = 0; i < GUACENC_DISPLAY_MAX_LAYERS; i++) {
 
-        /* Ignore layers without a parent */
-        int parent_index = layer->parent_index;
-        if (parent_index == GUACENC_LAYER_NO_PARENT)
+        /* Pull current layer, ignoring unallocated layers */
+        guacenc_layer* layer = render_order[i];
+        if (layer == NULL)
             continue;
 
-        /* Retrieve parent layer, ignoring layers with invalid parents */
-        guacenc_layer* parent = guacenc_display_get_layer(display, parent_index);
+        /* Ignore layers which are not rendered */
+        guacenc_layer* parent = guacenc_display_get_render_parent(display,
+                layer);
         if (parent == NULL)
             continue;
 
@@ -188,9 +361,17 @@ int guacenc_display_flatten(guacenc_display* display) {
         if (cairo == NULL)
             continue;
 
+        /* Ignore if no part of the layer needs to be rendered again */
+        guacenc_rect clip;
+        guacenc_rect_init(&clip, layer->x, layer->y, src->width, src->height);
+        guacenc_rect_intersect(&clip, &parent->damage);
+        if (guacenc_rect_is_empty(&clip))
+            continue;
+
         /* Render buffer to layer */
         cairo_reset_clip(cairo);
-        cairo_rectangle(cairo, layer->x, layer->y, src->width, src->height);
+        cairo_rectangle(cairo, clip.left, clip.top,
+                clip.right - clip.left, clip.bottom - clip.top);
         cairo_clip(cairo);
 
         cairo_set_source_surface(cairo, surface, layer->x, layer->y);
@@ -198,8 +379,21 @@ int guacenc_display_flatten(guacenc_display* display) {
 
     }
 
+    /* Only frames which were rendered to have changed */
+    display->frame_changed = !guacenc_rect_is_empty(&def_layer->damage);
+
+    /* Damage has now been fully handled */
+    for (i = 0; i < GUACENC_DISPLAY_MAX_LAYERS; i++) {
+        if (render_order[i] != NULL)
+            guacenc_rect_clear(&render_order[i]->damage);
+    }
+
     /* Render cursor on top of everything else */
-    return guacenc_display_render_cursor(display);
+    if (render_cursor) {
+        display->cursor_rect = cursor_rect;
+        return guacenc_display_render_cursor(display);
+    }
 
-}
+    return 0;
 
+}
@@ -53,6 +53,9 @@ guacenc_layer* guacenc_display_get_layer(guacenc_display* display,
         /* Store layer within display for future retrieval / management */
         display->layers[index] = layer;
 
+        /* Composition of layers must be rebuilt */
+        display->layers_changed = true;
+
     }
 
     return layer;
@@ -93,6 +96,9 @@ int guacenc_display_free_layer(guacenc_display* display,
     /* Mark layer as freed */
     display->layers[index] = NULL;
 
+    /* Composition of layers must be rebuilt */
+    display->layers_changed = true;
+
     return 0;
 
 }
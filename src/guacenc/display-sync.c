@@ -37,9 +37,26 @@ int guacenc_display_sync(guacenc_display* display, guac_timestamp timestamp) {
         return 1;
     }
 
+    /* Measure requested range relative to the beginning of the recording */
+    if (display->origin == 0)
+        display->origin = timestamp;
+
+    guac_timestamp position = timestamp - display->origin;
+
+    /* Stop once the end of the requested range has been passed */
+    if (display->end >= 0 && position > display->end) {
+        display->ended = true;
+        return 0;
+    }
+
     /* Update timestamp of display */
     display->last_sync = timestamp;
 
+    /* Changes prior to the requested range continue to accumulate, but are
+     * not rendered or encoded */
+    if (position < display->start)
+        return 0;
+
     /* Flatten display to default layer */
     if (guacenc_display_flatten(display))
         return 1;
@@ -52,8 +69,11 @@ int guacenc_display_sync(guacenc_display* display, guac_timestamp timestamp) {
     if (guacenc_video_advance_timeline(display->output, timestamp))
         return 1;
 
-    /* Prepare frame for write upon next flush */
-    guacenc_video_prepare_frame(display->output, def_layer->frame);
+    /* Prepare frame for write upon next flush, reusing the previously
+     * prepared frame if nothing has changed */
+    if (display->frame_changed)
+        guacenc_video_prepare_frame(display->output, def_layer->frame);
+
     return 0;
 
 }
@@ -102,6 +102,13 @@ guacenc_display* guacenc_display_alloc(const char* path, const char* codec,
     /* Allocate special-purpose cursor layer */
     display->cursor = guacenc_cursor_alloc();
 
+    /* The first frame must be rendered in its entirety */
+    display->layers_changed = true;
+
+    /* Encode entire recording unless otherwise specified */
+    display->start = 0;
+    display->end = -1;
+
     return display;
 
 }
@@ -25,12 +25,15 @@
 #include "cursor.h"
 #include "image-stream.h"
 #include "layer.h"
+#include "rect.h"
 #include "video.h"
 
 #include <cairo/cairo.h>
 #include <guacamole/protocol.h>
 #include <guacamole/timestamp.h>
 
+#include <stdbool.h>
+
 /**
  * The maximum number of buffers that the Guacamole video encoder will handle
  * within a single Guacamole protocol dump.
@@ -94,11 +97,73 @@ typedef struct guacenc_display {
      */
     guacenc_video* output;
 
+    /**
+     * Whether any layer has been allocated, freed, moved, or shaded since the
+     * display was last flattened. If so, the next flatten operation
+     * recomposites every layer in its entirety and re-sorts render_order.
+     */
+    bool layers_changed;
+
+    /**
+     * All currently-allocated layers, in the order they must be rendered to
+     * their parent layers: deepest layers first, with siblings adjacent and
+     * ordered by descending Z. Unallocated entries are NULL and sorted last.
+     * This is only updated by guacenc_display_flatten() when layers_changed is
+     * set.
+     */
+    guacenc_layer* render_order[GUACENC_DISPLAY_MAX_LAYERS];
+
+    /**
+     * The region of the frame buffer of the default layer covered by the
+     * mouse cursor when it was last rendered, or an empty rectangle if the
+     * cursor has not been rendered.
+     */
+    guacenc_rect cursor_rect;
+
+    /**
+     * Whether the frame buffer of the default layer changed during the last
+     * flatten operation. If not, the previously-prepared video frame can be
+     * reused as-is.
+     */
+    bool frame_changed;
+
+    /**
+     * The timestamp of the first sync instruction within the recording,
+     * against which the start and end of the encoded range are measured, or
+     * 0 if not yet known. This is taken from the index of the recording if
+     * reading begins at a keyframe, and is otherwise the timestamp of the
+     * first sync instruction handled.
+     */
+    guac_timestamp origin;
+
+    /**
+     * The position within the recording at which encoding should begin, in
+     * milliseconds relative to the origin. Frames before this point are
+     * rendered but not encoded.
+     */
+    guac_timestamp start;
+
+    /**
+     * The position within the recording at which encoding should end, in
+     * milliseconds relative to the origin, or a negative value if the entire
+     * remainder of the recording should be encoded.
+     */
+    guac_timestamp end;
+
+    /**
+     * Whether the end of the encoded range has been reached, in which case no
+     * further instructions need be handled.
+     */
+    bool ended;
+
 } guacenc_display;
 
 /**
  * Handles a received "sync" instruction having the given timestamp, flushing
- * the current display to the in-progress video encoding.
+ * the current display to the in-progress video encoding. Frames outside the
+ * range of the recording requested via the start and end members of the
+ * display are not encoded, and the ended flag of the display is set once the
+ * end of that range has been passed.
  *
  * @param display
  *     The display to flush to the video encoding as a new frame.
@@ -116,8 +181,10 @@ int guacenc_display_sync(guacenc_display* display, guac_timestamp timestamp);
  * Flattens the given display, rendering all child layers to the frame buffers
  * of their parent layers. The frame buffer of the default layer of the display
  * will thus contain the flattened, composited rendering of the entire display
- * state after this function succeeds. The contents of the frame buffers of
- * each layer are replaced by this function.
+ * state after this function succeeds. Only the regions of each frame buffer
+ * affected by changes since the previous flatten operation are rendered
+ * again, and the frame_changed flag of the display is set only if the frame
+ * buffer of the default layer was modified.
  *
  * @param display
  *     The display to flatten.
@@ -19,25 +19,191 @@
 
 #include "config.h"
 #include "display.h"
+#include "encode.h"
+#include "index.h"
 #include "instructions.h"
 #include "log.h"
+#include "queue.h"
 
 #include <guacamole/client.h>
 #include <guacamole/error.h>
+#include <guacamole/mem.h>
 #include <guacamole/parser.h>
 #include <guacamole/socket.h>
+#include <guacamole/timestamp.h>
 
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <unistd.h>
 
+/**
+ * A single Guacamole instruction which has been read and parsed from the
+ * input file, and is awaiting handling. The opcode and all arguments are
+ * stored within the same allocated block as the structure itself.
+ */
+typedef struct guacenc_parsed_instruction {
+
+    /**
+     * The opcode of the instruction.
+     */
+    char* opcode;
+
+    /**
+     * The number of arguments passed to the instruction.
+     */
+    int argc;
+
+    /**
+     * All arguments passed to the instruction.
+     */
+    char** argv;
+
+} guacenc_parsed_instruction;
+
+/**
+ * The state of the thread which reads and parses instructions from an input
+ * file, queuing those instructions for handling.
+ */
+typedef struct guacenc_reader {
+
+    /**
+     * The name of the file being parsed (for logging purposes).
+     */
+    const char* path;
+
+    /**
+     * The guac_socket through which instructions should be read.
+     */
+    guac_socket* socket;
+
+    /**
+     * The queue to which each parsed instruction (guacenc_parsed_instruction)
+     * should be pushed. This queue is closed once no further instructions
+     * will be read.
+     */
+    guacenc_queue* instructions;
+
+    /**
+     * Zero if all instructions were read successfully (or reading was stopped
+     * early because no further instructions were needed), non-zero if reading
+     * or parsing of the input file failed. This may only be read after the
+     * reading thread has finished.
+     */
+    int result;
+
+} guacenc_reader;
+
+/**
+ * Copies the instruction most recently parsed by the given guac_parser, such
+ * that it may be handled after the parser has moved on to other instructions.
+ *
+ * @param parser
+ *     The guac_parser containing the instruction to copy.
+ *
+ * @return
+ *     A newly-allocated copy of the instruction, which must eventually be
+ *     freed with guac_mem_free().
+ */
+static guacenc_parsed_instruction* guacenc_copy_instruction(
+        guac_parser* parser) {
+
+    int i;
+
+    /* Determine space required for the instruction as a single block */
+    size_t size = sizeof(guacenc_parsed_instruction)
+        + sizeof(char*) * parser->argc
+        + strlen(parser->opcode) + 1;
+
+    for (i = 0; i < parser->argc; i++)
+        size += strlen(parser->argv[i]) + 1;
+
+    guacenc_parsed_instruction* instruction = guac_mem_alloc(size);
+    instruction->argc = parser->argc;
+    instruction->argv = (char**) (instruction + 1);
+
+    /* Copy opcode and arguments after the argument array */
+    char* current = (char*) (instruction->argv + parser->argc);
+
+    size_t length = strlen(parser->opcode) + 1;
+    instruction->opcode = memcpy(current, parser->opcode, length);
+    current += length;
+
+    for (i = 0; i < parser->argc; i++) {
+        length = strlen(parser->argv[i]) + 1;
+        instruction->argv[i] = memcpy(current, parser->argv[i], length);
+        current += length;
+    }
+
+    return instruction;
+
+}
+
+/**
+ * Reads and parses all Guacamole instructions from the socket of the given
+ * guacenc_reader until end-of-stream is reached, pushing each instruction to
+ * the reader's queue. The queue is closed once reading is complete.
+ *
+ * @param data
+ *     The guacenc_reader describing the socket to read and the queue to
+ *     populate.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guacenc_read_instructions(void* data) {
+
+    guacenc_reader* reader = (guacenc_reader*) data;
+    reader->result = 1;
+
+    /* Obtain Guacamole protocol parser */
+    guac_parser* parser = guac_parser_alloc();
+    if (parser == NULL) {
+        guacenc_queue_close(reader->instructions);
+        return NULL;
+    }
+
+    /* Continuously read and queue all instructions */
+    while (!guac_parser_read(parser, reader->socket, -1)) {
+
+        guacenc_parsed_instruction* instruction =
+            guacenc_copy_instruction(parser);
+
+        /* Stop reading if no further instructions are needed */
+        if (guacenc_queue_push(reader->instructions, instruction)) {
+            guac_mem_free(instruction);
+            reader->result = 0;
+            guac_parser_free(parser);
+            return NULL;
+        }
+
+    }
+
+    /* Fail on read/parse error */
+    if (guac_error != GUAC_STATUS_CLOSED)
+        guacenc_log(GUAC_LOG_ERROR, "%s: %s",
+                reader->path, guac_status_string(guac_error));
+
+    /* Parse complete */
+    else
+        reader->result = 0;
+
+    guacenc_queue_close(reader->instructions);
+    guac_parser_free(parser);
+    return NULL;
+
+}
+
 /**
  * Reads and handles all Guacamole instructions from the given guac_socket
- * until end-of-stream is reached.
+ * until end-of-stream is reached. Instructions are read and parsed on a
+ * separate thread, and are handled as they become available.
  *
  * @param display
  *     The current internal display of the Guacamole video encoder.
@@ -49,43 +215,71 @@
  * @param socket
  *     The guac_socket through which instructions should be read.
  *
+ * @param instruction_count
+ *     Pointer to an int which should receive the total number of
+ *     instructions handled.
+ *
  * @return
  *     Zero on success, non-zero if parsing of Guacamole protocol data through
  *     the given socket fails.
  */
-static int guacenc_read_instructions(guacenc_display* display,
-        const char* path, guac_socket* socket) {
+static int guacenc_handle_instructions(guacenc_display* display,
+        const char* path, guac_socket* socket, int* instruction_count) {
 
-    /* Obtain Guacamole protocol parser */
-    guac_parser* parser = guac_parser_alloc();
-    if (parser == NULL)
+    guacenc_reader reader = {
+        .path = path,
+        .socket = socket
+    };
+
+    reader.instructions = guacenc_queue_alloc(GUACENC_INSTRUCTION_QUEUE_SIZE);
+    if (reader.instructions == NULL)
         return 1;
 
-    /* Continuously read and handle all instructions */
-    while (!guac_parser_read(parser, socket, -1)) {
-        if (guacenc_handle_instruction(display, parser->opcode,
-                parser->argc, parser->argv)) {
+    /* Read instructions in parallel with their handling */
+    pthread_t reader_thread;
+    if (pthread_create(&reader_thread, NULL, guacenc_read_instructions,
+                (void*) &reader)) {
+        guacenc_log(GUAC_LOG_ERROR, "%s: Unable to start reading thread.",
+                path);
+        guacenc_queue_free(reader.instructions);
+        return 1;
+    }
+
+    /* Handle each instruction as it is read */
+    guacenc_parsed_instruction* instruction;
+    while ((instruction = guacenc_queue_pop(reader.instructions)) != NULL) {
+
+        if (guacenc_handle_instruction(display, instruction->opcode,
+                instruction->argc, instruction->argv)) {
             guacenc_log(GUAC_LOG_DEBUG, "Handling of \"%s\" instruction "
-                    "failed.", parser->opcode);
+                    "failed.", instruction->opcode);
+        }
+
+        guac_mem_free(instruction);
+        (*instruction_count)++;
+
+        /* Stop once the end of the requested range has been passed,
+         * discarding anything already read */
+        if (display->ended) {
+            guacenc_queue_close(reader.instructions);
+            while ((instruction = guacenc_queue_pop(reader.instructions)))
+                guac_mem_free(instruction);
         }
-    }
 
-    /* Fail on read/parse error */
-    if (guac_error != GUAC_STATUS_CLOSED) {
-        guacenc_log(GUAC_LOG_ERROR, "%s: %s",
-                path, guac_status_string(guac_error));
-        guac_parser_free(parser);
-        return 1;
     }
 
-    /* Parse complete */
-    guac_parser_free(parser);
-    return 0;
+    pthread_join(reader_thread, NULL);
+    guacenc_queue_free(reader.instructions);
+
+    return reader.result;
 
 }
 
 int guacenc_encode(const char* path, const char* out_path, const char* codec,
-        int width, int height, int bitrate, bool force) {
+        int width, int height, int bitrate, bool force,
+        guac_timestamp start, guac_timestamp end) {
+
+    guac_timestamp began = guac_timestamp_current();
 
     /* Open input file */
     int fd = open(path, O_RDONLY);
@@ -94,6 +288,12 @@ int guacenc_encode(const char* path, const char* out_path, const char* codec,
         return 1;
     }
 
+    /* Determine size of input file (for sake of statistics only) */
+    struct stat file_stat;
+    off_t input_size = 0;
+    if (fstat(fd, &file_stat) == 0)
+        input_size = file_stat.st_size;
+
     /* Lock entire input file for reading by the current process */
     struct flock file_lock = {
         .l_type   = F_RDLCK,
@@ -129,6 +329,45 @@ int guacenc_encode(const char* path, const char* out_path, const char* codec,
         return 1;
     }
 
+    /* Encode only the requested range */
+    display->start = start;
+    display->end = end;
+
+    /* Skip directly to the closest keyframe, if indexed */
+    if (start > 0 || end >= 0) {
+
+        guacenc_index* index = guacenc_index_load(path);
+        if (index != NULL) {
+
+            /* Measure range relative to the beginning of the recording,
+             * which the index records as the timestamp of the first sync */
+            display->origin = index->keyframes[0].timestamp;
+
+            const guacenc_keyframe* keyframe = guacenc_index_find(index,
+                    display->origin + start);
+
+            if (lseek(fd, keyframe->offset, SEEK_SET) == -1) {
+                guacenc_log(GUAC_LOG_ERROR, "%s: %s", path, strerror(errno));
+                guacenc_index_free(index);
+                guacenc_display_free(display);
+                close(fd);
+                return 1;
+            }
+
+            guacenc_log(GUAC_LOG_INFO, "Reading \"%s\" from keyframe at "
+                    "%.1f seconds.", path,
+                    (keyframe->timestamp - display->origin) / 1000.0);
+
+            guacenc_index_free(index);
+
+        }
+
+        else
+            guacenc_log(GUAC_LOG_INFO, "\"%s\" has no index and will be "
+                    "read from the beginning.", path);
+
+    }
+
     /* Obtain guac_socket wrapping file descriptor */
     guac_socket* socket = guac_socket_open(fd);
     if (socket == NULL) {
@@ -142,7 +381,9 @@ int guacenc_encode(const char* path, const char* out_path, const char* codec,
     guacenc_log(GUAC_LOG_INFO, "Encoding \"%s\" to \"%s\" ...", path, out_path);
 
     /* Attempt to read all instructions in the file */
-    if (guacenc_read_instructions(display, path, socket)) {
+    int instruction_count = 0;
+    if (guacenc_handle_instructions(display, path, socket,
+                &instruction_count)) {
         guac_socket_free(socket);
         guacenc_display_free(display);
         return 1;
@@ -150,7 +391,19 @@ int guacenc_encode(const char* path, const char* out_path, const char* codec,
 
     /* Close input and finish encoding process */
     guac_socket_free(socket);
-    return guacenc_display_free(display);
+    int64_t frames = display->output->frames;
+    int result = guacenc_display_free(display);
+
+    /* Report throughput of entire encoding process */
+    guac_timestamp elapsed = guac_timestamp_current() - began;
+    double seconds = (elapsed > 0 ? elapsed : 1) / 1000.0;
+    guacenc_log(GUAC_LOG_INFO, "Encoded \"%s\": %i instructions "
+            "(%.1f MB) and %" PRId64 " frames in %.2f seconds "
+            "(%.1f MB/s, %.1f frames/s).", path, instruction_count,
+            input_size / 1048576.0, frames, seconds,
+            input_size / 1048576.0 / seconds, frames / seconds);
+
+    return result;
 
 }
 
@@ -22,14 +22,27 @@
 
 #include "config.h"
 
+#include <guacamole/timestamp.h>
+
 #include <stdbool.h>
 
+/**
+ * The maximum number of parsed instructions which may be queued for handling
+ * before reading of further instructions from the input file blocks.
+ */
+#define GUACENC_INSTRUCTION_QUEUE_SIZE 1024
+
 /**
  * Encodes the given Guacamole protocol dump as video. A read lock will be
  * acquired on the input file to ensure that in-progress recordings are not
  * encoded. This behavior can be overridden by specifying true for the force
  * parameter.
  *
+ * Reading and parsing of the input file, rendering of the display, and
+ * encoding of video frames each take place on separate threads. Statistics
+ * describing the throughput of the encoding process are logged once encoding
+ * completes.
+ *
  * @param path
  *     The path to the file containing the raw Guacamole protocol dump.
  *
@@ -54,12 +67,25 @@
  *     Perform the encoding, even if the input file appears to be an
  *     in-progress recording (has an associated lock).
  *
+ * @param start
+ *     The position within the recording at which encoding should begin, in
+ *     milliseconds from the beginning of the recording. If the recording has
+ *     an index, reading begins at the closest preceding keyframe. Otherwise,
+ *     the recording is read from the beginning, without encoding anything
+ *     prior to the requested position.
+ *
+ * @param end
+ *     The position within the recording at which encoding should end, in
+ *     milliseconds from the beginning of the recording, or a negative value
+ *     to encode the remainder of the recording.
+ *
  * @return
  *     Zero on success, non-zero if an error prevented successful encoding of
  *     the video.
  */
 int guacenc_encode(const char* path, const char* out_path, const char* codec,
-        int width, int height, int bitrate, bool force);
+        int width, int height, int bitrate, bool force,
+        guac_timestamp start, guac_timestamp end);
 
 #endif
 
@@ -27,10 +27,161 @@
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 
+#include <guacamole/mem.h>
+#include <guacamole/timestamp.h>
+
 #include <getopt.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 
+/**
+ * The set of input files to be encoded, shared by all threads encoding those
+ * files in parallel, along with the options that apply to every file.
+ */
+typedef struct guacenc_jobs {
+
+    /**
+     * Lock which must be acquired whenever next_file or failures is accessed.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * The paths of all input files to be encoded.
+     */
+    char** files;
+
+    /**
+     * The total number of input files to be encoded.
+     */
+    int total_files;
+
+    /**
+     * The index of the next input file which has not yet been claimed for
+     * encoding by any thread.
+     */
+    int next_file;
+
+    /**
+     * The number of input files which could not be encoded.
+     */
+    int failures;
+
+    /**
+     * The width of the output video, in pixels.
+     */
+    int width;
+
+    /**
+     * The height of the output video, in pixels.
+     */
+    int height;
+
+    /**
+     * The desired bitrate of the output video, in bits per second.
+     */
+    int bitrate;
+
+    /**
+     * Whether input files should be encoded even if they appear to be
+     * in-progress recordings.
+     */
+    bool force;
+
+    /**
+     * The position within each recording at which encoding should begin, in
+     * milliseconds from the beginning of the recording.
+     */
+    guac_timestamp start;
+
+    /**
+     * The position within each recording at which encoding should end, in
+     * milliseconds from the beginning of the recording, or a negative value
+     * if each recording should be encoded in its entirety.
+     */
+    guac_timestamp end;
+
+} guacenc_jobs;
+
+/**
+ * Encodes the given input file as video, writing the result to a file having
+ * the same name with the ".m4v" extension added.
+ *
+ * @param jobs
+ *     The options which apply to all input files.
+ *
+ * @param path
+ *     The path of the input file to encode.
+ *
+ * @return
+ *     Zero if the file was encoded successfully, non-zero otherwise.
+ */
+static int guacenc_encode_file(guacenc_jobs* jobs, const char* path) {
+
+    /* Generate output filename */
+    char out_path[4096];
+    int len = snprintf(out_path, sizeof(out_path), "%s.m4v", path);
+
+    /* Do not write if filename exceeds maximum length */
+    if (len >= sizeof(out_path)) {
+        guacenc_log(GUAC_LOG_ERROR, "Cannot write output file for \"%s\": "
+                "Name too long", path);
+        return 1;
+    }
+
+    /* Attempt encoding, log granular success/failure at debug level */
+    if (guacenc_encode(path, out_path, "mpeg4",
+                jobs->width, jobs->height, jobs->bitrate, jobs->force,
+                jobs->start, jobs->end)) {
+        guacenc_log(GUAC_LOG_DEBUG,
+                "%s was NOT successfully encoded.", path);
+        return 1;
+    }
+
+    guacenc_log(GUAC_LOG_DEBUG, "%s was successfully encoded.", path);
+    return 0;
+
+}
+
+/**
+ * Repeatedly claims and encodes input files which have not yet been claimed
+ * by any other thread, until no such files remain.
+ *
+ * @param data
+ *     The guacenc_jobs describing all input files to be encoded.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guacenc_run_jobs(void* data) {
+
+    guacenc_jobs* jobs = (guacenc_jobs*) data;
+
+    for (;;) {
+
+        /* Claim next file, if any */
+        pthread_mutex_lock(&jobs->lock);
+        if (jobs->next_file >= jobs->total_files) {
+            pthread_mutex_unlock(&jobs->lock);
+            break;
+        }
+
+        const char* path = jobs->files[jobs->next_file++];
+        pthread_mutex_unlock(&jobs->lock);
+
+        /* Track number of overall failures */
+        if (guacenc_encode_file(jobs, path)) {
+            pthread_mutex_lock(&jobs->lock);
+            jobs->failures++;
+            pthread_mutex_unlock(&jobs->lock);
+        }
+
+    }
+
+    return NULL;
+
+}
+
 int main(int argc, char* argv[]) {
 
     int i;
@@ -40,10 +191,21 @@ int main(int argc, char* argv[]) {
     int width = GUACENC_DEFAULT_WIDTH;
     int height = GUACENC_DEFAULT_HEIGHT;
     int bitrate = GUACENC_DEFAULT_BITRATE;
+    int job_count = GUACENC_DEFAULT_JOBS;
+    guac_timestamp start_position = 0;
+    guac_timestamp end_position = -1;
+
+    /* Options which are available only in long form */
+    static const struct option long_options[] = {
+        { "start", required_argument, NULL, 'S' },
+        { "end",   required_argument, NULL, 'E' },
+        { NULL,    0,                 NULL, 0   }
+    };
 
     /* Parse arguments */
     int opt;
-    while ((opt = getopt(argc, argv, "s:r:f")) != -1) {
+    while ((opt = getopt_long(argc, argv, "s:r:j:f",
+                    long_options, NULL)) != -1) {
 
         /* -s: Dimensions (WIDTHxHEIGHT) */
         if (opt == 's') {
@@ -61,10 +223,34 @@ int main(int argc, char* argv[]) {
             }
         }
 
+        /* -j: Number of files to encode concurrently */
+        else if (opt == 'j') {
+            if (guacenc_parse_int(optarg, &job_count) || job_count <= 0) {
+                guacenc_log(GUAC_LOG_ERROR, "Invalid number of jobs.");
+                goto invalid_options;
+            }
+        }
+
         /* -f: Force */
         else if (opt == 'f')
             force = true;
 
+        /* --start: Position to begin encoding ([[HH:]MM:]SS) */
+        else if (opt == 'S') {
+            if (guacenc_parse_position(optarg, &start_position)) {
+                guacenc_log(GUAC_LOG_ERROR, "Invalid start position.");
+                goto invalid_options;
+            }
+        }
+
+        /* --end: Position to end encoding ([[HH:]MM:]SS) */
+        else if (opt == 'E') {
+            if (guacenc_parse_position(optarg, &end_position)) {
+                guacenc_log(GUAC_LOG_ERROR, "Invalid end position.");
+                goto invalid_options;
+            }
+        }
+
         /* Invalid option */
         else {
             goto invalid_options;
@@ -72,6 +258,13 @@ int main(int argc, char* argv[]) {
 
     }
 
+    /* The requested range must not be empty */
+    if (end_position >= 0 && end_position <= start_position) {
+        guacenc_log(GUAC_LOG_ERROR, "End position must be after start "
+                "position.");
+        goto invalid_options;
+    }
+
     /* Log start */
     guacenc_log(GUAC_LOG_INFO, "Guacamole video encoder (guacenc) "
             "version " VERSION);
@@ -85,9 +278,7 @@ int main(int argc, char* argv[]) {
     av_register_all();
 #endif
 
-    /* Track number of overall failures */
     int total_files = argc - optind;
-    int failures = 0;
 
     /* Abort if no files given */
     if (total_files <= 0) {
@@ -100,35 +291,65 @@ int main(int argc, char* argv[]) {
     guacenc_log(GUAC_LOG_INFO, "Video will be encoded at %ix%i "
             "and %i bps.", width, height, bitrate);
 
-    /* Encode all input files */
-    for (i = optind; i < argc; i++) {
+    /* Never use more threads than there are files */
+    if (job_count > total_files)
+        job_count = total_files;
 
-        /* Get current filename */
-        const char* path = argv[i];
+    guacenc_jobs jobs = {
+        .files = argv + optind,
+        .total_files = total_files,
+        .width = width,
+        .height = height,
+        .bitrate = bitrate,
+        .force = force,
+        .start = start_position,
+        .end = end_position
+    };
 
-        /* Generate output filename */
-        char out_path[4096];
-        int len = snprintf(out_path, sizeof(out_path), "%s.m4v", path);
+    pthread_mutex_init(&jobs.lock, NULL);
 
-        /* Do not write if filename exceeds maximum length */
-        if (len >= sizeof(out_path)) {
-            guacenc_log(GUAC_LOG_ERROR, "Cannot write output file for \"%s\": "
-                    "Name too long", path);
-            continue;
-        }
+    guac_timestamp start = guac_timestamp_current();
+
+    /* Encode all input files, using additional threads only if multiple
+     * files should be encoded concurrently */
+    if (job_count > 1) {
 
-        /* Attempt encoding, log granular success/failure at debug level */
-        if (guacenc_encode(path, out_path, "mpeg4",
-                    width, height, bitrate, force)) {
-            failures++;
-            guacenc_log(GUAC_LOG_DEBUG,
-                    "%s was NOT successfully encoded.", path);
+        guacenc_log(GUAC_LOG_INFO, "Encoding up to %i files concurrently.",
+                job_count);
+
+        pthread_t* threads = guac_mem_alloc(sizeof(pthread_t), job_count);
+
+        int started = 0;
+        for (i = 0; i < job_count; i++) {
+            if (pthread_create(&threads[started], NULL, guacenc_run_jobs,
+                        (void*) &jobs) == 0)
+                started++;
         }
-        else
-            guacenc_log(GUAC_LOG_DEBUG, "%s was successfully encoded.", path);
+
+        /* Fall back to encoding on the current thread if no threads could be
+         * started */
+        if (started == 0)
+            guacenc_run_jobs(&jobs);
+
+        for (i = 0; i < started; i++)
+            pthread_join(threads[i], NULL);
+
+        guac_mem_free(threads);
 
     }
 
+    else
+        guacenc_run_jobs(&jobs);
+
+    pthread_mutex_destroy(&jobs.lock);
+
+    int failures = jobs.failures;
+
+    /* Report overall throughput */
+    guac_timestamp elapsed = guac_timestamp_current() - start;
+    guacenc_log(GUAC_LOG_INFO, "Processed %i file(s) in %.2f seconds.",
+            total_files, elapsed / 1000.0);
+
     /* Warn if at least one file failed */
     if (failures != 0)
         guacenc_log(GUAC_LOG_WARNING, "Encoding failed for %i of %i file(s).",
@@ -147,7 +368,10 @@ invalid_options:
     fprintf(stderr, "USAGE: %s"
             " [-s WIDTHxHEIGHT]"
             " [-r BITRATE]"
+            " [-j JOBS]"
             " [-f]"
+            " [--start POSITION]"
+            " [--end POSITION]"
             " [FILE]...\n", argv[0]);
 
     return 1;
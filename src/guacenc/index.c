@@ -0,0 +1,117 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "index.h"
+#include "log.h"
+
+#include <guacamole/mem.h>
+#include <guacamole/recording.h>
+#include <guacamole/timestamp.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+
+guacenc_index* guacenc_index_load(const char* path) {
+
+    /* Index resides alongside recording */
+    char index_path[4096];
+    int length = snprintf(index_path, sizeof(index_path),
+            "%s" GUAC_RECORDING_INDEX_SUFFIX, path);
+    if (length >= sizeof(index_path))
+        return NULL;
+
+    FILE* file = fopen(index_path, "r");
+    if (file == NULL)
+        return NULL;
+
+    guacenc_index* index = guac_mem_zalloc(sizeof(guacenc_index));
+    int capacity = 0;
+
+    /* Read all complete entries */
+    uint64_t timestamp;
+    uint64_t offset;
+    while (fscanf(file, "%" SCNu64 ",%" SCNu64 "\n",
+                &timestamp, &offset) == 2) {
+
+        /* Keyframes must be in order */
+        if (index->count > 0
+                && timestamp < index->keyframes[index->count - 1].timestamp) {
+            guacenc_log(GUAC_LOG_WARNING, "Ignoring out-of-order keyframes "
+                    "within \"%s\".", index_path);
+            break;
+        }
+
+        /* Grow array as necessary */
+        if (index->count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            index->keyframes = guac_mem_realloc(index->keyframes,
+                    sizeof(guacenc_keyframe), capacity);
+        }
+
+        guacenc_keyframe* keyframe = &index->keyframes[index->count++];
+        keyframe->timestamp = timestamp;
+        keyframe->offset = offset;
+
+    }
+
+    fclose(file);
+
+    /* An index is only usable if it describes the beginning of the
+     * recording */
+    if (index->count == 0 || index->keyframes[0].offset != 0) {
+        guacenc_log(GUAC_LOG_WARNING, "Ignoring invalid index \"%s\".",
+                index_path);
+        guacenc_index_free(index);
+        return NULL;
+    }
+
+    return index;
+
+}
+
+const guacenc_keyframe* guacenc_index_find(const guacenc_index* index,
+        guac_timestamp timestamp) {
+
+    /* Binary search for the last keyframe at or before the timestamp, with
+     * the first keyframe as a fallback */
+    int low = 0;
+    int high = index->count - 1;
+
+    while (low < high) {
+
+        int mid = low + (high - low + 1) / 2;
+
+        if (index->keyframes[mid].timestamp <= timestamp)
+            low = mid;
+        else
+            high = mid - 1;
+
+    }
+
+    return &index->keyframes[low];
+
+}
+
+void guacenc_index_free(guacenc_index* index) {
+    guac_mem_free(index->keyframes);
+    guac_mem_free(index);
+}
+
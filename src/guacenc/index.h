@@ -0,0 +1,111 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUACENC_INDEX_H
+#define GUACENC_INDEX_H
+
+#include "config.h"
+
+#include <guacamole/timestamp.h>
+
+#include <sys/types.h>
+
+/**
+ * A point within a recording at which the full state of the connection was
+ * written, such that playback can begin at that point without processing any
+ * preceding data.
+ */
+typedef struct guacenc_keyframe {
+
+    /**
+     * The timestamp of the keyframe.
+     */
+    guac_timestamp timestamp;
+
+    /**
+     * The byte offset within the recording at which the keyframe begins.
+     */
+    off_t offset;
+
+} guacenc_keyframe;
+
+/**
+ * The index of a recording, as written alongside that recording by guacd
+ * when indexing is enabled.
+ */
+typedef struct guacenc_index {
+
+    /**
+     * All keyframes within the recording, in order of increasing timestamp.
+     * The first keyframe is the beginning of the recording, and has the
+     * timestamp of the first sync instruction within the recording.
+     */
+    guacenc_keyframe* keyframes;
+
+    /**
+     * The number of keyframes within the keyframes array.
+     */
+    int count;
+
+} guacenc_index;
+
+/**
+ * Loads the index of the recording at the given path, if any. The index is
+ * read from the file having the same name as the recording with
+ * GUAC_RECORDING_INDEX_SUFFIX appended. If the index is incomplete (such as
+ * for an in-progress recording), only the complete entries are loaded.
+ *
+ * @param path
+ *     The path to the recording whose index should be loaded.
+ *
+ * @return
+ *     A newly-allocated guacenc_index containing at least one keyframe, or
+ *     NULL if the recording has no index or the index is invalid.
+ */
+guacenc_index* guacenc_index_load(const char* path);
+
+/**
+ * Returns the latest keyframe within the given index which occurs at or
+ * before the given timestamp. If no such keyframe exists, the first keyframe
+ * (the beginning of the recording) is returned.
+ *
+ * @param index
+ *     The index to search.
+ *
+ * @param timestamp
+ *     The timestamp of the point in the recording which playback should
+ *     reach.
+ *
+ * @return
+ *     The keyframe from which playback should begin to reach the given
+ *     timestamp.
+ */
+const guacenc_keyframe* guacenc_index_find(const guacenc_index* index,
+        guac_timestamp timestamp);
+
+/**
+ * Frees the given index and all keyframes within it.
+ *
+ * @param index
+ *     The index to free.
+ */
+void guacenc_index_free(guacenc_index* index);
+
+#endif
+
@@ -21,6 +21,7 @@
 #include "display.h"
 #include "log.h"
 
+#include <cairo/cairo.h>
 #include <guacamole/client.h>
 
 #include <stdlib.h>
@@ -48,9 +49,25 @@ int guacenc_handle_cfill(guacenc_display* display, int argc, char** argv) {
 
     /* Fill with RGBA color */
     if (buffer->cairo != NULL) {
-        cairo_set_operator(buffer->cairo, guacenc_display_cairo_operator(mask));
+
+        cairo_operator_t op = guacenc_display_cairo_operator(mask);
+
+        /* Record the area affected by the fill, rounding outward by a full
+         * pixel to account for any non-integer coordinates (an empty path
+         * affects nothing unless the operator is unbounded) */
+        double x1, y1, x2, y2;
+        cairo_fill_extents(buffer->cairo, &x1, &y1, &x2, &y2);
+
+        int left = (int) x1 - 1;
+        int top = (int) y1 - 1;
+        int width = x2 > x1 ? (int) x2 + 1 - left : 0;
+        int height = y2 > y1 ? (int) y2 + 1 - top : 0;
+        guacenc_buffer_mark_dirty(buffer, op, left, top, width, height);
+
+        cairo_set_operator(buffer->cairo, op);
         cairo_set_source_rgba(buffer->cairo, r, g, b, a);
         cairo_fill(buffer->cairo);
+
     }
 
     return 0;
@@ -55,6 +55,9 @@ int guacenc_handle_move(guacenc_display* display, int argc, char** argv) {
     layer->y = y;
     layer->z = z;
 
+    /* Composition of layers must be rebuilt */
+    display->layers_changed = true;
+
     return 0;
 
 }
@@ -45,6 +45,9 @@ int guacenc_handle_shade(guacenc_display* display, int argc, char** argv) {
     /* Update layer properties */
     layer->opacity = opacity;
 
+    /* Composition of layers must be rebuilt */
+    display->layers_changed = true;
+
     return 0;
 
 }
@@ -23,8 +23,9 @@
 #include "log.h"
 
 #include <guacamole/client.h>
+#include <guacamole/opcode-map.h>
 
-#include <string.h>
+#include <pthread.h>
 
 guacenc_instruction_handler_mapping guacenc_instruction_handler_map[] = {
     {"blob",     guacenc_handle_blob},
@@ -44,31 +45,50 @@ guacenc_instruction_handler_mapping guacenc_instruction_handler_map[] = {
     {NULL,       NULL}
 };
 
+/**
+ * Index of guacenc_instruction_handler_map, allowing the handler for any
+ * opcode to be located without comparing against every opcode in turn.
+ */
+static guac_opcode_map guacenc_instruction_opcode_map;
+
+/**
+ * Guard ensuring guacenc_instruction_opcode_map is built exactly once.
+ */
+static pthread_once_t guacenc_instruction_opcode_map_initialized =
+    PTHREAD_ONCE_INIT;
+
+/**
+ * Builds guacenc_instruction_opcode_map. This function is invoked exactly
+ * once, via pthread_once(), prior to the first instruction being handled.
+ */
+static void guacenc_init_instruction_opcode_map() {
+    guac_opcode_map_init(&guacenc_instruction_opcode_map,
+            guacenc_instruction_handler_map,
+            sizeof(guacenc_instruction_handler_mapping));
+}
+
 int guacenc_handle_instruction(guacenc_display* display, const char* opcode,
         int argc, char** argv) {
 
-    /* Search through mapping for instruction handler having given opcode */
-    guacenc_instruction_handler_mapping* current = guacenc_instruction_handler_map;
-    while (current->opcode != NULL) {
-
-        /* Invoke handler if opcode matches (if defined) */
-        if (strcmp(current->opcode, opcode) == 0) {
+    pthread_once(&guacenc_instruction_opcode_map_initialized,
+            guacenc_init_instruction_opcode_map);
 
-            /* Invoke defined handler */
-            guacenc_instruction_handler* handler = current->handler;
-            if (handler != NULL)
-                return handler(display, argc, argv);
+    /* Locate instruction handler having given opcode */
+    const guacenc_instruction_handler_mapping* mapping =
+        guac_opcode_map_lookup(&guacenc_instruction_opcode_map, opcode);
 
-            /* Log defined but unimplemented instructions */
-            guacenc_log(GUAC_LOG_DEBUG, "\"%s\" not implemented", opcode);
-            return 0;
+    if (mapping != NULL) {
 
-        }
+        /* Invoke defined handler */
+        guacenc_instruction_handler* handler = mapping->handler;
+        if (handler != NULL)
+            return handler(display, argc, argv);
 
-        /* Next candidate handler */
-        current++;
+        /* Log defined but unimplemented instructions */
+        guacenc_log(GUAC_LOG_DEBUG, "\"%s\" not implemented", opcode);
+        return 0;
 
-    } /* end opcode search */
+    }
 
     /* Ignore any unknown instructions */
     return 0;
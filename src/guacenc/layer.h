@@ -22,6 +22,7 @@
 
 #include "config.h"
 #include "buffer.h"
+#include "rect.h"
 
 /**
  * The value assigned to the parent_index property of a guacenc_layer if it has
@@ -77,6 +78,13 @@ typedef struct guacenc_layer {
      */
     guacenc_buffer* frame;
 
+    /**
+     * The region of the frame buffer of this layer which must be rendered
+     * again during the flatten operation in progress, in the coordinates of
+     * this layer. Outside of guacenc_display_flatten(), this is empty.
+     */
+    guacenc_rect damage;
+
 } guacenc_layer;
 
 /**
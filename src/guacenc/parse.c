@@ -69,6 +69,53 @@ int guacenc_parse_dimensions(char* arg, int* width, int* height) {
 
 }
 
+int guacenc_parse_position(const char* arg, guac_timestamp* position) {
+
+    guac_timestamp value = 0;
+    int components = 0;
+
+    /* Parse each colon-separated component */
+    for (;;) {
+
+        char* end;
+
+        /* Each component must begin with a digit (no signs or whitespace) */
+        if (*arg < '0' || *arg > '9')
+            return 1;
+
+        errno = 0;
+        long int component = strtol(arg, &end, 10);
+        if (errno != 0 || component > INT_MAX)
+            return 1;
+
+        /* Components other than the first (and largest) may not overflow
+         * into the next */
+        if (components > 0 && component >= 60)
+            return 1;
+
+        value = value * 60 + component;
+        components++;
+
+        if (*end == '\0')
+            break;
+
+        /* Components must be separated by colons, with at most three
+         * components (hours, minutes, and seconds) */
+        if (*end != ':' || components == 3)
+            return 1;
+
+        arg = end + 1;
+
+    }
+
+    /* Store value in milliseconds */
+    *position = value * 1000;
+
+    /* Parsing successful */
+    return 0;
+
+}
+
 guac_timestamp guacenc_parse_timestamp(const char* str) {
 
     int sign = 1;
@@ -65,6 +65,24 @@ int guacenc_parse_int(char* arg, int* i);
  */
 int guacenc_parse_dimensions(char* arg, int* width, int* height);
 
+/**
+ * Parses a position within a recording of the form [[HOURS:]MINUTES:]SECONDS,
+ * where each component is a non-negative decimal integer. The parsed value
+ * will be stored in the provided pointer only if the given position is valid.
+ *
+ * @param arg
+ *     The string to parse.
+ *
+ * @param position
+ *     A pointer to the guac_timestamp in which the parsed position should be
+ *     stored, in milliseconds.
+ *
+ * @return
+ *     Zero if parsing was successful, non-zero if the provided string was
+ *     invalid.
+ */
+int guacenc_parse_position(const char* arg, guac_timestamp* position);
+
 /**
  * Parses a guac_timestamp from the given string. The string is assumed to
  * consist solely of decimal digits with an optional leading minus sign. If the
@@ -0,0 +1,122 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "queue.h"
+
+#include <guacamole/mem.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+
+guacenc_queue* guacenc_queue_alloc(int capacity) {
+
+    guacenc_queue* queue = guac_mem_zalloc(sizeof(guacenc_queue));
+    if (queue == NULL)
+        return NULL;
+
+    queue->items = guac_mem_zalloc(sizeof(void*), capacity);
+    if (queue->items == NULL) {
+        guac_mem_free(queue);
+        return NULL;
+    }
+
+    queue->capacity = capacity;
+
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+
+    return queue;
+
+}
+
+void guacenc_queue_free(guacenc_queue* queue) {
+
+    pthread_cond_destroy(&queue->not_full);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_mutex_destroy(&queue->lock);
+
+    guac_mem_free(queue->items);
+    guac_mem_free(queue);
+
+}
+
+int guacenc_queue_push(guacenc_queue* queue, void* item) {
+
+    pthread_mutex_lock(&queue->lock);
+
+    /* Wait for space to become available */
+    while (!queue->closed && queue->length == queue->capacity)
+        pthread_cond_wait(&queue->not_full, &queue->lock);
+
+    /* Refuse new items once closed */
+    if (queue->closed) {
+        pthread_mutex_unlock(&queue->lock);
+        return 1;
+    }
+
+    int tail = (queue->head + queue->length) % queue->capacity;
+    queue->items[tail] = item;
+    queue->length++;
+
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+
+    return 0;
+
+}
+
+void* guacenc_queue_pop(guacenc_queue* queue) {
+
+    pthread_mutex_lock(&queue->lock);
+
+    /* Wait for an item to become available */
+    while (!queue->closed && queue->length == 0)
+        pthread_cond_wait(&queue->not_empty, &queue->lock);
+
+    /* Nothing further will be available once closed and drained */
+    if (queue->length == 0) {
+        pthread_mutex_unlock(&queue->lock);
+        return NULL;
+    }
+
+    void* item = queue->items[queue->head];
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->length--;
+
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+
+    return item;
+
+}
+
+void guacenc_queue_close(guacenc_queue* queue) {
+
+    pthread_mutex_lock(&queue->lock);
+
+    queue->closed = true;
+
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+
+}
+
@@ -0,0 +1,142 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUACENC_QUEUE_H
+#define GUACENC_QUEUE_H
+
+#include "config.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+
+/**
+ * A bounded, first-in-first-out queue of arbitrary items which connects two
+ * threads of the encoding pipeline. Pushing to a full queue blocks until
+ * space is available, and popping from an empty queue blocks until an item is
+ * pushed or the queue is closed.
+ */
+typedef struct guacenc_queue {
+
+    /**
+     * Lock which is acquired whenever the queue is accessed.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Condition which is signalled whenever an item is pushed or the queue is
+     * closed.
+     */
+    pthread_cond_t not_empty;
+
+    /**
+     * Condition which is signalled whenever an item is popped or the queue is
+     * closed.
+     */
+    pthread_cond_t not_full;
+
+    /**
+     * Circular buffer of all items currently within the queue.
+     */
+    void** items;
+
+    /**
+     * The maximum number of items that the queue may contain.
+     */
+    int capacity;
+
+    /**
+     * The index of the oldest item within the queue.
+     */
+    int head;
+
+    /**
+     * The number of items currently within the queue.
+     */
+    int length;
+
+    /**
+     * Whether the queue has been closed. Items can no longer be pushed to a
+     * closed queue, though any items already present can still be popped.
+     */
+    bool closed;
+
+} guacenc_queue;
+
+/**
+ * Allocates a new, empty queue which may contain up to the given number of
+ * items.
+ *
+ * @param capacity
+ *     The maximum number of items that the queue may contain.
+ *
+ * @return
+ *     A newly-allocated queue, or NULL if allocation fails.
+ */
+guacenc_queue* guacenc_queue_alloc(int capacity);
+
+/**
+ * Frees the given queue. Any items still within the queue are not freed. No
+ * thread may be using the queue when it is freed.
+ *
+ * @param queue
+ *     The queue to free.
+ */
+void guacenc_queue_free(guacenc_queue* queue);
+
+/**
+ * Adds the given item to the end of the given queue, waiting for space to
+ * become available if the queue is full.
+ *
+ * @param queue
+ *     The queue to add the item to.
+ *
+ * @param item
+ *     The item to add. This may not be NULL.
+ *
+ * @return
+ *     Zero if the item was added, non-zero if the queue has been closed and
+ *     the item was not added.
+ */
+int guacenc_queue_push(guacenc_queue* queue, void* item);
+
+/**
+ * Removes and returns the item at the front of the given queue, waiting for
+ * an item to be added if the queue is empty.
+ *
+ * @param queue
+ *     The queue to remove an item from.
+ *
+ * @return
+ *     The item removed from the queue, or NULL if the queue has been closed
+ *     and no items remain.
+ */
+void* guacenc_queue_pop(guacenc_queue* queue);
+
+/**
+ * Closes the given queue, waking any threads waiting on the queue. Further
+ * attempts to push items will fail, while items already within the queue
+ * can still be popped.
+ *
+ * @param queue
+ *     The queue to close.
+ */
+void guacenc_queue_close(guacenc_queue* queue);
+
+#endif
+
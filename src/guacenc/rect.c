@@ -0,0 +1,80 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+#include "rect.h"
+
+#include <stdbool.h>
+
+void guacenc_rect_init(guacenc_rect* rect, int x, int y, int width,
+        int height) {
+    rect->left = x;
+    rect->top = y;
+    rect->right = x + width;
+    rect->bottom = y + height;
+}
+
+void guacenc_rect_clear(guacenc_rect* rect) {
+    guacenc_rect_init(rect, 0, 0, 0, 0);
+}
+
+bool guacenc_rect_is_empty(const guacenc_rect* rect) {
+    return rect->right <= rect->left || rect->bottom <= rect->top;
+}
+
+void guacenc_rect_extend(guacenc_rect* rect, const guacenc_rect* other) {
+
+    /* Extending by nothing has no effect */
+    if (guacenc_rect_is_empty(other))
+        return;
+
+    /* Extending nothing results in the other rectangle */
+    if (guacenc_rect_is_empty(rect)) {
+        *rect = *other;
+        return;
+    }
+
+    if (other->left < rect->left)     rect->left = other->left;
+    if (other->top < rect->top)       rect->top = other->top;
+    if (other->right > rect->right)   rect->right = other->right;
+    if (other->bottom > rect->bottom) rect->bottom = other->bottom;
+
+}
+
+void guacenc_rect_intersect(guacenc_rect* rect, const guacenc_rect* other) {
+
+    if (other->left > rect->left)     rect->left = other->left;
+    if (other->top > rect->top)       rect->top = other->top;
+    if (other->right < rect->right)   rect->right = other->right;
+    if (other->bottom < rect->bottom) rect->bottom = other->bottom;
+
+    /* Normalize non-intersecting rectangles */
+    if (guacenc_rect_is_empty(rect))
+        guacenc_rect_clear(rect);
+
+}
+
+bool guacenc_rect_intersects(const guacenc_rect* a, const guacenc_rect* b) {
+
+    guacenc_rect intersection = *a;
+    guacenc_rect_intersect(&intersection, b);
+
+    return !guacenc_rect_is_empty(&intersection);
+
+}
@@ -0,0 +1,133 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUACENC_RECT_H
+#define GUACENC_RECT_H
+
+#include "config.h"
+
+#include <stdbool.h>
+
+/**
+ * An arbitrary rectangle, described by the coordinates of its edges. The
+ * right and bottom edges are exclusive. A rectangle having no area is empty.
+ */
+typedef struct guacenc_rect {
+
+    /**
+     * The X coordinate of the left edge of the rectangle, inclusive.
+     */
+    int left;
+
+    /**
+     * The Y coordinate of the top edge of the rectangle, inclusive.
+     */
+    int top;
+
+    /**
+     * The X coordinate of the right edge of the rectangle, exclusive.
+     */
+    int right;
+
+    /**
+     * The Y coordinate of the bottom edge of the rectangle, exclusive.
+     */
+    int bottom;
+
+} guacenc_rect;
+
+/**
+ * Initializes the given rectangle with the given position and size.
+ *
+ * @param rect
+ *     The rectangle to initialize.
+ *
+ * @param x
+ *     The X coordinate of the upper-left corner of the rectangle.
+ *
+ * @param y
+ *     The Y coordinate of the upper-left corner of the rectangle.
+ *
+ * @param width
+ *     The width of the rectangle, in pixels.
+ *
+ * @param height
+ *     The height of the rectangle, in pixels.
+ */
+void guacenc_rect_init(guacenc_rect* rect, int x, int y, int width,
+        int height);
+
+/**
+ * Resets the given rectangle such that it is empty.
+ *
+ * @param rect
+ *     The rectangle to reset.
+ */
+void guacenc_rect_clear(guacenc_rect* rect);
+
+/**
+ * Returns whether the given rectangle has no area.
+ *
+ * @param rect
+ *     The rectangle to test.
+ *
+ * @return
+ *     true if the rectangle is empty, false otherwise.
+ */
+bool guacenc_rect_is_empty(const guacenc_rect* rect);
+
+/**
+ * Extends the given rectangle such that it also contains the given other
+ * rectangle. If the other rectangle is empty, this function has no effect.
+ *
+ * @param rect
+ *     The rectangle to extend.
+ *
+ * @param other
+ *     The rectangle which must be contained within the extended rectangle.
+ */
+void guacenc_rect_extend(guacenc_rect* rect, const guacenc_rect* other);
+
+/**
+ * Reduces the given rectangle to its intersection with the given other
+ * rectangle. If the rectangles do not intersect, the result is empty.
+ *
+ * @param rect
+ *     The rectangle to reduce.
+ *
+ * @param other
+ *     The rectangle to intersect with.
+ */
+void guacenc_rect_intersect(guacenc_rect* rect, const guacenc_rect* other);
+
+/**
+ * Returns whether the given rectangles share any area.
+ *
+ * @param a
+ *     The first rectangle.
+ *
+ * @param b
+ *     The second rectangle.
+ *
+ * @return
+ *     true if the rectangles intersect, false otherwise.
+ */
+bool guacenc_rect_intersects(const guacenc_rect* a, const guacenc_rect* b);
+
+#endif
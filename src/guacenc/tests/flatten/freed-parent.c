@@ -0,0 +1,138 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "buffer.h"
+#include "cursor.h"
+#include "display.h"
+#include "layer.h"
+
+#include <CUnit/CUnit.h>
+#include <cairo/cairo.h>
+#include <guacamole/mem.h>
+
+#include <stdint.h>
+
+/**
+ * ARGB value of an opaque black pixel.
+ */
+#define TEST_BLACK 0xFF000000
+
+/**
+ * ARGB value of an opaque white pixel.
+ */
+#define TEST_WHITE 0xFFFFFFFF
+
+/**
+ * Resizes the given layer and fills it with the given opaque color, marking
+ * the layer as dirty.
+ *
+ * @param layer
+ *     The layer to fill.
+ *
+ * @param width
+ *     The new width of the layer, in pixels.
+ *
+ * @param height
+ *     The new height of the layer, in pixels.
+ *
+ * @param color
+ *     The gray level to fill the layer with, from 0.0 (black) to 1.0
+ *     (white).
+ */
+static void test_fill(guacenc_layer* layer, int width, int height,
+        double color) {
+
+    guacenc_buffer* buffer = layer->buffer;
+    CU_ASSERT_EQUAL_FATAL(guacenc_buffer_resize(buffer, width, height), 0);
+
+    cairo_set_source_rgb(buffer->cairo, color, color, color);
+    cairo_paint(buffer->cairo);
+    guacenc_buffer_mark_all_dirty(buffer);
+
+}
+
+/**
+ * Returns the ARGB value of the pixel at the given coordinates within the
+ * given buffer.
+ *
+ * @param buffer
+ *     The buffer to read from.
+ *
+ * @param x
+ *     The X coordinate of the pixel.
+ *
+ * @param y
+ *     The Y coordinate of the pixel.
+ *
+ * @return
+ *     The ARGB value of the pixel.
+ */
+static uint32_t test_pixel(guacenc_buffer* buffer, int x, int y) {
+    return ((uint32_t*) (buffer->image + y * buffer->stride))[x];
+}
+
+/**
+ * Verifies that a parent layer which is implicitly allocated again while
+ * layers are sorted for rendering (because a child still references it after
+ * it was freed) is included in the composition, such that anything later
+ * drawn to that parent is rendered.
+ */
+void test_flatten__freed_parent() {
+
+    guacenc_display* display = guac_mem_zalloc(sizeof(guacenc_display));
+    display->cursor = guacenc_cursor_alloc();
+    display->layers_changed = true;
+
+    /* Black default layer */
+    guacenc_layer* def_layer = guacenc_display_get_layer(display, 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(def_layer);
+    test_fill(def_layer, 100, 100, 0.0);
+
+    /* Empty layer 2 is the parent of empty layer 1 */
+    guacenc_layer* parent = guacenc_display_get_layer(display, 2);
+    guacenc_layer* child = guacenc_display_get_layer(display, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(parent);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(child);
+    child->parent_index = 2;
+
+    CU_ASSERT_EQUAL_FATAL(guacenc_display_flatten(display), 0);
+    CU_ASSERT_EQUAL(test_pixel(def_layer->frame, 10, 10), TEST_BLACK);
+
+    /* Free the parent while the child still references it. The parent is
+     * allocated again as the layers are sorted for the next frame. */
+    CU_ASSERT_EQUAL(guacenc_display_free_layer(display, 2), 0);
+    CU_ASSERT_EQUAL_FATAL(guacenc_display_flatten(display), 0);
+    CU_ASSERT_FALSE(display->layers_changed);
+
+    parent = display->layers[2];
+    CU_ASSERT_PTR_NOT_NULL_FATAL(parent);
+
+    /* Anything drawn to the new parent must be rendered */
+    test_fill(parent, 50, 50, 1.0);
+
+    CU_ASSERT_EQUAL_FATAL(guacenc_display_flatten(display), 0);
+    CU_ASSERT_EQUAL(test_pixel(def_layer->frame, 10, 10), TEST_WHITE);
+    CU_ASSERT_EQUAL(test_pixel(def_layer->frame, 60, 60), TEST_BLACK);
+
+    for (int i = 0; i < GUACENC_DISPLAY_MAX_LAYERS; i++)
+        guacenc_layer_free(display->layers[i]);
+
+    guacenc_cursor_free(display->cursor);
+    guac_mem_free(display);
+
+}
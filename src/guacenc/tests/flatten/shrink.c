@@ -0,0 +1,149 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "buffer.h"
+#include "cursor.h"
+#include "display.h"
+#include "instructions.h"
+#include "layer.h"
+
+#include <CUnit/CUnit.h>
+#include <cairo/cairo.h>
+#include <guacamole/mem.h>
+
+#include <stdint.h>
+
+/**
+ * ARGB value of an opaque black pixel.
+ */
+#define TEST_BLACK 0xFF000000
+
+/**
+ * ARGB value of an opaque white pixel.
+ */
+#define TEST_WHITE 0xFFFFFFFF
+
+/**
+ * Fills the entire given buffer with the given opaque color, marking the
+ * buffer as dirty.
+ *
+ * @param buffer
+ *     The buffer to fill.
+ *
+ * @param color
+ *     The gray level to fill the buffer with, from 0.0 (black) to 1.0
+ *     (white).
+ */
+static void test_fill(guacenc_buffer* buffer, double color) {
+    cairo_set_source_rgb(buffer->cairo, color, color, color);
+    cairo_paint(buffer->cairo);
+    guacenc_buffer_mark_all_dirty(buffer);
+}
+
+/**
+ * Returns the ARGB value of the pixel at the given coordinates within the
+ * given buffer.
+ *
+ * @param buffer
+ *     The buffer to read from.
+ *
+ * @param x
+ *     The X coordinate of the pixel.
+ *
+ * @param y
+ *     The Y coordinate of the pixel.
+ *
+ * @return
+ *     The ARGB value of the pixel.
+ */
+static uint32_t test_pixel(guacenc_buffer* buffer, int x, int y) {
+    return ((uint32_t*) (buffer->image + y * buffer->stride))[x];
+}
+
+/**
+ * Resizes the given layer as a "size" instruction would.
+ *
+ * @param display
+ *     The display containing the layer.
+ *
+ * @param index
+ *     The index of the layer, as a string.
+ *
+ * @param width
+ *     The new width of the layer, as a string.
+ *
+ * @param height
+ *     The new height of the layer, as a string.
+ */
+static void test_size(guacenc_display* display, char* index, char* width,
+        char* height) {
+    char* argv[] = { index, width, height };
+    CU_ASSERT_EQUAL(guacenc_handle_size(display, 3, argv), 0);
+}
+
+/**
+ * Verifies that shrinking a visible child layer, including shrinking it to
+ * nothing, causes the area of its parent which the child no longer covers to
+ * be rendered again, rather than retaining the old contents of the child.
+ */
+void test_flatten__shrink() {
+
+    guacenc_display* display = guac_mem_zalloc(sizeof(guacenc_display));
+    display->cursor = guacenc_cursor_alloc();
+    display->layers_changed = true;
+
+    /* Black default layer */
+    guacenc_layer* def_layer = guacenc_display_get_layer(display, 0);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(def_layer);
+    test_size(display, "0", "100", "100");
+    test_fill(def_layer->buffer, 0.0);
+
+    /* White child layer covering its top-left corner */
+    guacenc_layer* layer = guacenc_display_get_layer(display, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(layer);
+    test_size(display, "1", "50", "50");
+    test_fill(layer->buffer, 1.0);
+
+    CU_ASSERT_EQUAL_FATAL(guacenc_display_flatten(display), 0);
+    CU_ASSERT_EQUAL(test_pixel(def_layer->frame, 10, 10), TEST_WHITE);
+    CU_ASSERT_EQUAL(test_pixel(def_layer->frame, 40, 40), TEST_WHITE);
+    CU_ASSERT_EQUAL(test_pixel(def_layer->frame, 60, 60), TEST_BLACK);
+
+    /* Area no longer covered by the shrunk layer must be black again */
+    test_size(display, "1", "20", "20");
+    CU_ASSERT_FALSE(display->layers_changed);
+
+    CU_ASSERT_EQUAL_FATAL(guacenc_display_flatten(display), 0);
+    CU_ASSERT_EQUAL(test_pixel(def_layer->frame, 10, 10), TEST_WHITE);
+    CU_ASSERT_EQUAL(test_pixel(def_layer->frame, 40, 40), TEST_BLACK);
+    CU_ASSERT_EQUAL(test_pixel(def_layer->frame, 60, 60), TEST_BLACK);
+
+    /* Nothing remains of a layer resized to nothing */
+    test_size(display, "1", "0", "0");
+
+    CU_ASSERT_EQUAL_FATAL(guacenc_display_flatten(display), 0);
+    CU_ASSERT_EQUAL(test_pixel(def_layer->frame, 10, 10), TEST_BLACK);
+    CU_ASSERT_EQUAL(test_pixel(def_layer->frame, 40, 40), TEST_BLACK);
+
+    for (int i = 0; i < GUACENC_DISPLAY_MAX_LAYERS; i++)
+        guacenc_layer_free(display->layers[i]);
+
+    guacenc_cursor_free(display->cursor);
+    guac_mem_free(display);
+
+}
@@ -21,6 +21,7 @@
 #include "buffer.h"
 #include "ffmpeg-compat.h"
 #include "log.h"
+#include "queue.h"
 #include "video.h"
 
 #include <cairo/cairo.h>
@@ -41,10 +42,51 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+/**
+ * An operation to be performed by the encoding thread of a guacenc_video.
+ * Operations are performed in the order they are queued.
+ */
+typedef struct guacenc_video_operation {
+
+    /**
+     * A copy of the image data of a new frame which should replace the frame
+     * to be written, or NULL if the frame to be written should not change.
+     * This image data is in the same format as the image data of a
+     * guacenc_buffer.
+     */
+    unsigned char* image;
+
+    /**
+     * The width of the copied image data, in pixels.
+     */
+    int width;
+
+    /**
+     * The height of the copied image data, in pixels.
+     */
+    int height;
+
+    /**
+     * The number of bytes in each row of the copied image data.
+     */
+    int stride;
+
+    /**
+     * The number of times the frame to be written should be written, after
+     * replacing that frame with any new frame provided.
+     */
+    int count;
+
+} guacenc_video_operation;
+
+static void* guacenc_video_encode_operations(void* data);
+
 guacenc_video* guacenc_video_alloc(const char* path, const char* codec_name,
         int width, int height, int bitrate) {
 
@@ -155,10 +197,29 @@ guacenc_video* guacenc_video_alloc(const char* path, const char* codec_name,
     /* No frames have been written or prepared yet */
     video->last_timestamp = 0;
     video->next_pts = 0;
+    video->frames = 0;
+    video->failed = false;
+
+    /* Convert and encode frames on a dedicated thread */
+    video->operations = guacenc_queue_alloc(GUACENC_VIDEO_QUEUE_SIZE);
+    if (video->operations == NULL)
+        goto fail_queue;
+
+    if (pthread_create(&video->encoder_thread, NULL,
+                guacenc_video_encode_operations, (void*) video)) {
+        guacenc_log(GUAC_LOG_ERROR, "Unable to start encoding thread.");
+        goto fail_thread;
+    }
 
     return video;
 
     /* Free all allocated data in case of failure */
+fail_thread:
+    guacenc_queue_free(video->operations);
+
+fail_queue:
+    guac_mem_free(video);
+
 fail_alloc_video:
 fail_output_file:
     avio_close(container_format_context->pb);
@@ -229,20 +290,64 @@ static int guacenc_video_write_frame(guacenc_video* video, AVFrame* frame) {
 }
 
 /**
- * Flushes the frame previously specified by guacenc_video_prepare_frame() as a
- * new frame of video, updating the internal video timestamp by one frame's
- * worth of time.
+ * Frees the given operation, including any image data it contains.
+ *
+ * @param operation
+ *     The operation to free.
+ */
+static void guacenc_video_operation_free(guacenc_video_operation* operation) {
+    guac_mem_free(operation->image);
+    guac_mem_free(operation);
+}
+
+/**
+ * Queues the given operation for the encoding thread of the given video. If
+ * the operation cannot be queued, it is freed.
+ *
+ * @param video
+ *     The video whose encoding thread should perform the operation.
+ *
+ * @param operation
+ *     The operation to queue.
+ *
+ * @return
+ *     Zero if the operation was queued, non-zero if encoding has failed and
+ *     no further operations can be queued.
+ */
+static int guacenc_video_queue_operation(guacenc_video* video,
+        guacenc_video_operation* operation) {
+
+    if (guacenc_queue_push(video->operations, operation)) {
+        guacenc_video_operation_free(operation);
+        return 1;
+    }
+
+    return 0;
+
+}
+
+/**
+ * Queues the frame previously specified by guacenc_video_prepare_frame() to
+ * be written the given number of times as new frames of video, updating the
+ * internal video timestamp by one frame's worth of time for each.
  *
  * @param video
  *     The video to flush.
  *
+ * @param count
+ *     The number of times the frame should be written.
+ *
  * @return
  *     Zero if flushing was successful, non-zero if an error occurs.
  */
-static int guacenc_video_flush_frame(guacenc_video* video) {
+static int guacenc_video_flush_frames(guacenc_video* video, int count) {
 
-    /* Write frame to video */
-    return guacenc_video_write_frame(video, video->next_frame) < 0;
+    guacenc_video_operation* operation =
+        guac_mem_zalloc(sizeof(guacenc_video_operation));
+    operation->count = count;
+
+    video->frames += count;
+    return guacenc_video_queue_operation(video, operation);
 
 }
 
@@ -267,13 +372,8 @@ int guacenc_video_advance_timeline(guacenc_video* video,
                         + elapsed * 1000 / GUACENC_VIDEO_FRAMERATE;
 
         /* Flush frames to bring timeline in sync, duplicating if necessary */
-        do {
-            if (guacenc_video_flush_frame(video)) {
-                guacenc_log(GUAC_LOG_ERROR, "Unable to flush frame to video "
-                        "stream.");
-                return 1;
-            }
-        } while (--elapsed != 0);
+        if (guacenc_video_flush_frames(video, elapsed))
+            return 1;
 
     }
 
@@ -284,12 +384,13 @@ int guacenc_video_advance_timeline(guacenc_video* video,
 }
 
 /**
- * Converts the given Guacamole video encoder buffer to a frame in the format
+ * Converts the image data of the given operation to a frame in the format
  * required by libavcodec / libswscale. Black margins of the specified sizes
  * will be added. No scaling is performed; the image data is copied verbatim.
  *
- * @param buffer
- *     The guacenc_buffer to copy as a new AVFrame.
+ * @param operation
+ *     The guacenc_video_operation whose image data should be copied as a new
+ *     AVFrame.
  *
  * @param lsize
  *     The size of the letterboxes to add, in pixels. Letterboxes are the
@@ -305,11 +406,11 @@ int guacenc_video_advance_timeline(guacenc_video* video,
  *
  * @return
  *     A pointer to a newly-allocated AVFrame containing exactly the same image
- *     data as the given buffer. The image data within the frame and the frame
- *     itself must be manually freed later.
+ *     data as the given operation. The image data within the frame and the
+ *     frame itself must be manually freed later.
  */
-static AVFrame* guacenc_video_frame_convert(guacenc_buffer* buffer, int lsize,
-        int psize) {
+static AVFrame* guacenc_video_frame_convert(
+        guacenc_video_operation* operation, int lsize, int psize) {
 
     /* Init size of left/right pillarboxes */
     int left = psize;
@@ -326,8 +427,8 @@ static AVFrame* guacenc_video_frame_convert(guacenc_buffer* buffer, int lsize,
 
     /* Copy buffer properties to frame */
     frame->format = AV_PIX_FMT_RGB32;
-    frame->width = buffer->width + left + right;
-    frame->height = buffer->height + top + bottom;
+    frame->width = operation->width + left + right;
+    frame->height = operation->height + top + bottom;
 
     /* Allocate actual backing data for frame */
     if (av_image_alloc(frame->data, frame->linesize, frame->width,
@@ -336,20 +437,17 @@ static AVFrame* guacenc_video_frame_convert(guacenc_buffer* buffer, int lsize,
         return NULL;
     }
 
-    /* Flush any pending operations */
-    cairo_surface_flush(buffer->surface);
-
     /* Get pointer to source image data */
-    unsigned char* src_data = buffer->image;
-    int src_stride = buffer->stride;
+    unsigned char* src_data = operation->image;
+    int src_stride = operation->stride;
 
     /* Get pointer to destination image data */
     unsigned char* dst_data = frame->data[0];
     int dst_stride = frame->linesize[0];
 
     /* Get source/destination dimensions */
-    int width = buffer->width;
-    int height = buffer->height;
+    int width = operation->width;
+    int height = operation->height;
 
     /* Source buffer is guaranteed to fit within destination buffer */
     assert(width <= frame->width);
@@ -398,29 +496,36 @@ static AVFrame* guacenc_video_frame_convert(guacenc_buffer* buffer, int lsize,
 
 }
 
-void guacenc_video_prepare_frame(guacenc_video* video, guacenc_buffer* buffer) {
+/**
+ * Replaces the frame to be written to the given video with the image data of
+ * the given operation, scaling that image data to fit the video.
+ *
+ * @param video
+ *     The video whose next frame should be replaced.
+ *
+ * @param operation
+ *     The operation containing the image data of the new frame.
+ */
+static void guacenc_video_scale_frame(guacenc_video* video,
+        guacenc_video_operation* operation) {
 
     int lsize;
     int psize;
 
-    /* Ignore NULL buffers */
-    if (buffer == NULL || buffer->surface == NULL)
-        return;
-
     /* Obtain destination frame */
     AVFrame* dst = video->next_frame;
 
     /* Determine width of image if height is scaled to match destination */
-    int scaled_width = buffer->width * dst->height / buffer->height;
+    int scaled_width = operation->width * dst->height / operation->height;
 
     /* Determine height of image if width is scaled to match destination */
-    int scaled_height = buffer->height * dst->width / buffer->width;
+    int scaled_height = operation->height * dst->width / operation->width;
 
     /* If height-based scaling results in a fit width, add pillarboxes */
     if (scaled_width <= dst->width) {
         lsize = 0;
         psize = (dst->width - scaled_width)
-               * buffer->height / dst->height / 2;
+               * operation->height / dst->height / 2;
     }
 
     /* If width-based scaling results in a fit width, add letterboxes */
@@ -428,11 +533,11 @@ void guacenc_video_prepare_frame(guacenc_video* video, guacenc_buffer* buffer) {
         assert(scaled_height <= dst->height);
         psize = 0;
         lsize = (dst->height - scaled_height)
-               * buffer->width / dst->width / 2;
+               * operation->width / dst->width / 2;
     }
 
     /* Prepare source frame for buffer */
-    AVFrame* src = guacenc_video_frame_convert(buffer, lsize, psize);
+    AVFrame* src = guacenc_video_frame_convert(operation, lsize, psize);
     if (src == NULL) {
         guacenc_log(GUAC_LOG_WARNING, "Failed to allocate source frame. "
                 "Frame dropped.");
@@ -466,6 +571,77 @@ void guacenc_video_prepare_frame(guacenc_video* video, guacenc_buffer* buffer) {
 
 }
 
+/**
+ * Converts and encodes each operation queued for the given video, in order,
+ * until the queue of operations is closed and empty. Once any operation fails,
+ * the queue is closed such that no further operations are accepted, and the
+ * remaining operations are discarded.
+ *
+ * @param data
+ *     The guacenc_video whose operations should be performed.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guacenc_video_encode_operations(void* data) {
+
+    guacenc_video* video = (guacenc_video*) data;
+
+    guacenc_video_operation* operation;
+    while ((operation = guacenc_queue_pop(video->operations)) != NULL) {
+
+        if (!video->failed) {
+
+            /* Replace frame to be written, if a new frame was prepared */
+            if (operation->image != NULL)
+                guacenc_video_scale_frame(video, operation);
+
+            /* Write frame as many times as requested */
+            for (int i = 0; i < operation->count; i++) {
+                if (guacenc_video_write_frame(video, video->next_frame) < 0) {
+                    guacenc_log(GUAC_LOG_ERROR, "Unable to flush frame to "
+                            "video stream.");
+                    video->failed = true;
+                    guacenc_queue_close(video->operations);
+                    break;
+                }
+            }
+
+        }
+
+        guacenc_video_operation_free(operation);
+
+    }
+
+    return NULL;
+
+}
+
+void guacenc_video_prepare_frame(guacenc_video* video, guacenc_buffer* buffer) {
+
+    /* Ignore NULL buffers */
+    if (buffer == NULL || buffer->surface == NULL)
+        return;
+
+    /* Flush any pending operations */
+    cairo_surface_flush(buffer->surface);
+
+    /* Copy image data such that rendering may continue while the copy is
+     * converted and encoded */
+    guacenc_video_operation* operation =
+        guac_mem_zalloc(sizeof(guacenc_video_operation));
+
+    operation->image = guac_mem_alloc(buffer->stride, buffer->height);
+    operation->width = buffer->width;
+    operation->height = buffer->height;
+    operation->stride = buffer->stride;
+    memcpy(operation->image, buffer->image,
+            guac_mem_ckd_mul_or_die(buffer->stride, buffer->height));
+
+    guacenc_video_queue_operation(video, operation);
+
+}
+
 int guacenc_video_free(guacenc_video* video) {
 
     /* Ignore NULL video */
@@ -473,7 +649,12 @@ int guacenc_video_free(guacenc_video* video) {
         return 0;
 
     /* Write final frame */
-    guacenc_video_flush_frame(video);
+    guacenc_video_flush_frames(video, 1);
+
+    /* Wait for all queued frames to be encoded */
+    guacenc_queue_close(video->operations);
+    pthread_join(video->encoder_thread, NULL);
+    guacenc_queue_free(video->operations);
 
     /* Flush any unwritten frames */
     int retval;
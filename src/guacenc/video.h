@@ -22,6 +22,7 @@
 
 #include "config.h"
 #include "buffer.h"
+#include "queue.h"
 
 #include <guacamole/timestamp.h>
 #include <libavcodec/avcodec.h>
@@ -34,6 +35,8 @@
 #include <libavformat/avformat.h>
 #endif
 
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 
@@ -42,6 +45,14 @@
  */
 #define GUACENC_VIDEO_FRAMERATE 25
 
+/**
+ * The maximum number of pending operations which may be queued for the
+ * encoding thread of a video before further frames block the thread
+ * rendering those frames. Each pending operation may hold a copy of a full
+ * frame.
+ */
+#define GUACENC_VIDEO_QUEUE_SIZE 8
+
 /**
  * A video which is actively being encoded. Frames can be added to the video
  * as they are generated, along with their associated timestamps, and the
@@ -102,6 +113,31 @@ typedef struct guacenc_video {
      */
     guac_timestamp last_timestamp;
 
+    /**
+     * The total number of frames submitted for encoding, including
+     * duplicates.
+     */
+    int64_t frames;
+
+    /**
+     * Queue of pending operations (guacenc_video_operation) to be performed
+     * by the encoding thread, in order.
+     */
+    guacenc_queue* operations;
+
+    /**
+     * The thread which converts and encodes all frames, writing the
+     * resulting packets to the output file.
+     */
+    pthread_t encoder_thread;
+
+    /**
+     * Whether encoding of any frame has failed. This is set only by the
+     * encoding thread, and may only be read after the encoding thread has
+     * finished.
+     */
+    bool failed;
+
 } guacenc_video;
 
 /**
@@ -153,7 +189,7 @@ guacenc_video* guacenc_video_alloc(const char* path, const char* codec_name,
  *
  * @return
  *     Zero if the timeline was adjusted successfully, non-zero if an error
- *     occurs (such as during the encoding of duplicate frames).
+ *     occurs (such as if the encoding of previous frames has failed).
  */
 int guacenc_video_advance_timeline(guacenc_video* video,
         guac_timestamp timestamp);
@@ -169,6 +205,10 @@ int guacenc_video_advance_timeline(guacenc_video* video,
  * timeline or through reaching the end of the encoding process
  * (guacenc_video_free()).
  *
+ * The image data of the given buffer is copied, with conversion and encoding
+ * of that copy taking place on a separate thread. The buffer may be modified
+ * as soon as this function returns.
+ *
  * @param video
  *     The video in which the given buffer should be queued for possible
  *     writing (depending on timing vs. video framerate).
@@ -182,7 +222,7 @@ void guacenc_video_prepare_frame(guacenc_video* video, guacenc_buffer* buffer);
 /**
  * Frees all resources associated with the given video, finalizing the encoding
  * process. Any buffered frames which have not yet been written will be written
- * at this point.
+ * at this point, waiting for the encoding thread to finish.
  *
  * @return
  *     Zero if the video was successfully written and freed, non-zero if the
@@ -22,38 +22,59 @@
 #include "instructions.h"
 #include "log.h"
 
-#include <string.h>
+#include <guacamole/opcode-map.h>
+
+#include <pthread.h>
 
 guaclog_instruction_handler_mapping guaclog_instruction_handler_map[] = {
     {"key", guaclog_handle_key},
     {NULL,  NULL}
 };
 
+/**
+ * Index of guaclog_instruction_handler_map, allowing the handler for any
+ * opcode to be located without comparing against every opcode in turn.
+ */
+static guac_opcode_map guaclog_instruction_opcode_map;
+
+/**
+ * Guard ensuring guaclog_instruction_opcode_map is built exactly once.
+ */
+static pthread_once_t guaclog_instruction_opcode_map_initialized =
+    PTHREAD_ONCE_INIT;
+
+/**
+ * Builds guaclog_instruction_opcode_map. This function is invoked exactly
+ * once, via pthread_once(), prior to the first instruction being handled.
+ */
+static void guaclog_init_instruction_opcode_map() {
+    guac_opcode_map_init(&guaclog_instruction_opcode_map,
+            guaclog_instruction_handler_map,
+            sizeof(guaclog_instruction_handler_mapping));
+}
+
 int guaclog_handle_instruction(guaclog_state* state, const char* opcode,
         int argc, char** argv) {
 
-    /* Search through mapping for instruction handler having given opcode */
-    guaclog_instruction_handler_mapping* current = guaclog_instruction_handler_map;
-    while (current->opcode != NULL) {
-
-        /* Invoke handler if opcode matches (if defined) */
-        if (strcmp(current->opcode, opcode) == 0) {
+    pthread_once(&guaclog_instruction_opcode_map_initialized,
+            guaclog_init_instruction_opcode_map);
 
-            /* Invoke defined handler */
-            guaclog_instruction_handler* handler = current->handler;
-            if (handler != NULL)
-                return handler(state, argc, argv);
+    /* Locate instruction handler having given opcode */
+    const guaclog_instruction_handler_mapping* mapping =
+        guac_opcode_map_lookup(&guaclog_instruction_opcode_map, opcode);
 
-            /* Log defined but unimplemented instructions */
-            guaclog_log(GUAC_LOG_DEBUG, "\"%s\" not implemented", opcode);
-            return 0;
+    if (mapping != NULL) {
 
-        }
+        /* Invoke defined handler */
+        guaclog_instruction_handler* handler = mapping->handler;
+        if (handler != NULL)
+            return handler(state, argc, argv);
 
-        /* Next candidate handler */
-        current++;
+        /* Log defined but unimplemented instructions */
+        guaclog_log(GUAC_LOG_DEBUG, "\"%s\" not implemented", opcode);
+        return 0;
 
-    } /* end opcode search */
+    }
 
     /* Ignore any unknown instructions */
     return 0;
@@ -0,0 +1,332 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "adpcm_encoder.h"
+#include "guacamole/audio.h"
+#include "guacamole/client.h"
+#include "guacamole/mem.h"
+#include "guacamole/protocol.h"
+#include "guacamole/socket.h"
+#include "guacamole/user.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * The quantizer step sizes defined by IMA ADPCM, indexed by step index.
+ */
+static const int guac_adpcm_step_table[89] = {
+        7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+       19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+       50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+      130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+      337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+      876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+     2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+     5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+/**
+ * The adjustment made to the step index after each 4-bit code, indexed by
+ * that code.
+ */
+static const int guac_adpcm_index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+/**
+ * Updates the given channel state to match the state of the decoder after
+ * decoding the given 4-bit code.
+ *
+ * @param state
+ *     The channel state to update.
+ *
+ * @param code
+ *     The 4-bit IMA ADPCM code being decoded.
+ *
+ * @param step
+ *     The quantizer step size in effect when the code was produced.
+ */
+static void guac_adpcm_update_state(adpcm_channel_state* state, int code,
+        int step) {
+
+    /* Reconstruct difference exactly as the decoder will */
+    int difference = step >> 3;
+    if (code & 4) difference += step;
+    if (code & 2) difference += step >> 1;
+    if (code & 1) difference += step >> 2;
+
+    if (code & 8)
+        state->predictor -= difference;
+    else
+        state->predictor += difference;
+
+    /* Clamp predictor to range of 16-bit PCM */
+    if (state->predictor > INT16_MAX)
+        state->predictor = INT16_MAX;
+    else if (state->predictor < INT16_MIN)
+        state->predictor = INT16_MIN;
+
+    /* Adapt step size */
+    state->step_index += guac_adpcm_index_table[code];
+    if (state->step_index < 0)
+        state->step_index = 0;
+    else if (state->step_index > 88)
+        state->step_index = 88;
+
+}
+
+int guac_adpcm_encode_sample(adpcm_channel_state* state, int16_t sample) {
+
+    int step = guac_adpcm_step_table[state->step_index];
+    int difference = sample - state->predictor;
+    int code = 0;
+
+    /* Store sign separately from magnitude */
+    if (difference < 0) {
+        code = 8;
+        difference = -difference;
+    }
+
+    /* Quantize magnitude of difference relative to current step size */
+    if (difference >= step) {
+        code |= 4;
+        difference -= step;
+    }
+
+    if (difference >= step >> 1) {
+        code |= 2;
+        difference -= step >> 1;
+    }
+
+    if (difference >= step >> 2)
+        code |= 1;
+
+    guac_adpcm_update_state(state, code, step);
+    return code;
+
+}
+
+int16_t guac_adpcm_decode_sample(adpcm_channel_state* state, int code) {
+
+    guac_adpcm_update_state(state, code & 0xF,
+            guac_adpcm_step_table[state->step_index]);
+
+    return state->predictor;
+
+}
+
+/**
+ * Encodes the given interleaved 16-bit little-endian PCM frames as a single
+ * ADPCM block, sending that block as a blob along the given audio stream. The
+ * total number of samples (frames multiplied by channels) must be even.
+ *
+ * @param audio
+ *     The audio stream along which the block should be sent.
+ *
+ * @param pcm
+ *     The PCM data to encode.
+ *
+ * @param frames
+ *     The number of frames of PCM data to encode. This must not exceed
+ *     GUAC_ADPCM_ENCODER_BLOCK_FRAMES.
+ */
+static void adpcm_encoder_send_block(guac_audio_stream* audio,
+        const unsigned char* pcm, int frames) {
+
+    adpcm_encoder_state* state = (adpcm_encoder_state*) audio->data;
+    unsigned char* block = state->block;
+    int channels = audio->channels;
+
+    /* Write state of each channel as of the beginning of the block */
+    for (int i = 0; i < channels; i++) {
+        adpcm_channel_state* channel = &state->channels[i];
+        uint16_t predictor = (uint16_t) channel->predictor;
+        *(block++) = predictor & 0xFF;
+        *(block++) = predictor >> 8;
+        *(block++) = channel->step_index;
+        *(block++) = 0;
+    }
+
+    /* Encode each sample as a 4-bit code, two codes per byte */
+    int samples = frames * channels;
+    for (int i = 0; i < samples; i += 2) {
+
+        int16_t first  = (int16_t) (pcm[0] | (pcm[1] << 8));
+        int16_t second = (int16_t) (pcm[2] | (pcm[3] << 8));
+
+        int low  = guac_adpcm_encode_sample(&state->channels[i % channels],
+                first);
+        int high = guac_adpcm_encode_sample(
+                &state->channels[(i + 1) % channels], second);
+
+        *(block++) = low | (high << 4);
+        pcm += 4;
+
+    }
+
+    guac_protocol_send_blob(audio->client->socket, audio->stream,
+            state->block, block - state->block);
+
+}
+
+static void adpcm_encoder_send_audio(guac_audio_stream* audio,
+        guac_socket* socket) {
+
+    char mimetype[256];
+
+    /* Produce mimetype string from format info */
+    snprintf(mimetype, sizeof(mimetype), "%s;rate=%i,channels=%i",
+            adpcm_encoder->mimetype, audio->rate, audio->channels);
+
+    /* Associate stream */
+    guac_protocol_send_audio(socket, audio->stream, mimetype);
+
+}
+
+static void adpcm_encoder_begin_handler(guac_audio_stream* audio) {
+
+    adpcm_encoder_state* state;
+
+    /* Broadcast existence of stream */
+    adpcm_encoder_send_audio(audio, audio->client->socket);
+
+    /* Allocate and init encoder state */
+    audio->data = state = guac_mem_alloc(sizeof(adpcm_encoder_state));
+    state->written = 0;
+    state->length = guac_mem_ckd_mul_or_die(GUAC_ADPCM_ENCODER_BUFFER_SIZE,
+            audio->rate, audio->channels, 2) / 1000;
+
+    state->buffer = guac_mem_alloc(state->length);
+    state->channels = guac_mem_zalloc(sizeof(adpcm_channel_state),
+            audio->channels);
+
+    /* Each block contains a header for each channel followed by 4 bits per
+     * sample */
+    state->block = guac_mem_alloc(audio->channels,
+            GUAC_ADPCM_ENCODER_HEADER_SIZE + GUAC_ADPCM_ENCODER_BLOCK_FRAMES / 2);
+
+}
+
+static void adpcm_encoder_join_handler(guac_audio_stream* audio,
+        guac_user* user) {
+
+    /* Notify user of existence of stream */
+    adpcm_encoder_send_audio(audio, user->socket);
+
+}
+
+static void adpcm_encoder_end_handler(guac_audio_stream* audio) {
+
+    adpcm_encoder_state* state = (adpcm_encoder_state*) audio->data;
+
+    /* Send end of stream */
+    guac_protocol_send_end(audio->client->socket, audio->stream);
+
+    /* Free state information */
+    guac_mem_free(state->block);
+    guac_mem_free(state->channels);
+    guac_mem_free(state->buffer);
+    guac_mem_free(state);
+
+}
+
+static void adpcm_encoder_write_handler(guac_audio_stream* audio,
+        const unsigned char* pcm_data, int length) {
+
+    adpcm_encoder_state* state = (adpcm_encoder_state*) audio->data;
+
+    while (length > 0) {
+
+        /* Prefer to copy a chunk of equal size to available buffer space */
+        int chunk_size = state->length - state->written;
+
+        /* If no space remains, flush and retry */
+        if (chunk_size == 0) {
+            guac_audio_stream_flush(audio);
+            continue;
+        }
+
+        /* Do not copy more data than is available in source PCM */
+        if (chunk_size > length)
+            chunk_size = length;
+
+        /* Copy block of PCM data into buffer */
+        memcpy(state->buffer + state->written, pcm_data, chunk_size);
+
+        /* Advance to next block */
+        state->written += chunk_size;
+        pcm_data += chunk_size;
+        length -= chunk_size;
+
+    }
+
+}
+
+static void adpcm_encoder_flush_handler(guac_audio_stream* audio) {
+
+    adpcm_encoder_state* state = (adpcm_encoder_state*) audio->data;
+    int frame_size = audio->channels * 2;
+
+    /* Encode only complete frames, and only an even number of samples, such
+     * that each block ends on a byte boundary */
+    int frames = state->written / frame_size;
+    if ((frames * audio->channels) % 2 != 0)
+        frames--;
+
+    /* Encode and send all complete frames as blocks */
+    const unsigned char* pcm = state->buffer;
+    int remaining = frames;
+    while (remaining > 0) {
+
+        int block_frames = remaining;
+        if (block_frames > GUAC_ADPCM_ENCODER_BLOCK_FRAMES)
+            block_frames = GUAC_ADPCM_ENCODER_BLOCK_FRAMES;
+
+        adpcm_encoder_send_block(audio, pcm, block_frames);
+
+        pcm += block_frames * frame_size;
+        remaining -= block_frames;
+
+    }
+
+    /* Retain any data which could not yet be encoded */
+    state->written -= frames * frame_size;
+    memmove(state->buffer, pcm, state->written);
+
+}
+
+/* ADPCM encoder handlers */
+guac_audio_encoder _adpcm_encoder = {
+    .mimetype      = "audio/x-ima-adpcm",
+    .begin_handler = adpcm_encoder_begin_handler,
+    .write_handler = adpcm_encoder_write_handler,
+    .flush_handler = adpcm_encoder_flush_handler,
+    .join_handler  = adpcm_encoder_join_handler,
+    .end_handler   = adpcm_encoder_end_handler
+};
+
+/* Actual encoder definition */
+guac_audio_encoder* adpcm_encoder = &_adpcm_encoder;
+
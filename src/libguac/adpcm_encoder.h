@@ -0,0 +1,149 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_ADPCM_ENCODER_H
+#define GUAC_ADPCM_ENCODER_H
+
+#include "config.h"
+
+#include "guacamole/audio.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The maximum number of frames (one sample for each channel) to encode within
+ * each ADPCM block. Each block is sent as its own blob and can be decoded
+ * independently of all other blocks.
+ */
+#define GUAC_ADPCM_ENCODER_BLOCK_FRAMES 2048
+
+/**
+ * The number of bytes within the header that begins each ADPCM block, for
+ * each channel.
+ */
+#define GUAC_ADPCM_ENCODER_HEADER_SIZE 4
+
+/**
+ * The size of the ADPCM encoder input PCM buffer, in milliseconds. The
+ * equivalent size in bytes will vary by PCM rate and number of channels.
+ */
+#define GUAC_ADPCM_ENCODER_BUFFER_SIZE 250
+
+/**
+ * The encoding state of a single channel of IMA ADPCM audio.
+ */
+typedef struct adpcm_channel_state {
+
+    /**
+     * The value of the most recently encoded sample, as it will be
+     * reconstructed by the decoder.
+     */
+    int predictor;
+
+    /**
+     * The index of the current quantizer step size within the IMA ADPCM
+     * step size table.
+     */
+    int step_index;
+
+} adpcm_channel_state;
+
+/**
+ * The current state of the ADPCM encoder. The ADPCM encoder compresses 16-bit
+ * PCM to 4 bits per sample using IMA ADPCM, sending the result as a series of
+ * blocks, one block per blob.
+ *
+ * Each block begins with a 4-byte header for each channel, in channel order,
+ * consisting of the predictor as a signed 16-bit little-endian integer, the
+ * step index as an unsigned 8-bit integer, and a reserved zero byte. The
+ * header is followed by one 4-bit code for each sample, interleaved by channel
+ * exactly as the original PCM, with the first of each pair of samples stored
+ * in the low nibble of each byte. The number of frames within a block is
+ * implied by its length.
+ */
+typedef struct adpcm_encoder_state {
+
+    /**
+     * Buffer of not-yet-encoded 16-bit PCM data.
+     */
+    unsigned char* buffer;
+
+    /**
+     * Size of the PCM buffer, in bytes.
+     */
+    size_t length;
+
+    /**
+     * The current number of bytes stored within the PCM buffer.
+     */
+    int written;
+
+    /**
+     * The encoding state of each channel.
+     */
+    adpcm_channel_state* channels;
+
+    /**
+     * Buffer into which each ADPCM block is encoded prior to being sent.
+     */
+    unsigned char* block;
+
+} adpcm_encoder_state;
+
+/**
+ * Encodes the given 16-bit PCM sample as a 4-bit IMA ADPCM code, updating the
+ * given channel state to match the state of the decoder after decoding that
+ * code.
+ *
+ * @param state
+ *     The encoding state of the channel that the sample belongs to.
+ *
+ * @param sample
+ *     The sample to encode.
+ *
+ * @return
+ *     The 4-bit IMA ADPCM code representing the given sample.
+ */
+int guac_adpcm_encode_sample(adpcm_channel_state* state, int16_t sample);
+
+/**
+ * Decodes the given 4-bit IMA ADPCM code, updating the given channel state
+ * accordingly. This is the exact inverse of guac_adpcm_encode_sample(), and
+ * is what any client receiving ADPCM audio must implement.
+ *
+ * @param state
+ *     The decoding state of the channel that the code belongs to.
+ *
+ * @param code
+ *     The 4-bit IMA ADPCM code to decode.
+ *
+ * @return
+ *     The decoded 16-bit PCM sample.
+ */
+int16_t guac_adpcm_decode_sample(adpcm_channel_state* state, int code);
+
+/**
+ * Audio encoder which writes 16-bit PCM as IMA ADPCM, using 4 bits per
+ * sample.
+ */
+extern guac_audio_encoder* adpcm_encoder;
+
+#endif
+
@@ -19,6 +19,7 @@
 
 #include "config.h"
 
+#include "adpcm_encoder.h"
 #include "guacamole/mem.h"
 #include "guacamole/audio.h"
 #include "guacamole/client.h"
@@ -53,11 +54,37 @@ static void guac_audio_stream_set_encoder(guac_audio_stream* audio,
 
 }
 
+/**
+ * Returns whether the given user has declared support for the given audio
+ * mimetype.
+ *
+ * @param user
+ *     The user whose supported audio mimetypes should be checked.
+ *
+ * @param mimetype
+ *     The audio mimetype to check for.
+ *
+ * @return
+ *     Non-zero if the given user supports the given audio mimetype, zero
+ *     otherwise.
+ */
+static int guac_audio_user_supports(guac_user* user, const char* mimetype) {
+
+    for (int i = 0; user->info.audio_mimetypes[i] != NULL; i++) {
+        if (strcmp(user->info.audio_mimetypes[i], mimetype) == 0)
+            return 1;
+    }
+
+    return 0;
+
+}
+
 /**
  * Assigns a new audio encoder to the given guac_audio_stream based on the
- * audio mimetypes declared as supported by the given user. If no audio encoder
- * can be found, no new audio encoder is assigned, and the existing encoder is
- * left untouched (if any).
+ * audio mimetypes declared as supported by the given user. Compressed audio is
+ * preferred over raw PCM whenever supported. If no audio encoder can be
+ * found, no new audio encoder is assigned, and the existing encoder is left
+ * untouched (if any).
  *
  * @param user
  *     The user whose supported audio mimetypes should determine the audio
@@ -84,6 +111,13 @@ static void* guac_audio_assign_encoder(guac_user* user, void* data) {
     if (user == NULL || audio->encoder != NULL)
         return audio->encoder;
 
+    /* Prefer compressed audio, which requires a quarter of the bandwidth of
+     * 16-bit raw audio */
+    if (bps == 16 && guac_audio_user_supports(user, adpcm_encoder->mimetype)) {
+        guac_audio_stream_set_encoder(audio, adpcm_encoder);
+        return audio->encoder;
+    }
+
     /* For each supported mimetype, check for an associated encoder */
     for (i=0; user->info.audio_mimetypes[i] != NULL; i++) {
 
@@ -0,0 +1,228 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "base64.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The SSSE3 implementation is compiled only for x86 targets built with a
+ * compiler that allows individual functions to target instruction set
+ * extensions. Whether the CPU actually supports SSSE3 is checked at runtime.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) \
+        && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define GUAC_BASE64_SSSE3
+#include <tmmintrin.h>
+#endif
+
+/**
+ * The 64 characters used by base64, in order of the 6-bit values they
+ * represent.
+ */
+static const char GUAC_BASE64_CHARACTERS[64] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/**
+ * Encodes each complete group of three bytes within the given input as four
+ * base64 characters, one group at a time. Any trailing bytes which do not
+ * form a complete group are ignored.
+ *
+ * @param output
+ *     The buffer which should receive the encoded data.
+ *
+ * @param input
+ *     The bytes to encode.
+ *
+ * @param length
+ *     The number of bytes available in the input buffer.
+ *
+ * @return
+ *     The number of bytes consumed from the input buffer, which will always
+ *     be a multiple of three.
+ */
+static size_t guac_base64_encode_scalar(char* output,
+        const unsigned char* input, size_t length) {
+
+    size_t consumed = 0;
+
+    while (length - consumed >= 3) {
+
+        uint32_t group = (input[0] << 16) | (input[1] << 8) | input[2];
+
+        output[0] = GUAC_BASE64_CHARACTERS[(group >> 18) & 0x3F];
+        output[1] = GUAC_BASE64_CHARACTERS[(group >> 12) & 0x3F];
+        output[2] = GUAC_BASE64_CHARACTERS[(group >>  6) & 0x3F];
+        output[3] = GUAC_BASE64_CHARACTERS[ group        & 0x3F];
+
+        input    += 3;
+        output   += 4;
+        consumed += 3;
+
+    }
+
+    return consumed;
+
+}
+
+#ifdef GUAC_BASE64_SSSE3
+/**
+ * Encodes as much of the given input as possible as base64 using SSSE3,
+ * producing 16 characters for every 12 bytes of input. As each iteration
+ * reads a full 16 bytes (of which only 12 are used), encoding stops while at
+ * least 16 bytes of input remain, leaving the remainder to be encoded by
+ * guac_base64_encode_scalar(). This function MUST NOT be called unless the
+ * CPU supports SSSE3.
+ *
+ * @param output
+ *     The buffer which should receive the encoded data.
+ *
+ * @param input
+ *     The bytes to encode.
+ *
+ * @param length
+ *     The number of bytes available in the input buffer.
+ *
+ * @return
+ *     The number of bytes consumed from the input buffer, which will always
+ *     be a multiple of twelve.
+ */
+__attribute__((target("ssse3")))
+static size_t guac_base64_encode_ssse3(char* output,
+        const unsigned char* input, size_t length) {
+
+    /* Reorders each group of three bytes such that each 6-bit value can be
+     * isolated within a 16-bit lane using only shifts and masks */
+    const __m128i shuffle = _mm_setr_epi8(
+            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+
+    /* Offsets which, when added to a 6-bit value, produce the corresponding
+     * base64 character, indexed by the range the value falls within */
+    const __m128i offsets = _mm_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+            '/' - 63, 'A', 0, 0);
+
+    size_t consumed = 0;
+
+    while (length - consumed >= 16) {
+
+        __m128i in = _mm_loadu_si128((const __m128i*) input);
+        in = _mm_shuffle_epi8(in, shuffle);
+
+        /* Split each group of three bytes into four 6-bit values */
+        __m128i high = _mm_mulhi_epu16(
+                _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)),
+                _mm_set1_epi32(0x04000040));
+
+        __m128i low = _mm_mullo_epi16(
+                _mm_and_si128(in, _mm_set1_epi32(0x003F03F0)),
+                _mm_set1_epi32(0x01000010));
+
+        __m128i values = _mm_or_si128(high, low);
+
+        /* Map each value to the index of its offset: 0 for A-Z, 1-10 for
+         * 0-9 (all having the same offset), 11 for '+', 12 for '/', and 13
+         * for a-z */
+        __m128i index = _mm_subs_epu8(values, _mm_set1_epi8(51));
+        __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), values);
+        index = _mm_or_si128(index, _mm_and_si128(upper, _mm_set1_epi8(13)));
+
+        __m128i encoded = _mm_add_epi8(values,
+                _mm_shuffle_epi8(offsets, index));
+
+        _mm_storeu_si128((__m128i*) output, encoded);
+
+        input    += 12;
+        output   += 16;
+        consumed += 12;
+
+    }
+
+    return consumed;
+
+}
+
+/**
+ * Returns whether the current CPU supports SSSE3. The result of the check is
+ * cached after the first call.
+ *
+ * @return
+ *     Non-zero if the current CPU supports SSSE3, zero otherwise.
+ */
+static int guac_base64_has_ssse3() {
+
+    static int supported = -1;
+
+    if (supported == -1) {
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("ssse3") ? 1 : 0;
+    }
+
+    return supported;
+
+}
+#endif
+
+size_t guac_base64_encode(char* output, const unsigned char* input,
+        size_t length) {
+
+    char* start = output;
+    size_t consumed;
+
+#ifdef GUAC_BASE64_SSSE3
+    /* Encode bulk of data with SSSE3, if available */
+    if (guac_base64_has_ssse3()) {
+        consumed = guac_base64_encode_ssse3(output, input, length);
+        input  += consumed;
+        output += consumed / 3 * 4;
+        length -= consumed;
+    }
+#endif
+
+    /* Encode remaining complete groups of three bytes */
+    consumed = guac_base64_encode_scalar(output, input, length);
+    input  += consumed;
+    output += consumed / 3 * 4;
+    length -= consumed;
+
+    /* AAAAAA [AABBBB] [BBBB--] ------ (one character of padding) */
+    if (length == 2) {
+        output[0] = GUAC_BASE64_CHARACTERS[input[0] >> 2];
+        output[1] = GUAC_BASE64_CHARACTERS[((input[0] & 0x03) << 4) | (input[1] >> 4)];
+        output[2] = GUAC_BASE64_CHARACTERS[(input[1] & 0x0F) << 2];
+        output[3] = '=';
+        output += 4;
+    }
+
+    /* AAAAAA [AA----] ------ ------ (two characters of padding) */
+    else if (length == 1) {
+        output[0] = GUAC_BASE64_CHARACTERS[input[0] >> 2];
+        output[1] = GUAC_BASE64_CHARACTERS[(input[0] & 0x03) << 4];
+        output[2] = '=';
+        output[3] = '=';
+        output += 4;
+    }
+
+    return output - start;
+
+}
@@ -0,0 +1,60 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __GUAC_BASE64_H
+#define __GUAC_BASE64_H
+
+#include <stddef.h>
+
+/**
+ * Returns the number of characters required to represent the given number of
+ * bytes in base64, including any padding.
+ *
+ * @param length
+ *     The number of bytes to be encoded.
+ *
+ * @return
+ *     The number of base64 characters required to encode the given number
+ *     of bytes.
+ */
+#define GUAC_BASE64_ENCODED_LENGTH(length) ((((length) + 2) / 3) * 4)
+
+/**
+ * Encodes the given bytes as base64, writing the result to the given output
+ * buffer. The output is NOT null-terminated. If the number of bytes given is
+ * not a multiple of three, the output is padded with '=' characters. Where
+ * supported by the CPU at runtime, a vectorized implementation is used.
+ *
+ * @param output
+ *     The buffer which should receive the encoded data. This buffer must be
+ *     at least GUAC_BASE64_ENCODED_LENGTH(length) bytes long.
+ *
+ * @param input
+ *     The bytes to encode.
+ *
+ * @param length
+ *     The number of bytes to encode.
+ *
+ * @return
+ *     The number of characters written to the output buffer.
+ */
+size_t guac_base64_encode(char* output, const unsigned char* input,
+        size_t length);
+
+#endif
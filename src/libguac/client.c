@@ -36,6 +36,7 @@
 #include "guacamole/timestamp.h"
 #include "guacamole/user.h"
 #include "id.h"
+#include "socket-broadcast.h"
 
 #include <dlfcn.h>
 #include <errno.h>
@@ -156,6 +157,93 @@ void guac_client_free_stream(guac_client* client, guac_stream* stream) {
 
 }
 
+/**
+ * Returns the GUAC_CLIENT_MIMETYPE_* flags of each mimetype within the given
+ * list which has a corresponding flag.
+ *
+ * @param mimetypes
+ *     The NULL-terminated list of mimetypes to check, or NULL if no mimetypes
+ *     are supported.
+ *
+ * @return
+ *     The bitwise OR of the GUAC_CLIENT_MIMETYPE_* flags of each mimetype in
+ *     the given list.
+ */
+static int guac_client_mimetype_flags(const char** mimetypes) {
+
+    int flags = 0;
+
+    if (mimetypes == NULL)
+        return 0;
+
+    for (; *mimetypes != NULL; mimetypes++) {
+        if (strcmp(*mimetypes, "image/webp") == 0)
+            flags |= GUAC_CLIENT_MIMETYPE_IMAGE_WEBP;
+        else if (strcmp(*mimetypes, "audio/L8") == 0)
+            flags |= GUAC_CLIENT_MIMETYPE_AUDIO_L8;
+        else if (strcmp(*mimetypes, "audio/L16") == 0)
+            flags |= GUAC_CLIENT_MIMETYPE_AUDIO_L16;
+    }
+
+    return flags;
+
+}
+
+/**
+ * Recomputes the summary of the capabilities of all users of the given client
+ * from the current list of non-pending users and the current owner. The
+ * write lock for the list of non-pending users must already be held by the
+ * current thread.
+ *
+ * @param client
+ *     The client whose capability summary should be recomputed.
+ */
+static void guac_client_update_capabilities(guac_client* client) {
+
+    guac_client_capabilities capabilities = {
+        .users = 0,
+#ifdef ENABLE_WEBP
+        .webp = 1,
+#else
+        .webp = 0,
+#endif
+        .protocol_version = GUAC_PROTOCOL_VERSION_UNKNOWN,
+        .owner_protocol_version = GUAC_PROTOCOL_VERSION_UNKNOWN,
+        .mimetypes = 0
+    };
+
+    /* Summarize the capabilities that all non-pending users share */
+    for (guac_user* user = client->__users; user != NULL; user = user->__next) {
+
+        guac_protocol_version version = user->info.protocol_version;
+        if (capabilities.users == 0 || version < capabilities.protocol_version)
+            capabilities.protocol_version = version;
+
+        if (capabilities.webp)
+            capabilities.webp = guac_user_supports_webp(user);
+
+        /* Keep only the mimetypes that every user declares */
+        int mimetypes =
+              guac_client_mimetype_flags(user->info.image_mimetypes)
+            | guac_client_mimetype_flags(user->info.audio_mimetypes);
+
+        if (capabilities.users == 0)
+            capabilities.mimetypes = mimetypes;
+        else
+            capabilities.mimetypes &= mimetypes;
+
+        capabilities.users++;
+
+    }
+
+    if (client->__owner != NULL)
+        capabilities.owner_protocol_version =
+            client->__owner->info.protocol_version;
+
+    client->__capabilities = capabilities;
+
+}
+
 /**
  * Promote all pending users to full users, calling the join pending handler
  * before, if any.
@@ -227,6 +315,10 @@ static void guac_client_promote_pending_users(union sigval data) {
     /* If any users were removed from the pending list, promote them now */
     if (last_user != NULL) {
 
+        /* Start delivering broadcast data to each promoted user */
+        for (user = first_user; user != NULL; user = user->__next)
+            guac_socket_broadcast_add_user(client->socket, user);
+
         /* Add all formerly-pending users to the start of the user list */
         if (client->__users != NULL)
             client->__users->__prev = last_user;
@@ -234,6 +326,8 @@ static void guac_client_promote_pending_users(union sigval data) {
         last_user->__next = client->__users;
         client->__users = first_user;
 
+        guac_client_update_capabilities(client);
+
     }
 
     guac_rwlock_release_lock(&(client->__users_lock));
@@ -308,6 +402,14 @@ guac_client* guac_client_alloc() {
     /* Set up broadcast sockets */
     client->socket = guac_socket_broadcast(client);
     client->pending_socket = guac_socket_broadcast_pending(client);
+    client->__broadcast_socket = client->socket;
+
+    /* No frames have yet been sent */
+    client->__next_frame = 0;
+    pthread_mutex_init(&(client->__frames_lock), NULL);
+
+    /* There are not yet any users whose capabilities must be considered */
+    guac_client_update_capabilities(client);
 
     return client;
 
@@ -370,6 +472,7 @@ void guac_client_free(guac_client* client) {
         timer_delete(client->__pending_users_timer);
 
     pthread_mutex_destroy(&(client->__pending_users_timer_mutex));
+    pthread_mutex_destroy(&(client->__frames_lock));
 
     /* Destroy the reentrant read-write locks */
     guac_rwlock_destroy(&(client->__users_lock));
@@ -561,8 +664,12 @@ int guac_client_add_user(guac_client* client, guac_user* user, int argc, char**
         guac_client_add_pending_user(client, user);
 
         /* Update owner pointer if user is owner */
-        if (user->owner)
+        if (user->owner) {
+            guac_rwlock_acquire_write_lock(&(client->__users_lock));
             client->__owner = user;
+            guac_client_update_capabilities(client);
+            guac_rwlock_release_lock(&(client->__users_lock));
+        }
 
     }
 
@@ -597,9 +704,14 @@ void guac_client_remove_user(guac_client* client, guac_user* user) {
     if (user->owner)
         client->__owner = NULL;
 
+    guac_client_update_capabilities(client);
+
     guac_rwlock_release_lock(&(client->__users_lock));
     guac_rwlock_release_lock(&(client->__pending_users_lock));
 
+    /* Stop delivering broadcast data to the user, if applicable */
+    guac_socket_broadcast_remove_user(client->socket, user);
+
     /* Update owner of user having left the connection. */
     if (!user->owner)
         guac_client_owner_notify_leave(client, user);
@@ -612,6 +724,11 @@ void guac_client_remove_user(guac_client* client, guac_user* user) {
 
 }
 
+int guac_client_enable_async_broadcast(guac_client* client,
+        size_t buffer_size) {
+    return guac_socket_broadcast_enable_async(client->socket, buffer_size);
+}
+
 void guac_client_foreach_user(guac_client* client, guac_user_callback* callback, void* data) {
 
     guac_user* current;
@@ -710,6 +827,20 @@ int guac_client_end_multiple_frames(guac_client* client, int frames) {
     /* Update and send timestamp */
     client->last_sent_timestamp = guac_timestamp_current();
 
+    /* Remember the amount of data sent as of this frame, such that the
+     * bandwidth of each user can be estimated once they confirm the frame */
+    pthread_mutex_lock(&(client->__frames_lock));
+
+    guac_client_frame* frame = &(client->__frames[client->__next_frame]);
+    frame->timestamp = client->last_sent_timestamp;
+    frame->bytes = guac_socket_broadcast_get_bytes_written(
+            client->__broadcast_socket);
+
+    client->__next_frame = (client->__next_frame + 1)
+        % GUAC_CLIENT_FRAME_HISTORY_SIZE;
+
+    pthread_mutex_unlock(&(client->__frames_lock));
+
     /* Log received timestamp and calculated lag (at TRACE level only) */
     guac_client_log(client, GUAC_LOG_TRACE, "Server completed "
             "frame %" PRIu64 "ms (%i logical frames)", client->last_sent_timestamp, frames);
@@ -847,6 +978,90 @@ int guac_client_get_processing_lag(guac_client* client) {
 
 }
 
+/**
+ * Callback which is invoked by guac_client_get_link_estimate() for each user,
+ * merging that user's smoothed estimates into the given
+ * guac_client_link_estimate such that the worst conditions of any user are
+ * represented.
+ *
+ * @param user
+ *     The user whose estimates should be merged.
+ *
+ * @param data
+ *     A pointer to the guac_client_link_estimate being populated.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* __merge_link_estimate(guac_user* user, void* data) {
+
+    guac_client_link_estimate* estimate = (guac_client_link_estimate*) data;
+
+    if (user->smoothed_processing_lag > estimate->processing_lag)
+        estimate->processing_lag = user->smoothed_processing_lag;
+
+    if (user->processing_lag_deviation > estimate->processing_lag_deviation)
+        estimate->processing_lag_deviation = user->processing_lag_deviation;
+
+    if (user->smoothed_rtt > estimate->rtt)
+        estimate->rtt = user->smoothed_rtt;
+
+    /* Users without a bandwidth estimate do not constrain the minimum */
+    if (user->bandwidth != 0 && (estimate->bandwidth == 0
+                || user->bandwidth < estimate->bandwidth))
+        estimate->bandwidth = user->bandwidth;
+
+    return NULL;
+
+}
+
+void guac_client_get_link_estimate(guac_client* client,
+        guac_client_link_estimate* estimate) {
+
+    estimate->processing_lag = 0;
+    estimate->processing_lag_deviation = 0;
+    estimate->rtt = 0;
+    estimate->bandwidth = 0;
+
+    guac_client_foreach_user(client, __merge_link_estimate, estimate);
+
+}
+
+int guac_client_smooth_estimate(int estimate, int sample, int weight) {
+
+    int error = sample - estimate;
+    return estimate + (error + (error < 0 ? -weight : weight) / 2) / weight;
+
+}
+
+int guac_client_get_frame_bytes(guac_client* client, guac_timestamp timestamp,
+        uint64_t* bytes) {
+
+    int result = 1;
+
+    pthread_mutex_lock(&(client->__frames_lock));
+
+    /* Search backwards from the most recently sent frame */
+    int index = client->__next_frame;
+    for (int i = 0; i < GUAC_CLIENT_FRAME_HISTORY_SIZE; i++) {
+
+        index = (index + GUAC_CLIENT_FRAME_HISTORY_SIZE - 1)
+            % GUAC_CLIENT_FRAME_HISTORY_SIZE;
+
+        guac_client_frame* frame = &(client->__frames[index]);
+        if (frame->timestamp == timestamp) {
+            *bytes = frame->bytes;
+            result = 0;
+            break;
+        }
+
+    }
+
+    pthread_mutex_unlock(&(client->__frames_lock));
+    return result;
+
+}
+
 void guac_client_stream_argv(guac_client* client, guac_socket* socket,
         const char* mimetype, const char* name, const char* value) {
 
@@ -867,12 +1082,9 @@ void guac_client_stream_argv(guac_client* client, guac_socket* socket,
 
 }
 
-void guac_client_stream_png(guac_client* client, guac_socket* socket,
-        guac_composite_mode mode, const guac_layer* layer, int x, int y,
-        cairo_surface_t* surface) {
-
-    /* Allocate new stream for image */
-    guac_stream* stream = guac_client_alloc_stream(client);
+void guac_client_write_png(guac_client* client, guac_socket* socket,
+        guac_stream* stream, guac_composite_mode mode,
+        const guac_layer* layer, int x, int y, cairo_surface_t* surface) {
 
     /* Declare stream as containing image data */
     guac_protocol_send_img(socket, stream, mode, layer, "image/png", x, y);
@@ -883,18 +1095,28 @@ void guac_client_stream_png(guac_client* client, guac_socket* socket,
     /* Terminate stream */
     guac_protocol_send_end(socket, stream);
 
-    /* Free allocated stream */
-    guac_client_free_stream(client, stream);
-
 }
 
-void guac_client_stream_jpeg(guac_client* client, guac_socket* socket,
+void guac_client_stream_png(guac_client* client, guac_socket* socket,
         guac_composite_mode mode, const guac_layer* layer, int x, int y,
-        cairo_surface_t* surface, int quality) {
+        cairo_surface_t* surface) {
 
     /* Allocate new stream for image */
     guac_stream* stream = guac_client_alloc_stream(client);
 
+    /* Send image over stream */
+    guac_client_write_png(client, socket, stream, mode, layer, x, y, surface);
+
+    /* Free allocated stream */
+    guac_client_free_stream(client, stream);
+
+}
+
+void guac_client_write_jpeg(guac_client* client, guac_socket* socket,
+        guac_stream* stream, guac_composite_mode mode,
+        const guac_layer* layer, int x, int y, cairo_surface_t* surface,
+        int quality) {
+
     /* Declare stream as containing image data */
     guac_protocol_send_img(socket, stream, mode, layer, "image/jpeg", x, y);
 
@@ -904,19 +1126,30 @@ void guac_client_stream_jpeg(guac_client* client, guac_socket* socket,
     /* Terminate stream */
     guac_protocol_send_end(socket, stream);
 
-    /* Free allocated stream */
-    guac_client_free_stream(client, stream);
-
 }
 
-void guac_client_stream_webp(guac_client* client, guac_socket* socket,
+void guac_client_stream_jpeg(guac_client* client, guac_socket* socket,
         guac_composite_mode mode, const guac_layer* layer, int x, int y,
-        cairo_surface_t* surface, int quality, int lossless) {
+        cairo_surface_t* surface, int quality) {
 
-#ifdef ENABLE_WEBP
     /* Allocate new stream for image */
     guac_stream* stream = guac_client_alloc_stream(client);
 
+    /* Send image over stream */
+    guac_client_write_jpeg(client, socket, stream, mode, layer, x, y,
+            surface, quality);
+
+    /* Free allocated stream */
+    guac_client_free_stream(client, stream);
+
+}
+
+void guac_client_write_webp(guac_client* client, guac_socket* socket,
+        guac_stream* stream, guac_composite_mode mode,
+        const guac_layer* layer, int x, int y, cairo_surface_t* surface,
+        int quality, int lossless) {
+
+#ifdef ENABLE_WEBP
     /* Declare stream as containing image data */
     guac_protocol_send_img(socket, stream, mode, layer, "image/webp", x, y);
 
@@ -925,103 +1158,54 @@ void guac_client_stream_webp(guac_client* client, guac_socket* socket,
 
     /* Terminate stream */
     guac_protocol_send_end(socket, stream);
-
-    /* Free allocated stream */
-    guac_client_free_stream(client, stream);
 #else
     /* Do nothing if WebP support is not built in */
 #endif
 
 }
 
-#ifdef ENABLE_WEBP
-/**
- * Callback which is invoked by guac_client_supports_webp() for each user
- * associated with the given client, thus updating an overall support flag
- * describing the WebP support state for the client as a whole.
- *
- * @param user
- *     The user to check for WebP support.
- *
- * @param data
- *     Pointer to an int containing the current WebP support status for the
- *     client associated with the given user. This flag will be 0 if any user
- *     already checked has lacked WebP support, or 1 otherwise.
- *
- * @return
- *     Always NULL.
- */
-static void* __webp_support_callback(guac_user* user, void* data) {
+void guac_client_stream_webp(guac_client* client, guac_socket* socket,
+        guac_composite_mode mode, const guac_layer* layer, int x, int y,
+        cairo_surface_t* surface, int quality, int lossless) {
 
-    int* webp_supported = (int*) data;
+#ifdef ENABLE_WEBP
+    /* Allocate new stream for image */
+    guac_stream* stream = guac_client_alloc_stream(client);
 
-    /* Check whether current user supports WebP */
-    if (*webp_supported)
-        *webp_supported = guac_user_supports_webp(user);
+    /* Send image over stream */
+    guac_client_write_webp(client, socket, stream, mode, layer, x, y,
+            surface, quality, lossless);
 
-    return NULL;
+    /* Free allocated stream */
+    guac_client_free_stream(client, stream);
+#else
+    /* Do nothing if WebP support is not built in */
+#endif
 
 }
-#endif
 
-/**
- * A callback function which is invoked by guac_client_owner_supports_msg()
- * to determine if the owner of a client supports the "msg" instruction,
- * returning zero if the user does not support the instruction or non-zero if
- * the user supports it.
- * 
- * @param user
- *     The guac_user that will be checked for "msg" instruction support.
- * 
- * @param data
- *     Data provided to the callback. This value is never used within this
- *     callback.
- * 
- * @return
- *     A non-zero integer if the provided user who owns the connection supports
- *     the "msg" instruction, or zero if the user does not. The integer is cast
- *     as a void*.
- */
-static void* guac_owner_supports_msg_callback(guac_user* user, void* data) {
+void guac_client_get_capabilities(guac_client* client,
+        guac_client_capabilities* capabilities) {
 
-    return (void*) ((intptr_t) guac_user_supports_msg(user));
+    /* The summary spans several values, so must not be copied mid-update */
+    guac_rwlock_acquire_read_lock(&(client->__users_lock));
+    *capabilities = client->__capabilities;
+    guac_rwlock_release_lock(&(client->__users_lock));
 
 }
 
 int guac_client_owner_supports_msg(guac_client* client) {
 
-    return (int) ((intptr_t) guac_client_for_owner(client, guac_owner_supports_msg_callback, NULL));
+    return client->__capabilities.owner_protocol_version
+        >= GUAC_PROTOCOL_VERSION_1_5_0;
 
 }
 
-/**
- * A callback function which is invoked by guac_client_owner_supports_required()
- * to determine if the owner of a client supports the "required" instruction,
- * returning zero if the user does not support the instruction or non-zero if
- * the user supports it.
- * 
- * @param user
- *     The guac_user that will be checked for "required" instruction support.
- * 
- * @param data
- *     Data provided to the callback. This value is never used within this
- *     callback.
- * 
- * @return
- *     A non-zero integer if the provided user who owns the connection supports
- *     the "required" instruction, or zero if the user does not. The integer
- *     is cast as a void*.
- */
-static void* guac_owner_supports_required_callback(guac_user* user, void* data) {
-    
-    return (void*) ((intptr_t) guac_user_supports_required(user));
-    
-}
-
 int guac_client_owner_supports_required(guac_client* client) {
-    
-    return (int) ((intptr_t) guac_client_for_owner(client, guac_owner_supports_required_callback, NULL));
-    
+
+    return client->__capabilities.owner_protocol_version
+        >= GUAC_PROTOCOL_VERSION_1_3_0;
+
 }
 
 /**
@@ -1144,17 +1328,7 @@ int guac_client_owner_notify_leave(guac_client* client, guac_user* quitter) {
 
 int guac_client_supports_webp(guac_client* client) {
 
-#ifdef ENABLE_WEBP
-    int webp_supported = 1;
-
-    /* WebP is supported for entire client only if each user supports it */
-    guac_client_foreach_user(client, __webp_support_callback, &webp_supported);
-
-    return webp_supported;
-#else
-    /* Support for WebP is completely absent */
-    return 0;
-#endif
+    return client->__capabilities.webp;
 
 }
 
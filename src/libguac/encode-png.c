@@ -292,11 +292,11 @@ int guac_png_write(guac_socket* socket, guac_stream* stream,
     /* Flush pending operations to surface */
     cairo_surface_flush(surface);
 
-    /* Attempt to build palette */
-    guac_palette* palette = guac_palette_alloc(surface);
+    /* Attempt to build palette, reusing the palette of the current thread */
+    guac_palette* palette = guac_palette_get();
 
     /* If not possible, resort to Cairo PNG writer */
-    if (palette == NULL)
+    if (guac_palette_build(palette, surface))
         return guac_png_cairo_write(socket, stream, surface);
 
     /* Calculate BPP from palette size */
@@ -308,7 +308,6 @@ int guac_png_write(guac_socket* socket, guac_stream* stream,
     /* Set up PNG writer */
     png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
     if (!png) {
-        guac_palette_free(palette);
         guac_error = GUAC_STATUS_INTERNAL_ERROR;
         guac_error_message = "libpng failed to create write structure";
         return -1;
@@ -317,7 +316,6 @@ int guac_png_write(guac_socket* socket, guac_stream* stream,
     png_info = png_create_info_struct(png);
     if (!png_info) {
         png_destroy_write_struct(&png, NULL);
-        guac_palette_free(palette);
         guac_error = GUAC_STATUS_INTERNAL_ERROR;
         guac_error_message = "libpng failed to create info structure";
         return -1;
@@ -326,7 +324,6 @@ int guac_png_write(guac_socket* socket, guac_stream* stream,
     /* Set error handler */
     if (setjmp(png_jmpbuf(png))) {
         png_destroy_write_struct(&png, &png_info);
-        guac_palette_free(palette);
         guac_error = GUAC_STATUS_IO_ERROR;
         guac_error_message = "libpng output error";
         return -1;
@@ -344,20 +341,29 @@ int guac_png_write(guac_socket* socket, guac_stream* stream,
 
     /* Copy data from surface into PNG data */
     png_rows = (png_byte**) guac_mem_alloc(sizeof(png_byte*), height);
+    png_byte* png_data = (png_byte*) guac_mem_alloc(width, height);
     for (y=0; y<height; y++) {
 
-        /* Allocate new PNG row */
-        png_byte* row = (png_byte*) guac_mem_alloc(sizeof(png_byte), width);
+        png_byte* row = png_data + y * width;
         png_rows[y] = row;
 
+        int last_color = -1;
+        int last_index = 0;
+
         /* Copy data from surface into current row */
         for (x=0; x<width; x++) {
 
             /* Get pixel color */
             int color = ((uint32_t*) data)[x] & 0xFFFFFF;
 
+            /* Look up index in palette only if color has changed */
+            if (color != last_color) {
+                last_index = guac_palette_find(palette, color);
+                last_color = color;
+            }
+
             /* Set index in row */
-            row[x] = guac_palette_find(palette, color);
+            row[x] = last_index;
 
         }
 
@@ -389,12 +395,8 @@ int guac_png_write(guac_socket* socket, guac_stream* stream,
     /* Finish write */
     png_destroy_write_struct(&png, &png_info);
 
-    /* Free palette */
-    guac_palette_free(palette);
-
     /* Free PNG data */
-    for (y=0; y<height; y++)
-        guac_mem_free(png_rows[y]);
+    guac_mem_free(png_data);
     guac_mem_free(png_rows);
 
     /* Ensure all data is written */
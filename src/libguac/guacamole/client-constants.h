@@ -83,5 +83,30 @@
  */
 #define GUAC_BUFFER_POOL_INITIAL_SIZE 1024
 
+/**
+ * The number of most-recently sent frames for which the total number of bytes
+ * sent is remembered, for the sake of estimating the bandwidth available to
+ * each user as those frames are confirmed.
+ */
+#define GUAC_CLIENT_FRAME_HISTORY_SIZE 64
+
+/**
+ * The flag set in the mimetypes of a guac_client_capabilities summary if
+ * every user has declared support for "image/webp".
+ */
+#define GUAC_CLIENT_MIMETYPE_IMAGE_WEBP 0x01
+
+/**
+ * The flag set in the mimetypes of a guac_client_capabilities summary if
+ * every user has declared support for "audio/L8".
+ */
+#define GUAC_CLIENT_MIMETYPE_AUDIO_L8 0x02
+
+/**
+ * The flag set in the mimetypes of a guac_client_capabilities summary if
+ * every user has declared support for "audio/L16".
+ */
+#define GUAC_CLIENT_MIMETYPE_AUDIO_L16 0x04
+
 #endif
 
@@ -34,6 +34,23 @@
  */
 typedef struct guac_client guac_client;
 
+/**
+ * The total number of bytes sent to users by a guac_client as of the end of a
+ * particular frame.
+ */
+typedef struct guac_client_frame guac_client_frame;
+
+/**
+ * Smoothed estimates of the lag, round-trip time, and bandwidth experienced by
+ * the users of a guac_client.
+ */
+typedef struct guac_client_link_estimate guac_client_link_estimate;
+
+/**
+ * Summary of the capabilities shared by the users of a guac_client.
+ */
+typedef struct guac_client_capabilities guac_client_capabilities;
+
 /**
  * Possible current states of the Guacamole client. Currently, the only
  * two states are GUAC_CLIENT_RUNNING and GUAC_CLIENT_STOPPING.
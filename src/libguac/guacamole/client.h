@@ -32,6 +32,7 @@
 #include "layer-types.h"
 #include "object-types.h"
 #include "pool-types.h"
+#include "protocol-types.h"
 #include "rwlock.h"
 #include "socket-types.h"
 #include "stream-types.h"
@@ -43,8 +44,88 @@
 
 #include <pthread.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <time.h>
 
+struct guac_client_frame {
+
+    /**
+     * The timestamp of the frame, as sent within its "sync" instruction.
+     */
+    guac_timestamp timestamp;
+
+    /**
+     * The total number of bytes sent to all non-pending users prior to the
+     * "sync" instruction which ended the frame.
+     */
+    uint64_t bytes;
+
+};
+
+struct guac_client_link_estimate {
+
+    /**
+     * The highest smoothed processing lag of any user, in milliseconds. See
+     * the smoothed_processing_lag member of guac_user.
+     */
+    int processing_lag;
+
+    /**
+     * The highest mean deviation of the processing lag of any user from their
+     * smoothed processing lag, in milliseconds.
+     */
+    int processing_lag_deviation;
+
+    /**
+     * The highest smoothed network round-trip time of any user, in
+     * milliseconds.
+     */
+    int rtt;
+
+    /**
+     * The lowest estimated bandwidth of any user, in bytes per second, or
+     * zero if no user yet has a bandwidth estimate.
+     */
+    int bandwidth;
+
+};
+
+struct guac_client_capabilities {
+
+    /**
+     * The number of non-pending users included in this summary.
+     */
+    int users;
+
+    /**
+     * Non-zero if every non-pending user supports WebP and the server has
+     * been built with WebP support, zero otherwise.
+     */
+    int webp;
+
+    /**
+     * The lowest protocol version of any non-pending user, or
+     * GUAC_PROTOCOL_VERSION_UNKNOWN if there are no such users.
+     */
+    guac_protocol_version protocol_version;
+
+    /**
+     * The protocol version of the owner of the connection, or
+     * GUAC_PROTOCOL_VERSION_UNKNOWN if the owner is not currently connected.
+     */
+    guac_protocol_version owner_protocol_version;
+
+    /**
+     * Bitwise OR of the GUAC_CLIENT_MIMETYPE_* flags of each mimetype that
+     * every non-pending user has declared support for, or zero if there are
+     * no such users. Image mimetypes which all users are assumed to support,
+     * such as "image/png" and "image/jpeg", are not represented.
+     */
+    int mimetypes;
+
+};
+
 struct guac_client {
 
     /**
@@ -314,6 +395,38 @@ struct guac_client {
      */
     void* __plugin_handle;
 
+    /**
+     * The broadcast socket originally assigned to the socket member of this
+     * guac_client. The socket member may later be replaced by a socket which
+     * wraps this socket (for example, for session recording), while this
+     * reference is used to count the bytes actually sent to users.
+     */
+    guac_socket* __broadcast_socket;
+
+    /**
+     * Ring of the most recently sent frames, for the sake of determining how
+     * many bytes were received by a user at the time they confirm a frame.
+     */
+    guac_client_frame __frames[GUAC_CLIENT_FRAME_HISTORY_SIZE];
+
+    /**
+     * The index within __frames at which the next sent frame will be stored.
+     */
+    int __next_frame;
+
+    /**
+     * Lock which is acquired whenever __frames is read or modified.
+     */
+    pthread_mutex_t __frames_lock;
+
+    /**
+     * Summary of the capabilities of all users of this client, recomputed
+     * only when users join or leave, while the write lock of __users_lock is
+     * held. This summary should be accessed only through
+     * guac_client_get_capabilities() and similar functions.
+     */
+    guac_client_capabilities __capabilities;
+
 };
 
 /**
@@ -480,6 +593,33 @@ int guac_client_add_user(guac_client* client, guac_user* user, int argc, char**
  */
 void guac_client_remove_user(guac_client* client, guac_user* user);
 
+/**
+ * Changes the broadcast socket of the given client such that data written to
+ * that socket is delivered to each connected user by a separate thread,
+ * rather than being written to each user's socket in turn. Data is written
+ * once to a shared buffer of the given size, and is then copied to each
+ * user's socket as quickly as that user can receive it. A user that falls
+ * behind by more than the size of the buffer is disconnected, such that a
+ * single slow user cannot delay the connection for all other users. The
+ * socket used to synchronize pending users is unaffected.
+ *
+ * This function must be called before any users have joined the connection.
+ *
+ * @param client
+ *     The client whose broadcast socket should deliver data to users
+ *     asynchronously.
+ *
+ * @param buffer_size
+ *     The size of the buffer shared by all users, in bytes. This will be
+ *     rounded up to the next power of two, and to a minimum of 64 KB.
+ *
+ * @return
+ *     Zero if asynchronous delivery was enabled successfully, non-zero
+ *     otherwise, in which case guac_error is set appropriately.
+ */
+int guac_client_enable_async_broadcast(guac_client* client,
+        size_t buffer_size);
+
 /**
  * Calls the given function on all currently-connected users of the given
  * client. The function will be given a reference to a guac_user and the
@@ -655,6 +795,70 @@ int guac_client_load_plugin(guac_client* client, const char* protocol);
  */
 int guac_client_get_processing_lag(guac_client* client);
 
+/**
+ * Calculates smoothed estimates of the lag, network round-trip time, and
+ * bandwidth experienced by the pool of users, based on the "sync"
+ * instructions received from each user. Unlike
+ * guac_client_get_processing_lag(), which reflects only the most recent frame,
+ * these estimates are averaged across frames such that isolated bursts of lag
+ * do not dominate, and are thus better suited for deciding how aggressively
+ * to compress or skip future frames. The estimates of the user experiencing
+ * the worst conditions are used for each value.
+ *
+ * @param client
+ *     The guac_client to calculate the link estimate of.
+ *
+ * @param estimate
+ *     The guac_client_link_estimate to populate. All values are zero if no
+ *     users are connected or no frames have yet been confirmed.
+ */
+void guac_client_get_link_estimate(guac_client* client,
+        guac_client_link_estimate* estimate);
+
+/**
+ * Moves the given smoothed estimate toward the given sample by the given
+ * fraction of their difference, rounding to the nearest integer such that
+ * small but persistent differences are not ignored. This is the
+ * exponentially-weighted moving average used for the smoothed estimates of
+ * each user, and may be used by protocol plugins to smooth their own
+ * measurements in the same way.
+ *
+ * @param estimate
+ *     The current smoothed estimate.
+ *
+ * @param sample
+ *     The newly-measured value.
+ *
+ * @param weight
+ *     The reciprocal of the fraction of the difference between the sample
+ *     and the estimate to apply.
+ *
+ * @return
+ *     The new smoothed estimate.
+ */
+int guac_client_smooth_estimate(int estimate, int sample, int weight);
+
+/**
+ * Retrieves the total number of bytes that had been sent to all non-pending
+ * users at the end of the frame having the given timestamp. Only the most
+ * recent GUAC_CLIENT_FRAME_HISTORY_SIZE frames are remembered.
+ *
+ * @param client
+ *     The guac_client that sent the frame.
+ *
+ * @param timestamp
+ *     The timestamp of the frame, as sent within its "sync" instruction.
+ *
+ * @param bytes
+ *     Pointer to the uint64_t that should receive the number of bytes sent.
+ *
+ * @return
+ *     Zero if the frame was found and the number of bytes has been stored,
+ *     non-zero if the frame is not among the most recently sent frames.
+ */
+int guac_client_get_frame_bytes(guac_client* client, guac_timestamp timestamp,
+        uint64_t* bytes);
+
 /**
  * Sends a request to the owner of the given guac_client for parameters required
  * to continue the connection started by the client. The function returns zero
@@ -814,6 +1018,138 @@ void guac_client_stream_webp(guac_client* client, guac_socket* socket,
         guac_composite_mode mode, const guac_layer* layer, int x, int y,
         cairo_surface_t* surface, int quality, int lossless);
 
+/**
+ * Streams the image data of the given surface over the given, already
+ * allocated image stream as PNG-encoded data, sending the "img" instruction
+ * which declares the stream, all image data, and the "end" instruction which
+ * terminates the stream. This function is identical to
+ * guac_client_stream_png() except that allocation of the stream is left to
+ * the caller, allowing the stream to remain reserved until the resulting
+ * instructions have actually been sent.
+ *
+ * @param client
+ *     The Guacamole client which owns the given stream.
+ *
+ * @param socket
+ *     The socket over which instructions associated with the image stream
+ *     should be sent.
+ *
+ * @param stream
+ *     The stream over which the image should be sent. This stream must
+ *     already have been allocated, and is not freed by this function.
+ *
+ * @param mode
+ *     The composite mode to use when rendering the image over the given layer.
+ *
+ * @param layer
+ *     The destination layer.
+ *
+ * @param x
+ *     The X coordinate of the upper-left corner of the destination rectangle
+ *     within the given layer.
+ *
+ * @param y
+ *     The Y coordinate of the upper-left corner of the destination rectangle
+ *     within the given layer.
+ *
+ * @param surface
+ *     A Cairo surface containing the image data to be streamed.
+ */
+void guac_client_write_png(guac_client* client, guac_socket* socket,
+        guac_stream* stream, guac_composite_mode mode,
+        const guac_layer* layer, int x, int y, cairo_surface_t* surface);
+
+/**
+ * Streams the image data of the given surface over the given, already
+ * allocated image stream as JPEG-encoded data at the given quality. This
+ * function is identical to guac_client_stream_jpeg() except that allocation
+ * of the stream is left to the caller.
+ *
+ * @param client
+ *     The Guacamole client which owns the given stream.
+ *
+ * @param socket
+ *     The socket over which instructions associated with the image stream
+ *     should be sent.
+ *
+ * @param stream
+ *     The stream over which the image should be sent. This stream must
+ *     already have been allocated, and is not freed by this function.
+ *
+ * @param mode
+ *     The composite mode to use when rendering the image over the given layer.
+ *
+ * @param layer
+ *     The destination layer.
+ *
+ * @param x
+ *     The X coordinate of the upper-left corner of the destination rectangle
+ *     within the given layer.
+ *
+ * @param y
+ *     The Y coordinate of the upper-left corner of the destination rectangle
+ *     within the given layer.
+ *
+ * @param surface
+ *     A Cairo surface containing the image data to be streamed.
+ *
+ * @param quality
+ *     The JPEG image quality, which must be an integer value between 0 and 100
+ *     inclusive. Larger values indicate improving quality at the expense of
+ *     larger file size.
+ */
+void guac_client_write_jpeg(guac_client* client, guac_socket* socket,
+        guac_stream* stream, guac_composite_mode mode,
+        const guac_layer* layer, int x, int y, cairo_surface_t* surface,
+        int quality);
+
+/**
+ * Streams the image data of the given surface over the given, already
+ * allocated image stream as WebP-encoded data at the given quality. This
+ * function is identical to guac_client_stream_webp() except that allocation
+ * of the stream is left to the caller. If the server does not support WebP,
+ * this function has no effect.
+ *
+ * @param client
+ *     The Guacamole client which owns the given stream.
+ *
+ * @param socket
+ *     The socket over which instructions associated with the image stream
+ *     should be sent.
+ *
+ * @param stream
+ *     The stream over which the image should be sent. This stream must
+ *     already have been allocated, and is not freed by this function.
+ *
+ * @param mode
+ *     The composite mode to use when rendering the image over the given layer.
+ *
+ * @param layer
+ *     The destination layer.
+ *
+ * @param x
+ *     The X coordinate of the upper-left corner of the destination rectangle
+ *     within the given layer.
+ *
+ * @param y
+ *     The Y coordinate of the upper-left corner of the destination rectangle
+ *     within the given layer.
+ *
+ * @param surface
+ *     A Cairo surface containing the image data to be streamed.
+ *
+ * @param quality
+ *     The WebP image quality, which must be an integer value between 0 and 100
+ *     inclusive.
+ *
+ * @param lossless
+ *     Zero to encode a lossy image, non-zero to encode losslessly.
+ */
+void guac_client_write_webp(guac_client* client, guac_socket* socket,
+        guac_stream* stream, guac_composite_mode mode,
+        const guac_layer* layer, int x, int y, cairo_surface_t* surface,
+        int quality, int lossless);
+
 /**
  * Returns whether the owner of the given client supports the "msg"
  * instruction, returning non-zero if the client owner does support the
@@ -880,9 +1216,29 @@ int guac_client_owner_notify_join(guac_client* client, guac_user* joiner);
  */
 int guac_client_owner_notify_leave(guac_client* client, guac_user* quitter);
 
+/**
+ * Retrieves the summary of the capabilities shared by all users of the given
+ * client. This summary is recomputed only when users join or leave the
+ * connection. It is copied while holding the read lock for the list of
+ * users, which is cheap but may briefly wait for a user to finish joining or
+ * leaving. Callers that need only a single capability for every update sent
+ * should instead use guac_client_supports_webp() or a similar function, which
+ * read a single value from the summary without acquiring any lock.
+ *
+ * @param client
+ *     The Guacamole client whose users' capabilities should be retrieved.
+ *
+ * @param capabilities
+ *     The guac_client_capabilities to populate.
+ */
+void guac_client_get_capabilities(guac_client* client,
+        guac_client_capabilities* capabilities);
+
 /**
  * Returns whether all users of the given client support WebP. If any user does
  * not support WebP, or the server cannot encode WebP images, zero is returned.
+ * This is determined from the summary maintained for the client as users join
+ * and leave, and does not require iterating the users of the client.
  *
  * @param client
  *     The Guacamole client whose users should be checked for WebP support.
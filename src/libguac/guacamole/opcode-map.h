@@ -0,0 +1,137 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _GUAC_OPCODE_MAP_H
+#define _GUAC_OPCODE_MAP_H
+
+/**
+ * Provides a structure and functions for quickly locating the entry for a
+ * particular instruction opcode within a static table of opcode mappings,
+ * such as the tables mapping opcodes to instruction handlers.
+ *
+ * @file opcode-map.h
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The maximum number of slots within the hash table of a guac_opcode_map.
+ * This must be a power of two.
+ */
+#define GUAC_OPCODE_MAP_MAX_SLOTS 512
+
+/**
+ * The maximum number of mappings that can be located by hash within a
+ * guac_opcode_map. Tables containing more mappings than this will still
+ * function, but each lookup will compare against every opcode in turn.
+ */
+#define GUAC_OPCODE_MAP_MAX_MAPPINGS 255
+
+/**
+ * Index of a static, NULL-terminated table of mappings, where each mapping is
+ * a structure whose first member is the opcode (a "const char*" or "char*")
+ * of the instruction it applies to. The index is a perfect hash table: the
+ * seed of the hash function is chosen such that no two opcodes within the
+ * table occupy the same slot, and thus each lookup requires computing one
+ * hash and performing at most one string comparison.
+ */
+typedef struct guac_opcode_map {
+
+    /**
+     * The first mapping within the NULL-terminated table of mappings being
+     * indexed.
+     */
+    const char* mappings;
+
+    /**
+     * The size of each mapping within the table, in bytes.
+     */
+    size_t mapping_size;
+
+    /**
+     * The number of mappings within the table, excluding the terminating
+     * mapping having a NULL opcode.
+     */
+    int count;
+
+    /**
+     * The seed of the hash function which produces no collisions for the
+     * opcodes within the table.
+     */
+    uint32_t seed;
+
+    /**
+     * The number of slots in use within the hash table, minus one, or zero if
+     * no suitable hash table could be built and each lookup must compare
+     * against every opcode.
+     */
+    unsigned int mask;
+
+    /**
+     * The hash table, where each slot contains one greater than the index of
+     * the mapping whose opcode hashes to that slot, or zero if no opcode
+     * hashes to that slot.
+     */
+    uint8_t slots[GUAC_OPCODE_MAP_MAX_SLOTS];
+
+} guac_opcode_map;
+
+/**
+ * Initializes the given guac_opcode_map, building an index of the given
+ * NULL-terminated table of mappings. The table is not copied and must remain
+ * unchanged for as long as the guac_opcode_map is in use. This function is
+ * not threadsafe with respect to other functions operating on the same
+ * guac_opcode_map and should be invoked exactly once, such as via
+ * pthread_once(), prior to any lookups.
+ *
+ * @param map
+ *     The guac_opcode_map to initialize.
+ *
+ * @param mappings
+ *     The first mapping within the table to index. The first member of each
+ *     mapping must be the opcode of that mapping, and the end of the table
+ *     must be marked with a mapping having a NULL opcode.
+ *
+ * @param mapping_size
+ *     The size of each mapping within the table, in bytes.
+ */
+void guac_opcode_map_init(guac_opcode_map* map, const void* mappings,
+        size_t mapping_size);
+
+/**
+ * Returns the mapping within the table indexed by the given guac_opcode_map
+ * whose opcode exactly matches the given opcode. This function is threadsafe
+ * once the guac_opcode_map has been initialized.
+ *
+ * @param map
+ *     The guac_opcode_map to search.
+ *
+ * @param opcode
+ *     The opcode to search for.
+ *
+ * @return
+ *     A pointer to the mapping having the given opcode, or NULL if no such
+ *     mapping exists.
+ */
+const void* guac_opcode_map_lookup(const guac_opcode_map* map,
+        const char* opcode);
+
+#endif
+
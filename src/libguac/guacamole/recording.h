@@ -21,6 +21,11 @@
 #define GUAC_RECORDING_H
 
 #include <guacamole/client.h>
+#include <guacamole/socket-types.h>
+#include <guacamole/timestamp.h>
+
+#include <stddef.h>
+#include <stdint.h>
 
 /**
  * Provides functions and structures to be use for session recording.
@@ -48,6 +53,109 @@
  */
 #define GUAC_COMMON_RECORDING_MAX_NAME_LENGTH 2048
 
+/**
+ * The number of bytes of recording data which may be held in memory awaiting
+ * a write to the recording file, not including any data spilled beyond this
+ * limit due to GUAC_RECORDING_OVERFLOW_SPILL.
+ */
+#define GUAC_RECORDING_BUFFER_SIZE 4194304
+
+/**
+ * The behavior of a recording when data is produced faster than it can be
+ * written to the recording file, and the in-memory buffer of pending data
+ * has filled.
+ */
+typedef enum guac_recording_overflow {
+
+    /**
+     * Wait until enough pending data has been written to make room. No data
+     * is lost, but the connection stalls for as long as the recording file
+     * cannot be written. This is the default.
+     */
+    GUAC_RECORDING_OVERFLOW_BLOCK,
+
+    /**
+     * Discard each instruction that does not fit, in its entirety. Once room
+     * is available, a "log" instruction noting the number of instructions
+     * dropped is written to the recording in their place.
+     */
+    GUAC_RECORDING_OVERFLOW_DROP,
+
+    /**
+     * Continue buffering pending data in memory beyond the normal limit,
+     * without bound. No data is lost and the connection never stalls, at the
+     * cost of memory.
+     */
+    GUAC_RECORDING_OVERFLOW_SPILL
+
+} guac_recording_overflow;
+
+/**
+ * The suffix appended to the filename of a recording to produce the filename
+ * of its index, if an index is being written.
+ */
+#define GUAC_RECORDING_INDEX_SUFFIX ".idx"
+
+/**
+ * The default minimum amount of time between keyframes written to an indexed
+ * recording, in milliseconds.
+ */
+#define GUAC_RECORDING_DEFAULT_KEYFRAME_INTERVAL 60000
+
+/**
+ * Callback which writes the full current state of a connection to the given
+ * socket, as would be sent to a newly-joined user, such that the state of the
+ * connection can be reconstructed from that point in a recording alone.
+ *
+ * @param socket
+ *     The guac_socket to which the full connection state should be written.
+ *
+ * @param data
+ *     The arbitrary data provided when the keyframe was requested.
+ */
+typedef void guac_recording_keyframe_callback(guac_socket* socket, void* data);
+
+/**
+ * Counters describing the progress of writing a recording to its file.
+ */
+typedef struct guac_recording_stats {
+
+    /**
+     * The total number of bytes written to the recording file.
+     */
+    uint64_t bytes_written;
+
+    /**
+     * The number of bytes currently awaiting a write to the recording file.
+     */
+    size_t queue_length;
+
+    /**
+     * The largest number of bytes that have awaited a write to the recording
+     * file at any one time.
+     */
+    size_t max_queue_length;
+
+    /**
+     * The total amount of time that the connection has spent waiting for
+     * room in the buffer of pending data, in milliseconds.
+     */
+    guac_timestamp stall_time;
+
+    /**
+     * The total number of instructions which have been discarded due to
+     * GUAC_RECORDING_OVERFLOW_DROP.
+     */
+    uint64_t instructions_dropped;
+
+    /**
+     * Non-zero if writing to the recording file has failed, in which case
+     * all further data is discarded, zero otherwise.
+     */
+    int failed;
+
+} guac_recording_stats;
+
 /**
  * An in-progress session recording, attached to a guac_client instance such
  * that output Guacamole instructions may be dynamically intercepted and
@@ -56,8 +164,15 @@
 typedef struct guac_recording {
 
     /**
-     * The guac_socket which writes directly to the recording file, rather than
-     * to any particular user.
+     * The client that this recording is recording.
+     */
+    guac_client* client;
+
+    /**
+     * The guac_socket which writes to the recording file, rather than to any
+     * particular user. Data written to this socket is buffered in memory and
+     * written to the file by a dedicated thread, such that slow storage does
+     * not delay the connection.
      */
     guac_socket* socket;
 
@@ -95,6 +210,40 @@ typedef struct guac_recording {
      */
     int include_keys;
 
+    /**
+     * The full path to the recording file.
+     */
+    char* filename;
+
+    /**
+     * The file descriptor of the index of this recording, or -1 if no index
+     * is being written. Each line of the index describes one keyframe as the
+     * timestamp of that keyframe and the byte offset within the recording at
+     * which the keyframe begins, as decimal integers separated by a comma.
+     * The first line describes the beginning of the recording, with the
+     * timestamp of the first "sync" instruction within the recording.
+     */
+    int index_fd;
+
+    /**
+     * The minimum amount of time between keyframes, in milliseconds.
+     */
+    int keyframe_interval;
+
+    /**
+     * The time that the most recent keyframe (or the index itself) was
+     * written.
+     */
+    guac_timestamp last_keyframe;
+
+    /**
+     * Non-zero if the first line of the index, describing the beginning of
+     * the recording, has been written, zero otherwise. This line is written
+     * by the first call to guac_recording_keyframe(), once the timestamp of
+     * the first "sync" instruction is known.
+     */
+    int index_origin_written;
+
 } guac_recording;
 
 /**
@@ -158,6 +307,50 @@ guac_recording* guac_recording_create(guac_client* client,
         int include_output, int include_mouse, int include_touch,
         int include_keys);
 
+/**
+ * Begins writing an index alongside the given recording, such that playback
+ * of the recording may begin at an arbitrary point in time without first
+ * processing all preceding data. The index is written to a file having the
+ * same name as the recording with GUAC_RECORDING_INDEX_SUFFIX appended, and
+ * is populated as keyframes are written with guac_recording_keyframe(). An
+ * index can only be written for recordings that include output.
+ *
+ * @param recording
+ *     The recording to index.
+ *
+ * @param keyframe_interval
+ *     The minimum amount of time between keyframes, in milliseconds.
+ *
+ * @return
+ *     Zero if the index was successfully created, non-zero otherwise.
+ */
+int guac_recording_enable_index(guac_recording* recording,
+        int keyframe_interval);
+
+/**
+ * Writes a keyframe to the given recording if the recording is indexed and
+ * at least the keyframe interval has elapsed since the previous keyframe. A
+ * keyframe consists of the full connection state, written by the given
+ * callback, followed by a "sync" instruction. The byte offset at which the
+ * keyframe begins is added to the index only if the entire keyframe is
+ * written to the recording. This function must be invoked after every frame
+ * is ended with guac_client_end_frame() or similar, while the state being
+ * written is not being modified. The first invocation also records the
+ * timestamp of the first frame as the beginning of the recording, from which
+ * positions within the recording are measured during playback.
+ *
+ * @param recording
+ *     The recording to which a keyframe should be written, if due.
+ *
+ * @param callback
+ *     The callback to invoke to write the full connection state.
+ *
+ * @param data
+ *     Arbitrary data to pass to the callback.
+ */
+void guac_recording_keyframe(guac_recording* recording,
+        guac_recording_keyframe_callback* callback, void* data);
+
 /**
  * Frees the resources associated with the given in-progress recording. Note
  * that, due to the manner that recordings are attached to the guac_client, the
@@ -169,6 +362,33 @@ guac_recording* guac_recording_create(guac_client* client,
  */
 void guac_recording_free(guac_recording* recording);
 
+/**
+ * Sets the behavior of the given recording for when data is produced faster
+ * than it can be written to the recording file. By default, recordings use
+ * GUAC_RECORDING_OVERFLOW_BLOCK.
+ *
+ * @param recording
+ *     The guac_recording to modify.
+ *
+ * @param overflow
+ *     The behavior to use when the buffer of pending data is full.
+ */
+void guac_recording_set_overflow(guac_recording* recording,
+        guac_recording_overflow overflow);
+
+/**
+ * Retrieves the current counters describing the progress of writing the
+ * given recording to its file.
+ *
+ * @param recording
+ *     The guac_recording to retrieve the counters of.
+ *
+ * @param stats
+ *     The guac_recording_stats structure to populate.
+ */
+void guac_recording_get_stats(guac_recording* recording,
+        guac_recording_stats* stats);
+
 /**
  * Reports the current mouse position and button state within the recording.
  *
@@ -42,6 +42,7 @@
 
 #include <pthread.h>
 #include <stdarg.h>
+#include <stdint.h>
 
 struct guac_user_info {
 
@@ -538,6 +539,53 @@ struct guac_user {
      */
     guac_user_touch_handler* touch_handler;
 
+    /**
+     * The processing lag experienced by the user, smoothed across frames with
+     * an exponentially-weighted moving average such that isolated bursts of
+     * lag do not dominate, in milliseconds.
+     */
+    int smoothed_processing_lag;
+
+    /**
+     * The mean deviation of the processing lag experienced by the user from
+     * smoothed_processing_lag, in milliseconds. This grows as lag becomes
+     * bursty.
+     */
+    int processing_lag_deviation;
+
+    /**
+     * The network round-trip time experienced by the user, smoothed across
+     * frames, in milliseconds.
+     */
+    int smoothed_rtt;
+
+    /**
+     * The approximate rate at which the user is able to receive data, in
+     * bytes per second, smoothed across frames. This will be zero if no
+     * estimate is yet available.
+     */
+    int bandwidth;
+
+    /**
+     * The number of frames confirmed by the user through "sync" instructions
+     * which have contributed to the smoothed estimates above.
+     */
+    int __frames_confirmed;
+
+    /**
+     * The time (in milliseconds, relative to the server's clock) that the
+     * user last confirmed a frame whose total size in bytes was known, or
+     * zero if no such frame has been confirmed since the last frame of
+     * unknown size.
+     */
+    guac_timestamp __last_confirmed_timestamp;
+
+    /**
+     * The total number of bytes sent to the user as of the end of the frame
+     * last confirmed at __last_confirmed_timestamp.
+     */
+    uint64_t __last_confirmed_bytes;
+
 };
 
 /**
@@ -0,0 +1,180 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "guacamole/opcode-map.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * The number of seeds that will be tried for each possible hash table size
+ * before moving on to the next larger size.
+ */
+#define GUAC_OPCODE_MAP_SEED_ATTEMPTS 256
+
+/**
+ * Returns the opcode of the mapping at the given index within the table
+ * indexed by the given guac_opcode_map.
+ *
+ * @param map
+ *     The guac_opcode_map indexing the table.
+ *
+ * @param index
+ *     The index of the mapping within the table.
+ *
+ * @return
+ *     The opcode of the mapping at the given index, or NULL if the index
+ *     refers to the terminating mapping.
+ */
+static const char* guac_opcode_map_get_opcode(const guac_opcode_map* map,
+        int index) {
+    return *((const char* const*) (map->mappings + index * map->mapping_size));
+}
+
+/**
+ * Hashes the given opcode using a seeded variant of 32-bit FNV-1a.
+ *
+ * @param seed
+ *     The seed to mix into the hash.
+ *
+ * @param opcode
+ *     The opcode to hash.
+ *
+ * @return
+ *     The 32-bit hash of the given opcode.
+ */
+static uint32_t guac_opcode_map_hash(uint32_t seed, const char* opcode) {
+
+    uint32_t hash = 2166136261u ^ seed;
+
+    while (*opcode != '\0') {
+        hash ^= (unsigned char) *(opcode++);
+        hash *= 16777619u;
+    }
+
+    /* Fold upper bits into the lower bits used to select a slot */
+    return hash ^ (hash >> 15);
+
+}
+
+/**
+ * Attempts to fill the hash table of the given guac_opcode_map using the
+ * given seed and number of slots, such that no two opcodes occupy the same
+ * slot.
+ *
+ * @param map
+ *     The guac_opcode_map whose hash table should be filled.
+ *
+ * @param seed
+ *     The seed of the hash function to use.
+ *
+ * @param mask
+ *     The number of slots to use, minus one.
+ *
+ * @return
+ *     Non-zero if the table was filled with no collisions, zero otherwise.
+ */
+static int guac_opcode_map_try_fill(guac_opcode_map* map, uint32_t seed,
+        unsigned int mask) {
+
+    memset(map->slots, 0, sizeof(map->slots));
+
+    for (int i = 0; i < map->count; i++) {
+
+        const char* opcode = guac_opcode_map_get_opcode(map, i);
+        unsigned int slot = guac_opcode_map_hash(seed, opcode) & mask;
+
+        /* Fail if slot already taken */
+        if (map->slots[slot] != 0)
+            return 0;
+
+        map->slots[slot] = i + 1;
+
+    }
+
+    return 1;
+
+}
+
+void guac_opcode_map_init(guac_opcode_map* map, const void* mappings,
+        size_t mapping_size) {
+
+    map->mappings = (const char*) mappings;
+    map->mapping_size = mapping_size;
+    map->count = 0;
+    map->seed = 0;
+    map->mask = 0;
+
+    /* Count mappings */
+    while (guac_opcode_map_get_opcode(map, map->count) != NULL)
+        map->count++;
+
+    /* Tables too large to index are searched linearly */
+    if (map->count > GUAC_OPCODE_MAP_MAX_MAPPINGS)
+        return;
+
+    /* Start with a table at least twice the number of opcodes */
+    unsigned int size = 2;
+    while (size < (unsigned int) map->count * 2)
+        size *= 2;
+
+    /* Find the smallest table and a seed that produce no collisions */
+    for (; size <= GUAC_OPCODE_MAP_MAX_SLOTS; size *= 2) {
+        for (uint32_t seed = 0; seed < GUAC_OPCODE_MAP_SEED_ATTEMPTS; seed++) {
+            if (guac_opcode_map_try_fill(map, seed, size - 1)) {
+                map->seed = seed;
+                map->mask = size - 1;
+                return;
+            }
+        }
+    }
+
+    /* No perfect hash found; fall back to searching linearly */
+    memset(map->slots, 0, sizeof(map->slots));
+
+}
+
+const void* guac_opcode_map_lookup(const guac_opcode_map* map,
+        const char* opcode) {
+
+    /* Search every mapping if no hash table could be built */
+    if (map->mask == 0) {
+
+        for (int i = 0; i < map->count; i++) {
+            if (strcmp(guac_opcode_map_get_opcode(map, i), opcode) == 0)
+                return map->mappings + i * map->mapping_size;
+        }
+
+        return NULL;
+
+    }
+
+    /* Otherwise, only one mapping can possibly match */
+    unsigned int slot = guac_opcode_map_hash(map->seed, opcode) & map->mask;
+    int index = map->slots[slot] - 1;
+
+    if (index >= 0 && strcmp(guac_opcode_map_get_opcode(map, index), opcode) == 0)
+        return map->mappings + index * map->mapping_size;
+
+    return NULL;
+
+}
@@ -24,12 +24,106 @@
 
 #include <cairo/cairo.h>
 
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-guac_palette* guac_palette_alloc(cairo_surface_t* surface) {
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Key used to store the palette reserved for each thread.
+ */
+static pthread_key_t __guac_palette_key;
+
+/**
+ * Guards creation of the key used to store the palette reserved for each
+ * thread.
+ */
+static pthread_once_t __guac_palette_key_init = PTHREAD_ONCE_INIT;
+
+/**
+ * Frees the given palette. This function is invoked automatically for the
+ * palette of each terminating thread.
+ *
+ * @param palette
+ *     The palette to free.
+ */
+static void __guac_palette_free(void* palette) {
+    guac_mem_free(palette);
+}
+
+/**
+ * Creates the key used to store the palette reserved for each thread.
+ */
+static void __guac_alloc_palette_key() {
+    pthread_key_create(&__guac_palette_key, __guac_palette_free);
+}
+
+/**
+ * Returns the number of pixels at the start of the given row which are
+ * identical to the given color, ignoring alpha.
+ *
+ * @param row
+ *     The pixels to check.
+ *
+ * @param width
+ *     The number of pixels within the row.
+ *
+ * @param color
+ *     The color to compare each pixel against, without alpha.
+ *
+ * @return
+ *     The number of leading pixels within the row which match the given
+ *     color.
+ */
+static int __guac_palette_skip_run(const uint32_t* row, int width,
+        int color) {
+
+    int x = 0;
+
+#ifdef __SSE2__
+    const __m128i mask = _mm_set1_epi32(0xFFFFFF);
+    const __m128i expected = _mm_set1_epi32(color);
+
+    /* Skip four pixels at a time while all match */
+    for (; x + 4 <= width; x += 4) {
+        __m128i pixels = _mm_and_si128(mask,
+                _mm_loadu_si128((const __m128i*) (row + x)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(pixels, expected)) != 0xFFFF)
+            break;
+    }
+#endif
+
+    /* Skip any remaining matching pixels individually */
+    while (x < width && (int) (row[x] & 0xFFFFFF) == color)
+        x++;
+
+    return x;
+
+}
+
+guac_palette* guac_palette_get() {
+
+    pthread_once(&__guac_palette_key_init, __guac_alloc_palette_key);
+
+    /* Allocate palette for current thread only if not already allocated */
+    guac_palette* palette =
+        (guac_palette*) pthread_getspecific(__guac_palette_key);
+
+    if (palette == NULL) {
+        palette = (guac_palette*) guac_mem_zalloc(sizeof(guac_palette));
+        pthread_setspecific(__guac_palette_key, palette);
+    }
+
+    return palette;
+
+}
+
+int guac_palette_build(guac_palette* palette, cairo_surface_t* surface) {
 
     int x, y;
 
@@ -38,14 +132,22 @@ guac_palette* guac_palette_alloc(cairo_surface_t* surface) {
     int stride = cairo_image_surface_get_stride(surface);
     unsigned char* data = cairo_image_surface_get_data(surface);
 
-    /* Allocate palette */
-    guac_palette* palette = (guac_palette*) guac_mem_zalloc(sizeof(guac_palette));
+    /* Invalidate all entries from any previous build. Entries need only be
+     * cleared if the generation counter wraps around. */
+    palette->size = 0;
+    if (++palette->generation == 0) {
+        memset(palette->entries, 0, sizeof(palette->entries));
+        palette->generation = 1;
+    }
 
     for (y=0; y<height; y++) {
+
+        const uint32_t* row = (const uint32_t*) data;
+
         for (x=0; x<width; x++) {
 
             /* Get pixel color */
-            int color = ((uint32_t*) data)[x] & 0xFFFFFF;
+            int color = row[x] & 0xFFFFFF;
 
             /* Calculate hash code */
             int hash = ((color & 0xFFF000) >> 12) ^ (color & 0xFFF);
@@ -58,15 +160,13 @@ guac_palette* guac_palette_alloc(cairo_surface_t* surface) {
                 entry = &(palette->entries[hash]);
 
                 /* If we've found a free space, use it */
-                if (entry->index == 0) {
+                if (entry->generation != palette->generation) {
 
                     png_color* c;
 
                     /* Stop if already at capacity */
-                    if (palette->size == 256) {
-                        guac_palette_free(palette);
-                        return NULL;
-                    }
+                    if (palette->size == 256)
+                        return 1;
 
                     /* Store in palette */
                     c = &(palette->colors[palette->size]);
@@ -77,6 +177,7 @@ guac_palette* guac_palette_alloc(cairo_surface_t* surface) {
                     /* Add color to map */
                     entry->index = ++palette->size;
                     entry->color = color;
+                    entry->generation = palette->generation;
 
                     break;
 
@@ -90,6 +191,11 @@ guac_palette* guac_palette_alloc(cairo_surface_t* surface) {
                 hash = (hash+1) & 0xFFF;
 
             }
+
+            /* Skip any following pixels of the same color, which must
+             * already be stored */
+            x += __guac_palette_skip_run(row + x + 1, width - x - 1, color);
+
         }
 
         /* Advance to next data row */
@@ -97,7 +203,7 @@ guac_palette* guac_palette_alloc(cairo_surface_t* surface) {
 
     }
 
-    return palette;
+    return 0;
 
 }
 
@@ -114,7 +220,7 @@ int guac_palette_find(guac_palette* palette, int color) {
         entry = &(palette->entries[hash]);
 
         /* If we've found a free space, color not stored. */
-        if (entry->index == 0)
+        if (entry->generation != palette->generation)
             return -1;
 
         /* Otherwise, if color indeed stored here, done */
@@ -127,8 +233,3 @@ int guac_palette_find(guac_palette* palette, int color) {
     }
 
 }
-
-void guac_palette_free(guac_palette* palette) {
-    guac_mem_free(palette);
-}
-
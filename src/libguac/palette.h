@@ -29,6 +29,13 @@ typedef struct guac_palette_entry {
     int index;
     int color;
 
+    /**
+     * The generation of the palette during which this entry was last
+     * written. The entry is only valid if this matches the current
+     * generation of the palette.
+     */
+    unsigned int generation;
+
 } guac_palette_entry;
 
 typedef struct guac_palette {
@@ -37,11 +44,47 @@ typedef struct guac_palette {
     png_color colors[256];
     int size;
 
+    /**
+     * The current generation of this palette, incremented each time the
+     * palette is rebuilt such that entries from previous builds are
+     * invalidated without clearing the entire table.
+     */
+    unsigned int generation;
+
 } guac_palette;
 
-guac_palette* guac_palette_alloc(cairo_surface_t* surface);
+/**
+ * Returns the palette reserved for use by the current thread, allocating
+ * that palette if this is the first call within the current thread. The
+ * palette is reused by all later calls within the same thread, and is
+ * automatically freed when the thread terminates. It MUST NOT be freed by
+ * the caller.
+ *
+ * @return
+ *     The palette reserved for use by the current thread.
+ */
+guac_palette* guac_palette_get();
+
+/**
+ * Rebuilds the given palette from the colors of the given surface,
+ * discarding any colors from previous builds. Alpha is ignored. The build
+ * stops as soon as more than 256 distinct colors are found.
+ *
+ * @param palette
+ *     The palette to rebuild.
+ *
+ * @param surface
+ *     The surface whose colors should be stored within the palette. This
+ *     surface must be 32 bits per pixel.
+ *
+ * @return
+ *     Zero if the surface contains at most 256 distinct colors and the
+ *     palette was built successfully, non-zero if the surface contains too
+ *     many colors to be represented by a palette.
+ */
+int guac_palette_build(guac_palette* palette, cairo_surface_t* surface);
+
 int guac_palette_find(guac_palette* palette, int color);
-void guac_palette_free(guac_palette* palette);
 
 #endif
 
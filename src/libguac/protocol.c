@@ -31,7 +31,6 @@
 
 #include <cairo/cairo.h>
 
-#include <inttypes.h>
 #include <setjmp.h>
 #include <stdarg.h>
 #include <stdint.h>
@@ -69,22 +68,198 @@ guac_protocol_version_mapping guac_protocol_version_table[] = {
     { GUAC_PROTOCOL_VERSION_UNKNOWN, NULL }
 };
 
+/**
+ * The maximum number of bytes required to represent any int64_t in decimal,
+ * including its sign.
+ */
+#define GUAC_PROTOCOL_INT_MAX_DIGITS 20
+
+/**
+ * The maximum number of bytes required to represent any int64_t as a
+ * Guacamole protocol element, including the length prefix and period.
+ */
+#define GUAC_PROTOCOL_INT_ELEMENT_MAX_LENGTH (GUAC_PROTOCOL_INT_MAX_DIGITS + 3)
+
+/**
+ * The maximum number of arguments which may be sent by
+ * guac_protocol_send_int_instruction().
+ */
+#define GUAC_PROTOCOL_MAX_INT_ARGS 9
+
+/**
+ * The maximum length of the opcode element that may be provided to
+ * guac_protocol_send_int_instruction(), including its length prefix.
+ */
+#define GUAC_PROTOCOL_MAX_INT_OPCODE_LENGTH 16
+
+/**
+ * The decimal representations of all integers from 0 through 99, as
+ * consecutive pairs of digits.
+ */
+static const char guac_protocol_digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/**
+ * Writes the decimal representation of the given integer to the given
+ * buffer, without null terminator. Digits are produced two at a time using a
+ * lookup table, avoiding the overhead of snprintf().
+ *
+ * @param buffer
+ *     The buffer to write to. This buffer must have at least
+ *     GUAC_PROTOCOL_INT_MAX_DIGITS bytes available.
+ *
+ * @param value
+ *     The integer to write.
+ *
+ * @return
+ *     The number of bytes written.
+ */
+static int guac_protocol_format_digits(char* buffer, int64_t value) {
+
+    char digits[GUAC_PROTOCOL_INT_MAX_DIGITS];
+    char* current = digits + sizeof(digits);
+
+    /* Work with the magnitude as unsigned such that INT64_MIN is handled */
+    uint64_t magnitude = value < 0 ? -(uint64_t) value : (uint64_t) value;
+
+    /* Produce digits in pairs, from least significant to most */
+    while (magnitude >= 100) {
+        const char* pair = &guac_protocol_digit_pairs[(magnitude % 100) * 2];
+        *(--current) = pair[1];
+        *(--current) = pair[0];
+        magnitude /= 100;
+    }
+
+    if (magnitude >= 10) {
+        const char* pair = &guac_protocol_digit_pairs[magnitude * 2];
+        *(--current) = pair[1];
+        *(--current) = pair[0];
+    }
+    else
+        *(--current) = '0' + magnitude;
+
+    if (value < 0)
+        *(--current) = '-';
+
+    int length = digits + sizeof(digits) - current;
+    memcpy(buffer, current, length);
+    return length;
+
+}
+
+/**
+ * Writes the given integer to the given buffer as a Guacamole protocol
+ * element, including its length prefix, without null terminator. As the
+ * decimal representation of an integer is purely ASCII, its length is known
+ * without scanning the result as UTF-8.
+ *
+ * @param buffer
+ *     The buffer to write to. This buffer must have at least
+ *     GUAC_PROTOCOL_INT_ELEMENT_MAX_LENGTH bytes available.
+ *
+ * @param value
+ *     The integer to write.
+ *
+ * @return
+ *     The number of bytes written.
+ */
+static int guac_protocol_format_int(char* buffer, int64_t value) {
+
+    char digits[GUAC_PROTOCOL_INT_MAX_DIGITS];
+    int length = guac_protocol_format_digits(digits, value);
+
+    /* The length prefix never exceeds two digits */
+    char* current = buffer;
+    if (length >= 10)
+        *(current++) = '0' + length / 10;
+    *(current++) = '0' + length % 10;
+    *(current++) = '.';
+
+    memcpy(current, digits, length);
+    return current - buffer + length;
+
+}
+
+/**
+ * Sends an instruction whose arguments are all integers, formatting the
+ * entire instruction in memory such that it is written to the given socket
+ * with a single call to guac_socket_write().
+ *
+ * @param socket
+ *     The guac_socket connection to use.
+ *
+ * @param opcode
+ *     The opcode of the instruction, already formatted as a Guacamole
+ *     protocol element (for example, "4.copy"). This may be no longer than
+ *     GUAC_PROTOCOL_MAX_INT_OPCODE_LENGTH bytes.
+ *
+ * @param args
+ *     The integer arguments of the instruction.
+ *
+ * @param argc
+ *     The number of arguments within the args array. This may be no greater
+ *     than GUAC_PROTOCOL_MAX_INT_ARGS.
+ *
+ * @return
+ *     Zero on success, non-zero on error.
+ */
+static int guac_protocol_send_int_instruction(guac_socket* socket,
+        const char* opcode, const int64_t* args, int argc) {
+
+    char buffer[GUAC_PROTOCOL_MAX_INT_OPCODE_LENGTH
+        + GUAC_PROTOCOL_MAX_INT_ARGS * (GUAC_PROTOCOL_INT_ELEMENT_MAX_LENGTH + 1)
+        + 1];
+
+    size_t opcode_length = strlen(opcode);
+    memcpy(buffer, opcode, opcode_length);
+    char* current = buffer + opcode_length;
+
+    for (int i = 0; i < argc; i++) {
+        *(current++) = ',';
+        current += guac_protocol_format_int(current, args[i]);
+    }
+
+    *(current++) = ';';
+
+    int ret_val;
+
+    guac_socket_instruction_begin(socket);
+    ret_val = guac_socket_write(socket, buffer, current - buffer) != 0;
+    guac_socket_instruction_end(socket);
+
+    return ret_val;
+
+}
+
 /* Output formatting functions */
 
 ssize_t __guac_socket_write_length_string(guac_socket* socket, const char* str) {
 
+    /* Write length prefix and period together */
+    char prefix[GUAC_PROTOCOL_INT_MAX_DIGITS + 1];
+    int length = guac_protocol_format_digits(prefix, guac_utf8_strlen(str));
+    prefix[length++] = '.';
+
     return
-           guac_socket_write_int(socket, guac_utf8_strlen(str))
-        || guac_socket_write_string(socket, ".")
+           guac_socket_write(socket, prefix, length)
         || guac_socket_write_string(socket, str);
 
 }
 
 ssize_t __guac_socket_write_length_int(guac_socket* socket, int64_t i) {
 
-    char buffer[128];
-    snprintf(buffer, sizeof(buffer), "%"PRIi64, i);
-    return __guac_socket_write_length_string(socket, buffer);
+    char buffer[GUAC_PROTOCOL_INT_ELEMENT_MAX_LENGTH];
+    return guac_socket_write(socket, buffer,
+            guac_protocol_format_int(buffer, i));
 
 }
 
@@ -321,41 +496,17 @@ int guac_protocol_send_cfill(guac_socket* socket,
         guac_composite_mode mode, const guac_layer* layer,
         int r, int g, int b, int a) {
 
-    int ret_val;
+    const int64_t args[] = { mode, layer->index, r, g, b, a };
 
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "5.cfill,")
-        || __guac_socket_write_length_int(socket, mode)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, r)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, g)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, b)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, a)
-        || guac_socket_write_string(socket, ";");
-
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "5.cfill", args, 6);
 
 }
 
 int guac_protocol_send_close(guac_socket* socket, const guac_layer* layer) {
 
-    int ret_val;
+    const int64_t args[] = { layer->index };
 
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "5.close,")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ";");
-
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "5.close", args, 1);
 
 }
 
@@ -385,16 +536,9 @@ int guac_protocol_send_connect(guac_socket* socket, const char** args) {
 
 int guac_protocol_send_clip(guac_socket* socket, const guac_layer* layer) {
 
-    int ret_val;
-
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "4.clip,")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ";");
+    const int64_t args[] = { layer->index };
 
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "4.clip", args, 1);
 
 }
 
@@ -420,32 +564,11 @@ int guac_protocol_send_copy(guac_socket* socket,
         const guac_layer* srcl, int srcx, int srcy, int w, int h,
         guac_composite_mode mode, const guac_layer* dstl, int dstx, int dsty) {
 
-    int ret_val;
-
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "4.copy,")
-        || __guac_socket_write_length_int(socket, srcl->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, srcx)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, srcy)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, w)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, h)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, mode)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, dstl->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, dstx)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, dsty)
-        || guac_socket_write_string(socket, ";");
+    const int64_t args[] = {
+        srcl->index, srcx, srcy, w, h, mode, dstl->index, dstx, dsty
+    };
 
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "4.copy", args, 9);
 
 }
 
@@ -454,87 +577,29 @@ int guac_protocol_send_cstroke(guac_socket* socket,
         guac_line_cap_style cap, guac_line_join_style join, int thickness,
         int r, int g, int b, int a) {
 
-    int ret_val;
+    const int64_t args[] = {
+        mode, layer->index, cap, join, thickness, r, g, b, a
+    };
 
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "7.cstroke,")
-        || __guac_socket_write_length_int(socket, mode)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, cap)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, join)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, thickness)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, r)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, g)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, b)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, a)
-        || guac_socket_write_string(socket, ";");
-
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "7.cstroke", args, 9);
 
 }
 
 int guac_protocol_send_cursor(guac_socket* socket, int x, int y,
         const guac_layer* srcl, int srcx, int srcy, int w, int h) {
-    int ret_val;
 
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "6.cursor,")
-        || __guac_socket_write_length_int(socket, x)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, y)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, srcl->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, srcx)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, srcy)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, w)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, h)
-        || guac_socket_write_string(socket, ";");
+    const int64_t args[] = { x, y, srcl->index, srcx, srcy, w, h };
 
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "6.cursor", args, 7);
 
 }
 
 int guac_protocol_send_curve(guac_socket* socket, const guac_layer* layer,
         int cp1x, int cp1y, int cp2x, int cp2y, int x, int y) {
 
-    int ret_val;
+    const int64_t args[] = { layer->index, cp1x, cp1y, cp2x, cp2y, x, y };
 
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "5.curve,")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, cp1x)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, cp1y)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, cp2x)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, cp2y)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, x)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, y)
-        || guac_socket_write_string(socket, ";");
-
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "5.curve", args, 7);
 
 }
 
@@ -550,16 +615,9 @@ int guac_protocol_send_disconnect(guac_socket* socket) {
 
 int guac_protocol_send_dispose(guac_socket* socket, const guac_layer* layer) {
 
-    int ret_val;
-
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "7.dispose,")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ";");
+    const int64_t args[] = { layer->index };
 
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "7.dispose", args, 1);
 
 }
 
@@ -716,34 +774,18 @@ int guac_protocol_send_filesystem(guac_socket* socket,
 
 int guac_protocol_send_identity(guac_socket* socket, const guac_layer* layer) {
 
-    int ret_val;
+    const int64_t args[] = { layer->index };
 
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "8.identity,")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ";");
-
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "8.identity", args, 1);
 
 }
 
 int guac_protocol_send_key(guac_socket* socket, int keysym, int pressed,
         guac_timestamp timestamp) {
 
-    int ret_val;
-
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "3.key,")
-        || __guac_socket_write_length_int(socket, keysym)
-        || guac_socket_write_string(socket, pressed ? ",1.1," : ",1.0,")
-        || __guac_socket_write_length_int(socket, timestamp)
-        || guac_socket_write_string(socket, ";");
+    const int64_t args[] = { keysym, pressed ? 1 : 0, timestamp };
 
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "3.key", args, 3);
 
 }
 
@@ -751,40 +793,18 @@ int guac_protocol_send_lfill(guac_socket* socket,
         guac_composite_mode mode, const guac_layer* layer,
         const guac_layer* srcl) {
 
-    int ret_val;
-
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "5.lfill,")
-        || __guac_socket_write_length_int(socket, mode)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, srcl->index)
-        || guac_socket_write_string(socket, ";");
+    const int64_t args[] = { mode, layer->index, srcl->index };
 
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "5.lfill", args, 3);
 
 }
 
 int guac_protocol_send_line(guac_socket* socket, const guac_layer* layer,
         int x, int y) {
 
-    int ret_val;
-
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "4.line,")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, x)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, y)
-        || guac_socket_write_string(socket, ";");
+    const int64_t args[] = { layer->index, x, y };
 
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "4.line", args, 3);
 
 }
 
@@ -793,48 +813,20 @@ int guac_protocol_send_lstroke(guac_socket* socket,
         guac_line_cap_style cap, guac_line_join_style join, int thickness,
         const guac_layer* srcl) {
 
-    int ret_val;
+    const int64_t args[] = {
+        mode, layer->index, cap, join, thickness, srcl->index
+    };
 
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "7.lstroke,")
-        || __guac_socket_write_length_int(socket, mode)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, cap)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, join)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, thickness)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, srcl->index)
-        || guac_socket_write_string(socket, ";");
-
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "7.lstroke", args, 6);
 
 }
 
 int guac_protocol_send_mouse(guac_socket* socket, int x, int y,
         int button_mask, guac_timestamp timestamp) {
 
-    int ret_val;
+    const int64_t args[] = { x, y, button_mask, timestamp };
 
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "5.mouse,")
-        || __guac_socket_write_length_int(socket, x)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, y)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, button_mask)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, timestamp)
-        || guac_socket_write_string(socket, ";");
-
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "5.mouse", args, 4);
 
 }
 
@@ -872,24 +864,9 @@ int guac_protocol_send_touch(guac_socket* socket, int id, int x, int y,
 int guac_protocol_send_move(guac_socket* socket, const guac_layer* layer,
         const guac_layer* parent, int x, int y, int z) {
 
-    int ret_val;
+    const int64_t args[] = { layer->index, parent->index, x, y, z };
 
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "4.move,")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, parent->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, x)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, y)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, z)
-        || guac_socket_write_string(socket, ";");
-
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "4.move", args, 5);
 
 }
 
@@ -987,31 +964,17 @@ int guac_protocol_send_img(guac_socket* socket, const guac_stream* stream,
 
 int guac_protocol_send_pop(guac_socket* socket, const guac_layer* layer) {
 
-    int ret_val;
-
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "3.pop,")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ";");
+    const int64_t args[] = { layer->index };
 
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "3.pop", args, 1);
 
 }
 
 int guac_protocol_send_push(guac_socket* socket, const guac_layer* layer) {
 
-    int ret_val;
+    const int64_t args[] = { layer->index };
 
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "4.push,")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ";");
-
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "4.push", args, 1);
 
 }
 
@@ -1033,24 +996,9 @@ int guac_protocol_send_ready(guac_socket* socket, const char* id) {
 int guac_protocol_send_rect(guac_socket* socket,
         const guac_layer* layer, int x, int y, int width, int height) {
 
-    int ret_val;
-
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "4.rect,")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, x)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, y)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, width)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, height)
-        || guac_socket_write_string(socket, ";");
+    const int64_t args[] = { layer->index, x, y, width, height };
 
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "4.rect", args, 5);
 
 }
 
@@ -1073,16 +1021,9 @@ int guac_protocol_send_required(guac_socket* socket, const char** required) {
 
 int guac_protocol_send_reset(guac_socket* socket, const guac_layer* layer) {
 
-    int ret_val;
+    const int64_t args[] = { layer->index };
 
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "5.reset,")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ";");
-
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "5.reset", args, 1);
 
 }
 
@@ -1144,76 +1085,36 @@ int guac_protocol_send_select(guac_socket* socket, const char* protocol) {
 int guac_protocol_send_shade(guac_socket* socket, const guac_layer* layer,
         int a) {
 
-    int ret_val;
-
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "5.shade,")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, a)
-        || guac_socket_write_string(socket, ";");
+    const int64_t args[] = { layer->index, a };
 
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "5.shade", args, 2);
 
 }
 
 int guac_protocol_send_size(guac_socket* socket, const guac_layer* layer,
         int w, int h) {
 
-    int ret_val;
+    const int64_t args[] = { layer->index, w, h };
 
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "4.size,")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, w)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, h)
-        || guac_socket_write_string(socket, ";");
-
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "4.size", args, 3);
 
 }
 
 int guac_protocol_send_start(guac_socket* socket, const guac_layer* layer,
         int x, int y) {
 
-    int ret_val;
-
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "5.start,")
-        || __guac_socket_write_length_int(socket, layer->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, x)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, y)
-        || guac_socket_write_string(socket, ";");
+    const int64_t args[] = { layer->index, x, y };
 
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "5.start", args, 3);
 
 }
 
 int guac_protocol_send_sync(guac_socket* socket, guac_timestamp timestamp,
         int frames) {
 
-    int ret_val;
+    const int64_t args[] = { timestamp, frames };
 
-    guac_socket_instruction_begin(socket);
-    ret_val = 
-           guac_socket_write_string(socket, "4.sync,")
-        || __guac_socket_write_length_int(socket, timestamp)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, frames)
-        || guac_socket_write_string(socket, ";");
-
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "4.sync", args, 2);
 
 }
 
@@ -1221,32 +1122,11 @@ int guac_protocol_send_transfer(guac_socket* socket,
         const guac_layer* srcl, int srcx, int srcy, int w, int h,
         guac_transfer_function fn, const guac_layer* dstl, int dstx, int dsty) {
 
-    int ret_val;
+    const int64_t args[] = {
+        srcl->index, srcx, srcy, w, h, fn, dstl->index, dstx, dsty
+    };
 
-    guac_socket_instruction_begin(socket);
-    ret_val =
-           guac_socket_write_string(socket, "8.transfer,")
-        || __guac_socket_write_length_int(socket, srcl->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, srcx)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, srcy)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, w)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, h)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, fn)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, dstl->index)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, dstx)
-        || guac_socket_write_string(socket, ",")
-        || __guac_socket_write_length_int(socket, dsty)
-        || guac_socket_write_string(socket, ";");
-
-    guac_socket_instruction_end(socket);
-    return ret_val;
+    return guac_protocol_send_int_instruction(socket, "8.transfer", args, 9);
 
 }
 
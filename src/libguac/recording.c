@@ -22,7 +22,9 @@
 #include "guacamole/protocol.h"
 #include "guacamole/recording.h"
 #include "guacamole/socket.h"
+#include "guacamole/string.h"
 #include "guacamole/timestamp.h"
+#include "socket-recording.h"
 
 #ifdef __MINGW32__
 #include <direct.h>
@@ -32,6 +34,8 @@
 #include <sys/types.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -162,13 +166,33 @@ guac_recording* guac_recording_create(guac_client* client,
         return NULL;
     }
 
+    /* Write recording asynchronously, such that slow storage does not
+     * delay the connection */
+    guac_socket* socket = guac_socket_recording(fd,
+            GUAC_RECORDING_BUFFER_SIZE, GUAC_RECORDING_OVERFLOW_BLOCK);
+    if (socket == NULL) {
+        guac_client_log(client, GUAC_LOG_ERROR,
+                "Creation of recording failed: Unable to start writer "
+                "thread.");
+        close(fd);
+        return NULL;
+    }
+
     /* Create recording structure with reference to underlying socket */
     guac_recording* recording = guac_mem_alloc(sizeof(guac_recording));
-    recording->socket = guac_socket_open(fd);
+    recording->client = client;
+    recording->socket = socket;
     recording->include_output = include_output;
     recording->include_mouse = include_mouse;
     recording->include_touch = include_touch;
     recording->include_keys = include_keys;
+    recording->filename = guac_strdup(filename);
+
+    /* No index is written unless explicitly enabled */
+    recording->index_fd = -1;
+    recording->keyframe_interval = 0;
+    recording->last_keyframe = 0;
+    recording->index_origin_written = 0;
 
     /* Replace client socket with wrapped recording socket only if including
      * output within the recording */
@@ -186,16 +210,167 @@ guac_recording* guac_recording_create(guac_client* client,
 
 void guac_recording_free(guac_recording* recording) {
 
+    guac_recording_stats stats;
+    guac_recording_get_stats(recording, &stats);
+
+    guac_client_log(recording->client, GUAC_LOG_DEBUG, "Recording: %" PRIu64
+            " bytes written, %zu bytes pending (at most %zu), stalled for "
+            "%" PRIu64 " ms, %" PRIu64 " instructions dropped.",
+            stats.bytes_written, stats.queue_length, stats.max_queue_length,
+            (uint64_t) stats.stall_time, stats.instructions_dropped);
+
+    if (stats.failed)
+        guac_client_log(recording->client, GUAC_LOG_WARNING, "Recording "
+                "is incomplete, as the recording file could not be "
+                "written.");
+
     /* If not including broadcast output, the output socket is not associated
      * with the client, and must be freed manually */
     if (!recording->include_output)
         guac_socket_free(recording->socket);
 
+    /* Close index, if any */
+    if (recording->index_fd != -1)
+        close(recording->index_fd);
+
     /* Free recording itself */
+    guac_mem_free(recording->filename);
     guac_mem_free(recording);
 
 }
 
+/**
+ * Appends an entry describing a keyframe to the index of the given recording.
+ * If the entry cannot be written, a warning is logged and no further entries
+ * will be written.
+ *
+ * @param recording
+ *     The recording whose index should be updated.
+ *
+ * @param timestamp
+ *     The timestamp of the keyframe.
+ *
+ * @param offset
+ *     The byte offset within the recording at which the keyframe begins.
+ */
+static void guac_recording_write_index(guac_recording* recording,
+        guac_timestamp timestamp, uint64_t offset) {
+
+    char entry[64];
+    int length = snprintf(entry, sizeof(entry), "%" PRIu64 ",%" PRIu64 "\n",
+            (uint64_t) timestamp, offset);
+
+    /* Stop indexing if the index cannot be written (the recording itself is
+     * unaffected) */
+    if (write(recording->index_fd, entry, length) != length) {
+        guac_client_log(recording->client, GUAC_LOG_WARNING, "Recording "
+                "index could not be written: %s. Further keyframes will not "
+                "be indexed.", strerror(errno));
+        close(recording->index_fd);
+        recording->index_fd = -1;
+    }
+
+}
+
+int guac_recording_enable_index(guac_recording* recording,
+        int keyframe_interval) {
+
+    /* Keyframes are only meaningful if output is recorded */
+    if (!recording->include_output) {
+        guac_client_log(recording->client, GUAC_LOG_WARNING, "Recording "
+                "index will not be created, as output is excluded from the "
+                "recording.");
+        return 1;
+    }
+
+    char filename[GUAC_COMMON_RECORDING_MAX_NAME_LENGTH
+        + sizeof(GUAC_RECORDING_INDEX_SUFFIX)];
+
+    snprintf(filename, sizeof(filename), "%s" GUAC_RECORDING_INDEX_SUFFIX,
+            recording->filename);
+
+    int fd = open(filename, O_CREAT | O_TRUNC | O_WRONLY,
+            S_IRUSR | S_IWUSR | S_IRGRP);
+    if (fd == -1) {
+        guac_client_log(recording->client, GUAC_LOG_ERROR,
+                "Creation of recording index failed: %s", strerror(errno));
+        return 1;
+    }
+
+    recording->index_fd = fd;
+    recording->keyframe_interval = keyframe_interval;
+    recording->last_keyframe = guac_timestamp_current();
+
+    guac_client_log(recording->client, GUAC_LOG_INFO,
+            "Index of recording will be saved to \"%s\".", filename);
+
+    return 0;
+
+}
+
+void guac_recording_keyframe(guac_recording* recording,
+        guac_recording_keyframe_callback* callback, void* data) {
+
+    /* Ignore unless indexing */
+    if (recording->index_fd == -1)
+        return;
+
+    /* The beginning of the recording is implicitly a keyframe, located in
+     * time by the first sync, just as playback without an index would */
+    if (!recording->index_origin_written) {
+        guac_recording_write_index(recording,
+                recording->client->last_sent_timestamp, 0);
+        recording->index_origin_written = 1;
+    }
+
+    /* Ignore unless a keyframe is due and can still be indexed */
+    guac_timestamp timestamp = guac_timestamp_current();
+    if (recording->index_fd == -1
+            || timestamp - recording->last_keyframe
+                < recording->keyframe_interval)
+        return;
+
+    recording->last_keyframe = timestamp;
+
+    guac_socket* socket = recording->socket;
+    guac_recording_stats stats;
+
+    /* Note the offset of the keyframe while no other instruction can be
+     * partially written */
+    guac_socket_instruction_begin(socket);
+    guac_recording_get_stats(recording, &stats);
+    guac_socket_instruction_end(socket);
+
+    uint64_t offset = stats.bytes_written + stats.queue_length;
+    uint64_t dropped = stats.instructions_dropped;
+
+    /* Write full state, marking its end with a frame boundary */
+    callback(socket, data);
+    guac_protocol_send_sync(socket, timestamp, 0);
+    guac_socket_flush(socket);
+
+    /* Index the keyframe only if it was recorded in its entirety */
+    guac_recording_get_stats(recording, &stats);
+    if (stats.failed || stats.instructions_dropped != dropped) {
+        guac_client_log(recording->client, GUAC_LOG_DEBUG, "Keyframe was "
+                "not fully recorded and will not be indexed.");
+        return;
+    }
+
+    guac_recording_write_index(recording, timestamp, offset);
+
+}
+
+void guac_recording_set_overflow(guac_recording* recording,
+        guac_recording_overflow overflow) {
+    guac_socket_recording_set_overflow(recording->socket, overflow);
+}
+
+void guac_recording_get_stats(guac_recording* recording,
+        guac_recording_stats* stats) {
+    guac_socket_recording_get_stats(recording->socket, stats);
+}
+
 void guac_recording_report_mouse(guac_recording* recording,
         int x, int y, int button_mask) {
 
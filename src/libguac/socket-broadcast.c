@@ -24,9 +24,12 @@
 #include "guacamole/error.h"
 #include "guacamole/socket.h"
 #include "guacamole/user.h"
+#include "socket-broadcast.h"
 
 #include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
  * A function that will broadcast arbitrary data to a subset of users for
@@ -45,6 +48,113 @@
 typedef void guac_socket_broadcast_handler(
         guac_client* client, guac_user_callback* callback, void* data);
 
+typedef struct guac_socket_broadcast_ring guac_socket_broadcast_ring;
+
+typedef struct guac_socket_broadcast_reader guac_socket_broadcast_reader;
+
+/**
+ * The state of a single user receiving data from the ring buffer of an
+ * asynchronous broadcast socket. Each reader has its own writer thread which
+ * copies data from the ring to the user's socket independently of all other
+ * readers.
+ */
+struct guac_socket_broadcast_reader {
+
+    /**
+     * The user receiving data.
+     */
+    guac_user* user;
+
+    /**
+     * The ring buffer that this reader receives data from.
+     */
+    guac_socket_broadcast_ring* ring;
+
+    /**
+     * The total number of bytes written to the ring prior to the first byte
+     * not yet copied by this reader. This value is only modified while the
+     * ring lock is held.
+     */
+    uint64_t position;
+
+    /**
+     * Non-zero if the data not yet copied by this reader has been overwritten
+     * within the ring, and thus the user can no longer receive a consistent
+     * stream of instructions.
+     */
+    int dropped;
+
+    /**
+     * Non-zero if the writer thread of this reader should terminate.
+     */
+    int stopping;
+
+    /**
+     * The writer thread copying data from the ring to the user's socket.
+     */
+    pthread_t thread;
+
+    /**
+     * The next reader of the same ring, or NULL if this is the last reader.
+     */
+    guac_socket_broadcast_reader* next;
+
+};
+
+/**
+ * Ring buffer which receives all data written to an asynchronous broadcast
+ * socket. Data is written to the ring exactly once, regardless of the number
+ * of users, and is copied out by each user's writer thread at that thread's
+ * own pace. Writing to the ring never waits for any reader.
+ */
+struct guac_socket_broadcast_ring {
+
+    /**
+     * The contents of the ring.
+     */
+    char* buffer;
+
+    /**
+     * The size of the buffer, in bytes. This is always a power of two.
+     */
+    size_t size;
+
+    /**
+     * The total number of bytes ever written to the ring.
+     */
+    uint64_t head;
+
+    /**
+     * The total number of bytes ever written to the ring up to and including
+     * the end of the last complete instruction. Readers never copy beyond
+     * this point, such that each user's socket receives only whole
+     * instructions.
+     */
+    uint64_t committed;
+
+    /**
+     * The value of committed at the time readers were last signalled.
+     */
+    uint64_t signalled;
+
+    /**
+     * Lock which guards all members of the ring and of its readers.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Condition which is signalled whenever new data is available to readers
+     * or a reader has been dropped or stopped.
+     */
+    pthread_cond_t modified;
+
+    /**
+     * All readers currently receiving data from this ring.
+     */
+    guac_socket_broadcast_reader* readers;
+
+};
+
 /**
  * Data associated with an open socket which writes to a subset of connected
  * users of a particular guac_client.
@@ -68,6 +178,21 @@ typedef struct guac_socket_broadcast_data {
      */
     guac_socket_broadcast_handler* broadcast_handler;
 
+    /**
+     * The ring buffer receiving all data written to this socket if the
+     * socket is in asynchronous mode, or NULL if data is written directly to
+     * each user's socket.
+     */
+    guac_socket_broadcast_ring* ring;
+
+    /**
+     * The total number of bytes written to this socket. This is updated only
+     * by the write handler, which is normally invoked while an instruction is
+     * being written and socket_lock is held, and is thus approximate if read
+     * concurrently.
+     */
+    uint64_t bytes_written;
+
 } guac_socket_broadcast_data;
 
 /**
@@ -87,6 +212,203 @@ typedef struct __write_chunk {
 
 } __write_chunk;
 
+/**
+ * Appends the given data to the given ring buffer. Any reader which has not
+ * yet copied data that must be overwritten to make room is marked as dropped
+ * and its writer thread is signalled. This function never waits for readers.
+ *
+ * @param ring
+ *     The ring buffer to append data to.
+ *
+ * @param buf
+ *     The data to append.
+ *
+ * @param count
+ *     The number of bytes to append.
+ */
+static void guac_socket_broadcast_ring_write(guac_socket_broadcast_ring* ring,
+        const void* buf, size_t count) {
+
+    const char* data = (const char*) buf;
+    int any_dropped = 0;
+
+    pthread_mutex_lock(&(ring->lock));
+
+    uint64_t head = ring->head + count;
+
+    /* Drop any readers that would lose data not yet copied */
+    guac_socket_broadcast_reader* reader = ring->readers;
+    while (reader != NULL) {
+
+        if (!reader->dropped && head - reader->position > ring->size) {
+            reader->dropped = 1;
+            any_dropped = 1;
+        }
+
+        reader = reader->next;
+    }
+
+    /* Only the final ring-sized portion of an oversized write can be kept */
+    if (count > ring->size) {
+        data += count - ring->size;
+        count = ring->size;
+    }
+
+    /* Copy data into ring, wrapping around the end of the buffer */
+    size_t offset = (head - count) & (ring->size - 1);
+    size_t length = ring->size - offset;
+    if (length > count)
+        length = count;
+
+    memcpy(ring->buffer + offset, data, length);
+    memcpy(ring->buffer, data + length, count - length);
+
+    ring->head = head;
+
+    if (any_dropped)
+        pthread_cond_broadcast(&(ring->modified));
+
+    pthread_mutex_unlock(&(ring->lock));
+
+}
+
+/**
+ * Marks all data written to the given ring buffer thus far as a complete
+ * set of instructions that may be copied by readers. Readers are signalled
+ * only if a significant amount of data has accumulated since they were last
+ * signalled, with all other data being delivered when the broadcast socket
+ * is flushed.
+ *
+ * @param ring
+ *     The ring buffer whose data should be committed.
+ */
+static void guac_socket_broadcast_ring_commit(guac_socket_broadcast_ring* ring) {
+
+    pthread_mutex_lock(&(ring->lock));
+
+    ring->committed = ring->head;
+
+    /* Wake readers early if a large amount of data is pending */
+    if (ring->committed - ring->signalled >= ring->size / 4) {
+        ring->signalled = ring->committed;
+        pthread_cond_broadcast(&(ring->modified));
+    }
+
+    pthread_mutex_unlock(&(ring->lock));
+
+}
+
+/**
+ * Signals all readers of the given ring buffer that committed data is
+ * available to be copied, if any such data has been committed since they
+ * were last signalled.
+ *
+ * @param ring
+ *     The ring buffer whose readers should be signalled.
+ */
+static void guac_socket_broadcast_ring_signal(guac_socket_broadcast_ring* ring) {
+
+    pthread_mutex_lock(&(ring->lock));
+
+    if (ring->signalled != ring->committed) {
+        ring->signalled = ring->committed;
+        pthread_cond_broadcast(&(ring->modified));
+    }
+
+    pthread_mutex_unlock(&(ring->lock));
+
+}
+
+/**
+ * Writer thread which copies all data committed to the ring buffer of an
+ * asynchronous broadcast socket to the socket of a single user. Each batch
+ * of available data is written as a single locked unit via
+ * guac_socket_instruction_begin() and guac_socket_instruction_end(), such
+ * that other writes to the user's socket are interleaved only at
+ * instruction boundaries. If the user falls too far behind, or writing to
+ * the user's socket fails, the user is stopped with guac_user_stop().
+ *
+ * @param data
+ *     The guac_socket_broadcast_reader associated with the user.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_socket_broadcast_writer_thread(void* data) {
+
+    guac_socket_broadcast_reader* reader = (guac_socket_broadcast_reader*) data;
+    guac_socket_broadcast_ring* ring = reader->ring;
+    guac_user* user = reader->user;
+
+    char buffer[GUAC_SOCKET_BROADCAST_READ_SIZE];
+    int failed = 0;
+
+    pthread_mutex_lock(&(ring->lock));
+
+    while (!failed) {
+
+        /* Wait for data */
+        while (!reader->stopping && !reader->dropped
+                && reader->position == ring->committed)
+            pthread_cond_wait(&(ring->modified), &(ring->lock));
+
+        if (reader->stopping || reader->dropped)
+            break;
+
+        pthread_mutex_unlock(&(ring->lock));
+        guac_socket_instruction_begin(user->socket);
+        pthread_mutex_lock(&(ring->lock));
+
+        /* Copy all committed data, writing outside of the ring lock */
+        while (!failed && !reader->stopping && !reader->dropped
+                && reader->position != ring->committed) {
+
+            size_t offset = reader->position & (ring->size - 1);
+            size_t length = ring->size - offset;
+
+            if (length > ring->committed - reader->position)
+                length = ring->committed - reader->position;
+
+            if (length > sizeof(buffer))
+                length = sizeof(buffer);
+
+            memcpy(buffer, ring->buffer + offset, length);
+            reader->position += length;
+
+            pthread_mutex_unlock(&(ring->lock));
+            failed = guac_socket_write(user->socket, buffer, length);
+            pthread_mutex_lock(&(ring->lock));
+
+        }
+
+        pthread_mutex_unlock(&(ring->lock));
+
+        if (guac_socket_flush(user->socket))
+            failed = 1;
+
+        guac_socket_instruction_end(user->socket);
+        pthread_mutex_lock(&(ring->lock));
+
+    }
+
+    int dropped = reader->dropped;
+    pthread_mutex_unlock(&(ring->lock));
+
+    /* Disconnect users that can no longer be written to */
+    if (dropped) {
+        guac_user_log(user, GUAC_LOG_WARNING, "User \"%s\" has fallen too "
+                "far behind the rest of the connection and will be "
+                "disconnected.", user->user_id);
+        guac_user_stop(user);
+    }
+
+    else if (failed)
+        guac_user_stop(user);
+
+    return NULL;
+
+}
+
 /**
  * Callback which handles read requests on the broadcast socket. This callback
  * always fails, as the broadcast socket is write-only; it cannot be read.
@@ -164,6 +486,14 @@ static ssize_t __guac_socket_broadcast_write_handler(guac_socket* socket,
     guac_socket_broadcast_data* data =
         (guac_socket_broadcast_data*) socket->data;
 
+    data->bytes_written += count;
+
+    /* Write chunk once to ring if in asynchronous mode */
+    if (data->ring != NULL) {
+        guac_socket_broadcast_ring_write(data->ring, buf, count);
+        return count;
+    }
+
     /* Build chunk */
     __write_chunk chunk;
     chunk.buffer = buf;
@@ -218,6 +548,12 @@ static ssize_t __guac_socket_broadcast_flush_handler(guac_socket* socket) {
     guac_socket_broadcast_data* data =
         (guac_socket_broadcast_data*) socket->data;
 
+    /* Wake writer threads if in asynchronous mode */
+    if (data->ring != NULL) {
+        guac_socket_broadcast_ring_signal(data->ring);
+        return 0;
+    }
+
     /* Flush the users */
     data->broadcast_handler(data->client, __flush_callback, NULL);
 
@@ -266,6 +602,10 @@ static void __guac_socket_broadcast_lock_handler(guac_socket* socket) {
     /* Acquire exclusive access to socket */
     pthread_mutex_lock(&(data->socket_lock));
 
+    /* Writer threads lock the sockets of users in asynchronous mode */
+    if (data->ring != NULL)
+        return;
+
     /* Lock sockets of the users */
     data->broadcast_handler(data->client, __lock_callback, NULL);
 
@@ -307,8 +647,13 @@ static void __guac_socket_broadcast_unlock_handler(guac_socket* socket) {
     guac_socket_broadcast_data* data =
         (guac_socket_broadcast_data*) socket->data;
 
+    /* Make the completed instruction available to writer threads */
+    if (data->ring != NULL)
+        guac_socket_broadcast_ring_commit(data->ring);
+
     /* Unlock sockets of all users */
-    data->broadcast_handler(data->client, __unlock_callback, NULL);
+    else
+        data->broadcast_handler(data->client, __unlock_callback, NULL);
 
     /* Relinquish exclusive access to socket */
     pthread_mutex_unlock(&(data->socket_lock));
@@ -358,6 +703,20 @@ static int __guac_socket_broadcast_free_handler(guac_socket* socket) {
     guac_socket_broadcast_data* data =
         (guac_socket_broadcast_data*) socket->data;
 
+    guac_socket_broadcast_ring* ring = data->ring;
+    if (ring != NULL) {
+
+        /* Stop any remaining writer threads */
+        while (ring->readers != NULL)
+            guac_socket_broadcast_remove_user(socket, ring->readers->user);
+
+        pthread_cond_destroy(&(ring->modified));
+        pthread_mutex_destroy(&(ring->lock));
+        guac_mem_free(ring->buffer);
+        guac_mem_free(ring);
+
+    }
+
     /* Destroy locks */
     pthread_mutex_destroy(&(data->socket_lock));
 
@@ -393,6 +752,10 @@ static guac_socket* __guac_socket_init(
     /* Set the provided broadcast handler */
     data->broadcast_handler = broadcast_handler;
 
+    /* Write directly to each user's socket unless explicitly changed */
+    data->ring = NULL;
+    data->bytes_written = 0;
+
     /* Store client as socket data */
     data->client = client;
     socket->data = data;
@@ -430,3 +793,127 @@ guac_socket* guac_socket_broadcast_pending(guac_client* client) {
 
 }
 
+uint64_t guac_socket_broadcast_get_bytes_written(guac_socket* socket) {
+
+    guac_socket_broadcast_data* data =
+        (guac_socket_broadcast_data*) socket->data;
+
+    return data->bytes_written;
+
+}
+
+int guac_socket_broadcast_enable_async(guac_socket* socket,
+        size_t buffer_size) {
+
+    guac_socket_broadcast_data* data =
+        (guac_socket_broadcast_data*) socket->data;
+
+    /* Nothing to do if already in asynchronous mode */
+    if (data->ring != NULL)
+        return 0;
+
+    /* Round buffer size up to a power of two */
+    size_t size = GUAC_SOCKET_BROADCAST_MIN_RING_SIZE;
+    while (size < buffer_size) {
+
+        /* Refuse sizes that cannot be represented */
+        if (size > SIZE_MAX / 2) {
+            guac_error = GUAC_STATUS_INVALID_ARGUMENT;
+            guac_error_message = "Broadcast buffer size is too large";
+            return 1;
+        }
+
+        size *= 2;
+
+    }
+
+    guac_socket_broadcast_ring* ring =
+        guac_mem_zalloc(sizeof(guac_socket_broadcast_ring));
+
+    ring->buffer = guac_mem_alloc(size);
+    ring->size = size;
+
+    pthread_mutex_init(&(ring->lock), NULL);
+    pthread_cond_init(&(ring->modified), NULL);
+
+    /* Ensure ring is complete before any other thread can see it */
+    pthread_mutex_lock(&(data->socket_lock));
+    data->ring = ring;
+    pthread_mutex_unlock(&(data->socket_lock));
+
+    return 0;
+
+}
+
+void guac_socket_broadcast_add_user(guac_socket* socket, guac_user* user) {
+
+    guac_socket_broadcast_data* data =
+        (guac_socket_broadcast_data*) socket->data;
+
+    guac_socket_broadcast_ring* ring = data->ring;
+    if (ring == NULL)
+        return;
+
+    guac_socket_broadcast_reader* reader =
+        guac_mem_zalloc(sizeof(guac_socket_broadcast_reader));
+
+    reader->user = user;
+    reader->ring = ring;
+
+    pthread_mutex_lock(&(ring->lock));
+
+    /* Begin with the first instruction not yet completely written */
+    reader->position = ring->committed;
+
+    if (pthread_create(&(reader->thread), NULL,
+                guac_socket_broadcast_writer_thread, reader)) {
+        pthread_mutex_unlock(&(ring->lock));
+        guac_user_log(user, GUAC_LOG_ERROR, "Unable to start broadcast "
+                "writer thread for user \"%s\".", user->user_id);
+        guac_mem_free(reader);
+        guac_user_stop(user);
+        return;
+    }
+
+    reader->next = ring->readers;
+    ring->readers = reader;
+
+    pthread_mutex_unlock(&(ring->lock));
+
+}
+
+void guac_socket_broadcast_remove_user(guac_socket* socket, guac_user* user) {
+
+    guac_socket_broadcast_data* data =
+        (guac_socket_broadcast_data*) socket->data;
+
+    guac_socket_broadcast_ring* ring = data->ring;
+    if (ring == NULL)
+        return;
+
+    pthread_mutex_lock(&(ring->lock));
+
+    /* Locate and unlink the reader associated with the given user */
+    guac_socket_broadcast_reader** current = &(ring->readers);
+    while (*current != NULL && (*current)->user != user)
+        current = &((*current)->next);
+
+    guac_socket_broadcast_reader* reader = *current;
+    if (reader == NULL) {
+        pthread_mutex_unlock(&(ring->lock));
+        return;
+    }
+
+    *current = reader->next;
+
+    /* Signal writer thread to stop */
+    reader->stopping = 1;
+    pthread_cond_broadcast(&(ring->modified));
+
+    pthread_mutex_unlock(&(ring->lock));
+
+    /* Wait for any in-progress write to the user's socket to finish */
+    pthread_join(reader->thread, NULL);
+    guac_mem_free(reader);
+
+}
@@ -0,0 +1,109 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __GUAC_SOCKET_BROADCAST_H
+#define __GUAC_SOCKET_BROADCAST_H
+
+#include "guacamole/socket-types.h"
+#include "guacamole/user-types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The smallest ring buffer that will be allocated for a broadcast socket in
+ * asynchronous mode, in bytes.
+ */
+#define GUAC_SOCKET_BROADCAST_MIN_RING_SIZE 65536
+
+/**
+ * The maximum number of bytes that a per-user writer thread will copy out of
+ * the ring buffer of an asynchronous broadcast socket at once.
+ */
+#define GUAC_SOCKET_BROADCAST_READ_SIZE 8192
+
+/**
+ * Returns the total number of bytes that have been written to the given
+ * broadcast socket since it was created. If instructions are being written
+ * concurrently, the value returned is approximate.
+ *
+ * @param socket
+ *     The broadcast socket to query, as returned by guac_socket_broadcast()
+ *     or guac_socket_broadcast_pending().
+ *
+ * @return
+ *     The total number of bytes written to the given socket.
+ */
+uint64_t guac_socket_broadcast_get_bytes_written(guac_socket* socket);
+
+/**
+ * Switches the given broadcast socket into asynchronous mode. Rather than
+ * writing each chunk of data to the socket of every user in turn, data is
+ * written once to a shared ring buffer of the given size, from which a
+ * dedicated writer thread for each user copies complete instructions to that
+ * user's socket. A user that falls behind by more than the size of the ring
+ * is stopped with guac_user_stop() rather than delaying the writer. This
+ * function must be called before any users are added to the socket.
+ *
+ * @param socket
+ *     The broadcast socket to switch into asynchronous mode, as returned by
+ *     guac_socket_broadcast().
+ *
+ * @param buffer_size
+ *     The size of the shared ring buffer, in bytes. This will be rounded up
+ *     to the next power of two no smaller than
+ *     GUAC_SOCKET_BROADCAST_MIN_RING_SIZE.
+ *
+ * @return
+ *     Zero if asynchronous mode was enabled successfully, non-zero otherwise.
+ */
+int guac_socket_broadcast_enable_async(guac_socket* socket,
+        size_t buffer_size);
+
+/**
+ * Starts delivering data written to the given asynchronous broadcast socket
+ * to the given user, beginning with the first instruction that has not yet
+ * been completely written. A dedicated writer thread is started for the
+ * user. If the socket is not in asynchronous mode, this function has no
+ * effect.
+ *
+ * @param socket
+ *     The broadcast socket that the user should receive data from.
+ *
+ * @param user
+ *     The user to start delivering data to.
+ */
+void guac_socket_broadcast_add_user(guac_socket* socket, guac_user* user);
+
+/**
+ * Stops delivering data written to the given asynchronous broadcast socket
+ * to the given user, waiting for that user's writer thread to terminate. If
+ * the socket is not in asynchronous mode, or the user was never added to the
+ * socket, this function has no effect.
+ *
+ * @param socket
+ *     The broadcast socket that the user should stop receiving data from.
+ *
+ * @param user
+ *     The user to stop delivering data to.
+ */
+void guac_socket_broadcast_remove_user(guac_socket* socket, guac_user* user);
+
+#endif
+
@@ -0,0 +1,792 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "guacamole/mem.h"
+#include "guacamole/recording.h"
+#include "guacamole/socket.h"
+#include "guacamole/timestamp.h"
+#include "socket-recording.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct guac_socket_recording_chunk guac_socket_recording_chunk;
+
+/**
+ * A block of data which did not fit within the ring buffer of a recording
+ * socket using GUAC_RECORDING_OVERFLOW_SPILL.
+ */
+struct guac_socket_recording_chunk {
+
+    /**
+     * The number of bytes of data within this chunk.
+     */
+    size_t length;
+
+    /**
+     * The next chunk of spilled data, or NULL if this is the last chunk.
+     */
+    guac_socket_recording_chunk* next;
+
+    /**
+     * The data within this chunk.
+     */
+    char data[GUAC_SOCKET_RECORDING_SPILL_SIZE];
+
+};
+
+/**
+ * Data associated with an open socket which writes to a recording file via a
+ * ring buffer and a dedicated writer thread.
+ */
+typedef struct guac_socket_recording_data {
+
+    /**
+     * The file descriptor of the recording file.
+     */
+    int fd;
+
+    /**
+     * The contents of the ring.
+     */
+    char* buffer;
+
+    /**
+     * The size of the buffer, in bytes. This is always a power of two.
+     */
+    size_t size;
+
+    /**
+     * The total number of bytes ever written to the ring.
+     */
+    uint64_t head;
+
+    /**
+     * The total number of bytes ever written to the ring which may be written
+     * to the file. Data beyond this point belongs to an instruction which may
+     * still be dropped.
+     */
+    uint64_t committed;
+
+    /**
+     * The total number of bytes ever written from the ring to the file. The
+     * space occupied by these bytes may be reused.
+     */
+    uint64_t tail;
+
+    /**
+     * The first chunk of data spilled beyond the ring, or NULL if no data has
+     * been spilled. While any data remains spilled, all new data is spilled
+     * as well, such that the order of data is preserved.
+     */
+    guac_socket_recording_chunk* spill_head;
+
+    /**
+     * The last chunk of data spilled beyond the ring, or NULL if no data has
+     * been spilled.
+     */
+    guac_socket_recording_chunk* spill_tail;
+
+    /**
+     * The total number of bytes within all spilled chunks.
+     */
+    size_t spilled;
+
+    /**
+     * The behavior to use when the ring is full.
+     */
+    guac_recording_overflow overflow;
+
+    /**
+     * Non-zero if an instruction is currently being written, zero otherwise.
+     */
+    int in_instruction;
+
+    /**
+     * The value of head when the instruction currently being written began.
+     */
+    uint64_t instruction_start;
+
+    /**
+     * The value of overflow when the instruction currently being written
+     * began. This behavior applies to the entire instruction.
+     */
+    guac_recording_overflow instruction_overflow;
+
+    /**
+     * Non-zero if the instruction currently being written has been dropped,
+     * in which case the remainder of that instruction is discarded.
+     */
+    int dropping;
+
+    /**
+     * The number of instructions dropped since a note of dropped
+     * instructions was last written to the recording.
+     */
+    uint64_t dropped;
+
+    /**
+     * Non-zero if the writer thread should write all committed data without
+     * waiting for more to accumulate.
+     */
+    int flush_requested;
+
+    /**
+     * Non-zero if the writer thread should write all remaining data and
+     * terminate.
+     */
+    int stopping;
+
+    /**
+     * Counters describing the progress of writing the recording.
+     */
+    guac_recording_stats stats;
+
+    /**
+     * Lock which is acquired when an instruction is being written, and
+     * released when the instruction is finished being written.
+     */
+    pthread_mutex_t socket_lock;
+
+    /**
+     * Lock which guards all other members of this structure.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Condition which is signalled when data is available to the writer
+     * thread, or when the writer thread should terminate.
+     */
+    pthread_cond_t data_ready;
+
+    /**
+     * Condition which is signalled when the writer thread has made room
+     * within the ring.
+     */
+    pthread_cond_t space_available;
+
+    /**
+     * The thread writing data from the ring to the recording file.
+     */
+    pthread_t writer;
+
+} guac_socket_recording_data;
+
+/**
+ * Writes the entirety of the given buffer to the given file descriptor.
+ *
+ * @param fd
+ *     The file descriptor to write to.
+ *
+ * @param buffer
+ *     The data to write.
+ *
+ * @param length
+ *     The number of bytes to write.
+ *
+ * @return
+ *     Zero if all data was written successfully, non-zero otherwise.
+ */
+static int guac_socket_recording_write_fully(int fd, const char* buffer,
+        size_t length) {
+
+    while (length > 0) {
+
+        ssize_t written = write(fd, buffer, length);
+        if (written < 0) {
+
+            if (errno == EINTR)
+                continue;
+
+            return 1;
+
+        }
+
+        buffer += written;
+        length -= written;
+
+    }
+
+    return 0;
+
+}
+
+/**
+ * Copies the given data into the ring of the given recording socket, which
+ * must have at least the given number of bytes available. The ring lock must
+ * be held.
+ *
+ * @param data
+ *     The recording socket data whose ring should receive the data.
+ *
+ * @param buf
+ *     The data to copy.
+ *
+ * @param count
+ *     The number of bytes to copy.
+ */
+static void guac_socket_recording_append(guac_socket_recording_data* data,
+        const char* buf, size_t count) {
+
+    size_t offset = data->head & (data->size - 1);
+    size_t length = data->size - offset;
+
+    if (length > count)
+        length = count;
+
+    memcpy(data->buffer + offset, buf, length);
+    memcpy(data->buffer, buf + length, count - length);
+
+    data->head += count;
+
+}
+
+/**
+ * Copies the given data into newly-allocated memory beyond the ring of the
+ * given recording socket. The ring lock must be held.
+ *
+ * @param data
+ *     The recording socket data whose spilled data should receive the data.
+ *
+ * @param buf
+ *     The data to copy.
+ *
+ * @param count
+ *     The number of bytes to copy.
+ */
+static void guac_socket_recording_spill(guac_socket_recording_data* data,
+        const char* buf, size_t count) {
+
+    data->spilled += count;
+
+    while (count > 0) {
+
+        guac_socket_recording_chunk* chunk = data->spill_tail;
+
+        /* Allocate new chunk once current chunk is full */
+        if (chunk == NULL || chunk->length == sizeof(chunk->data)) {
+
+            chunk = guac_mem_alloc(sizeof(guac_socket_recording_chunk));
+            chunk->length = 0;
+            chunk->next = NULL;
+
+            if (data->spill_tail != NULL)
+                data->spill_tail->next = chunk;
+            else
+                data->spill_head = chunk;
+
+            data->spill_tail = chunk;
+
+        }
+
+        size_t length = sizeof(chunk->data) - chunk->length;
+        if (length > count)
+            length = count;
+
+        memcpy(chunk->data + chunk->length, buf, length);
+        chunk->length += length;
+
+        buf += length;
+        count -= length;
+
+    }
+
+}
+
+/**
+ * Frees all data spilled beyond the ring of the given recording socket. The
+ * ring lock must be held.
+ *
+ * @param data
+ *     The recording socket data whose spilled data should be freed.
+ */
+static void guac_socket_recording_free_spill(
+        guac_socket_recording_data* data) {
+
+    guac_socket_recording_chunk* current = data->spill_head;
+    while (current != NULL) {
+        guac_socket_recording_chunk* next = current->next;
+        guac_mem_free(current);
+        current = next;
+    }
+
+    data->spill_head = NULL;
+    data->spill_tail = NULL;
+    data->spilled = 0;
+
+}
+
+/**
+ * Wakes the writer thread of the given recording socket if enough committed
+ * data has accumulated. The ring lock must be held.
+ *
+ * @param data
+ *     The recording socket data whose writer thread may need to be woken.
+ */
+static void guac_socket_recording_update(guac_socket_recording_data* data) {
+
+    size_t queue_length = data->head - data->tail + data->spilled;
+    if (queue_length > data->stats.max_queue_length)
+        data->stats.max_queue_length = queue_length;
+
+    if (data->committed - data->tail >= GUAC_SOCKET_RECORDING_WRITE_SIZE
+            || data->spill_head != NULL)
+        pthread_cond_signal(&(data->data_ready));
+
+}
+
+/**
+ * Writer thread which writes all data committed to the ring of a recording
+ * socket, followed by any spilled data, to the recording file. Data is
+ * written once enough has accumulated or the socket is flushed. If writing
+ * fails, all pending and future data is discarded.
+ *
+ * @param arg
+ *     The guac_socket_recording_data of the recording socket.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* guac_socket_recording_writer_thread(void* arg) {
+
+    guac_socket_recording_data* data = (guac_socket_recording_data*) arg;
+
+    pthread_mutex_lock(&(data->lock));
+
+    for (;;) {
+
+        /* Wait for enough data to warrant a write */
+        while (!data->stopping && !data->flush_requested
+                && data->spill_head == NULL
+                && data->committed - data->tail < GUAC_SOCKET_RECORDING_WRITE_SIZE)
+            pthread_cond_wait(&(data->data_ready), &(data->lock));
+
+        int failed;
+
+        /* Data within the ring always precedes any spilled data */
+        if (data->committed != data->tail) {
+
+            size_t offset = data->tail & (data->size - 1);
+            size_t length = data->size - offset;
+
+            if (length > data->committed - data->tail)
+                length = data->committed - data->tail;
+
+            /* Write outside of lock, as written data is not modified until
+             * tail advances */
+            pthread_mutex_unlock(&(data->lock));
+            failed = guac_socket_recording_write_fully(data->fd,
+                    data->buffer + offset, length);
+            pthread_mutex_lock(&(data->lock));
+
+            if (!failed) {
+                data->tail += length;
+                data->stats.bytes_written += length;
+            }
+
+        }
+
+        else if (data->spill_head != NULL) {
+
+            guac_socket_recording_chunk* chunk = data->spill_head;
+            data->spill_head = chunk->next;
+            if (data->spill_head == NULL)
+                data->spill_tail = NULL;
+
+            pthread_mutex_unlock(&(data->lock));
+            failed = guac_socket_recording_write_fully(data->fd,
+                    chunk->data, chunk->length);
+            pthread_mutex_lock(&(data->lock));
+
+            if (!failed) {
+                data->spilled -= chunk->length;
+                data->stats.bytes_written += chunk->length;
+            }
+
+            guac_mem_free(chunk);
+
+        }
+
+        /* All data written */
+        else {
+            data->flush_requested = 0;
+            if (data->stopping)
+                break;
+            continue;
+        }
+
+        /* Discard everything if the file can no longer be written */
+        if (failed) {
+            data->stats.failed = 1;
+            data->tail = data->committed = data->head;
+            guac_socket_recording_free_spill(data);
+        }
+
+        pthread_cond_broadcast(&(data->space_available));
+
+    }
+
+    pthread_mutex_unlock(&(data->lock));
+    return NULL;
+
+}
+
+/**
+ * Writes a "log" instruction noting the number of instructions dropped since
+ * such a note was last written, if any instructions have been dropped and
+ * there is room. The ring lock must be held.
+ *
+ * @param data
+ *     The recording socket data to write the note to.
+ */
+static void guac_socket_recording_note_dropped(
+        guac_socket_recording_data* data) {
+
+    if (data->dropped == 0)
+        return;
+
+    char message[64];
+    int message_length = snprintf(message, sizeof(message),
+            "Recording incomplete: %" PRIu64 " instruction(s) dropped",
+            data->dropped);
+
+    char instruction[96];
+    int length = snprintf(instruction, sizeof(instruction), "3.log,%i.%s;",
+            message_length, message);
+
+    if (data->spill_head != NULL)
+        guac_socket_recording_spill(data, instruction, length);
+
+    else if (data->size - (data->head - data->tail) >= (size_t) length)
+        guac_socket_recording_append(data, instruction, length);
+
+    /* Try again before the next instruction if there is still no room */
+    else
+        return;
+
+    data->committed = data->head;
+    data->dropped = 0;
+
+}
+
+/**
+ * Writes data to the ring of the given recording socket, handling a full
+ * ring according to the overflow behavior in effect. This function never
+ * fails; data which cannot be written is discarded.
+ *
+ * @param socket
+ *     The recording socket to write to.
+ *
+ * @param buf
+ *     The data to write.
+ *
+ * @param count
+ *     The number of bytes to write.
+ *
+ * @return
+ *     The number of bytes provided, which is always count.
+ */
+static ssize_t guac_socket_recording_write_handler(guac_socket* socket,
+        const void* buf, size_t count) {
+
+    guac_socket_recording_data* data =
+        (guac_socket_recording_data*) socket->data;
+
+    const char* current = buf;
+    size_t remaining = count;
+
+    pthread_mutex_lock(&(data->lock));
+
+    /* Discard data for failed recordings and dropped instructions */
+    if (data->stats.failed || data->dropping) {
+        pthread_mutex_unlock(&(data->lock));
+        return count;
+    }
+
+    guac_recording_overflow overflow = data->in_instruction
+        ? data->instruction_overflow : data->overflow;
+
+    uint64_t start = data->head;
+
+    while (remaining > 0) {
+
+        /* Preserve ordering relative to data already spilled */
+        if (data->spill_head != NULL) {
+            guac_socket_recording_spill(data, current, remaining);
+            break;
+        }
+
+        size_t length = data->size - (data->head - data->tail);
+        if (length > remaining)
+            length = remaining;
+
+        guac_socket_recording_append(data, current, length);
+        current += length;
+        remaining -= length;
+
+        if (remaining == 0)
+            break;
+
+        /* Ring is full */
+        if (overflow == GUAC_RECORDING_OVERFLOW_SPILL) {
+            guac_socket_recording_spill(data, current, remaining);
+            break;
+        }
+
+        /* Rewind to the start of the instruction, discarding the rest */
+        else if (overflow == GUAC_RECORDING_OVERFLOW_DROP) {
+
+            if (data->in_instruction) {
+                data->head = data->instruction_start;
+                data->dropping = 1;
+            }
+            else
+                data->head = start;
+
+            data->dropped++;
+            data->stats.instructions_dropped++;
+            break;
+
+        }
+
+        /* Otherwise, wait for the writer thread to make room */
+        data->committed = data->head;
+        pthread_cond_signal(&(data->data_ready));
+
+        guac_timestamp stall_start = guac_timestamp_current();
+        while (!data->stats.failed
+                && data->head - data->tail == data->size)
+            pthread_cond_wait(&(data->space_available), &(data->lock));
+
+        data->stats.stall_time += guac_timestamp_current() - stall_start;
+
+        if (data->stats.failed)
+            break;
+
+    }
+
+    /* Data may be written immediately unless its instruction may yet be
+     * dropped */
+    if (!data->in_instruction || overflow != GUAC_RECORDING_OVERFLOW_DROP)
+        data->committed = data->head;
+
+    guac_socket_recording_update(data);
+    pthread_mutex_unlock(&(data->lock));
+
+    return count;
+
+}
+
+/**
+ * Requests that the writer thread of the given recording socket write all
+ * committed data. This function does not wait for the data to be written.
+ *
+ * @param socket
+ *     The recording socket to flush.
+ *
+ * @return
+ *     Always zero.
+ */
+static ssize_t guac_socket_recording_flush_handler(guac_socket* socket) {
+
+    guac_socket_recording_data* data =
+        (guac_socket_recording_data*) socket->data;
+
+    pthread_mutex_lock(&(data->lock));
+
+    if (data->committed != data->tail || data->spill_head != NULL) {
+        data->flush_requested = 1;
+        pthread_cond_signal(&(data->data_ready));
+    }
+
+    pthread_mutex_unlock(&(data->lock));
+    return 0;
+
+}
+
+/**
+ * Acquires exclusive access to the given recording socket for the duration
+ * of an instruction, first noting any previously-dropped instructions.
+ *
+ * @param socket
+ *     The recording socket to lock.
+ */
+static void guac_socket_recording_lock_handler(guac_socket* socket) {
+
+    guac_socket_recording_data* data =
+        (guac_socket_recording_data*) socket->data;
+
+    pthread_mutex_lock(&(data->socket_lock));
+    pthread_mutex_lock(&(data->lock));
+
+    guac_socket_recording_note_dropped(data);
+
+    data->in_instruction = 1;
+    data->instruction_start = data->head;
+    data->instruction_overflow = data->overflow;
+
+    pthread_mutex_unlock(&(data->lock));
+
+}
+
+/**
+ * Commits the instruction just written to the given recording socket and
+ * relinquishes exclusive access to the socket.
+ *
+ * @param socket
+ *     The recording socket to unlock.
+ */
+static void guac_socket_recording_unlock_handler(guac_socket* socket) {
+
+    guac_socket_recording_data* data =
+        (guac_socket_recording_data*) socket->data;
+
+    pthread_mutex_lock(&(data->lock));
+
+    data->in_instruction = 0;
+    data->dropping = 0;
+    data->committed = data->head;
+
+    guac_socket_recording_update(data);
+    pthread_mutex_unlock(&(data->lock));
+
+    pthread_mutex_unlock(&(data->socket_lock));
+
+}
+
+/**
+ * Writes all pending data to the recording file, stops the writer thread,
+ * and frees all data associated with the given recording socket, closing the
+ * recording file.
+ *
+ * @param socket
+ *     The recording socket to free.
+ *
+ * @return
+ *     Always zero.
+ */
+static int guac_socket_recording_free_handler(guac_socket* socket) {
+
+    guac_socket_recording_data* data =
+        (guac_socket_recording_data*) socket->data;
+
+    /* Wait for all pending data to be written */
+    pthread_mutex_lock(&(data->lock));
+    data->stopping = 1;
+    pthread_cond_signal(&(data->data_ready));
+    pthread_mutex_unlock(&(data->lock));
+
+    pthread_join(data->writer, NULL);
+
+    guac_socket_recording_free_spill(data);
+
+    pthread_cond_destroy(&(data->space_available));
+    pthread_cond_destroy(&(data->data_ready));
+    pthread_mutex_destroy(&(data->lock));
+    pthread_mutex_destroy(&(data->socket_lock));
+
+    close(data->fd);
+
+    guac_mem_free(data->buffer);
+    guac_mem_free(data);
+    return 0;
+
+}
+
+guac_socket* guac_socket_recording(int fd, size_t buffer_size,
+        guac_recording_overflow overflow) {
+
+    /* Round buffer size up to a power of two */
+    size_t size = GUAC_SOCKET_RECORDING_MIN_RING_SIZE;
+    while (size < buffer_size && size <= SIZE_MAX / 2)
+        size *= 2;
+
+    guac_socket_recording_data* data =
+        guac_mem_zalloc(sizeof(guac_socket_recording_data));
+
+    data->fd = fd;
+    data->buffer = guac_mem_alloc(size);
+    data->size = size;
+    data->overflow = overflow;
+
+    pthread_mutex_init(&(data->socket_lock), NULL);
+    pthread_mutex_init(&(data->lock), NULL);
+    pthread_cond_init(&(data->data_ready), NULL);
+    pthread_cond_init(&(data->space_available), NULL);
+
+    if (pthread_create(&(data->writer), NULL,
+                guac_socket_recording_writer_thread, data)) {
+        pthread_cond_destroy(&(data->space_available));
+        pthread_cond_destroy(&(data->data_ready));
+        pthread_mutex_destroy(&(data->lock));
+        pthread_mutex_destroy(&(data->socket_lock));
+        guac_mem_free(data->buffer);
+        guac_mem_free(data);
+        return NULL;
+    }
+
+    /* Associate recording-specific data with new socket */
+    guac_socket* socket = guac_socket_alloc();
+    socket->data = data;
+
+    /* Assign handlers */
+    socket->write_handler  = guac_socket_recording_write_handler;
+    socket->flush_handler  = guac_socket_recording_flush_handler;
+    socket->lock_handler   = guac_socket_recording_lock_handler;
+    socket->unlock_handler = guac_socket_recording_unlock_handler;
+    socket->free_handler   = guac_socket_recording_free_handler;
+
+    return socket;
+
+}
+
+void guac_socket_recording_set_overflow(guac_socket* socket,
+        guac_recording_overflow overflow) {
+
+    guac_socket_recording_data* data =
+        (guac_socket_recording_data*) socket->data;
+
+    pthread_mutex_lock(&(data->lock));
+    data->overflow = overflow;
+    pthread_mutex_unlock(&(data->lock));
+
+}
+
+void guac_socket_recording_get_stats(guac_socket* socket,
+        guac_recording_stats* stats) {
+
+    guac_socket_recording_data* data =
+        (guac_socket_recording_data*) socket->data;
+
+    pthread_mutex_lock(&(data->lock));
+
+    *stats = data->stats;
+    stats->queue_length = data->head - data->tail + data->spilled;
+
+    pthread_mutex_unlock(&(data->lock));
+
+}
@@ -0,0 +1,97 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __GUAC_SOCKET_RECORDING_H
+#define __GUAC_SOCKET_RECORDING_H
+
+#include "guacamole/recording.h"
+#include "guacamole/socket-types.h"
+
+#include <stddef.h>
+
+/**
+ * The smallest ring buffer that will be allocated for a recording socket, in
+ * bytes.
+ */
+#define GUAC_SOCKET_RECORDING_MIN_RING_SIZE 65536
+
+/**
+ * The number of bytes of pending data which will cause the writer thread of a
+ * recording socket to write to the file without waiting for a flush.
+ */
+#define GUAC_SOCKET_RECORDING_WRITE_SIZE 65536
+
+/**
+ * The size of each block of memory allocated to hold data spilled beyond the
+ * ring buffer of a recording socket, in bytes.
+ */
+#define GUAC_SOCKET_RECORDING_SPILL_SIZE 65536
+
+/**
+ * Allocates a new guac_socket which writes to the given file descriptor
+ * asynchronously. Data written to the socket is appended to an in-memory ring
+ * buffer, and is written to the file descriptor in large sequential writes by
+ * a dedicated writer thread. Flushing the socket only wakes the writer
+ * thread; it never waits for the file to be written. The file descriptor is
+ * closed when the socket is freed, after all pending data has been written.
+ *
+ * @param fd
+ *     The file descriptor to write to.
+ *
+ * @param buffer_size
+ *     The size of the ring buffer, in bytes. This will be rounded up to the
+ *     next power of two no smaller than GUAC_SOCKET_RECORDING_MIN_RING_SIZE.
+ *
+ * @param overflow
+ *     The behavior to use when the ring buffer is full.
+ *
+ * @return
+ *     A newly-allocated guac_socket, or NULL if the writer thread cannot be
+ *     started.
+ */
+guac_socket* guac_socket_recording(int fd, size_t buffer_size,
+        guac_recording_overflow overflow);
+
+/**
+ * Sets the behavior of the given recording socket for when its ring buffer
+ * is full.
+ *
+ * @param socket
+ *     The recording socket to modify, as returned by guac_socket_recording().
+ *
+ * @param overflow
+ *     The behavior to use when the ring buffer is full.
+ */
+void guac_socket_recording_set_overflow(guac_socket* socket,
+        guac_recording_overflow overflow);
+
+/**
+ * Retrieves the current counters of the given recording socket.
+ *
+ * @param socket
+ *     The recording socket to retrieve the counters of, as returned by
+ *     guac_socket_recording().
+ *
+ * @param stats
+ *     The guac_recording_stats structure to populate.
+ */
+void guac_socket_recording_get_stats(guac_socket* socket,
+        guac_recording_stats* stats);
+
+#endif
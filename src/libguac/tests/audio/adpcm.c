@@ -0,0 +1,117 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "adpcm_encoder.h"
+
+#include <CUnit/CUnit.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * The number of samples to encode for each test.
+ */
+#define TEST_SAMPLES 44100
+
+/**
+ * The number of samples allowed for the encoder to adapt its step size to
+ * the test signal before the accuracy of decoded samples is verified.
+ */
+#define TEST_ADAPT_SAMPLES 64
+
+/**
+ * The maximum difference allowed between each original sample and its
+ * decoded equivalent once the encoder has adapted to the test signal.
+ */
+#define TEST_MAX_ERROR 2048
+
+/**
+ * The period of the triangle wave used as the test signal, in samples.
+ */
+#define TEST_PERIOD 200
+
+/**
+ * Returns the sample at the given position within a triangle wave having a
+ * period of TEST_PERIOD samples and an amplitude of 16000.
+ */
+static int16_t test_sample(int i) {
+    int phase = i % TEST_PERIOD;
+    if (phase < TEST_PERIOD / 2)
+        return -16000 + phase * 32000 / (TEST_PERIOD / 2);
+    return 16000 - (phase - TEST_PERIOD / 2) * 32000 / (TEST_PERIOD / 2);
+}
+
+/**
+ * Test which verifies that samples encoded with guac_adpcm_encode_sample() are
+ * decoded by guac_adpcm_decode_sample() to values close to the original, with
+ * the decoder tracking the state of the encoder exactly.
+ */
+void test_audio__adpcm_round_trip() {
+
+    adpcm_channel_state encoder = { 0 };
+    adpcm_channel_state decoder = { 0 };
+
+    for (int i = 0; i < TEST_SAMPLES; i++) {
+
+        int16_t sample = test_sample(i);
+
+        int code = guac_adpcm_encode_sample(&encoder, sample);
+        CU_ASSERT_FATAL(code >= 0 && code <= 15);
+
+        int16_t decoded = guac_adpcm_decode_sample(&decoder, code);
+        CU_ASSERT_EQUAL_FATAL(decoded, encoder.predictor);
+        CU_ASSERT_EQUAL_FATAL(decoder.step_index, encoder.step_index);
+
+        if (i >= TEST_ADAPT_SAMPLES)
+            CU_ASSERT_FATAL(abs(decoded - sample) <= TEST_MAX_ERROR);
+
+    }
+
+}
+
+/**
+ * Test which verifies that encoding remains stable at the extremes of the
+ * range of 16-bit PCM, with neither the predictor nor the step index leaving
+ * their valid ranges.
+ */
+void test_audio__adpcm_extremes() {
+
+    adpcm_channel_state state = { 0 };
+
+    /* Full-scale square wave */
+    for (int i = 0; i < TEST_SAMPLES; i++) {
+
+        int16_t sample = (i / 50) % 2 ? INT16_MAX : INT16_MIN;
+        guac_adpcm_encode_sample(&state, sample);
+
+        CU_ASSERT_FATAL(state.predictor >= INT16_MIN);
+        CU_ASSERT_FATAL(state.predictor <= INT16_MAX);
+        CU_ASSERT_FATAL(state.step_index >= 0 && state.step_index <= 88);
+
+    }
+
+    /* Silence must be approached closely once the step size has shrunk */
+    for (int i = 0; i < TEST_SAMPLES; i++)
+        guac_adpcm_encode_sample(&state, 0);
+
+    CU_ASSERT(abs(state.predictor) <= 16);
+    CU_ASSERT_EQUAL(state.step_index, 0);
+
+}
+
@@ -0,0 +1,199 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CUnit/CUnit.h>
+#include <guacamole/client.h>
+#include <guacamole/protocol-types.h>
+#include <guacamole/socket.h>
+#include <guacamole/timestamp.h>
+#include <guacamole/user.h>
+
+#include <stddef.h>
+
+/**
+ * The maximum amount of time to wait for pending users to be promoted, in
+ * milliseconds.
+ */
+#define TEST_PROMOTION_TIMEOUT 5000
+
+/**
+ * Image mimetypes claimed by a test user which supports WebP.
+ */
+static const char* webp_mimetypes[] = { "image/png", "image/webp", NULL };
+
+/**
+ * Image mimetypes claimed by a test user which does not support WebP.
+ */
+static const char* png_mimetypes[] = { "image/png", NULL };
+
+/**
+ * Audio mimetypes claimed by the owner of the test connection.
+ */
+static const char* owner_audio_mimetypes[] = { "audio/L8", "audio/L16", NULL };
+
+/**
+ * Audio mimetypes claimed by the viewer of the test connection.
+ */
+static const char* viewer_audio_mimetypes[] = { "audio/L16", NULL };
+
+/**
+ * Allocates a new user of the given client having the given protocol version
+ * and supported image mimetypes, and with a socket which discards all data
+ * written to it.
+ *
+ * @param client
+ *     The client that the user will be joining.
+ *
+ * @param version
+ *     The protocol version of the user.
+ *
+ * @param image_mimetypes
+ *     The NULL-terminated list of image mimetypes supported by the user.
+ *
+ * @param owner
+ *     Non-zero if the user should be the owner of the connection, zero
+ *     otherwise.
+ *
+ * @return
+ *     A newly-allocated user.
+ */
+static guac_user* test_user_alloc(guac_client* client,
+        guac_protocol_version version, const char** image_mimetypes,
+        int owner) {
+
+    guac_user* user = guac_user_alloc();
+    user->client = client;
+    user->socket = guac_socket_alloc();
+    user->owner = owner;
+    user->info.protocol_version = version;
+    user->info.image_mimetypes = image_mimetypes;
+
+    return user;
+
+}
+
+/**
+ * Frees a user allocated with test_user_alloc().
+ *
+ * @param user
+ *     The user to free.
+ */
+static void test_user_free(guac_user* user) {
+    guac_socket_free(user->socket);
+    guac_user_free(user);
+}
+
+/**
+ * Waits for the given number of users to be promoted from pending users to
+ * full users, as reflected by the capability summary of the given client.
+ *
+ * @param client
+ *     The client whose users are being promoted.
+ *
+ * @param users
+ *     The number of non-pending users to wait for.
+ *
+ * @param capabilities
+ *     The guac_client_capabilities to populate with the capability summary
+ *     of the client once the users have been promoted.
+ */
+static void test_wait_for_users(guac_client* client, int users,
+        guac_client_capabilities* capabilities) {
+
+    guac_timestamp start = guac_timestamp_current();
+
+    guac_client_get_capabilities(client, capabilities);
+    while (capabilities->users != users
+            && guac_timestamp_current() - start < TEST_PROMOTION_TIMEOUT) {
+        guac_timestamp_msleep(10);
+        guac_client_get_capabilities(client, capabilities);
+    }
+
+}
+
+/**
+ * Test which verifies that the capability summary of a guac_client reflects
+ * the capabilities of its users as those users join and leave.
+ */
+void test_client__capabilities() {
+
+    guac_client_capabilities capabilities;
+
+    guac_client* client = guac_client_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(client);
+
+    /* No users or owner are initially present */
+    guac_client_get_capabilities(client, &capabilities);
+    CU_ASSERT_EQUAL(capabilities.users, 0);
+    CU_ASSERT_EQUAL(capabilities.protocol_version,
+            GUAC_PROTOCOL_VERSION_UNKNOWN);
+    CU_ASSERT_FALSE(guac_client_owner_supports_msg(client));
+    CU_ASSERT_FALSE(guac_client_owner_supports_required(client));
+
+    guac_user* owner = test_user_alloc(client,
+            GUAC_PROTOCOL_VERSION_1_5_0, webp_mimetypes, 1);
+    guac_user* viewer = test_user_alloc(client,
+            GUAC_PROTOCOL_VERSION_1_3_0, png_mimetypes, 0);
+
+    owner->info.audio_mimetypes = owner_audio_mimetypes;
+    viewer->info.audio_mimetypes = viewer_audio_mimetypes;
+
+    /* Owner capabilities are known as soon as the owner joins */
+    CU_ASSERT_EQUAL_FATAL(guac_client_add_user(client, owner, 0, NULL), 0);
+    CU_ASSERT_TRUE(guac_client_owner_supports_msg(client));
+    CU_ASSERT_TRUE(guac_client_owner_supports_required(client));
+
+    /* Capabilities shared by all users are known once users are promoted */
+    CU_ASSERT_EQUAL_FATAL(guac_client_add_user(client, viewer, 0, NULL), 0);
+    test_wait_for_users(client, 2, &capabilities);
+    CU_ASSERT_EQUAL_FATAL(capabilities.users, 2);
+    CU_ASSERT_EQUAL(capabilities.protocol_version,
+            GUAC_PROTOCOL_VERSION_1_3_0);
+    CU_ASSERT_EQUAL(capabilities.owner_protocol_version,
+            GUAC_PROTOCOL_VERSION_1_5_0);
+    CU_ASSERT_FALSE(capabilities.webp);
+    CU_ASSERT_FALSE(guac_client_supports_webp(client));
+    CU_ASSERT_EQUAL(capabilities.mimetypes, GUAC_CLIENT_MIMETYPE_AUDIO_L16);
+
+    /* Capabilities no longer consider users that have left */
+    guac_client_remove_user(client, viewer);
+    guac_client_get_capabilities(client, &capabilities);
+    CU_ASSERT_EQUAL(capabilities.users, 1);
+    CU_ASSERT_EQUAL(capabilities.protocol_version,
+            GUAC_PROTOCOL_VERSION_1_5_0);
+    CU_ASSERT_EQUAL(guac_client_supports_webp(client),
+            guac_user_supports_webp(owner));
+    CU_ASSERT_EQUAL(capabilities.mimetypes,
+              GUAC_CLIENT_MIMETYPE_IMAGE_WEBP
+            | GUAC_CLIENT_MIMETYPE_AUDIO_L8
+            | GUAC_CLIENT_MIMETYPE_AUDIO_L16);
+
+    /* Owner capabilities are cleared once the owner leaves */
+    guac_client_remove_user(client, owner);
+    guac_client_get_capabilities(client, &capabilities);
+    CU_ASSERT_EQUAL(capabilities.users, 0);
+    CU_ASSERT_EQUAL(capabilities.mimetypes, 0);
+    CU_ASSERT_FALSE(guac_client_owner_supports_msg(client));
+    CU_ASSERT_FALSE(guac_client_owner_supports_required(client));
+
+    guac_client_free(client);
+    test_user_free(viewer);
+    test_user_free(owner);
+
+}
@@ -0,0 +1,133 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CUnit/CUnit.h>
+#include <guacamole/opcode-map.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Arbitrary mapping of opcode to value, with the opcode as the first member
+ * as required by guac_opcode_map.
+ */
+typedef struct test_mapping {
+
+    /**
+     * The opcode of this mapping.
+     */
+    const char* opcode;
+
+    /**
+     * An arbitrary value unique to this mapping.
+     */
+    int value;
+
+} test_mapping;
+
+/**
+ * Test mappings covering all opcodes handled by libguac, terminated by a
+ * mapping having a NULL opcode.
+ */
+static test_mapping test_mappings[] = {
+    { "sync",       1  },
+    { "touch",      2  },
+    { "mouse",      3  },
+    { "key",        4  },
+    { "clipboard",  5  },
+    { "disconnect", 6  },
+    { "size",       7  },
+    { "file",       8  },
+    { "pipe",       9  },
+    { "ack",        10 },
+    { "blob",       11 },
+    { "end",        12 },
+    { "get",        13 },
+    { "put",        14 },
+    { "audio",      15 },
+    { "argv",       16 },
+    { "nop",        17 },
+    { NULL,         0  }
+};
+
+/**
+ * Verifies that guac_opcode_map_lookup() locates every mapping within an
+ * indexed table, and returns NULL for opcodes which are not in the table,
+ * including prefixes and extensions of opcodes which are.
+ */
+void test_opcode_map__lookup() {
+
+    guac_opcode_map map;
+    guac_opcode_map_init(&map, test_mappings, sizeof(test_mapping));
+
+    /* Every opcode must map to its own entry */
+    for (test_mapping* current = test_mappings; current->opcode != NULL; current++) {
+        const test_mapping* found = guac_opcode_map_lookup(&map, current->opcode);
+        CU_ASSERT_PTR_EQUAL(found, current);
+    }
+
+    /* Opcodes not within the table must not be found */
+    CU_ASSERT_PTR_NULL(guac_opcode_map_lookup(&map, ""));
+    CU_ASSERT_PTR_NULL(guac_opcode_map_lookup(&map, "syn"));
+    CU_ASSERT_PTR_NULL(guac_opcode_map_lookup(&map, "syncs"));
+    CU_ASSERT_PTR_NULL(guac_opcode_map_lookup(&map, "SYNC"));
+    CU_ASSERT_PTR_NULL(guac_opcode_map_lookup(&map, "select"));
+    CU_ASSERT_PTR_NULL(guac_opcode_map_lookup(&map, "connect"));
+
+}
+
+/**
+ * Verifies that guac_opcode_map_lookup() behaves correctly for empty tables
+ * and for tables too large to be indexed by hash.
+ */
+void test_opcode_map__lookup_limits() {
+
+    guac_opcode_map map;
+
+    /* Empty tables contain nothing */
+    test_mapping empty[] = { { NULL, 0 } };
+    guac_opcode_map_init(&map, empty, sizeof(test_mapping));
+    CU_ASSERT_PTR_NULL(guac_opcode_map_lookup(&map, "sync"));
+    CU_ASSERT_PTR_NULL(guac_opcode_map_lookup(&map, ""));
+
+    /* Generate a table larger than can be indexed by hash */
+    int count = GUAC_OPCODE_MAP_MAX_MAPPINGS + 10;
+    test_mapping* large = calloc(count + 1, sizeof(test_mapping));
+    char (*opcodes)[16] = calloc(count, sizeof(*opcodes));
+
+    for (int i = 0; i < count; i++) {
+        snprintf(opcodes[i], sizeof(opcodes[i]), "op%i", i);
+        large[i].opcode = opcodes[i];
+        large[i].value = i;
+    }
+
+    /* All opcodes must still be found */
+    guac_opcode_map_init(&map, large, sizeof(test_mapping));
+    for (int i = 0; i < count; i++) {
+        const test_mapping* found = guac_opcode_map_lookup(&map, opcodes[i]);
+        CU_ASSERT_PTR_EQUAL(found, &large[i]);
+    }
+
+    CU_ASSERT_PTR_NULL(guac_opcode_map_lookup(&map, "op"));
+
+    free(opcodes);
+    free(large);
+
+}
+
@@ -0,0 +1,107 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CUnit/CUnit.h>
+#include <guacamole/layer.h>
+#include <guacamole/protocol.h>
+#include <guacamole/socket.h>
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Buffer receiving all data written to the test socket.
+ */
+static char test_output[4096];
+
+/**
+ * The number of bytes currently stored within test_output.
+ */
+static size_t test_output_length;
+
+/**
+ * The number of times the write handler of the test socket was invoked.
+ */
+static int test_writes;
+
+/**
+ * Write handler which appends all written data to test_output.
+ */
+static ssize_t test_write_handler(guac_socket* socket, const void* buf,
+        size_t count) {
+
+    /* Fail the write if the output buffer would overflow */
+    if (test_output_length + count >= sizeof(test_output))
+        return -1;
+
+    memcpy(test_output + test_output_length, buf, count);
+    test_output_length += count;
+    test_output[test_output_length] = '\0';
+    test_writes++;
+
+    return count;
+
+}
+
+/**
+ * Test which verifies that instructions consisting only of integer arguments
+ * are formatted correctly across the full range of integer values, and that
+ * each such instruction is written to the socket in a single write.
+ */
+void test_protocol__send_int() {
+
+    guac_socket* socket = guac_socket_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(socket);
+    socket->write_handler = test_write_handler;
+
+    guac_layer src = { .index = -1 };
+    guac_layer dst = { .index = 12 };
+
+    test_output_length = 0;
+    test_writes = 0;
+    guac_protocol_send_copy(socket, &src, 0, 9, 10, 99, GUAC_COMP_OVER,
+            &dst, 100, -123456789);
+    CU_ASSERT_STRING_EQUAL(test_output,
+            "4.copy,2.-1,1.0,1.9,2.10,2.99,2.14,2.12,3.100,10.-123456789;");
+    CU_ASSERT_EQUAL(test_writes, 1);
+
+    test_output_length = 0;
+    test_writes = 0;
+    guac_protocol_send_sync(socket, INT64_MAX, 0);
+    CU_ASSERT_STRING_EQUAL(test_output,
+            "4.sync,19.9223372036854775807,1.0;");
+    CU_ASSERT_EQUAL(test_writes, 1);
+
+    test_output_length = 0;
+    guac_protocol_send_sync(socket, INT64_MIN, 1);
+    CU_ASSERT_STRING_EQUAL(test_output,
+            "4.sync,20.-9223372036854775808,1.1;");
+
+    test_output_length = 0;
+    guac_protocol_send_key(socket, 65307, 5, 1234567890123);
+    CU_ASSERT_STRING_EQUAL(test_output, "3.key,5.65307,1.1,13.1234567890123;");
+
+    test_output_length = 0;
+    guac_protocol_send_key(socket, 32, 0, 0);
+    CU_ASSERT_STRING_EQUAL(test_output, "3.key,2.32,1.0,1.0;");
+
+    guac_socket_free(socket);
+
+}
+
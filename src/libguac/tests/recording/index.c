@@ -0,0 +1,142 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CUnit/CUnit.h>
+#include <guacamole/client.h>
+#include <guacamole/protocol.h>
+#include <guacamole/recording.h>
+#include <guacamole/socket.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * The number of key events to write to the test recording before and after
+ * the keyframe.
+ */
+#define TEST_EVENTS 1000
+
+/**
+ * Keyframe callback which writes a single, recognizable instruction in place
+ * of full connection state.
+ *
+ * @param socket
+ *     The socket to write the instruction to.
+ *
+ * @param data
+ *     Unused.
+ */
+static void test_keyframe_callback(guac_socket* socket, void* data) {
+    guac_protocol_send_name(socket, "keyframe");
+}
+
+/**
+ * Test which verifies that the index of a recording points to the beginning
+ * of the recording, located in time by the first sync, and to the exact
+ * offset of each keyframe.
+ */
+void test_recording__index() {
+
+    char path[] = "/tmp/guac-test-recording-XXXXXX";
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(path));
+
+    guac_client* client = guac_client_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(client);
+
+    guac_recording* recording = guac_recording_create(client, path,
+            "recording", 0, 1, 0, 0, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(recording);
+
+    /* Write a keyframe whenever requested */
+    CU_ASSERT_EQUAL_FATAL(guac_recording_enable_index(recording, 0), 0);
+
+    for (int i = 0; i < TEST_EVENTS; i++)
+        guac_recording_report_key(recording, i, 1);
+
+    /* Keyframes are recorded after each frame */
+    guac_client_end_frame(client);
+    guac_recording_keyframe(recording, test_keyframe_callback, NULL);
+
+    for (int i = 0; i < TEST_EVENTS; i++)
+        guac_recording_report_key(recording, i, 0);
+
+    guac_recording_free(recording);
+    guac_client_free(client);
+
+    char filename[sizeof(path) + 16];
+    char index_filename[sizeof(path) + 32];
+    snprintf(filename, sizeof(filename), "%s/recording", path);
+    snprintf(index_filename, sizeof(index_filename), "%s/recording"
+            GUAC_RECORDING_INDEX_SUFFIX, path);
+
+    FILE* index = fopen(index_filename, "r");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(index);
+
+    /* First entry is the beginning of the recording */
+    uint64_t start_timestamp, start_offset;
+    CU_ASSERT_EQUAL_FATAL(fscanf(index, "%" SCNu64 ",%" SCNu64 "\n",
+                &start_timestamp, &start_offset), 2);
+    CU_ASSERT_EQUAL(start_offset, 0);
+
+    /* Second entry is the keyframe */
+    uint64_t timestamp, offset;
+    CU_ASSERT_EQUAL_FATAL(fscanf(index, "%" SCNu64 ",%" SCNu64 "\n",
+                &timestamp, &offset), 2);
+    CU_ASSERT(timestamp >= start_timestamp);
+    CU_ASSERT(offset > 0);
+
+    /* No other keyframes were requested */
+    CU_ASSERT_EQUAL(fgetc(index), EOF);
+    fclose(index);
+
+    FILE* file = fopen(filename, "r");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+
+    /* Beginning of recording is the timestamp of the first sync */
+    uint64_t sync_timestamp;
+    char instruction[64];
+    while (fscanf(file, "%63[^;];", instruction) == 1) {
+        if (sscanf(instruction, "4.sync,%*d.%" SCNu64 ",",
+                    &sync_timestamp) == 1)
+            break;
+    }
+
+    CU_ASSERT_FALSE_FATAL(feof(file));
+    CU_ASSERT_EQUAL(sync_timestamp, start_timestamp);
+
+    /* Keyframe must begin exactly at the indexed offset */
+    CU_ASSERT_EQUAL_FATAL(fseek(file, offset, SEEK_SET), 0);
+
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fgets(instruction, sizeof(instruction),
+                file));
+    CU_ASSERT_EQUAL(strncmp(instruction, "4.name,8.keyframe;",
+                strlen("4.name,8.keyframe;")), 0);
+
+    fclose(file);
+
+    unlink(index_filename);
+    unlink(filename);
+    rmdir(path);
+
+}
+
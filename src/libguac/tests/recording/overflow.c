@@ -0,0 +1,416 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include "socket-recording.h"
+
+#include <CUnit/CUnit.h>
+#include <guacamole/mem.h>
+#include <guacamole/protocol.h>
+#include <guacamole/recording.h>
+#include <guacamole/socket.h>
+#include <guacamole/timestamp.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * The number of instructions to write to the test recording before its sink
+ * begins reading. This is enough to overflow both the smallest ring and the
+ * buffer of the pipe serving as the sink.
+ */
+#define TEST_INSTRUCTIONS 20000
+
+/**
+ * The maximum amount of time to wait for the writer thread of the test
+ * recording to write all pending data, in milliseconds.
+ */
+#define TEST_DRAIN_TIMEOUT 5000
+
+/**
+ * The maximum number of elements in any instruction within the test
+ * recording, including the opcode.
+ */
+#define TEST_MAX_ELEMENTS 4
+
+/**
+ * The maximum length of any element of any instruction within the test
+ * recording, including the null terminator.
+ */
+#define TEST_MAX_ELEMENT_LENGTH 128
+
+/**
+ * A sink for recording data which accepts no data until explicitly started,
+ * after which it reads all data from a pipe into memory until the write end
+ * of that pipe is closed.
+ */
+typedef struct test_sink {
+
+    /**
+     * The read end of the pipe.
+     */
+    int fd;
+
+    /**
+     * All data read so far.
+     */
+    char* data;
+
+    /**
+     * The number of bytes within data.
+     */
+    size_t length;
+
+    /**
+     * The number of bytes allocated for data.
+     */
+    size_t size;
+
+    /**
+     * The thread reading from the pipe.
+     */
+    pthread_t reader;
+
+} test_sink;
+
+/**
+ * Reads all data from the pipe of the given test_sink until the write end of
+ * that pipe is closed.
+ *
+ * @param arg
+ *     The test_sink to read into.
+ *
+ * @return
+ *     Always NULL.
+ */
+static void* test_sink_read(void* arg) {
+
+    test_sink* sink = (test_sink*) arg;
+
+    for (;;) {
+
+        if (sink->size - sink->length < 4096) {
+            sink->size *= 2;
+            sink->data = guac_mem_realloc(sink->data, sink->size);
+        }
+
+        ssize_t length = read(sink->fd, sink->data + sink->length,
+                sink->size - sink->length);
+        if (length <= 0)
+            break;
+
+        sink->length += length;
+
+    }
+
+    return NULL;
+
+}
+
+/**
+ * Verifies that the given data contains only complete, well-formed Guacamole
+ * instructions, parsing each instruction in turn. Only ASCII data is
+ * expected, such that the length of each element is its length in bytes.
+ *
+ * @param data
+ *     A pointer to the data to parse. If an instruction is parsed
+ *     successfully, this pointer is advanced past that instruction.
+ *
+ * @param end
+ *     The end of the data to parse.
+ *
+ * @param elements
+ *     An array which receives the null-terminated opcode and arguments of the
+ *     parsed instruction.
+ *
+ * @return
+ *     The number of elements in the parsed instruction, or zero if the data
+ *     does not begin with a well-formed instruction.
+ */
+static int test_parse_instruction(const char** data, const char* end,
+        char elements[TEST_MAX_ELEMENTS][TEST_MAX_ELEMENT_LENGTH]) {
+
+    const char* current = *data;
+
+    for (int count = 0; count < TEST_MAX_ELEMENTS; count++) {
+
+        /* Parse element length */
+        int length = 0;
+        const char* digits = current;
+        while (current < end && *current >= '0' && *current <= '9')
+            length = length * 10 + (*(current++) - '0');
+
+        if (current == digits || current == end || *(current++) != '.'
+                || length >= TEST_MAX_ELEMENT_LENGTH
+                || end - current <= length)
+            return 0;
+
+        /* Store element value */
+        memcpy(elements[count], current, length);
+        elements[count][length] = '\0';
+        current += length;
+
+        /* Element must be followed by another, or by the end of the
+         * instruction */
+        char terminator = *(current++);
+        if (terminator == ';') {
+            *data = current;
+            return count + 1;
+        }
+
+        if (terminator != ',')
+            return 0;
+
+    }
+
+    return 0;
+
+}
+
+/**
+ * Writes the Nth instruction of the test recording. Even instructions are
+ * "key" instructions, written with a single write. Odd instructions are
+ * "name" instructions, written in several pieces, such that dropping such an
+ * instruction requires rewinding past data already within the ring. Either
+ * way, the instruction identifies its own index.
+ *
+ * @param socket
+ *     The recording socket to write to.
+ *
+ * @param index
+ *     The index of the instruction to write.
+ */
+static void test_write_instruction(guac_socket* socket, int index) {
+
+    char name[32];
+
+    if (index % 2 == 0)
+        guac_protocol_send_key(socket, index, 1, 0);
+
+    else {
+        snprintf(name, sizeof(name), "%i", index);
+        guac_protocol_send_name(socket, name);
+    }
+
+}
+
+/**
+ * Writes TEST_INSTRUCTIONS instructions to a recording socket using the
+ * given overflow behavior while its sink is not reading, such that the ring
+ * overflows. The sink is then started, all pending data is written, and one
+ * final instruction is written before the socket is freed.
+ *
+ * @param overflow
+ *     The overflow behavior to test.
+ *
+ * @param sink
+ *     The test_sink to populate with the data written by the socket. The
+ *     data within the sink must be freed with guac_mem_free().
+ *
+ * @param full_stats
+ *     The guac_recording_stats to populate with the counters of the socket
+ *     immediately after the ring overflowed.
+ *
+ * @param final_stats
+ *     The guac_recording_stats to populate with the counters of the socket
+ *     immediately before the socket is freed.
+ */
+static void test_overflow(guac_recording_overflow overflow, test_sink* sink,
+        guac_recording_stats* full_stats, guac_recording_stats* final_stats) {
+
+    int fds[2];
+    CU_ASSERT_EQUAL_FATAL(pipe(fds), 0);
+
+    sink->fd = fds[0];
+    sink->length = 0;
+    sink->size = 65536;
+    sink->data = guac_mem_alloc(sink->size);
+
+    /* Use the smallest possible ring */
+    guac_socket* socket = guac_socket_recording(fds[1], 0, overflow);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(socket);
+
+    /* Nothing is read yet, so the ring and pipe both fill */
+    for (int i = 0; i < TEST_INSTRUCTIONS; i++)
+        test_write_instruction(socket, i);
+
+    guac_socket_recording_get_stats(socket, full_stats);
+
+    /* Begin reading, and wait for everything pending to be written */
+    CU_ASSERT_EQUAL_FATAL(pthread_create(&(sink->reader), NULL,
+                test_sink_read, sink), 0);
+
+    guac_socket_flush(socket);
+
+    guac_timestamp start = guac_timestamp_current();
+    guac_socket_recording_get_stats(socket, final_stats);
+    while (final_stats->queue_length != 0
+            && guac_timestamp_current() - start < TEST_DRAIN_TIMEOUT) {
+        guac_timestamp_msleep(10);
+        guac_socket_recording_get_stats(socket, final_stats);
+    }
+
+    CU_ASSERT_EQUAL(final_stats->queue_length, 0);
+
+    /* Any drops can now be noted, as there is room */
+    test_write_instruction(socket, TEST_INSTRUCTIONS);
+    guac_socket_recording_get_stats(socket, final_stats);
+
+    /* Freeing the socket writes all data and closes the pipe */
+    guac_socket_free(socket);
+    pthread_join(sink->reader, NULL);
+    close(fds[0]);
+
+}
+
+/**
+ * Test which verifies that a recording socket using
+ * GUAC_RECORDING_OVERFLOW_DROP discards only whole instructions when its ring
+ * is full, and notes the number of instructions dropped within the recording
+ * once room is available.
+ */
+void test_recording__overflow_drop() {
+
+    test_sink sink;
+    guac_recording_stats full_stats;
+    guac_recording_stats final_stats;
+
+    test_overflow(GUAC_RECORDING_OVERFLOW_DROP, &sink, &full_stats,
+            &final_stats);
+
+    /* Instructions were dropped rather than waiting on the sink */
+    CU_ASSERT(full_stats.instructions_dropped > 0);
+    CU_ASSERT_EQUAL(full_stats.stall_time, 0);
+    CU_ASSERT(full_stats.max_queue_length
+            <= GUAC_SOCKET_RECORDING_MIN_RING_SIZE);
+    CU_ASSERT_EQUAL(final_stats.instructions_dropped,
+            full_stats.instructions_dropped);
+
+    char elements[TEST_MAX_ELEMENTS][TEST_MAX_ELEMENT_LENGTH];
+    const char* current = sink.data;
+    const char* end = sink.data + sink.length;
+
+    int written = 0;
+    int notes = 0;
+    int last_index = -1;
+    unsigned long noted_dropped = 0;
+
+    /* Every instruction must be intact, and surviving instructions must
+     * remain in order */
+    while (current < end) {
+
+        int count = test_parse_instruction(&current, end, elements);
+        CU_ASSERT_FATAL(count > 0);
+
+        if (strcmp(elements[0], "log") == 0) {
+
+            unsigned long dropped;
+            CU_ASSERT_EQUAL_FATAL(count, 2);
+            CU_ASSERT_FATAL(sscanf(elements[1], "Recording incomplete: %lu "
+                        "instruction(s) dropped", &dropped) == 1);
+
+            noted_dropped += dropped;
+            notes++;
+            continue;
+
+        }
+
+        int index;
+        if (strcmp(elements[0], "key") == 0) {
+            CU_ASSERT_EQUAL_FATAL(count, 4);
+            index = atoi(elements[1]);
+            CU_ASSERT_EQUAL(index % 2, 0);
+        }
+        else {
+            CU_ASSERT_STRING_EQUAL_FATAL(elements[0], "name");
+            CU_ASSERT_EQUAL_FATAL(count, 2);
+            index = atoi(elements[1]);
+            CU_ASSERT_EQUAL(index % 2, 1);
+        }
+
+        CU_ASSERT(index > last_index);
+        last_index = index;
+        written++;
+
+    }
+
+    /* Every instruction was either written or noted as dropped */
+    CU_ASSERT(notes > 0);
+    CU_ASSERT_EQUAL(last_index, TEST_INSTRUCTIONS);
+    CU_ASSERT_EQUAL(noted_dropped, final_stats.instructions_dropped);
+    CU_ASSERT_EQUAL(written + noted_dropped, TEST_INSTRUCTIONS + 1);
+
+    guac_mem_free(sink.data);
+
+}
+
+/**
+ * Test which verifies that a recording socket using
+ * GUAC_RECORDING_OVERFLOW_SPILL neither drops instructions nor waits when its
+ * ring is full, and that spilled data is written intact and in order.
+ */
+void test_recording__overflow_spill() {
+
+    test_sink sink;
+    guac_recording_stats full_stats;
+    guac_recording_stats final_stats;
+
+    test_overflow(GUAC_RECORDING_OVERFLOW_SPILL, &sink, &full_stats,
+            &final_stats);
+
+    /* Data was held beyond the ring rather than waiting on the sink */
+    CU_ASSERT_EQUAL(full_stats.instructions_dropped, 0);
+    CU_ASSERT_EQUAL(full_stats.stall_time, 0);
+    CU_ASSERT(full_stats.max_queue_length
+            > GUAC_SOCKET_RECORDING_MIN_RING_SIZE);
+    CU_ASSERT_EQUAL(final_stats.instructions_dropped, 0);
+
+    char elements[TEST_MAX_ELEMENTS][TEST_MAX_ELEMENT_LENGTH];
+    const char* current = sink.data;
+    const char* end = sink.data + sink.length;
+
+    /* Every instruction must be present, intact and in order */
+    int index = 0;
+    while (current < end) {
+
+        int count = test_parse_instruction(&current, end, elements);
+        CU_ASSERT_FATAL(count > 0);
+
+        if (index % 2 == 0) {
+            CU_ASSERT_STRING_EQUAL_FATAL(elements[0], "key");
+            CU_ASSERT_EQUAL_FATAL(count, 4);
+        }
+        else {
+            CU_ASSERT_STRING_EQUAL_FATAL(elements[0], "name");
+            CU_ASSERT_EQUAL_FATAL(count, 2);
+        }
+
+        CU_ASSERT_EQUAL_FATAL(atoi(elements[1]), index);
+        index++;
+
+    }
+
+    CU_ASSERT_EQUAL(index, TEST_INSTRUCTIONS + 1);
+
+    guac_mem_free(sink.data);
+
+}
@@ -0,0 +1,81 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CUnit/CUnit.h>
+#include <guacamole/client.h>
+#include <guacamole/recording.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * The number of key events to write to the test recording. This is enough
+ * to require several writes to the recording file.
+ */
+#define TEST_EVENTS 20000
+
+/**
+ * Test which verifies that all events reported to a recording are written to
+ * the recording file, in order, by the time the recording is freed.
+ */
+void test_recording__write() {
+
+    char path[] = "/tmp/guac-test-recording-XXXXXX";
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(path));
+
+    guac_client* client = guac_client_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(client);
+
+    guac_recording* recording = guac_recording_create(client, path,
+            "recording", 0, 0, 0, 0, 1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(recording);
+
+    for (int i = 0; i < TEST_EVENTS; i++)
+        guac_recording_report_key(recording, i, 1);
+
+    guac_recording_free(recording);
+    guac_client_free(client);
+
+    char filename[sizeof(path) + 16];
+    snprintf(filename, sizeof(filename), "%s/recording", path);
+
+    FILE* file = fopen(filename, "r");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+
+    /* Verify each key event was written in order */
+    int count = 0;
+    char instruction[128];
+    while (fscanf(file, "%127[^;];", instruction) == 1) {
+
+        int keysym;
+        CU_ASSERT_FATAL(sscanf(instruction, "3.key,%*d.%d,", &keysym) == 1);
+        CU_ASSERT_EQUAL(keysym, count);
+        count++;
+
+    }
+
+    CU_ASSERT_EQUAL(count, TEST_EVENTS);
+
+    fclose(file);
+    unlink(filename);
+    rmdir(path);
+
+}
@@ -0,0 +1,153 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CUnit/CUnit.h>
+#include <guacamole/socket.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The maximum number of bytes of test data to encode.
+ */
+#define TEST_DATA_SIZE 20000
+
+/**
+ * The size of the buffer receiving all data written to the test socket.
+ */
+#define TEST_OUTPUT_SIZE (TEST_DATA_SIZE / 3 * 4 + 16)
+
+/**
+ * All data written to the test socket since the last reset.
+ */
+static char written[TEST_OUTPUT_SIZE];
+
+/**
+ * The number of bytes in the written buffer.
+ */
+static size_t written_length;
+
+/**
+ * Write handler for the test socket which appends all data to the written
+ * buffer.
+ */
+static ssize_t test_write_handler(guac_socket* socket,
+        const void* buf, size_t count) {
+
+    if (written_length + count > sizeof(written))
+        return -1;
+
+    memcpy(written + written_length, buf, count);
+    written_length += count;
+    return count;
+
+}
+
+/**
+ * Encodes the given data as base64 one group of three bytes at a time, as a
+ * reference against which the output of guac_socket_write_base64() can be
+ * verified.
+ *
+ * @param output
+ *     The buffer which should receive the encoded data.
+ *
+ * @param data
+ *     The data to encode.
+ *
+ * @param length
+ *     The number of bytes to encode.
+ *
+ * @return
+ *     The number of characters written to the output buffer.
+ */
+static size_t reference_encode(char* output, const unsigned char* data,
+        size_t length) {
+
+    static const char characters[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    size_t count = 0;
+
+    for (size_t i = 0; i < length; i += 3) {
+
+        unsigned int a = data[i];
+        unsigned int b = (i + 1 < length) ? data[i + 1] : 0;
+        unsigned int c = (i + 2 < length) ? data[i + 2] : 0;
+
+        output[count++] = characters[a >> 2];
+        output[count++] = characters[((a & 0x03) << 4) | (b >> 4)];
+        output[count++] = (i + 1 < length) ? characters[((b & 0x0F) << 2) | (c >> 6)] : '=';
+        output[count++] = (i + 2 < length) ? characters[c & 0x3F] : '=';
+
+    }
+
+    return count;
+
+}
+
+/**
+ * Verifies that guac_socket_write_base64() and guac_socket_flush_base64()
+ * produce correct base64 for inputs of many different lengths, including
+ * inputs which are written across several calls that split groups of three
+ * bytes, and inputs large enough to be encoded in bulk.
+ */
+void test_socket__write_base64() {
+
+    static unsigned char data[TEST_DATA_SIZE];
+    static char expected[TEST_OUTPUT_SIZE];
+
+    /* Generate arbitrary test data covering all byte values */
+    srand(0xB64);
+    for (int i = 0; i < TEST_DATA_SIZE; i++)
+        data[i] = rand() & 0xFF;
+
+    guac_socket* socket = guac_socket_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(socket);
+    socket->write_handler = test_write_handler;
+
+    size_t lengths[] = { 0, 1, 2, 3, 4, 5, 11, 12, 13, 15, 16, 17, 47, 48, 49,
+        767, 768, 769, 6143, 6144, 6145, 12289, TEST_DATA_SIZE };
+
+    size_t splits[] = { 0, 1, 2, 5, 767, 768, 6145 };
+
+    for (int i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        for (int j = 0; j < sizeof(splits) / sizeof(splits[0]); j++) {
+
+            size_t length = lengths[i];
+            size_t split = splits[j];
+            if (split > length)
+                continue;
+
+            /* Write data in two parts, split at the given offset */
+            written_length = 0;
+            CU_ASSERT_EQUAL(guac_socket_write_base64(socket, data, split), 0);
+            CU_ASSERT_EQUAL(guac_socket_write_base64(socket, data + split,
+                        length - split), 0);
+            CU_ASSERT_EQUAL(guac_socket_flush_base64(socket), 0);
+
+            size_t expected_length = reference_encode(expected, data, length);
+            CU_ASSERT_EQUAL_FATAL(written_length, expected_length);
+            CU_ASSERT_NSTRING_EQUAL(written, expected, expected_length);
+
+        }
+    }
+
+    guac_socket_free(socket);
+
+}
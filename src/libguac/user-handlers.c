@@ -22,6 +22,7 @@
 #include "guacamole/mem.h"
 #include "guacamole/client.h"
 #include "guacamole/object.h"
+#include "guacamole/opcode-map.h"
 #include "guacamole/protocol.h"
 #include "guacamole/stream.h"
 #include "guacamole/string.h"
@@ -30,6 +31,8 @@
 #include "user-handlers.h"
 
 #include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -70,6 +73,31 @@ __guac_instruction_handler_mapping __guac_handshake_handler_map[] = {
     {NULL,       NULL}
 };
 
+guac_opcode_map __guac_instruction_opcode_map;
+
+guac_opcode_map __guac_handshake_opcode_map;
+
+/**
+ * Guard ensuring the indexes of the handler maps are built exactly once.
+ */
+static pthread_once_t __guac_opcode_maps_initialized = PTHREAD_ONCE_INIT;
+
+/**
+ * Builds the indexes of all handler maps. This function is invoked exactly
+ * once, via pthread_once(), prior to the first instruction being handled.
+ */
+static void __guac_init_opcode_maps() {
+
+    guac_opcode_map_init(&__guac_instruction_opcode_map,
+            __guac_instruction_handler_map,
+            sizeof(__guac_instruction_handler_mapping));
+
+    guac_opcode_map_init(&__guac_handshake_opcode_map,
+            __guac_handshake_handler_map,
+            sizeof(__guac_instruction_handler_mapping));
+
+}
+
 /**
  * Parses a 64-bit integer from the given string. It is assumed that the string
  * will contain only decimal digits, with an optional leading minus sign.
@@ -103,6 +131,56 @@ static int64_t __guac_parse_int(const char* str) {
 
 /* Guacamole instruction handlers */
 
+/**
+ * Updates the bandwidth estimate of the given user based on the number of
+ * bytes sent to that user as of the frame they have just confirmed. As the
+ * amount of data received between confirmations only reflects the bandwidth
+ * available if the user was actually kept busy, samples lower than the
+ * current estimate are only considered while the user is lagging.
+ *
+ * @param user
+ *     The user who has confirmed receipt of a frame.
+ *
+ * @param timestamp
+ *     The timestamp of the frame confirmed.
+ *
+ * @param current
+ *     The time that the confirmation was received, in milliseconds.
+ */
+static void __guac_update_bandwidth(guac_user* user,
+        guac_timestamp timestamp, guac_timestamp current) {
+
+    /* Bandwidth cannot be estimated for frames no longer remembered */
+    uint64_t bytes;
+    if (guac_client_get_frame_bytes(user->client, timestamp, &bytes)) {
+        user->__last_confirmed_timestamp = 0;
+        return;
+    }
+
+    guac_timestamp last_timestamp = user->__last_confirmed_timestamp;
+    uint64_t last_bytes = user->__last_confirmed_bytes;
+
+    user->__last_confirmed_timestamp = current;
+    user->__last_confirmed_bytes = bytes;
+
+    /* A sample requires a previous confirmation to measure from */
+    if (last_timestamp == 0 || current <= last_timestamp || bytes < last_bytes)
+        return;
+
+    uint64_t sample = (bytes - last_bytes) * 1000 / (current - last_timestamp);
+    /* Leave headroom such that smoothing cannot overflow */
+    if (sample > INT_MAX / 2)
+        sample = INT_MAX / 2;
+
+    if (user->bandwidth == 0)
+        user->bandwidth = sample;
+
+    else if ((int) sample > user->bandwidth || user->processing_lag > 0)
+        user->bandwidth = guac_client_smooth_estimate(user->bandwidth,
+                sample, 8);
+
+}
+
 int __guac_handle_sync(guac_user* user, int argc, char** argv) {
 
     int frame_duration;
@@ -149,13 +227,37 @@ int __guac_handle_sync(guac_user* user, int argc, char** argv) {
 
         user->processing_lag = processing_lag;
 
+        /* Smooth lag and RTT across frames, as TCP does for RTT (RFC 6298),
+         * such that isolated bursts do not dominate the estimates */
+        if (user->__frames_confirmed == 0) {
+            user->smoothed_processing_lag = processing_lag;
+            user->processing_lag_deviation = processing_lag / 2;
+            user->smoothed_rtt = estimated_rtt;
+        }
+        else {
+            int error = processing_lag - user->smoothed_processing_lag;
+            user->smoothed_processing_lag = guac_client_smooth_estimate(
+                    user->smoothed_processing_lag, processing_lag, 8);
+            user->processing_lag_deviation = guac_client_smooth_estimate(
+                    user->processing_lag_deviation, abs(error), 4);
+            user->smoothed_rtt = guac_client_smooth_estimate(
+                    user->smoothed_rtt, estimated_rtt, 8);
+        }
+
+        user->__frames_confirmed++;
+        __guac_update_bandwidth(user, timestamp, current);
+
     }
 
     /* Log received timestamp and calculated lag (at TRACE level only) */
     guac_user_log(user, GUAC_LOG_TRACE,
             "User confirmation of frame %" PRIu64 "ms received "
-            "at %" PRIu64 "ms (processing_lag=%ims, estimated_rtt=%ims)",
-            timestamp, current, user->processing_lag, user->last_frame_duration);
+            "at %" PRIu64 "ms (processing_lag=%ims, estimated_rtt=%ims, "
+            "smoothed_processing_lag=%ims, processing_lag_deviation=%ims, "
+            "smoothed_rtt=%ims, bandwidth=%iB/s)", timestamp, current,
+            user->processing_lag, user->last_frame_duration,
+            user->smoothed_processing_lag, user->processing_lag_deviation,
+            user->smoothed_rtt, user->bandwidth);
 
     if (user->sync_handler)
         return user->sync_handler(user, timestamp);
@@ -757,19 +859,17 @@ void guac_free_mimetypes(char** mimetypes) {
 
 }
 
-int __guac_user_call_opcode_handler(__guac_instruction_handler_mapping* map,
+int __guac_user_call_opcode_handler(guac_opcode_map* map,
         guac_user* user, const char* opcode, int argc, char** argv) {
 
-    /* For each defined instruction */
-    __guac_instruction_handler_mapping* current = map;
-    while (current->opcode != NULL) {
+    pthread_once(&__guac_opcode_maps_initialized, __guac_init_opcode_maps);
 
-        /* If recognized, call handler */
-        if (strcmp(opcode, current->opcode) == 0)
-            return current->handler(user, argc, argv);
+    /* If recognized, call handler */
+    const __guac_instruction_handler_mapping* mapping =
+        guac_opcode_map_lookup(map, opcode);
 
-        current++;
-    }
+    if (mapping != NULL)
+        return mapping->handler(user, argc, argv);
 
     /* If unrecognized, log and ignore */
     guac_user_log(user, GUAC_LOG_DEBUG, "Handler not found for \"%s\"",
@@ -32,6 +32,7 @@
 #include "config.h"
 
 #include "guacamole/client.h"
+#include "guacamole/opcode-map.h"
 #include "guacamole/timestamp.h"
 
 /**
@@ -250,6 +251,18 @@ extern __guac_instruction_handler_mapping __guac_instruction_handler_map[];
  */
 extern __guac_instruction_handler_mapping __guac_handshake_handler_map[];
 
+/**
+ * Index of __guac_instruction_handler_map, allowing the handler for any
+ * opcode to be located without comparing against every opcode in turn.
+ */
+extern guac_opcode_map __guac_instruction_opcode_map;
+
+/**
+ * Index of __guac_handshake_handler_map, allowing the handler for any opcode
+ * to be located without comparing against every opcode in turn.
+ */
+extern guac_opcode_map __guac_handshake_opcode_map;
+
 /**
  * Frees the given array of mimetypes, including the space allocated to each
  * mimetype string within the array. The provided array of mimetypes MUST have
@@ -281,14 +294,16 @@ char** guac_copy_mimetypes(char** mimetypes, int count);
 
 /**
  * Call the appropriate handler defined by the given user for the given
- * instruction. A comparison is made between the instruction opcode and the
- * initial handler lookup table defined in the map that is provided to this
- * function. If an entry for the instruction is found in the provided map,
- * the handler defined in that map will be called and the value returned.  If
- * no match is found, it is silently ignored.
+ * instruction. The instruction opcode is located within the handler lookup
+ * table indexed by the guac_opcode_map that is provided to this function. If
+ * an entry for the instruction is found in the indexed table, the handler
+ * defined in that table will be called and the value returned.  If no match
+ * is found, it is silently ignored.
  *
  * @param map
- *     The array that holds the opcode to handler mappings.
+ *     The index of the array that holds the opcode to handler mappings. This
+ *     must be either __guac_instruction_opcode_map or
+ *     __guac_handshake_opcode_map.
  * 
  * @param user
  *     The user whose handlers should be called.
@@ -306,7 +321,7 @@ char** guac_copy_mimetypes(char** mimetypes, int count);
  * @return
  *     Zero if the instruction was handled successfully, or non-zero otherwise.
  */
-int __guac_user_call_opcode_handler(__guac_instruction_handler_mapping* map,
+int __guac_user_call_opcode_handler(guac_opcode_map* map,
         guac_user* user, const char* opcode, int argc, char** argv);
 
 #endif
@@ -163,7 +163,7 @@ static void* guac_user_input_thread(void* data) {
         guac_error_message = NULL;
 
         /* Call handler, stop on error */
-        if (__guac_user_call_opcode_handler(__guac_instruction_handler_map, 
+        if (__guac_user_call_opcode_handler(&__guac_instruction_opcode_map,
                 user, parser->opcode, parser->argc, parser->argv)) {
 
             /* Log error */
@@ -267,7 +267,7 @@ static int __guac_user_handshake(guac_user* user, guac_parser* parser,
                 parser->opcode);
         
         /* Run instruction handler for opcode with arguments. */
-        if (__guac_user_call_opcode_handler(__guac_handshake_handler_map, user,
+        if (__guac_user_call_opcode_handler(&__guac_handshake_opcode_map, user,
                 parser->opcode, parser->argc, parser->argv)) {
             
             guac_user_log_handshake_failure(user);
@@ -335,6 +335,13 @@ int guac_user_handle_connection(guac_user* user, int usec_timeout) {
         return 1;
     }
     
+    /* Store protocol version prior to joining, such that the version is
+     * known to the join handler and to the client's capability summary */
+    if (strcmp(parser->argv[0],"") != 0)
+        user->info.protocol_version = guac_protocol_string_to_version(parser->argv[0]);
+    else
+        user->info.protocol_version = GUAC_PROTOCOL_VERSION_1_0_0;
+
     /* Attempt to join user to connection. */
     if (guac_client_add_user(client, user, (parser->argc - 1), parser->argv + 1))
         guac_client_log(client, GUAC_LOG_ERROR, "User \"%s\" could NOT "
@@ -346,16 +353,12 @@ int guac_user_handle_connection(guac_user* user, int usec_timeout) {
         guac_client_log(client, GUAC_LOG_INFO, "User \"%s\" joined connection "
                 "\"%s\" (%i users now present)", user->user_id,
                 client->connection_id, client->connected_users);
-        if (strcmp(parser->argv[0],"") != 0) {
+        if (strcmp(parser->argv[0],"") != 0)
             guac_client_log(client, GUAC_LOG_DEBUG, "Client is using protocol "
                     "version \"%s\"", parser->argv[0]);
-            user->info.protocol_version = guac_protocol_string_to_version(parser->argv[0]);
-        }
-        else {
+        else
             guac_client_log(client, GUAC_LOG_DEBUG, "Client has not defined "
                     "its protocol version.");
-            user->info.protocol_version = GUAC_PROTOCOL_VERSION_1_0_0;
-        }
 
         /* Handle user I/O, wait for connection to terminate */
         guac_user_start(parser, user, usec_timeout);
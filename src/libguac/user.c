@@ -55,6 +55,10 @@ guac_user* guac_user_alloc() {
     user->last_received_timestamp = guac_timestamp_current();
     user->last_frame_duration = 0;
     user->processing_lag = 0;
+    user->smoothed_processing_lag = 0;
+    user->processing_lag_deviation = 0;
+    user->smoothed_rtt = 0;
+    user->bandwidth = 0;
     user->active = 1;
 
     /* Allocate stream pool */
@@ -171,7 +175,7 @@ void guac_user_free_object(guac_user* user, guac_object* object) {
 
 int guac_user_handle_instruction(guac_user* user, const char* opcode, int argc, char** argv) {
 
-    return __guac_user_call_opcode_handler(__guac_instruction_handler_map,
+    return __guac_user_call_opcode_handler(&__guac_instruction_opcode_map,
             user, opcode, argc, argv);
 
 }
@@ -20,6 +20,8 @@
 #ifndef GUAC_RDP_CHANNELS_AUDIO_INPUT_AUDIO_BUFFER_H
 #define GUAC_RDP_CHANNELS_AUDIO_INPUT_AUDIO_BUFFER_H
 
+#include "channels/audio-input/audio-resampler.h"
+
 #include <guacamole/stream.h>
 #include <guacamole/user.h>
 #include <pthread.h>
@@ -56,29 +58,6 @@ typedef struct guac_rdp_audio_buffer guac_rdp_audio_buffer;
  */
 typedef void guac_rdp_audio_buffer_flush_handler(guac_rdp_audio_buffer* audio_buffer, int length);
 
-/**
- * A description of an arbitrary PCM audio format.
- */
-typedef struct guac_rdp_audio_format {
-
-    /**
-     * The rate of the audio data in samples per second.
-     */
-    int rate;
-
-    /**
-     * The number of channels included in the audio data. This will be 1 for
-     * monaural audio and 2 for stereo.
-     */
-    int channels;
-
-    /**
-     * The size of each sample within the audio data, in bytes.
-     */
-    int bps;
-
-} guac_rdp_audio_format;
-
 struct guac_rdp_audio_buffer {
 
     /**
@@ -128,6 +107,13 @@ struct guac_rdp_audio_buffer {
      */
     guac_rdp_audio_format out_format;
 
+    /**
+     * Converter which translates audio received in the input format to the
+     * output format. This is reinitialized at the start of each stream of
+     * received audio data.
+     */
+    guac_rdp_audio_resampler resampler;
+
     /**
      * The size that each audio packet must be, in bytes. The packet buffer
      * within this structure will be at least this size.
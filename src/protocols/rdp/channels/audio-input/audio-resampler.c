@@ -0,0 +1,422 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "channels/audio-input/audio-resampler.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * The value 1.0 as 32.32 fixed-point.
+ */
+#define GUAC_RDP_AUDIO_RESAMPLER_ONE ((uint64_t) 1 << 32)
+
+/**
+ * Reads a single sample of the given size from the given buffer, translating
+ * that sample to a signed 16-bit value. If the sample is 8-bit, it is scaled
+ * up to 16-bit.
+ *
+ * @param buffer
+ *     The buffer containing the sample. This buffer need not be aligned.
+ *
+ * @param bps
+ *     The size of the sample, in bytes. This must be 1 or 2.
+ *
+ * @return
+ *     The sample read from the given buffer, as a signed 16-bit value.
+ */
+static inline int16_t guac_rdp_audio_resampler_read_sample(const char* buffer,
+        int bps) {
+
+    if (bps == 2) {
+        int16_t sample;
+        memcpy(&sample, buffer, sizeof(sample));
+        return sample;
+    }
+
+    return (int8_t) *buffer * 256;
+
+}
+
+/**
+ * Translates the given input frames to signed 16-bit samples, mapping each
+ * input channel to the corresponding output channel. Stereo input is mixed
+ * down to mono if the output has a single channel. If the output has more
+ * channels than the input, the last input channel is repeated. If the output
+ * has fewer channels, excess input channels are dropped.
+ *
+ * @param resampler
+ *     The resampler whose input and output formats should be used.
+ *
+ * @param in
+ *     The input frames to translate.
+ *
+ * @param frames
+ *     The number of input frames to translate.
+ *
+ * @param out
+ *     The buffer to which the translated samples should be written. This
+ *     buffer must have space for the given number of frames in the output
+ *     channel layout.
+ */
+static void guac_rdp_audio_resampler_convert(
+        const guac_rdp_audio_resampler* resampler, const char* in,
+        int frames, int16_t* out) {
+
+    int in_bps = resampler->in_format.bps;
+    int in_channels = resampler->in_format.channels;
+    int out_channels = resampler->out_format.channels;
+    int in_frame_size = in_channels * in_bps;
+
+    /* Identical 16-bit layouts require no translation at all */
+    if (in_bps == 2 && in_channels == out_channels) {
+        memcpy(out, in, frames * in_frame_size);
+        return;
+    }
+
+    /* Mix stereo down to mono */
+    if (in_channels == 2 && out_channels == 1) {
+        for (int i = 0; i < frames; i++) {
+            int left  = guac_rdp_audio_resampler_read_sample(in, in_bps);
+            int right = guac_rdp_audio_resampler_read_sample(in + in_bps, in_bps);
+            out[i] = (left + right) / 2;
+            in += in_frame_size;
+        }
+        return;
+    }
+
+    /* Otherwise, map each output channel to an input channel */
+    for (int i = 0; i < frames; i++) {
+
+        for (int channel = 0; channel < out_channels; channel++) {
+
+            int in_channel = channel;
+            if (in_channel >= in_channels)
+                in_channel = in_channels - 1;
+
+            *(out++) = guac_rdp_audio_resampler_read_sample(
+                    in + in_channel * in_bps, in_bps);
+
+        }
+
+        in += in_frame_size;
+
+    }
+
+}
+
+/**
+ * Writes the given signed 16-bit samples to the given buffer using the given
+ * sample size. If the sample size is 8-bit, each sample is scaled down.
+ *
+ * @param samples
+ *     The samples to write.
+ *
+ * @param count
+ *     The number of samples to write.
+ *
+ * @param out
+ *     The buffer to which the samples should be written. This buffer need not
+ *     be aligned.
+ *
+ * @param bps
+ *     The size of each sample to write, in bytes. This must be 1 or 2.
+ */
+static void guac_rdp_audio_resampler_write(const int16_t* samples, int count,
+        char* out, int bps) {
+
+    if (bps == 2) {
+        memcpy(out, samples, count * sizeof(int16_t));
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+        out[i] = samples[i] >> 8;
+
+}
+
+/**
+ * Produces output frames by linearly interpolating between each pair of
+ * input frames surrounding the position of each output frame, advancing that
+ * position by the given step after each output frame. Interpolation stops
+ * once the position reaches the given end or the maximum number of output
+ * frames has been produced.
+ *
+ * @param block
+ *     The input frames, as signed 16-bit samples in the output channel
+ *     layout.
+ *
+ * @param channels
+ *     The number of channels in each frame.
+ *
+ * @param position
+ *     A pointer to the position of the next output frame within the input
+ *     frames, as 32.32 fixed-point. This position is updated as output frames
+ *     are produced.
+ *
+ * @param step
+ *     The distance between output frames in input frames, as 32.32
+ *     fixed-point.
+ *
+ * @param end
+ *     The position of the last input frame, as 32.32 fixed-point. Output
+ *     frames at or beyond this position require input which is not yet
+ *     available.
+ *
+ * @param out
+ *     The buffer to which output frames should be written.
+ *
+ * @param max_frames
+ *     The maximum number of output frames to produce.
+ *
+ * @return
+ *     The number of output frames produced.
+ */
+static inline int guac_rdp_audio_resampler_interpolate(const int16_t* block,
+        int channels, uint64_t* position, uint64_t step, uint64_t end,
+        int16_t* out, int max_frames) {
+
+    uint64_t current = *position;
+    int count = 0;
+
+    for (; current < end && count < max_frames; current += step, count++) {
+
+        const int16_t* before = block + (current >> 32) * channels;
+        const int16_t* after = before + channels;
+
+        /* Fraction of distance between frames, with 15 bits of precision
+         * such that the interpolation cannot overflow */
+        int32_t fraction = (current >> 17) & 0x7FFF;
+
+        for (int channel = 0; channel < channels; channel++) {
+            int32_t delta = after[channel] - before[channel];
+            *(out++) = before[channel] + ((delta * fraction) >> 15);
+        }
+
+    }
+
+    *position = current;
+    return count;
+
+}
+
+/**
+ * Converts the given block of complete input frames, writing up to the given
+ * number of output frames. Any output frames beyond that number are dropped.
+ *
+ * @param resampler
+ *     The resampler to use to convert the audio data.
+ *
+ * @param in
+ *     The input frames to convert.
+ *
+ * @param frames
+ *     The number of input frames to convert. This must not exceed
+ *     GUAC_RDP_AUDIO_RESAMPLER_BLOCK_FRAMES.
+ *
+ * @param out
+ *     The buffer to which output frames should be written.
+ *
+ * @param out_frames
+ *     The maximum number of output frames to write.
+ *
+ * @return
+ *     The number of output frames written.
+ */
+static int guac_rdp_audio_resampler_process_block(
+        guac_rdp_audio_resampler* resampler, const char* in, int frames,
+        char* out, int out_frames) {
+
+    int channels = resampler->out_format.channels;
+    int out_bps = resampler->out_format.bps;
+    int out_frame_size = channels * out_bps;
+
+    /* Translated input, preceded by the last frame of the previous block */
+    int16_t block[(GUAC_RDP_AUDIO_RESAMPLER_BLOCK_FRAMES + 1)
+        * GUAC_RDP_AUDIO_RESAMPLER_MAX_CHANNELS];
+
+    memcpy(block, resampler->last_frame, channels * sizeof(int16_t));
+    guac_rdp_audio_resampler_convert(resampler, in, frames, block + channels);
+
+    uint64_t position = resampler->position;
+    uint64_t step = resampler->step;
+    uint64_t end = (uint64_t) frames << 32;
+
+    int written = 0;
+
+    /* If rates match and output frames align exactly with input frames, the
+     * output is simply a contiguous run of the translated input */
+    if (step == GUAC_RDP_AUDIO_RESAMPLER_ONE
+            && (position & (GUAC_RDP_AUDIO_RESAMPLER_ONE - 1)) == 0) {
+
+        int first = position >> 32;
+        if (first < frames) {
+
+            written = frames - first;
+            if (written > out_frames)
+                written = out_frames;
+
+            guac_rdp_audio_resampler_write(block + first * channels,
+                    written * channels, out, out_bps);
+
+            position = end;
+
+        }
+
+    }
+
+    /* Otherwise, interpolate between each pair of surrounding input frames,
+     * using dedicated loops for the common mono and stereo cases */
+    else {
+
+        int16_t interpolated[GUAC_RDP_AUDIO_RESAMPLER_BLOCK_FRAMES
+            * GUAC_RDP_AUDIO_RESAMPLER_MAX_CHANNELS];
+
+        while (position < end) {
+
+            /* Skip any output frames which cannot fit within output buffer */
+            if (written == out_frames) {
+                position += (end - position + step - 1) / step * step;
+                break;
+            }
+
+            int max_frames = out_frames - written;
+            if (max_frames > GUAC_RDP_AUDIO_RESAMPLER_BLOCK_FRAMES)
+                max_frames = GUAC_RDP_AUDIO_RESAMPLER_BLOCK_FRAMES;
+
+            int count;
+            if (channels == 1)
+                count = guac_rdp_audio_resampler_interpolate(block, 1,
+                        &position, step, end, interpolated, max_frames);
+            else if (channels == 2)
+                count = guac_rdp_audio_resampler_interpolate(block, 2,
+                        &position, step, end, interpolated, max_frames);
+            else
+                count = guac_rdp_audio_resampler_interpolate(block, channels,
+                        &position, step, end, interpolated, max_frames);
+
+            guac_rdp_audio_resampler_write(interpolated, count * channels,
+                    out + written * out_frame_size, out_bps);
+
+            written += count;
+
+        }
+
+    }
+
+    /* The final input frame of this block is the first of the next */
+    memcpy(resampler->last_frame, block + frames * channels,
+            channels * sizeof(int16_t));
+
+    resampler->position = position - end;
+    return written;
+
+}
+
+int guac_rdp_audio_resampler_init(guac_rdp_audio_resampler* resampler,
+        const guac_rdp_audio_format* in_format,
+        const guac_rdp_audio_format* out_format) {
+
+    const guac_rdp_audio_format* formats[] = { in_format, out_format };
+
+    /* Verify both formats are supported */
+    for (int i = 0; i < 2; i++) {
+        const guac_rdp_audio_format* format = formats[i];
+        if (format->rate <= 0
+                || format->channels < 1
+                || format->channels > GUAC_RDP_AUDIO_RESAMPLER_MAX_CHANNELS
+                || (format->bps != 1 && format->bps != 2))
+            return 1;
+    }
+
+    resampler->in_format = *in_format;
+    resampler->out_format = *out_format;
+
+    /* Precompute ratio between input and output rates, rounding up such
+     * that accumulated error never places an output frame before its true
+     * position */
+    resampler->step = (((uint64_t) in_format->rate << 32)
+            + out_format->rate - 1) / out_format->rate;
+
+    /* The first output frame is the first input frame */
+    resampler->position = GUAC_RDP_AUDIO_RESAMPLER_ONE;
+    memset(resampler->last_frame, 0, sizeof(resampler->last_frame));
+    resampler->partial_length = 0;
+
+    return 0;
+
+}
+
+int guac_rdp_audio_resampler_process(guac_rdp_audio_resampler* resampler,
+        const char* in, int in_length, char* out, int out_length) {
+
+    int in_frame_size = resampler->in_format.channels
+                      * resampler->in_format.bps;
+
+    int out_frame_size = resampler->out_format.channels
+                       * resampler->out_format.bps;
+
+    int out_frames = out_length / out_frame_size;
+    int written = 0;
+
+    /* Complete any partial frame left over from the previous block */
+    if (resampler->partial_length > 0) {
+
+        int needed = in_frame_size - resampler->partial_length;
+        if (in_length < needed) {
+            memcpy(resampler->partial_frame + resampler->partial_length,
+                    in, in_length);
+            resampler->partial_length += in_length;
+            return 0;
+        }
+
+        memcpy(resampler->partial_frame + resampler->partial_length,
+                in, needed);
+        resampler->partial_length = 0;
+
+        in += needed;
+        in_length -= needed;
+
+        written += guac_rdp_audio_resampler_process_block(resampler,
+                resampler->partial_frame, 1, out, out_frames);
+
+    }
+
+    /* Convert all complete frames, one block at a time */
+    while (in_length >= in_frame_size) {
+
+        int frames = in_length / in_frame_size;
+        if (frames > GUAC_RDP_AUDIO_RESAMPLER_BLOCK_FRAMES)
+            frames = GUAC_RDP_AUDIO_RESAMPLER_BLOCK_FRAMES;
+
+        written += guac_rdp_audio_resampler_process_block(resampler, in,
+                frames, out + written * out_frame_size, out_frames - written);
+
+        in += frames * in_frame_size;
+        in_length -= frames * in_frame_size;
+
+    }
+
+    /* Store any remaining partial frame for the next block */
+    memcpy(resampler->partial_frame, in, in_length);
+    resampler->partial_length = in_length;
+
+    return written * out_frame_size;
+
+}
@@ -0,0 +1,165 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_RDP_CHANNELS_AUDIO_INPUT_AUDIO_RESAMPLER_H
+#define GUAC_RDP_CHANNELS_AUDIO_INPUT_AUDIO_RESAMPLER_H
+
+#include <stdint.h>
+
+/**
+ * The maximum number of channels supported by guac_rdp_audio_resampler for
+ * either its input or output format.
+ */
+#define GUAC_RDP_AUDIO_RESAMPLER_MAX_CHANNELS 8
+
+/**
+ * The maximum number of input frames converted by guac_rdp_audio_resampler
+ * at once. Larger amounts of input data are processed in blocks of this
+ * size.
+ */
+#define GUAC_RDP_AUDIO_RESAMPLER_BLOCK_FRAMES 256
+
+/**
+ * A description of an arbitrary PCM audio format.
+ */
+typedef struct guac_rdp_audio_format {
+
+    /**
+     * The rate of the audio data in samples per second.
+     */
+    int rate;
+
+    /**
+     * The number of channels included in the audio data. This will be 1 for
+     * monaural audio and 2 for stereo.
+     */
+    int channels;
+
+    /**
+     * The size of each sample within the audio data, in bytes.
+     */
+    int bps;
+
+} guac_rdp_audio_format;
+
+/**
+ * Streaming converter which translates PCM audio from one format to another,
+ * including the sample rate, number of channels, and sample size. Sample
+ * rates are converted using linear interpolation, with the position within
+ * the input stored as 32.32 fixed-point such that no division or
+ * floating-point arithmetic is needed per sample. Audio data may be provided
+ * in blocks of any size, including blocks which split frames.
+ */
+typedef struct guac_rdp_audio_resampler {
+
+    /**
+     * The format of the audio data provided to the resampler.
+     */
+    guac_rdp_audio_format in_format;
+
+    /**
+     * The format of the audio data produced by the resampler.
+     */
+    guac_rdp_audio_format out_format;
+
+    /**
+     * The distance between output frames in input frames, as 32.32
+     * fixed-point.
+     */
+    uint64_t step;
+
+    /**
+     * The position of the next output frame in input frames, as 32.32
+     * fixed-point, relative to the last input frame of the previous block.
+     */
+    uint64_t position;
+
+    /**
+     * The last input frame of the previous block, already translated to
+     * signed 16-bit samples and mapped to output channels.
+     */
+    int16_t last_frame[GUAC_RDP_AUDIO_RESAMPLER_MAX_CHANNELS];
+
+    /**
+     * Any partial input frame remaining at the end of the previous block.
+     */
+    char partial_frame[GUAC_RDP_AUDIO_RESAMPLER_MAX_CHANNELS * 2];
+
+    /**
+     * The number of bytes stored within partial_frame.
+     */
+    int partial_length;
+
+} guac_rdp_audio_resampler;
+
+/**
+ * Initializes the given resampler for converting audio from the given input
+ * format to the given output format, resetting any state related to audio
+ * data previously provided. Both formats must have between 1 and
+ * GUAC_RDP_AUDIO_RESAMPLER_MAX_CHANNELS channels, 8- or 16-bit samples, and
+ * a positive sample rate.
+ *
+ * @param resampler
+ *     The resampler to initialize.
+ *
+ * @param in_format
+ *     The format of the audio data that will be provided to the resampler.
+ *
+ * @param out_format
+ *     The format of the audio data that the resampler should produce.
+ *
+ * @return
+ *     Zero if the resampler was successfully initialized, non-zero if either
+ *     format is not supported.
+ */
+int guac_rdp_audio_resampler_init(guac_rdp_audio_resampler* resampler,
+        const guac_rdp_audio_format* in_format,
+        const guac_rdp_audio_format* out_format);
+
+/**
+ * Converts the given block of audio data, writing as many resulting frames as
+ * are available and fit within the given output buffer. Because each output
+ * frame is interpolated between two input frames, output lags input by one
+ * input frame. Any output frames which do not fit within the output buffer
+ * are dropped. The resampler must have been initialized with
+ * guac_rdp_audio_resampler_init().
+ *
+ * @param resampler
+ *     The resampler to use to convert the audio data.
+ *
+ * @param in
+ *     The audio data to convert, in the input format of the resampler.
+ *
+ * @param in_length
+ *     The number of bytes of audio data within the input buffer.
+ *
+ * @param out
+ *     The buffer to which converted audio data should be written, in the
+ *     output format of the resampler.
+ *
+ * @param out_length
+ *     The number of bytes available within the output buffer.
+ *
+ * @return
+ *     The number of bytes written to the output buffer.
+ */
+int guac_rdp_audio_resampler_process(guac_rdp_audio_resampler* resampler,
+        const char* in, int in_length, char* out, int out_length);
+
+#endif
@@ -140,7 +140,6 @@ void guac_rdpdr_fs_process_read(guac_rdp_common_svc* svc,
 
     UINT32 length;
     UINT64 offset;
-    char* buffer;
     int bytes_read;
 
     wStream* output_stream;
@@ -165,15 +164,21 @@ void guac_rdpdr_fs_process_read(guac_rdp_common_svc* svc,
     if (length > GUAC_RDP_MAX_READ_BUFFER)
         length = GUAC_RDP_MAX_READ_BUFFER;
 
-    /* Allocate buffer */
-    buffer = guac_mem_alloc(length);
+    /* Allocate response large enough for the entire read */
+    output_stream = guac_rdpdr_new_io_completion(device,
+            iorequest->completion_id, STATUS_SUCCESS, 4+length);
+
+    size_t length_position = Stream_GetPosition(output_stream);
+    Stream_Seek(output_stream, 4); /* Length (written below) */
 
-    /* Attempt read */
+    /* Attempt read directly into response */
     bytes_read = guac_rdp_fs_read((guac_rdp_fs*) device->data,
-            iorequest->file_id, offset, buffer, length);
+            iorequest->file_id, offset, Stream_Pointer(output_stream),
+            length);
 
-    /* If error, return invalid parameter */
+    /* If error, replace response, returning invalid parameter */
     if (bytes_read < 0) {
+        Stream_Free(output_stream, TRUE);
         output_stream = guac_rdpdr_new_io_completion(device,
                 iorequest->completion_id, guac_rdp_fs_get_status(bytes_read), 4);
         Stream_Write_UINT32(output_stream, 0); /* Length */
@@ -181,14 +186,14 @@ void guac_rdpdr_fs_process_read(guac_rdp_common_svc* svc,
 
     /* Otherwise, send bytes read */
     else {
-        output_stream = guac_rdpdr_new_io_completion(device,
-                iorequest->completion_id, STATUS_SUCCESS, 4+bytes_read);
-        Stream_Write_UINT32(output_stream, bytes_read);  /* Length */
-        Stream_Write(output_stream, buffer, bytes_read); /* ReadData */
+        Stream_Seek(output_stream, bytes_read); /* ReadData */
+        size_t end_position = Stream_GetPosition(output_stream);
+        Stream_SetPosition(output_stream, length_position);
+        Stream_Write_UINT32(output_stream, bytes_read); /* Length */
+        Stream_SetPosition(output_stream, end_position);
     }
 
     guac_rdp_common_svc_write(svc, output_stream);
-    guac_mem_free(buffer);
 
 }
 
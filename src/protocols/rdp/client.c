@@ -22,8 +22,10 @@
 #include "channels/cliprdr.h"
 #include "channels/disp.h"
 #include "channels/pipe-svc.h"
+#include "common/input.h"
 #include "config.h"
 #include "fs.h"
+#include "input.h"
 #include "log.h"
 #include "rdp.h"
 #include "settings.h"
@@ -211,6 +213,10 @@ int guac_client_init(guac_client* client, int argc, char** argv) {
     /* Init multi-touch support module (RDPEI) */
     rdp_client->rdpei = guac_rdp_rdpei_alloc(client);
 
+    /* Init coalescing of mouse and touch input */
+    rdp_client->input = guac_common_input_alloc(client,
+            guac_rdp_input_forward, client);
+
     /* Redirect FreeRDP log messages to guac_client_log() */
     guac_rdp_redirect_wlog(client);
 
@@ -244,6 +250,9 @@ int guac_rdp_client_free_handler(guac_client* client) {
     /* Wait for client thread */
     pthread_join(rdp_client->client_thread, NULL);
 
+    /* Stop coalescing input */
+    guac_common_input_free(rdp_client->input);
+
     /* Free parsed settings */
     if (rdp_client->settings != NULL)
         guac_rdp_settings_free(rdp_client->settings);
@@ -297,6 +306,9 @@ int guac_rdp_client_free_handler(guac_client* client) {
     if (rdp_client->audio_input != NULL)
         guac_rdp_audio_buffer_free(rdp_client->audio_input);
 
+    /* Free glyph run mask buffer */
+    guac_mem_free(rdp_client->glyph_run.mask);
+
     pthread_rwlock_destroy(&(rdp_client->lock));
     pthread_mutex_destroy(&(rdp_client->message_lock));
 
@@ -17,6 +17,7 @@
  * under the License.
  */
 
+#include "common/download.h"
 #include "common/json.h"
 #include "download.h"
 #include "fs.h"
@@ -37,63 +38,100 @@
 
 #include <stdlib.h>
 
-int guac_rdp_download_ack_handler(guac_user* user, guac_stream* stream,
-        char* message, guac_protocol_status status) {
+/**
+ * Read handler for downloads of files within the RDP filesystem, reading the
+ * next portion of the file being downloaded. The given data is expected to
+ * be the guac_rdp_download_status of the download.
+ *
+ * @param data
+ *     The guac_rdp_download_status of the file being downloaded.
+ *
+ * @param buffer
+ *     The buffer to read data into.
+ *
+ * @param length
+ *     The maximum number of bytes to read.
+ *
+ * @return
+ *     The number of bytes read, zero if the end of the file has been reached,
+ *     or a negative value if an error occurs.
+ */
+static int guac_rdp_download_read_handler(void* data, char* buffer,
+        int length) {
 
-    guac_client* client = user->client;
-    guac_rdp_client* rdp_client = (guac_rdp_client*) client->data;
-    guac_rdp_download_status* download_status = (guac_rdp_download_status*) stream->data;
+    guac_rdp_download_status* download_status =
+        (guac_rdp_download_status*) data;
+
+    guac_rdp_client* rdp_client =
+        (guac_rdp_client*) download_status->client->data;
 
-    /* Get filesystem, return error if no filesystem */
+    /* Fail if filesystem has been unloaded */
     guac_rdp_fs* fs = rdp_client->filesystem;
-    if (fs == NULL) {
-        guac_protocol_send_ack(user->socket, stream, "FAIL (NO FS)",
-                GUAC_PROTOCOL_STATUS_SERVER_ERROR);
-        guac_socket_flush(user->socket);
-        return 0;
-    }
+    if (fs == NULL)
+        return -1;
 
-    /* If successful, read data */
-    if (status == GUAC_PROTOCOL_STATUS_SUCCESS) {
-
-        /* Attempt read into buffer */
-        char buffer[4096];
-        int bytes_read = guac_rdp_fs_read(fs,
-                download_status->file_id,
-                download_status->offset, buffer, sizeof(buffer));
-
-        /* If bytes read, send as blob */
-        if (bytes_read > 0) {
-            download_status->offset += bytes_read;
-            guac_protocol_send_blob(user->socket, stream,
-                    buffer, bytes_read);
-        }
-
-        /* If EOF, send end */
-        else if (bytes_read == 0) {
-            guac_protocol_send_end(user->socket, stream);
-            guac_user_free_stream(user, stream);
-            guac_mem_free(download_status);
-        }
-
-        /* Otherwise, fail stream */
-        else {
-            guac_user_log(user, GUAC_LOG_ERROR,
-                    "Error reading file for download");
-            guac_protocol_send_end(user->socket, stream);
-            guac_user_free_stream(user, stream);
-            guac_mem_free(download_status);
-        }
+    int bytes_read = guac_rdp_fs_read(fs, download_status->file_id,
+            download_status->offset, buffer, length);
 
-        guac_socket_flush(user->socket);
+    if (bytes_read > 0)
+        download_status->offset += bytes_read;
 
-    }
+    return bytes_read;
 
-    /* Otherwise, return stream to user */
-    else
-        guac_user_free_stream(user, stream);
+}
 
-    return 0;
+/**
+ * Close handler for downloads of files within the RDP filesystem, closing the
+ * file that was downloaded and freeing the given guac_rdp_download_status.
+ *
+ * @param data
+ *     The guac_rdp_download_status of the file that was downloaded.
+ */
+static void guac_rdp_download_close_handler(void* data) {
+
+    guac_rdp_download_status* download_status =
+        (guac_rdp_download_status*) data;
+
+    guac_rdp_client* rdp_client =
+        (guac_rdp_client*) download_status->client->data;
+
+    /* Close file only if filesystem is still loaded */
+    guac_rdp_fs* fs = rdp_client->filesystem;
+    if (fs != NULL)
+        guac_rdp_fs_close(fs, download_status->file_id);
+
+    guac_mem_free(download_status);
+
+}
+
+/**
+ * Begins a download of the given file along the given stream, which must
+ * then be started with a "file" or "body" instruction.
+ *
+ * @param client
+ *     The client associated with the RDP filesystem.
+ *
+ * @param stream
+ *     The stream along which the file should be downloaded.
+ *
+ * @param file_id
+ *     The ID of the file to download, as returned by guac_rdp_fs_open().
+ *
+ * @param window
+ *     The maximum number of blobs which may be in flight at any one time.
+ */
+static void guac_rdp_download_begin(guac_client* client, guac_stream* stream,
+        int file_id, int window) {
+
+    guac_rdp_download_status* download_status =
+        guac_mem_alloc(sizeof(guac_rdp_download_status));
+
+    download_status->client = client;
+    download_status->file_id = file_id;
+    download_status->offset = 0;
+
+    guac_common_download_begin(stream, guac_rdp_download_read_handler,
+            guac_rdp_download_close_handler, download_status, window);
 
 }
 
@@ -153,15 +191,10 @@ int guac_rdp_download_get_handler(guac_user* user, guac_object* object,
     /* Otherwise, send file contents if downloads are allowed */
     else if (!fs->disable_download) {
 
-        /* Create stream data */
-        guac_rdp_download_status* download_status = guac_mem_alloc(sizeof(guac_rdp_download_status));
-        download_status->file_id = file_id;
-        download_status->offset = 0;
-
         /* Allocate stream for body */
         guac_stream* stream = guac_user_alloc_stream(user);
-        stream->data = download_status;
-        stream->ack_handler = guac_rdp_download_ack_handler;
+        guac_rdp_download_begin(client, stream, file_id,
+                fs->download_window);
 
         /* Associate new stream with get request */
         guac_protocol_send_body(user->socket, object, stream,
@@ -210,11 +243,8 @@ void* guac_rdp_download_to_user(guac_user* user, void* data) {
 
         /* Associate stream with transfer status */
         guac_stream* stream = guac_user_alloc_stream(user);
-        guac_rdp_download_status* download_status = guac_mem_alloc(sizeof(guac_rdp_download_status));
-        stream->data = download_status;
-        stream->ack_handler = guac_rdp_download_ack_handler;
-        download_status->file_id = file_id;
-        download_status->offset = 0;
+        guac_rdp_download_begin(client, stream, file_id,
+                filesystem->download_window);
 
         guac_user_log(user, GUAC_LOG_DEBUG, "%s: Initiating download "
                 "of \"%s\"", __func__, path);
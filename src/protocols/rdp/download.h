@@ -22,6 +22,7 @@
 
 #include "common/json.h"
 
+#include <guacamole/client.h>
 #include <guacamole/protocol.h>
 #include <guacamole/stream.h>
 #include <guacamole/user.h>
@@ -33,6 +34,11 @@
  */
 typedef struct guac_rdp_download_status {
 
+    /**
+     * The client associated with the RDP filesystem containing the file.
+     */
+    guac_client* client;
+
     /**
      * The file ID of the file being downloaded.
      */
@@ -45,11 +51,6 @@ typedef struct guac_rdp_download_status {
 
 } guac_rdp_download_status;
 
-/**
- * Handler for acknowledgements of receipt of data related to file downloads.
- */
-guac_user_ack_handler guac_rdp_download_ack_handler;
-
 /**
  * Handler for get messages. In context of downloads and the filesystem exposed
  * via the Guacamole protocol, get messages request the body of a file within
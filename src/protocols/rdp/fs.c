@@ -44,7 +44,8 @@
 #include <unistd.h>
 
 guac_rdp_fs* guac_rdp_fs_alloc(guac_client* client, const char* drive_path,
-        int create_drive_path, int disable_download, int disable_upload) {
+        int create_drive_path, int disable_download, int disable_upload,
+        int download_window) {
 
     /* Create drive path if it does not exist */
     if (create_drive_path) {
@@ -68,6 +69,7 @@ guac_rdp_fs* guac_rdp_fs_alloc(guac_client* client, const char* drive_path,
     fs->open_files = 0;
     fs->disable_download = disable_download;
     fs->disable_upload = disable_upload;
+    fs->download_window = download_window;
 
     return fs;
 
@@ -370,6 +372,8 @@ int guac_rdp_fs_open(guac_rdp_fs* fs, const char* path,
     file->absolute_path = guac_strdup(normalized_path);
     file->real_path = guac_strdup(real_path);
     file->bytes_written = 0;
+    file->read_offset = 0;
+    file->read_ahead_offset = 0;
 
     guac_client_log(fs->client, GUAC_LOG_DEBUG,
             "%s: Opened \"%s\" as file_id=%i",
@@ -410,6 +414,37 @@ int guac_rdp_fs_open(guac_rdp_fs* fs, const char* path,
 
 }
 
+/**
+ * Asks the operating system to begin reading the given file ahead of the
+ * given offset, if it has not already been asked to read far enough ahead.
+ * New read-ahead is requested only once half of the previously-requested
+ * read-ahead has been consumed, such that the request is not repeated for
+ * every read.
+ *
+ * @param file
+ *     The file being read sequentially.
+ *
+ * @param offset
+ *     The offset immediately following the data most recently read.
+ */
+static void guac_rdp_fs_read_ahead(guac_rdp_fs_file* file, uint64_t offset) {
+
+#ifdef POSIX_FADV_WILLNEED
+    if (file->read_ahead_offset >= offset + GUAC_RDP_FS_READ_AHEAD_SIZE / 2)
+        return;
+
+    uint64_t start = file->read_ahead_offset;
+    if (start < offset)
+        start = offset;
+
+    uint64_t end = offset + GUAC_RDP_FS_READ_AHEAD_SIZE;
+    posix_fadvise(file->fd, start, end - start, POSIX_FADV_WILLNEED);
+
+    file->read_ahead_offset = end;
+#endif
+
+}
+
 int guac_rdp_fs_read(guac_rdp_fs* fs, int file_id, uint64_t offset,
         void* buffer, int length) {
 
@@ -422,14 +457,18 @@ int guac_rdp_fs_read(guac_rdp_fs* fs, int file_id, uint64_t offset,
         return GUAC_RDP_FS_EINVAL;
     }
 
-    /* Attempt read */
-    lseek(file->fd, offset, SEEK_SET);
-    bytes_read = read(file->fd, buffer, length);
+    /* Attempt read, directly into the caller's buffer */
+    bytes_read = pread(file->fd, buffer, length, offset);
 
     /* Translate errno on error */
     if (bytes_read < 0)
         return guac_rdp_fs_get_errorcode(errno);
 
+    /* Keep storage ahead of sequential reads */
+    if (offset == file->read_offset)
+        guac_rdp_fs_read_ahead(file, offset + bytes_read);
+
+    file->read_offset = offset + bytes_read;
     return bytes_read;
 
 }
@@ -49,6 +49,13 @@
  */
 #define GUAC_RDP_FS_MAX_PATH 4096
 
+/**
+ * The number of bytes beyond the end of each sequential read of a file which
+ * the operating system will be asked to read ahead, such that the following
+ * read is satisfied from memory rather than waiting on storage.
+ */
+#define GUAC_RDP_FS_READ_AHEAD_SIZE 1048576
+
 /**
  * The maximum number of directories a path may contain.
  */
@@ -180,6 +187,19 @@ typedef struct guac_rdp_fs_file {
      */
     uint64_t bytes_written;
 
+    /**
+     * The offset immediately following the data returned by the most recent
+     * read of this file. A read beginning at this offset is considered
+     * sequential.
+     */
+    uint64_t read_offset;
+
+    /**
+     * The offset immediately following the data which the operating system
+     * has most recently been asked to read ahead.
+     */
+    uint64_t read_ahead_offset;
+
 } guac_rdp_fs_file;
 
 /**
@@ -222,6 +242,12 @@ typedef struct guac_rdp_fs {
      */
     int disable_upload;
 
+    /**
+     * The maximum number of blobs which may be sent along each download
+     * stream without having been acknowledged.
+     */
+    int download_window;
+
 } guac_rdp_fs;
 
 /**
@@ -269,11 +295,17 @@ typedef struct guac_rdp_fs_info {
  *     Non-zero if uploads from the browser to the remote server should be
  *     disabled.
  *
+ * @param download_window
+ *     The maximum number of blobs which may be sent along each download
+ *     stream without having been acknowledged. If less than one,
+ *     GUAC_COMMON_DOWNLOAD_DEFAULT_WINDOW is used.
+ *
  * @return
  *     The newly-allocated filesystem.
  */
 guac_rdp_fs* guac_rdp_fs_alloc(guac_client* client, const char* drive_path,
-        int create_drive_path, int disable_download, int disable_upload);
+        int create_drive_path, int disable_download, int disable_upload,
+        int download_window);
 
 /**
  * Frees the given filesystem.
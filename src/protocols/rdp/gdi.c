@@ -20,6 +20,7 @@
 #include "bitmap.h"
 #include "color.h"
 #include "common/display.h"
+#include "common/rect.h"
 #include "common/surface.h"
 #include "rdp.h"
 #include "settings.h"
@@ -33,7 +34,9 @@
 #include <guacamole/protocol.h>
 #include <winpr/wtypes.h>
 
+#include <inttypes.h>
 #include <stddef.h>
+#include <stdint.h>
 
 guac_transfer_function guac_rdp_rop3_transfer_function(guac_client* client,
         int rop3) {
@@ -394,9 +397,16 @@ void guac_rdp_gdi_mark_frame(rdpContext* context, int starting) {
     rdp_client->frames_received++;
 
     /* Flush a new frame if the client is ready for it */
-    if (time_elapsed >= guac_client_get_processing_lag(client)) {
+    if (time_elapsed >= guac_common_display_get_frame_delay(
+                rdp_client->display)) {
         guac_common_display_flush(rdp_client->display);
         guac_client_end_multiple_frames(client, rdp_client->frames_received);
+
+        /* Periodically record full display state, if indexing */
+        if (rdp_client->recording != NULL)
+            guac_common_display_record_keyframe(rdp_client->display,
+                    rdp_client->recording);
+
         guac_socket_flush(client->socket);
         rdp_client->frames_received = 0;
     }
@@ -433,6 +443,97 @@ BOOL guac_rdp_gdi_begin_paint(rdpContext* context) {
 
 }
 
+/**
+ * Returns the area of the given rectangle, in pixels.
+ *
+ * @param rect
+ *     The rectangle whose area should be returned.
+ *
+ * @return
+ *     The area of the given rectangle, in pixels.
+ */
+static uint64_t guac_rdp_gdi_rect_area(const guac_common_rect* rect) {
+    return (uint64_t) rect->width * rect->height;
+}
+
+/**
+ * Adds the given rectangle to the given set of rectangles to be drawn,
+ * merging it with any rectangles for which drawing the combined bounding
+ * rectangle is no more costly than drawing both separately. If the set is
+ * full, the given rectangle is merged with whichever rectangle results in
+ * the smallest combined area.
+ *
+ * @param rects
+ *     The set of rectangles to be drawn, which must have space for at least
+ *     GUAC_RDP_GDI_MAX_PAINT_RECTS rectangles.
+ *
+ * @param count
+ *     A pointer to the number of rectangles currently in the set, which will
+ *     be updated to reflect any rectangles added or merged.
+ *
+ * @param rect
+ *     The rectangle to add.
+ */
+static void guac_rdp_gdi_add_paint_rect(guac_common_rect* rects, int* count,
+        guac_common_rect rect) {
+
+    int merged;
+
+    /* Merge with existing rectangles until no cheaper merge remains, as each
+     * merge may make further merges worthwhile */
+    do {
+
+        merged = 0;
+
+        for (int i = 0; i < *count; i++) {
+
+            guac_common_rect combined = rect;
+            guac_common_rect_extend(&combined, &rects[i]);
+
+            if (guac_rdp_gdi_rect_area(&combined) <= guac_rdp_gdi_rect_area(&rect)
+                    + guac_rdp_gdi_rect_area(&rects[i])
+                    + GUAC_RDP_GDI_PAINT_RECT_COST) {
+
+                /* Replace existing rectangle with last in set */
+                rect = combined;
+                rects[i] = rects[--(*count)];
+                merged = 1;
+                break;
+
+            }
+
+        }
+
+    } while (merged);
+
+    /* Add as a separate rectangle if there is room */
+    if (*count < GUAC_RDP_GDI_MAX_PAINT_RECTS) {
+        rects[(*count)++] = rect;
+        return;
+    }
+
+    /* Otherwise, merge with the rectangle that grows the least */
+    int best = 0;
+    uint64_t best_area = UINT64_MAX;
+    for (int i = 0; i < *count; i++) {
+
+        guac_common_rect combined = rect;
+        guac_common_rect_extend(&combined, &rects[i]);
+
+        uint64_t area = guac_rdp_gdi_rect_area(&combined)
+            - guac_rdp_gdi_rect_area(&rects[i]);
+
+        if (area < best_area) {
+            best = i;
+            best_area = area;
+        }
+
+    }
+
+    guac_common_rect_extend(&rects[best], &rect);
+
+}
+
 BOOL guac_rdp_gdi_end_paint(rdpContext* context) {
 
     guac_client* client = ((rdp_freerdp_context*) context)->client;
@@ -448,25 +549,85 @@ BOOL guac_rdp_gdi_end_paint(rdpContext* context) {
     if (gdi->suppressOutput)
         return TRUE;
 
+    HGDI_WND hwnd = gdi->primary->hdc->hwnd;
+
     /* Ignore paint if nothing has been done (empty rect) */
-    if (gdi->primary->hdc->hwnd->invalid->null)
+    if (hwnd->invalid->null)
         return TRUE;
 
-    INT32 x = gdi->primary->hdc->hwnd->invalid->x;
-    INT32 y = gdi->primary->hdc->hwnd->invalid->y;
-    UINT32 w = gdi->primary->hdc->hwnd->invalid->w;
-    UINT32 h = gdi->primary->hdc->hwnd->invalid->h;
+    guac_common_rect bounds;
+    guac_common_rect_init(&bounds, 0, 0, gdi->width, gdi->height);
+
+    guac_common_rect rects[GUAC_RDP_GDI_MAX_PAINT_RECTS];
+    int count = 0;
+    uint64_t pixels_changed = 0;
+
+    /* Combine individual invalidated regions only where cheaper */
+    for (int i = 0; i < hwnd->ninvalid; i++) {
+
+        HGDI_RGN region = &(hwnd->cinvalid[i]);
+        if (region->null)
+            continue;
+
+        guac_common_rect rect;
+        guac_common_rect_init(&rect, region->x, region->y, region->w, region->h);
+        guac_common_rect_constrain(&rect, &bounds);
+
+        if (rect.width <= 0 || rect.height <= 0)
+            continue;
+
+        pixels_changed += guac_rdp_gdi_rect_area(&rect);
+        guac_rdp_gdi_add_paint_rect(rects, &count, rect);
+
+    }
+
+    /* Fall back to the overall bounding rectangle if no individual regions
+     * were recorded */
+    if (hwnd->ninvalid == 0) {
+
+        guac_common_rect rect;
+        guac_common_rect_init(&rect, hwnd->invalid->x, hwnd->invalid->y,
+                hwnd->invalid->w, hwnd->invalid->h);
+        guac_common_rect_constrain(&rect, &bounds);
+
+        if (rect.width > 0 && rect.height > 0) {
+            pixels_changed += guac_rdp_gdi_rect_area(&rect);
+            rects[count++] = rect;
+        }
+
+    }
+
+    uint64_t pixels_submitted = 0;
 
-    /* Create surface from image data */
-    cairo_surface_t* surface = cairo_image_surface_create_for_data(
-        gdi->primary_buffer + 4*x + y*gdi->stride,
-        CAIRO_FORMAT_RGB24, w, h, gdi->stride);
+    /* Draw each rectangle separately */
+    for (int i = 0; i < count; i++) {
+
+        guac_common_rect* rect = &rects[i];
+
+        /* Create surface from image data */
+        cairo_surface_t* surface = cairo_image_surface_create_for_data(
+            gdi->primary_buffer + 4*rect->x + rect->y*gdi->stride,
+            CAIRO_FORMAT_RGB24, rect->width, rect->height, gdi->stride);
+
+        /* Send surface to buffer */
+        guac_common_surface_draw(rdp_client->display->default_surface,
+                rect->x, rect->y, surface);
+
+        /* Free surface */
+        cairo_surface_destroy(surface);
+
+        pixels_submitted += guac_rdp_gdi_rect_area(rect);
+
+    }
 
-    /* Send surface to buffer */
-    guac_common_surface_draw(rdp_client->display->default_surface, x, y, surface);
+    guac_client_log(client, GUAC_LOG_TRACE, "EndPaint: %i region(s) "
+            "invalidated (%" PRIu64 " pixels changed), %i rectangle(s) drawn "
+            "(%" PRIu64 " pixels submitted).", hwnd->ninvalid, pixels_changed,
+            count, pixels_submitted);
 
-    /* Free surface */
-    cairo_surface_destroy(surface);
+    /* All invalidated regions have now been drawn */
+    hwnd->invalid->null = TRUE;
+    hwnd->ninvalid = 0;
 
     /* Next frame */
     if (gdi->inGfxFrame) {
@@ -25,6 +25,22 @@
 #include <freerdp/freerdp.h>
 #include <guacamole/protocol.h>
 
+/**
+ * The maximum number of separate rectangles that will be drawn for the
+ * regions invalidated between a single BeginPaint and EndPaint. If more
+ * rectangles would be needed, the rectangles which grow the least when
+ * combined are merged.
+ */
+#define GUAC_RDP_GDI_MAX_PAINT_RECTS 64
+
+/**
+ * The approximate cost of drawing an additional, separate rectangle, in
+ * terms of the number of pixels that could be drawn instead. Two invalidated
+ * regions are merged if drawing their bounding rectangle would cost no more
+ * than drawing each separately.
+ */
+#define GUAC_RDP_GDI_PAINT_RECT_COST 4096
+
 /**
  * Translates a standard RDP ROP3 value into a guac_composite_mode. Valid
  * ROP3 operations indexes are listed in the RDP protocol specifications:
@@ -30,6 +30,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* Define cairo_format_stride_for_width() if missing */
 #ifndef HAVE_CAIRO_FORMAT_STRIDE_FOR_WIDTH
@@ -47,18 +48,18 @@ BOOL guac_rdp_glyph_new(rdpContext* context, const rdpGlyph* glyph) {
     int width  = glyph->cx;
     int height = glyph->cy;
 
-    /* Init Cairo buffer */
-    stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, width);
+    /* Init Cairo buffer (one byte per pixel) */
+    stride = cairo_format_stride_for_width(CAIRO_FORMAT_A8, width);
     image_buffer = guac_mem_alloc(height, stride);
     image_buffer_row = image_buffer;
 
     /* Copy image data from image data to buffer */
     for (y = 0; y<height; y++) {
 
-        unsigned int*  image_buffer_current;
-        
+        unsigned char* image_buffer_current;
+
         /* Get current buffer row, advance to next */
-        image_buffer_current  = (unsigned int*) image_buffer_row;
+        image_buffer_current  = image_buffer_row;
         image_buffer_row     += stride;
 
         for (x = 0; x<width;) {
@@ -69,11 +70,8 @@ BOOL guac_rdp_glyph_new(rdpContext* context, const rdpGlyph* glyph) {
             /* Read bits, write pixels */
             for (i = 0; i<8 && x<width; i++, x++) {
 
-                /* Output RGB */
-                if (v & 0x80)
-                    *(image_buffer_current++) = 0xFF000000;
-                else
-                    *(image_buffer_current++) = 0x00000000;
+                /* Output alpha */
+                *(image_buffer_current++) = (v & 0x80) ? 0xFF : 0x00;
 
                 /* Next bit */
                 v <<= 1;
@@ -85,12 +83,85 @@ BOOL guac_rdp_glyph_new(rdpContext* context, const rdpGlyph* glyph) {
 
     /* Store glyph surface */
     ((guac_rdp_glyph*) glyph)->surface = cairo_image_surface_create_for_data(
-            image_buffer, CAIRO_FORMAT_ARGB32, width, height, stride);
+            image_buffer, CAIRO_FORMAT_A8, width, height, stride);
 
     return TRUE;
 
 }
 
+/**
+ * Paints all glyphs within the current glyph run onto the current drawing
+ * surface using the current glyph color, combining those glyphs into a single
+ * mask such that the surface is painted only once. The glyph run is emptied
+ * as a result of this call.
+ *
+ * @param rdp_client
+ *     The guac_rdp_client whose current glyph run should be painted.
+ */
+static void guac_rdp_glyph_run_flush(guac_rdp_client* rdp_client) {
+
+    guac_rdp_glyph_run* run = &(rdp_client->glyph_run);
+
+    /* Nothing to paint if no glyphs were drawn */
+    if (run->count == 0)
+        return;
+
+    int width  = run->right  - run->left;
+    int height = run->bottom - run->top;
+    int stride = cairo_format_stride_for_width(CAIRO_FORMAT_A8, width);
+
+    /* Grow mask buffer if necessary */
+    size_t size = guac_mem_ckd_mul_or_die(height, stride);
+    if (size > run->mask_size) {
+        guac_mem_free(run->mask);
+        run->mask = guac_mem_alloc(size);
+        run->mask_size = size;
+    }
+
+    memset(run->mask, 0, size);
+
+    /* Combine all glyphs into a single mask */
+    for (int i = 0; i < run->count; i++) {
+
+        guac_rdp_glyph_run_entry* entry = &(run->glyphs[i]);
+        cairo_surface_t* glyph_surface = entry->glyph->surface;
+
+        unsigned char* src = cairo_image_surface_get_data(glyph_surface);
+        int src_stride = cairo_image_surface_get_stride(glyph_surface);
+        int glyph_width = cairo_image_surface_get_width(glyph_surface);
+        int glyph_height = cairo_image_surface_get_height(glyph_surface);
+
+        unsigned char* dst = run->mask
+            + (entry->y - run->top) * stride + (entry->x - run->left);
+
+        for (int y = 0; y < glyph_height; y++) {
+
+            for (int x = 0; x < glyph_width; x++)
+                dst[x] |= src[x];
+
+            src += src_stride;
+            dst += stride;
+
+        }
+
+    }
+
+    /* Paint entire run at once */
+    cairo_surface_t* mask = cairo_image_surface_create_for_data(run->mask,
+            CAIRO_FORMAT_A8, width, height, stride);
+
+    uint32_t fgcolor = rdp_client->glyph_color;
+    guac_common_surface_paint(rdp_client->current_surface,
+            run->left, run->top, mask,
+            (fgcolor & 0xFF0000) >> 16,
+            (fgcolor & 0x00FF00) >> 8,
+             fgcolor & 0x0000FF);
+
+    cairo_surface_destroy(mask);
+    run->count = 0;
+
+}
+
 BOOL guac_rdp_glyph_draw(rdpContext* context, const rdpGlyph* glyph,
         GLYPH_CALLBACK_INT32 x, GLYPH_CALLBACK_INT32 y,
         GLYPH_CALLBACK_INT32 w, GLYPH_CALLBACK_INT32 h,
@@ -99,14 +170,35 @@ BOOL guac_rdp_glyph_draw(rdpContext* context, const rdpGlyph* glyph,
 
     guac_client* client = ((rdp_freerdp_context*) context)->client;
     guac_rdp_client* rdp_client = (guac_rdp_client*) client->data;
-    guac_common_surface* current_surface = rdp_client->current_surface;
-    uint32_t fgcolor = rdp_client->glyph_color;
+    guac_rdp_glyph_run* run = &(rdp_client->glyph_run);
+
+    cairo_surface_t* glyph_surface = ((guac_rdp_glyph*) glyph)->surface;
+    int right  = x + cairo_image_surface_get_width(glyph_surface);
+    int bottom = y + cairo_image_surface_get_height(glyph_surface);
+
+    /* Paint existing glyphs if no space remains within the run */
+    if (run->count == GUAC_RDP_GLYPH_RUN_MAX_GLYPHS)
+        guac_rdp_glyph_run_flush(rdp_client);
+
+    /* Update bounds of run to include glyph */
+    if (run->count == 0) {
+        run->left   = x;
+        run->top    = y;
+        run->right  = right;
+        run->bottom = bottom;
+    }
+    else {
+        if (x      < run->left)   run->left   = x;
+        if (y      < run->top)    run->top    = y;
+        if (right  > run->right)  run->right  = right;
+        if (bottom > run->bottom) run->bottom = bottom;
+    }
 
-    /* Paint with glyph as mask */
-    guac_common_surface_paint(current_surface, x, y, ((guac_rdp_glyph*) glyph)->surface,
-                               (fgcolor & 0xFF0000) >> 16,
-                               (fgcolor & 0x00FF00) >> 8,
-                                fgcolor & 0x0000FF);
+    /* Defer painting of glyph until end of run */
+    guac_rdp_glyph_run_entry* entry = &(run->glyphs[run->count++]);
+    entry->glyph = (guac_rdp_glyph*) glyph;
+    entry->x = x;
+    entry->y = y;
 
     return TRUE;
 
@@ -139,6 +231,9 @@ BOOL guac_rdp_glyph_begindraw(rdpContext* context,
     guac_rdp_client* rdp_client =
         (guac_rdp_client*) client->data;
 
+    /* Paint any glyphs remaining from a previous run which did not end */
+    guac_rdp_glyph_run_flush(rdp_client);
+
     /* Fill background with color if specified */
     if (width != 0 && height != 0 && !redundant) {
 
@@ -165,7 +260,14 @@ BOOL guac_rdp_glyph_enddraw(rdpContext* context,
         GLYPH_CALLBACK_INT32 x, GLYPH_CALLBACK_INT32 y,
         GLYPH_CALLBACK_INT32 width, GLYPH_CALLBACK_INT32 height,
         UINT32 fgcolor, UINT32 bgcolor) {
-    /* IGNORE */
+
+    guac_client* client = ((rdp_freerdp_context*) context)->client;
+    guac_rdp_client* rdp_client = (guac_rdp_client*) client->data;
+
+    /* Paint all glyphs drawn since guac_rdp_glyph_begindraw() */
+    guac_rdp_glyph_run_flush(rdp_client);
+
     return TRUE;
+
 }
 
@@ -27,6 +27,16 @@
 #include <freerdp/graphics.h>
 #include <winpr/wtypes.h>
 
+#include <stddef.h>
+
+/**
+ * The maximum number of glyphs which may be combined into a single glyph run
+ * before that run is painted. A GlyphIndex or FastGlyph order may draw more
+ * glyphs than this by reusing cached fragments, in which case the glyphs
+ * already within the run are painted early and a new run begins.
+ */
+#define GUAC_RDP_GLYPH_RUN_MAX_GLYPHS 256
+
 #ifdef FREERDP_GLYPH_CALLBACKS_ACCEPT_INT32
 /**
  * FreeRDP 2.0.0-rc4 and newer requires INT32 for all integer arguments of
@@ -52,12 +62,93 @@ typedef struct guac_rdp_glyph {
     rdpGlyph glyph;
 
     /**
-     * Cairo surface layer containing cached image data.
+     * Cairo surface containing the cached glyph as an 8-bit alpha mask
+     * (CAIRO_FORMAT_A8), where each pixel is either fully opaque or fully
+     * transparent.
      */
     cairo_surface_t* surface;
 
 } guac_rdp_glyph;
 
+/**
+ * A single glyph which has been drawn as part of a glyph run but has not yet
+ * been painted.
+ */
+typedef struct guac_rdp_glyph_run_entry {
+
+    /**
+     * The glyph being drawn.
+     */
+    guac_rdp_glyph* glyph;
+
+    /**
+     * The destination X coordinate of the upper-left corner of the glyph.
+     */
+    int x;
+
+    /**
+     * The destination Y coordinate of the upper-left corner of the glyph.
+     */
+    int y;
+
+} guac_rdp_glyph_run_entry;
+
+/**
+ * The glyphs drawn by a single GlyphIndex or FastGlyph order. Rather than
+ * painting each glyph separately, all glyphs within the run are combined into
+ * a single mask which is painted onto the current drawing surface in one
+ * operation once the order has been completely drawn.
+ */
+typedef struct guac_rdp_glyph_run {
+
+    /**
+     * All glyphs drawn since the run began.
+     */
+    guac_rdp_glyph_run_entry glyphs[GUAC_RDP_GLYPH_RUN_MAX_GLYPHS];
+
+    /**
+     * The number of glyphs within the glyphs array.
+     */
+    int count;
+
+    /**
+     * The X coordinate of the left edge of the bounding box of all glyphs
+     * within the run.
+     */
+    int left;
+
+    /**
+     * The Y coordinate of the top edge of the bounding box of all glyphs
+     * within the run.
+     */
+    int top;
+
+    /**
+     * The X coordinate of the right edge of the bounding box of all glyphs
+     * within the run, exclusive.
+     */
+    int right;
+
+    /**
+     * The Y coordinate of the bottom edge of the bounding box of all glyphs
+     * within the run, exclusive.
+     */
+    int bottom;
+
+    /**
+     * Buffer which receives the combined 8-bit alpha mask of all glyphs
+     * within the run. This buffer is reused between runs, growing as
+     * necessary, and may be NULL if no run has yet been painted.
+     */
+    unsigned char* mask;
+
+    /**
+     * The size of the mask buffer, in bytes.
+     */
+    size_t mask_size;
+
+} guac_rdp_glyph_run;
+
 /**
  * Caches the given glyph. Note that this caching currently only occurs server-
  * side, as it is more efficient to transmit the text as PNG.
@@ -75,7 +166,8 @@ BOOL guac_rdp_glyph_new(rdpContext* context, const rdpGlyph* glyph);
 
 /**
  * Draws a previously-cached glyph at the given coordinates within the current
- * drawing surface.
+ * drawing surface. The glyph is added to the current glyph run, and is not
+ * actually painted until the end of that run.
  *
  * @param context
  *     The rdpContext associated with the current RDP session.
@@ -129,8 +221,9 @@ void guac_rdp_glyph_free(rdpContext* context, rdpGlyph* glyph);
 
 /**
  * Called just prior to rendering a series of glyphs. After this function is
- * called, the glyphs will be individually rendered by calls to
- * guac_rdp_glyph_draw().
+ * called, the glyphs will be individually drawn by calls to
+ * guac_rdp_glyph_draw(), and are painted together once
+ * guac_rdp_glyph_enddraw() is called.
  *
  * @param context
  *     The rdpContext associated with the current RDP session.
@@ -174,10 +267,11 @@ BOOL guac_rdp_glyph_begindraw(rdpContext* context,
         UINT32 fgcolor, UINT32 bgcolor, BOOL redundant);
 
 /**
- * Called immediately after rendering a series of glyphs. Unlike
+ * Called immediately after rendering a series of glyphs, painting all glyphs
+ * drawn since guac_rdp_glyph_begindraw() was called. Unlike
  * guac_rdp_glyph_begindraw(), there is no way to detect through any invocation
- * of this function whether the background color is opaque or transparent. We
- * currently do NOT implement this function.
+ * of this function whether the background color is opaque or transparent, and
+ * the background rectangle provided is thus ignored.
  *
  * @param context
  *     The rdpContext associated with the current RDP session.
@@ -21,6 +21,7 @@
 #include "channels/rdpei.h"
 #include "common/cursor.h"
 #include "common/display.h"
+#include "common/input.h"
 #include "input.h"
 #include "keyboard.h"
 #include "rdp.h"
@@ -34,24 +35,27 @@
 
 #include <stdlib.h>
 
-int guac_rdp_user_mouse_handler(guac_user* user, int x, int y, int mask) {
-
-    guac_client* client = user->client;
-    guac_rdp_client* rdp_client = (guac_rdp_client*) client->data;
-
-    pthread_rwlock_rdlock(&(rdp_client->lock));
-
-    /* Skip if not yet connected */
-    freerdp* rdp_inst = rdp_client->rdp_inst;
-    if (rdp_inst == NULL)
-        goto complete;
-
-    /* Store current mouse location/state */
-    guac_common_cursor_update(rdp_client->display->cursor, user, x, y, mask);
-
-    /* Report mouse position within recording */
-    if (rdp_client->recording != NULL)
-        guac_recording_report_mouse(rdp_client->recording, x, y, mask);
+/**
+ * Sends the RDP input events necessary to move the mouse to the given
+ * position and update its button state to the given mask.
+ *
+ * @param rdp_client
+ *     The RDP client whose mouse state should be updated.
+ *
+ * @param rdp_inst
+ *     The FreeRDP instance to use to send input events.
+ *
+ * @param x
+ *     The X coordinate of the mouse pointer.
+ *
+ * @param y
+ *     The Y coordinate of the mouse pointer.
+ *
+ * @param mask
+ *     The mouse button mask.
+ */
+static void guac_rdp_send_mouse(guac_rdp_client* rdp_client, freerdp* rdp_inst,
+        int x, int y, int mask) {
 
     /* If button mask unchanged, just send move event */
     if (mask == rdp_client->mouse_button_mask) {
@@ -124,9 +128,60 @@ int guac_rdp_user_mouse_handler(guac_user* user, int x, int y, int mask) {
         rdp_client->mouse_button_mask = mask;
     }
 
+}
+
+void guac_rdp_input_forward(const guac_common_input_event* event, void* data) {
+
+    guac_client* client = (guac_client*) data;
+    guac_rdp_client* rdp_client = (guac_rdp_client*) client->data;
+
+    pthread_rwlock_rdlock(&(rdp_client->lock));
+
+    /* Skip if not yet connected */
+    freerdp* rdp_inst = rdp_client->rdp_inst;
+    if (rdp_inst == NULL)
+        goto complete;
+
+    /* Send mouse events directly */
+    if (event->type == GUAC_COMMON_INPUT_EVENT_MOUSE)
+        guac_rdp_send_mouse(rdp_client, rdp_inst, event->x, event->y,
+                event->mask);
+
+    /* Forward touch events along RDPEI channel */
+    else if (event->type == GUAC_COMMON_INPUT_EVENT_TOUCH)
+        guac_rdp_rdpei_touch_update(rdp_client->rdpei, event->id,
+                event->x, event->y, event->force);
+
 complete:
     pthread_rwlock_unlock(&(rdp_client->lock));
 
+}
+
+int guac_rdp_user_mouse_handler(guac_user* user, int x, int y, int mask) {
+
+    guac_client* client = user->client;
+    guac_rdp_client* rdp_client = (guac_rdp_client*) client->data;
+
+    pthread_rwlock_rdlock(&(rdp_client->lock));
+
+    /* Skip if not yet connected */
+    if (rdp_client->rdp_inst == NULL) {
+        pthread_rwlock_unlock(&(rdp_client->lock));
+        return 0;
+    }
+
+    /* Store current mouse location/state */
+    guac_common_cursor_update(rdp_client->display->cursor, user, x, y, mask);
+
+    /* Report mouse position within recording */
+    if (rdp_client->recording != NULL)
+        guac_recording_report_mouse(rdp_client->recording, x, y, mask);
+
+    pthread_rwlock_unlock(&(rdp_client->lock));
+
+    /* Send mouse events, combining any rapid motion */
+    guac_common_input_mouse(rdp_client->input, x, y, mask);
+
     return 0;
 }
 
@@ -139,21 +194,22 @@ int guac_rdp_user_touch_handler(guac_user* user, int id, int x, int y,
     pthread_rwlock_rdlock(&(rdp_client->lock));
 
     /* Skip if not yet connected */
-    freerdp* rdp_inst = rdp_client->rdp_inst;
-    if (rdp_inst == NULL)
-        goto complete;
+    if (rdp_client->rdp_inst == NULL) {
+        pthread_rwlock_unlock(&(rdp_client->lock));
+        return 0;
+    }
 
     /* Report touch event within recording */
     if (rdp_client->recording != NULL)
         guac_recording_report_touch(rdp_client->recording, id, x, y,
                 x_radius, y_radius, angle, force);
 
-    /* Forward touch event along RDPEI channel */
-    guac_rdp_rdpei_touch_update(rdp_client->rdpei, id, x, y, force);
-
-complete:
     pthread_rwlock_unlock(&(rdp_client->lock));
 
+    /* Forward touch events, combining any rapid motion */
+    guac_common_input_touch(rdp_client->input, id, x, y, x_radius, y_radius,
+            angle, force);
+
     return 0;
 }
 
@@ -163,6 +219,9 @@ int guac_rdp_user_key_handler(guac_user* user, int keysym, int pressed) {
     guac_rdp_client* rdp_client = (guac_rdp_client*) client->data;
     int retval = 0;
 
+    /* Send any combined motion before the key event */
+    guac_common_input_flush(rdp_client->input);
+
     pthread_rwlock_rdlock(&(rdp_client->lock));
 
     /* Report key state within recording */
@@ -20,8 +20,23 @@
 #ifndef GUAC_RDP_INPUT_H
 #define GUAC_RDP_INPUT_H
 
+#include "common/input.h"
+
 #include <guacamole/user.h>
 
+/**
+ * Forwards a mouse or touch event which has passed through the input
+ * coalescer of the RDP client to the RDP server. This function is a
+ * guac_common_input_handler.
+ *
+ * @param event
+ *     The event to forward.
+ *
+ * @param data
+ *     The guac_client associated with the RDP connection.
+ */
+void guac_rdp_input_forward(const guac_common_input_event* event, void* data);
+
 /**
  * Handler for Guacamole user mouse events.
  */
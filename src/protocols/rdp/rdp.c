@@ -490,6 +490,10 @@ static int guac_rdp_handle_connection(guac_client* client) {
      * heuristics) */
     guac_common_display_set_lossless(rdp_client->display, settings->lossless);
 
+    /* Limit the rate of shared cursor updates only if requested */
+    guac_common_cursor_set_update_interval(rdp_client->display->cursor,
+            settings->cursor_update_interval);
+
     rdp_client->current_surface = rdp_client->display->default_surface;
 
     rdp_client->available_svc = guac_common_list_alloc();
@@ -551,7 +555,8 @@ static int guac_rdp_handle_connection(guac_client* client) {
                 GUAC_RDP_FRAME_START_TIMEOUT);
         if (wait_result > 0) {
 
-            int processing_lag = guac_client_get_processing_lag(client);
+            int frame_delay = guac_common_display_get_frame_delay(
+                    rdp_client->display);
 
             /* Read server messages until frame is built */
             do {
@@ -586,7 +591,7 @@ static int guac_rdp_handle_connection(guac_client* client) {
 
                 /* Calculate time that client needs to catch up */
                 int time_elapsed = frame_end - frame_start;
-                int required_wait = processing_lag - time_elapsed;
+                int required_wait = frame_delay - time_elapsed;
 
                 /* Increase the duration of this frame if client is lagging */
                 if (required_wait > GUAC_RDP_FRAME_TIMEOUT)
@@ -621,10 +626,23 @@ static int guac_rdp_handle_connection(guac_client* client) {
         else if (!rdp_client->frames_supported || rdp_client->frames_received) {
             guac_common_display_flush(rdp_client->display);
             guac_client_end_multiple_frames(client, rdp_client->frames_received);
+
+            /* Periodically record full display state, if indexing */
+            if (rdp_client->recording != NULL)
+                guac_common_display_record_keyframe(rdp_client->display,
+                        rdp_client->recording);
+
             guac_socket_flush(client->socket);
             rdp_client->frames_received = 0;
         }
 
+        /* Otherwise, still send the latest position of the shared cursor,
+         * which would otherwise not be sent until the next frame */
+        else {
+            guac_common_cursor_flush(rdp_client->display->cursor);
+            guac_socket_flush(client->socket);
+        }
+
     }
 
     pthread_rwlock_wrlock(&(rdp_client->lock));
@@ -640,6 +658,10 @@ static int guac_rdp_handle_connection(guac_client* client) {
     freerdp_disconnect(rdp_inst);
     pthread_mutex_unlock(&(rdp_client->message_lock));
 
+    /* Discard any unpainted glyphs, which point into the glyph cache freed
+     * below */
+    rdp_client->glyph_run.count = 0;
+
     /* Clean up FreeRDP internal GDI implementation */
     gdi_free(rdp_inst);
 
@@ -718,7 +740,7 @@ void* guac_rdp_client_thread(void* data) {
         rdp_client->filesystem =
             guac_rdp_fs_alloc(client, settings->drive_path,
                     settings->create_drive_path, settings->disable_download,
-                    settings->disable_upload);
+                    settings->disable_upload, settings->download_window);
 
         /* Expose filesystem to owner */
         guac_client_for_owner(client, guac_rdp_fs_expose,
@@ -789,7 +811,8 @@ void* guac_rdp_client_thread(void* data) {
             guac_common_ssh_create_sftp_filesystem(rdp_client->sftp_session,
                     settings->sftp_root_directory, NULL,
                     settings->sftp_disable_download,
-                    settings->sftp_disable_upload);
+                    settings->sftp_disable_upload,
+                    settings->sftp_download_window);
 
         /* Expose filesystem to connection owner */
         guac_client_for_owner(client,
@@ -825,6 +848,12 @@ void* guac_rdp_client_thread(void* data) {
                 !settings->recording_exclude_mouse,
                 !settings->recording_exclude_touch,
                 settings->recording_include_keys);
+
+        /* Index recording, if requested */
+        if (rdp_client->recording != NULL && settings->recording_index)
+            guac_recording_enable_index(rdp_client->recording,
+                    GUAC_RECORDING_DEFAULT_KEYFRAME_INTERVAL);
+
     }
 
     /* Continue handling connections until error or client disconnect */
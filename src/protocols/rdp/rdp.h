@@ -26,10 +26,12 @@
 #include "channels/rdpei.h"
 #include "common/clipboard.h"
 #include "common/display.h"
+#include "common/input.h"
 #include "common/list.h"
 #include "common/surface.h"
 #include "config.h"
 #include "fs.h"
+#include "glyph.h"
 #include "keyboard.h"
 #include "print-job.h"
 #include "settings.h"
@@ -75,11 +77,23 @@ typedef struct guac_rdp_client {
      */
     int mouse_button_mask;
 
+    /**
+     * Coalescer which combines mouse and touch motion received from users
+     * before forwarding that motion to the RDP server.
+     */
+    guac_common_input* input;
+
     /**
      * Foreground color for any future glyphs.
      */
     uint32_t glyph_color;
 
+    /**
+     * The glyphs drawn since the current series of glyphs began, which will
+     * be painted together once that series ends.
+     */
+    guac_rdp_glyph_run glyph_run;
+
     /**
      * The display.
      */
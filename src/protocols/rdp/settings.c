@@ -19,6 +19,7 @@
 
 #include "argv.h"
 #include "common/defaults.h"
+#include "common/download.h"
 #include "common/string.h"
 #include "config.h"
 #include "resolution.h"
@@ -72,6 +73,7 @@ const char* GUAC_RDP_CLIENT_ARGS[] = {
     "create-drive-path",
     "disable-download",
     "disable-upload",
+    "download-window",
     "console",
     "console-audio",
     "server-layout",
@@ -113,6 +115,7 @@ const char* GUAC_RDP_CLIENT_ARGS[] = {
     "sftp-server-alive-interval",
     "sftp-disable-download",
     "sftp-disable-upload",
+    "sftp-download-window",
 #endif
 
     "recording-path",
@@ -121,6 +124,7 @@ const char* GUAC_RDP_CLIENT_ARGS[] = {
     "recording-exclude-mouse",
     "recording-exclude-touch",
     "recording-include-keys",
+    "recording-index",
     "create-recording-path",
     "resize-method",
     "enable-audio-input",
@@ -146,6 +150,7 @@ const char* GUAC_RDP_CLIENT_ARGS[] = {
 
     "force-lossless",
     "normalize-clipboard",
+    "cursor-update-interval",
     NULL
 };
 
@@ -260,6 +265,14 @@ enum RDP_ARGS_IDX {
      */
     IDX_DISABLE_UPLOAD,
 
+    /**
+     * The maximum number of blobs which may be sent along each download
+     * stream from the RDP drive without having been acknowledged. Larger
+     * values allow faster downloads over high-latency networks. By default,
+     * GUAC_COMMON_DOWNLOAD_DEFAULT_WINDOW blobs may be in flight.
+     */
+    IDX_DOWNLOAD_WINDOW,
+
     /**
      * "true" if this session is a console session, "false" or blank otherwise.
      */
@@ -511,6 +524,14 @@ enum RDP_ARGS_IDX {
      * blank otherwise.
      */
     IDX_SFTP_DISABLE_UPLOAD,
+
+    /**
+     * The maximum number of blobs which may be sent along each download
+     * stream from the SFTP server without having been acknowledged, if SFTP
+     * is configured and enabled. By default,
+     * GUAC_COMMON_DOWNLOAD_DEFAULT_WINDOW blobs may be in flight.
+     */
+    IDX_SFTP_DOWNLOAD_WINDOW,
 #endif
 
     /**
@@ -558,6 +579,15 @@ enum RDP_ARGS_IDX {
      */
     IDX_RECORDING_INCLUDE_KEYS,
 
+    /**
+     * Whether an index should be written alongside the session recording,
+     * allowing playback of the recording to begin at an arbitrary point in
+     * time. If enabled, the full state of the display is periodically
+     * written to the recording as a keyframe, and the location of each
+     * keyframe is noted within the index.
+     */
+    IDX_RECORDING_INDEX,
+
     /**
      * Whether the specified screen recording path should automatically be
      * created if it does not yet exist.
@@ -695,6 +725,13 @@ enum RDP_ARGS_IDX {
      */
     IDX_NORMALIZE_CLIPBOARD,
 
+    /**
+     * The minimum number of milliseconds between updates of the shared mouse
+     * cursor sent to each user that is not moving the cursor. If blank or
+     * zero, updates are sent with every frame.
+     */
+    IDX_CURSOR_UPDATE_INTERVAL,
+
     RDP_ARGS_COUNT
 };
 
@@ -865,6 +902,11 @@ guac_rdp_settings* guac_rdp_parse_args(guac_user* user,
         guac_user_parse_args_boolean(user, GUAC_RDP_CLIENT_ARGS, argv,
                 IDX_FORCE_LOSSLESS, 0);
 
+    /* Shared cursor update interval */
+    settings->cursor_update_interval =
+        guac_user_parse_args_int(user, GUAC_RDP_CLIENT_ARGS, argv,
+                IDX_CURSOR_UPDATE_INTERVAL, 0);
+
     /* Domain */
     settings->domain =
         guac_user_parse_args_string(user, GUAC_RDP_CLIENT_ARGS, argv,
@@ -1043,6 +1085,11 @@ guac_rdp_settings* guac_rdp_parse_args(guac_user* user,
         guac_user_parse_args_boolean(user, GUAC_RDP_CLIENT_ARGS, argv,
                 IDX_DISABLE_UPLOAD, 0);
 
+    /* Number of blobs in flight for each download over RDP */
+    settings->download_window =
+        guac_user_parse_args_int(user, GUAC_RDP_CLIENT_ARGS, argv,
+                IDX_DOWNLOAD_WINDOW, GUAC_COMMON_DOWNLOAD_DEFAULT_WINDOW);
+
     /* Pick keymap based on argument */
     settings->server_layout = NULL;
     if (argv[IDX_SERVER_LAYOUT][0] != '\0')
@@ -1124,6 +1171,11 @@ guac_rdp_settings* guac_rdp_parse_args(guac_user* user,
     settings->sftp_disable_upload =
         guac_user_parse_args_boolean(user, GUAC_RDP_CLIENT_ARGS, argv,
                 IDX_SFTP_DISABLE_UPLOAD, 0);
+
+    /* Number of blobs in flight for each download over SFTP */
+    settings->sftp_download_window =
+        guac_user_parse_args_int(user, GUAC_RDP_CLIENT_ARGS, argv,
+                IDX_SFTP_DOWNLOAD_WINDOW, GUAC_COMMON_DOWNLOAD_DEFAULT_WINDOW);
 #endif
 
     /* Read recording path */
@@ -1156,6 +1208,11 @@ guac_rdp_settings* guac_rdp_parse_args(guac_user* user,
         guac_user_parse_args_boolean(user, GUAC_RDP_CLIENT_ARGS, argv,
                 IDX_RECORDING_INCLUDE_KEYS, 0);
 
+    /* Parse recording index flag */
+    settings->recording_index =
+        guac_user_parse_args_boolean(user, GUAC_RDP_CLIENT_ARGS, argv,
+                IDX_RECORDING_INDEX, 0);
+
     /* Parse path creation flag */
     settings->create_recording_path =
         guac_user_parse_args_boolean(user, GUAC_RDP_CLIENT_ARGS, argv,
@@ -203,6 +203,13 @@ typedef struct guac_rdp_settings {
      */
     int lossless;
 
+    /**
+     * The minimum number of milliseconds between updates of the shared mouse
+     * cursor sent to each user that is not moving the cursor, or zero if
+     * updates should be sent with every frame.
+     */
+    int cursor_update_interval;
+
     /**
      * Whether audio is enabled.
      */
@@ -250,6 +257,12 @@ typedef struct guac_rdp_settings {
      */
     int disable_upload;
 
+    /**
+     * The maximum number of blobs which may be sent along each download
+     * stream over RDP without having been acknowledged.
+     */
+    int download_window;
+
     /**
      * Whether this session is a console session.
      */
@@ -506,6 +519,12 @@ typedef struct guac_rdp_settings {
      * Whether or not to disable file upload over SFTP.
      */
     int sftp_disable_upload;
+
+    /**
+     * The maximum number of blobs which may be sent along each download
+     * stream over SFTP without having been acknowledged.
+     */
+    int sftp_download_window;
 #endif
 
     /**
@@ -559,6 +578,13 @@ typedef struct guac_rdp_settings {
      */
     int recording_include_keys;
 
+    /**
+     * Non-zero if an index should be written alongside the session
+     * recording, allowing playback of the recording to begin at an arbitrary
+     * point in time, zero otherwise.
+     */
+    int recording_index;
+
     /**
      * The method to apply when the user's display changes size.
      */
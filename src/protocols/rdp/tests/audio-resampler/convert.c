@@ -0,0 +1,179 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "channels/audio-input/audio-resampler.h"
+
+#include <CUnit/CUnit.h>
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * The number of frames of test audio converted by each test.
+ */
+#define TEST_FRAMES 1000
+
+/**
+ * Returns the value of the given channel of the given frame of the test
+ * signal, a sawtooth wave spanning the full range of signed 16-bit samples
+ * and differing for each channel.
+ */
+static int16_t test_sample(int frame, int channel) {
+    return (int16_t) ((frame * 257 + channel * 12345) & 0xFFFF);
+}
+
+/**
+ * Converts TEST_FRAMES frames of the test signal from the given input format
+ * to the given output format, which must have the same rate, verifying that
+ * each output sample matches the value produced by the given mapping of
+ * input samples.
+ *
+ * @param in_channels
+ *     The number of channels in the input format.
+ *
+ * @param in_bps
+ *     The size of each input sample, in bytes.
+ *
+ * @param out_channels
+ *     The number of channels in the output format.
+ *
+ * @param out_bps
+ *     The size of each output sample, in bytes.
+ */
+static void test_convert(int in_channels, int in_bps, int out_channels,
+        int out_bps) {
+
+    guac_rdp_audio_format in_format = { 8000, in_channels, in_bps };
+    guac_rdp_audio_format out_format = { 8000, out_channels, out_bps };
+
+    guac_rdp_audio_resampler resampler;
+    CU_ASSERT_EQUAL_FATAL(guac_rdp_audio_resampler_init(&resampler,
+                &in_format, &out_format), 0);
+
+    static char in[TEST_FRAMES * GUAC_RDP_AUDIO_RESAMPLER_MAX_CHANNELS * 2];
+    static char out[TEST_FRAMES * GUAC_RDP_AUDIO_RESAMPLER_MAX_CHANNELS * 2];
+
+    /* Generate test signal in input format */
+    char* current = in;
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        for (int channel = 0; channel < in_channels; channel++) {
+            int16_t sample = test_sample(frame, channel);
+            if (in_bps == 2)
+                memcpy(current, &sample, sizeof(sample));
+            else
+                *current = sample >> 8;
+            current += in_bps;
+        }
+    }
+
+    int written = guac_rdp_audio_resampler_process(&resampler, in,
+            current - in, out, sizeof(out));
+
+    /* The final frame is withheld until the following frame is received */
+    CU_ASSERT_EQUAL_FATAL(written,
+            (TEST_FRAMES - 1) * out_channels * out_bps);
+
+    current = out;
+    for (int frame = 0; frame < TEST_FRAMES - 1; frame++) {
+        for (int channel = 0; channel < out_channels; channel++) {
+
+            /* Calculate expected value as 16-bit */
+            int expected;
+            if (in_channels == 2 && out_channels == 1) {
+                int left = test_sample(frame, 0);
+                int right = test_sample(frame, 1);
+                if (in_bps == 1) {
+                    left = (left >> 8) * 256;
+                    right = (right >> 8) * 256;
+                }
+                expected = (left + right) / 2;
+            }
+            else {
+                int in_channel = channel < in_channels ? channel : in_channels - 1;
+                expected = test_sample(frame, in_channel);
+                if (in_bps == 1)
+                    expected = (expected >> 8) * 256;
+            }
+
+            /* Read actual value */
+            int16_t actual;
+            if (out_bps == 2)
+                memcpy(&actual, current, sizeof(actual));
+            else {
+                actual = (int8_t) *current * 256;
+                expected = (expected >> 8) * 256;
+            }
+
+            if (actual != expected) {
+                CU_FAIL("Converted sample does not match expected value");
+                return;
+            }
+
+            current += out_bps;
+
+        }
+    }
+
+}
+
+/**
+ * Test which verifies that audio having the same rate as the output is
+ * translated between sample sizes and channel layouts without alteration
+ * beyond that required by the output format.
+ */
+void test_audio_resampler__convert() {
+
+    /* Sample size only */
+    test_convert(1, 2, 1, 2);
+    test_convert(2, 2, 2, 2);
+    test_convert(1, 1, 1, 2);
+    test_convert(1, 2, 1, 1);
+    test_convert(2, 1, 2, 1);
+
+    /* Channel mapping */
+    test_convert(1, 2, 2, 2);
+    test_convert(2, 2, 1, 2);
+    test_convert(2, 1, 1, 2);
+    test_convert(1, 1, 2, 1);
+    test_convert(4, 2, 2, 2);
+    test_convert(2, 2, 4, 1);
+
+}
+
+/**
+ * Test which verifies that unsupported formats are rejected.
+ */
+void test_audio_resampler__unsupported() {
+
+    guac_rdp_audio_resampler resampler;
+
+    guac_rdp_audio_format valid = { 44100, 2, 2 };
+    guac_rdp_audio_format no_rate = { 0, 2, 2 };
+    guac_rdp_audio_format no_channels = { 44100, 0, 2 };
+    guac_rdp_audio_format many_channels = { 44100,
+        GUAC_RDP_AUDIO_RESAMPLER_MAX_CHANNELS + 1, 2 };
+    guac_rdp_audio_format wide = { 44100, 2, 3 };
+
+    CU_ASSERT_EQUAL(guac_rdp_audio_resampler_init(&resampler, &valid, &valid), 0);
+    CU_ASSERT_NOT_EQUAL(guac_rdp_audio_resampler_init(&resampler, &no_rate, &valid), 0);
+    CU_ASSERT_NOT_EQUAL(guac_rdp_audio_resampler_init(&resampler, &valid, &no_channels), 0);
+    CU_ASSERT_NOT_EQUAL(guac_rdp_audio_resampler_init(&resampler, &many_channels, &valid), 0);
+    CU_ASSERT_NOT_EQUAL(guac_rdp_audio_resampler_init(&resampler, &valid, &wide), 0);
+
+}
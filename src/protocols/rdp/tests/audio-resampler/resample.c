@@ -0,0 +1,170 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "channels/audio-input/audio-resampler.h"
+
+#include <CUnit/CUnit.h>
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * The number of input frames of test audio resampled by each test.
+ */
+#define TEST_FRAMES 4800
+
+/**
+ * The maximum difference allowed between a resampled sample and the value
+ * produced by the reference resampler.
+ */
+#define TEST_TOLERANCE 2
+
+/**
+ * Returns the value of the given channel of the given frame of the test
+ * signal, a pair of sine waves of differing frequencies and amplitudes.
+ */
+static int16_t test_sample(int frame, int channel) {
+    double t = frame / 48000.0;
+    return (int16_t) (20000 * sin(2 * M_PI * 440 * t)
+            + 10000 * sin(2 * M_PI * (1000 + channel * 500) * t));
+}
+
+/**
+ * Returns the value of the given channel of the given output frame as
+ * produced by a straightforward floating-point linear interpolation of the
+ * test signal, or INT32_MIN if the output frame lies beyond the available
+ * input.
+ */
+static int32_t test_reference_sample(int in_rate, int out_rate, int frame,
+        int channel) {
+
+    double position = (double) frame * in_rate / out_rate;
+    int index = (int) position;
+    if (index + 1 >= TEST_FRAMES)
+        return INT32_MIN;
+
+    double fraction = position - index;
+    double before = test_sample(index, channel);
+    double after = test_sample(index + 1, channel);
+
+    return (int32_t) (before + (after - before) * fraction);
+
+}
+
+/**
+ * Resamples the stereo 16-bit test signal from the given input rate to the
+ * given output rate, providing the input in blocks of the given size, and
+ * verifies the result against the reference resampler.
+ *
+ * @param in_rate
+ *     The sample rate of the input.
+ *
+ * @param out_rate
+ *     The sample rate of the output.
+ *
+ * @param block_size
+ *     The number of bytes of input to provide to the resampler at a time.
+ *     This need not be a multiple of the size of a frame.
+ */
+static void test_resample(int in_rate, int out_rate, int block_size) {
+
+    guac_rdp_audio_format in_format = { in_rate, 2, 2 };
+    guac_rdp_audio_format out_format = { out_rate, 2, 2 };
+
+    guac_rdp_audio_resampler resampler;
+    CU_ASSERT_EQUAL_FATAL(guac_rdp_audio_resampler_init(&resampler,
+                &in_format, &out_format), 0);
+
+    static int16_t in[TEST_FRAMES * 2];
+    static int16_t out[TEST_FRAMES * 2 * 8];
+
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        in[frame * 2]     = test_sample(frame, 0);
+        in[frame * 2 + 1] = test_sample(frame, 1);
+    }
+
+    /* Resample entire test signal, one block at a time */
+    const char* current = (const char*) in;
+    int remaining = sizeof(in);
+    int written = 0;
+    while (remaining > 0) {
+
+        int length = block_size;
+        if (length > remaining)
+            length = remaining;
+
+        written += guac_rdp_audio_resampler_process(&resampler, current,
+                length, ((char*) out) + written, sizeof(out) - written);
+
+        current += length;
+        remaining -= length;
+
+    }
+
+    int out_frames = written / 4;
+
+    /* All output frames available from the input should be produced */
+    CU_ASSERT_EQUAL(test_reference_sample(in_rate, out_rate,
+                out_frames - 1, 0) == INT32_MIN, 0);
+    CU_ASSERT_EQUAL(test_reference_sample(in_rate, out_rate,
+                out_frames, 0), INT32_MIN);
+
+    for (int frame = 0; frame < out_frames; frame++) {
+        for (int channel = 0; channel < 2; channel++) {
+
+            int32_t expected = test_reference_sample(in_rate, out_rate,
+                    frame, channel);
+
+            int32_t actual = out[frame * 2 + channel];
+            if (abs(actual - expected) > TEST_TOLERANCE) {
+                CU_FAIL("Resampled audio differs from reference");
+                return;
+            }
+
+        }
+    }
+
+}
+
+/**
+ * Test which verifies that resampling between common rates produces the same
+ * result as a floating-point reference resampler, regardless of how the input
+ * is split into blocks.
+ */
+void test_audio_resampler__resample() {
+
+    int rates[][2] = {
+        { 48000, 44100 },
+        { 44100, 48000 },
+        { 48000, 22050 },
+        { 22050, 44100 },
+        {  8000, 48000 },
+        { 48000,  8000 },
+        { 44100, 44100 }
+    };
+
+    int block_sizes[] = { 1, 3, 4, 1022, 4096, TEST_FRAMES * 4 };
+
+    for (int i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        for (int j = 0; j < sizeof(block_sizes) / sizeof(block_sizes[0]); j++)
+            test_resample(rates[i][0], rates[i][1], block_sizes[j]);
+    }
+
+}
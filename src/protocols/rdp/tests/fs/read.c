@@ -0,0 +1,124 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "fs.h"
+
+#include <CUnit/CUnit.h>
+#include <guacamole/client.h>
+#include <winpr/file.h>
+#include <winpr/nt.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * The size of the test file, in bytes. This is deliberately larger than
+ * GUAC_RDP_FS_READ_AHEAD_SIZE and not a multiple of any read size used.
+ */
+#define TEST_FILE_SIZE 3000001
+
+/**
+ * The distance between each read performed while reading backwards through
+ * the test file, in bytes.
+ */
+#define TEST_BACKWARD_STEP 123457
+
+/**
+ * Returns the byte expected at the given offset within the test file.
+ */
+static unsigned char test_byte(uint64_t offset) {
+    return (unsigned char) ((offset * 31) ^ (offset >> 8));
+}
+
+/**
+ * Test which verifies that guac_rdp_fs_read() returns the correct data for
+ * both sequential and random reads, independent of any read-ahead.
+ */
+void test_fs__read() {
+
+    char path[] = "/tmp/guac-test-rdp-fs-XXXXXX";
+    CU_ASSERT_PTR_NOT_NULL_FATAL(mkdtemp(path));
+
+    char filename[sizeof(path) + 16];
+    snprintf(filename, sizeof(filename), "%s/file", path);
+
+    /* Create test file */
+    FILE* test_file = fopen(filename, "w");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(test_file);
+    for (uint64_t i = 0; i < TEST_FILE_SIZE; i++)
+        fputc(test_byte(i), test_file);
+    fclose(test_file);
+
+    guac_client* client = guac_client_alloc();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(client);
+
+    guac_rdp_fs* fs = guac_rdp_fs_alloc(client, path, 0, 0, 0, 0);
+    int file_id = guac_rdp_fs_open(fs, "\\file", GENERIC_READ, 0,
+            FILE_OPEN, 0);
+    CU_ASSERT_FATAL(file_id >= 0);
+
+    static unsigned char buffer[65536];
+
+    /* Read entire file sequentially in odd-sized chunks */
+    uint64_t offset = 0;
+    int bytes_read;
+    while ((bytes_read = guac_rdp_fs_read(fs, file_id, offset, buffer,
+                    65521)) > 0) {
+
+        for (int i = 0; i < bytes_read; i++) {
+            if (buffer[i] != test_byte(offset + i)) {
+                CU_FAIL("Sequential read returned incorrect data");
+                break;
+            }
+        }
+
+        offset += bytes_read;
+
+    }
+
+    CU_ASSERT_EQUAL(bytes_read, 0);
+    CU_ASSERT_EQUAL(offset, TEST_FILE_SIZE);
+
+    /* Read backwards through the file, stopping before the offset would
+     * drop below zero */
+    for (offset = TEST_FILE_SIZE - 1000; offset >= TEST_BACKWARD_STEP + 1000;
+            offset -= TEST_BACKWARD_STEP) {
+
+        bytes_read = guac_rdp_fs_read(fs, file_id, offset, buffer, 1000);
+        CU_ASSERT_EQUAL_FATAL(bytes_read, 1000);
+
+        for (int i = 0; i < bytes_read; i++) {
+            if (buffer[i] != test_byte(offset + i)) {
+                CU_FAIL("Random read returned incorrect data");
+                break;
+            }
+        }
+
+    }
+
+    guac_rdp_fs_close(fs, file_id);
+    guac_rdp_fs_free(fs);
+    guac_client_free(client);
+
+    unlink(filename);
+    rmdir(path);
+
+}
@@ -22,6 +22,7 @@
 #include "argv.h"
 #include "client.h"
 #include "common/defaults.h"
+#include "common/download.h"
 #include "settings.h"
 #include "terminal/terminal.h"
 
@@ -46,6 +47,7 @@ const char* GUAC_SSH_CLIENT_ARGS[] = {
     "sftp-root-directory",
     "sftp-disable-download",
     "sftp-disable-upload",
+    "sftp-download-window",
     "private-key",
     "passphrase",
     "public-key",
@@ -140,6 +142,13 @@ enum SSH_ARGS_IDX {
      */
     IDX_SFTP_DISABLE_UPLOAD,
 
+    /**
+     * The maximum number of blobs which may be sent along each download
+     * stream from the SFTP server without having been acknowledged. By
+     * default, GUAC_COMMON_DOWNLOAD_DEFAULT_WINDOW blobs may be in flight.
+     */
+    IDX_SFTP_DOWNLOAD_WINDOW,
+
     /**
      * The private key to use for authentication, if any.
      */
@@ -429,6 +438,11 @@ guac_ssh_settings* guac_ssh_parse_args(guac_user* user,
         guac_user_parse_args_boolean(user, GUAC_SSH_CLIENT_ARGS, argv,
                 IDX_SFTP_DISABLE_UPLOAD, false);
 
+    /* Number of blobs in flight for each download. */
+    settings->sftp_download_window =
+        guac_user_parse_args_int(user, GUAC_SSH_CLIENT_ARGS, argv,
+                IDX_SFTP_DOWNLOAD_WINDOW, GUAC_COMMON_DOWNLOAD_DEFAULT_WINDOW);
+
 #ifdef ENABLE_SSH_AGENT
     settings->enable_agent =
         guac_user_parse_args_boolean(user, GUAC_SSH_CLIENT_ARGS, argv,
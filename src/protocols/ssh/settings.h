@@ -184,6 +184,12 @@ typedef struct guac_ssh_settings {
      */
     bool sftp_disable_upload;
 
+    /**
+     * The maximum number of blobs which may be sent along each download
+     * stream over SFTP without having been acknowledged.
+     */
+    int sftp_download_window;
+
 #ifdef ENABLE_SSH_AGENT
     /**
      * Whether the SSH agent is enabled.
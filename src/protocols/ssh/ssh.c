@@ -378,7 +378,8 @@ void* ssh_client_thread(void* data) {
         ssh_client->sftp_filesystem = guac_common_ssh_create_sftp_filesystem(
                     ssh_client->sftp_session, settings->sftp_root_directory,
                     NULL, settings->sftp_disable_download,
-                    settings->sftp_disable_upload);
+                    settings->sftp_disable_upload,
+                    settings->sftp_download_window);
 
         /* Expose filesystem to connection owner */
         guac_client_for_owner(client,
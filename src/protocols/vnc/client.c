@@ -20,6 +20,8 @@
 #include "config.h"
 
 #include "client.h"
+#include "common/input.h"
+#include "input.h"
 #include "user.h"
 #include "vnc.h"
 
@@ -114,6 +116,10 @@ int guac_client_init(guac_client* client) {
     /* Init clipboard */
     vnc_client->clipboard = guac_common_clipboard_alloc();
 
+    /* Init coalescing of mouse input */
+    vnc_client->input = guac_common_input_alloc(client,
+            guac_vnc_input_forward, client);
+
     /* Set handlers */
     client->join_handler = guac_vnc_user_join_handler;
     client->join_pending_handler = guac_vnc_join_pending_handler;
@@ -128,6 +134,9 @@ int guac_vnc_client_free_handler(guac_client* client) {
     guac_vnc_client* vnc_client = (guac_vnc_client*) client->data;
     guac_vnc_settings* settings = vnc_client->settings;
 
+    /* Stop coalescing input before the VNC client is cleaned up */
+    guac_common_input_free(vnc_client->input);
+
     /* Clean up VNC client*/
     rfbClient* rfb_client = vnc_client->rfb_client;
     if (rfb_client != NULL) {
@@ -166,6 +175,9 @@ int guac_vnc_client_free_handler(guac_client* client) {
 
     }
 
+    /* Free pixel format conversion buffers */
+    guac_vnc_pixel_converter_destroy(&vnc_client->converter);
+
 #ifdef ENABLE_COMMON_SSH
     /* Free SFTP filesystem, if loaded */
     if (vnc_client->sftp_filesystem)
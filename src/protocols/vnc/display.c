@@ -22,6 +22,7 @@
 #include "client.h"
 #include "common/iconv.h"
 #include "common/surface.h"
+#include "pixel-format.h"
 #include "vnc.h"
 
 #include <cairo/cairo.h>
@@ -33,34 +34,18 @@
 #include <rfb/rfbclient.h>
 #include <rfb/rfbproto.h>
 
-/* Define cairo_format_stride_for_width() if missing */
-#ifndef HAVE_CAIRO_FORMAT_STRIDE_FOR_WIDTH
-#define cairo_format_stride_for_width(format, width) (width*4)
-#endif
-
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <syslog.h>
 
 void guac_vnc_update(rfbClient* client, int x, int y, int w, int h) {
 
     guac_client* gc = rfbClientGetClientData(client, GUAC_VNC_CLIENT_KEY);
     guac_vnc_client* vnc_client = (guac_vnc_client*) gc->data;
-
-    int dx, dy;
-
-    /* Cairo image buffer */
-    int stride;
-    unsigned char* buffer;
-    unsigned char* buffer_row_current;
-    cairo_surface_t* surface;
-
-    /* VNC framebuffer */
-    unsigned int bpp;
-    unsigned int fb_stride;
-    unsigned char* fb_row_current;
+    guac_vnc_pixel_converter* converter = &vnc_client->converter;
 
     /* Ignore extra update if already handled by copyrect */
     if (vnc_client->copy_rect_used) {
@@ -68,66 +53,14 @@ void guac_vnc_update(rfbClient* client, int x, int y, int w, int h) {
         return;
     }
 
-    /* Init Cairo buffer */
-    stride = cairo_format_stride_for_width(CAIRO_FORMAT_RGB24, w);
-    buffer = guac_mem_alloc(h, stride);
-    buffer_row_current = buffer;
-
-    bpp = client->format.bitsPerPixel/8;
-    fb_stride = bpp * client->width;
-    fb_row_current = client->frameBuffer + (y * fb_stride) + (x * bpp);
-
-    /* Copy image data from VNC client to PNG */
-    for (dy = y; dy<y+h; dy++) {
-
-        unsigned int*  buffer_current;
-        unsigned char* fb_current;
-        
-        /* Get current buffer row, advance to next */
-        buffer_current      = (unsigned int*) buffer_row_current;
-        buffer_row_current += stride;
-
-        /* Get current framebuffer row, advance to next */
-        fb_current      = fb_row_current;
-        fb_row_current += fb_stride;
-
-        for (dx = x; dx<x+w; dx++) {
-
-            unsigned char red, green, blue;
-            unsigned int v;
-
-            switch (bpp) {
-                case 4:
-                    v = *((uint32_t*)  fb_current);
-                    break;
-
-                case 2:
-                    v = *((uint16_t*) fb_current);
-                    break;
+    /* Reselect conversion strategy if the pixel format has changed */
+    if (memcmp(&converter->format, &client->format, sizeof(rfbPixelFormat)))
+        guac_vnc_pixel_converter_init(converter, &client->format,
+                vnc_client->settings->swap_red_blue);
 
-                default:
-                    v = *((uint8_t*)  fb_current);
-            }
-
-            /* Translate value to RGB */
-            red   = (v >> client->format.redShift)   * 0x100 / (client->format.redMax  + 1);
-            green = (v >> client->format.greenShift) * 0x100 / (client->format.greenMax+ 1);
-            blue  = (v >> client->format.blueShift)  * 0x100 / (client->format.blueMax + 1);
-
-            /* Output RGB */
-            if (vnc_client->settings->swap_red_blue)
-                *(buffer_current++) = (blue << 16) | (green << 8) | red;
-            else
-                *(buffer_current++) = (red  << 16) | (green << 8) | blue;
-
-            fb_current += bpp;
-
-        }
-    }
-
-    /* Create surface from decoded buffer */
-    surface = cairo_image_surface_create_for_data(buffer, CAIRO_FORMAT_RGB24,
-            w, h, stride);
+    /* Convert image data from VNC framebuffer */
+    cairo_surface_t* surface = guac_vnc_pixel_converter_convert(converter,
+            client, x, y, w, h);
 
     /* Draw directly to default layer */
     guac_common_surface_draw(vnc_client->display->default_surface,
@@ -135,7 +68,6 @@ void guac_vnc_update(rfbClient* client, int x, int y, int w, int h) {
 
     /* Free surface */
     cairo_surface_destroy(surface);
-    guac_mem_free(buffer);
 
 }
 
@@ -154,6 +86,10 @@ void guac_vnc_copyrect(rfbClient* client, int src_x, int src_y, int w, int h, in
 }
 
 void guac_vnc_set_pixel_format(rfbClient* client, int color_depth) {
+
+    guac_client* gc = rfbClientGetClientData(client, GUAC_VNC_CLIENT_KEY);
+    guac_vnc_client* vnc_client = (guac_vnc_client*) gc->data;
+
     client->format.trueColour = 1;
     switch(color_depth) {
         case 8:
@@ -190,6 +126,11 @@ void guac_vnc_set_pixel_format(rfbClient* client, int color_depth) {
             client->format.redMax       = 0xff;
             client->format.greenMax     = 0xff;
     }
+
+    /* Select the conversion strategy for the requested format */
+    guac_vnc_pixel_converter_init(&vnc_client->converter, &client->format,
+            vnc_client->settings->swap_red_blue);
+
 }
 
 rfbBool guac_vnc_malloc_framebuffer(rfbClient* rfb_client) {
@@ -21,17 +21,30 @@
 
 #include "common/cursor.h"
 #include "common/display.h"
+#include "common/input.h"
+#include "input.h"
 #include "vnc.h"
 
 #include <guacamole/recording.h>
 #include <guacamole/user.h>
 #include <rfb/rfbclient.h>
 
+void guac_vnc_input_forward(const guac_common_input_event* event, void* data) {
+
+    guac_client* client = (guac_client*) data;
+    guac_vnc_client* vnc_client = (guac_vnc_client*) client->data;
+    rfbClient* rfb_client = vnc_client->rfb_client;
+
+    /* Send VNC event only if finished connecting */
+    if (rfb_client != NULL && event->type == GUAC_COMMON_INPUT_EVENT_MOUSE)
+        SendPointerEvent(rfb_client, event->x, event->y, event->mask);
+
+}
+
 int guac_vnc_user_mouse_handler(guac_user* user, int x, int y, int mask) {
 
     guac_client* client = user->client;
     guac_vnc_client* vnc_client = (guac_vnc_client*) client->data;
-    rfbClient* rfb_client = vnc_client->rfb_client;
 
     /* Store current mouse location/state */
     guac_common_cursor_update(vnc_client->display->cursor, user, x, y, mask);
@@ -40,9 +53,8 @@ int guac_vnc_user_mouse_handler(guac_user* user, int x, int y, int mask) {
     if (vnc_client->recording != NULL)
         guac_recording_report_mouse(vnc_client->recording, x, y, mask);
 
-    /* Send VNC event only if finished connecting */
-    if (rfb_client != NULL)
-        SendPointerEvent(rfb_client, x, y, mask);
+    /* Send VNC event, combining any rapid motion */
+    guac_common_input_mouse(vnc_client->input, x, y, mask);
 
     return 0;
 }
@@ -52,6 +64,9 @@ int guac_vnc_user_key_handler(guac_user* user, int keysym, int pressed) {
     guac_vnc_client* vnc_client = (guac_vnc_client*) user->client->data;
     rfbClient* rfb_client = vnc_client->rfb_client;
 
+    /* Send any combined motion before the key event */
+    guac_common_input_flush(vnc_client->input);
+
     /* Report key state within recording */
     if (vnc_client->recording != NULL)
         guac_recording_report_key(vnc_client->recording,
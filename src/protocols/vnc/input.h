@@ -23,8 +23,22 @@
 
 #include "config.h"
 
+#include "common/input.h"
+
 #include <guacamole/user.h>
 
+/**
+ * Sends the given mouse event to the VNC server, if connected. This is the
+ * handler invoked by the guac_common_input coalescer of the VNC client.
+ *
+ * @param event
+ *     The mouse event to send.
+ *
+ * @param data
+ *     The guac_client associated with the VNC connection.
+ */
+void guac_vnc_input_forward(const guac_common_input_event* event, void* data);
+
 /**
  * Handler for Guacamole user mouse events.
  */
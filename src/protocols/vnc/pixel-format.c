@@ -0,0 +1,331 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "config.h"
+
+#include "pixel-format.h"
+
+#include <cairo/cairo.h>
+#include <guacamole/mem.h>
+#include <rfb/rfbclient.h>
+#include <rfb/rfbproto.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* Define cairo_format_stride_for_width() if missing */
+#ifndef HAVE_CAIRO_FORMAT_STRIDE_FOR_WIDTH
+#define cairo_format_stride_for_width(format, width) (width*4)
+#endif
+
+/**
+ * Converts a single pixel value from the given VNC pixel format to RGB24,
+ * scaling each component to the full 8-bit range.
+ *
+ * @param format
+ *     The pixel format of the given value.
+ *
+ * @param swap_red_blue
+ *     Non-zero if the red and blue components should be swapped, zero
+ *     otherwise.
+ *
+ * @param v
+ *     The pixel value to convert.
+ *
+ * @return
+ *     The equivalent RGB24 pixel.
+ */
+static uint32_t guac_vnc_convert_pixel(const rfbPixelFormat* format,
+        int swap_red_blue, unsigned int v) {
+
+    /* Translate value to RGB */
+    uint32_t red   = ((v >> format->redShift)   & format->redMax)   * 0x100 / (format->redMax   + 1);
+    uint32_t green = ((v >> format->greenShift) & format->greenMax) * 0x100 / (format->greenMax + 1);
+    uint32_t blue  = ((v >> format->blueShift)  & format->blueMax)  * 0x100 / (format->blueMax  + 1);
+
+    if (swap_red_blue)
+        return (blue << 16) | (green << 8) | red;
+
+    return (red << 16) | (green << 8) | blue;
+
+}
+
+/**
+ * Row conversion handler for pixel formats which have no more specific
+ * handler, converting each pixel independently with
+ * guac_vnc_convert_pixel().
+ */
+static void guac_vnc_convert_row_generic(
+        const guac_vnc_pixel_converter* converter,
+        const unsigned char* src, uint32_t* dst, int width) {
+
+    const rfbPixelFormat* format = &converter->format;
+    int swap_red_blue = converter->swap_red_blue;
+    int bpp = converter->bpp;
+
+    for (int i = 0; i < width; i++) {
+
+        unsigned int v;
+
+        switch (bpp) {
+            case 4:
+                v = *((uint32_t*) src);
+                break;
+
+            case 2:
+                v = *((uint16_t*) src);
+                break;
+
+            default:
+                v = *((uint8_t*) src);
+        }
+
+        *(dst++) = guac_vnc_convert_pixel(format, swap_red_blue, v);
+        src += bpp;
+
+    }
+
+}
+
+/**
+ * Row conversion handler for 8-bit pixels, translating each pixel through
+ * the converter's lookup table.
+ */
+static void guac_vnc_convert_row_8(const guac_vnc_pixel_converter* converter,
+        const unsigned char* src, uint32_t* dst, int width) {
+
+    const uint32_t* lookup = converter->lookup;
+
+    for (int i = 0; i < width; i++)
+        dst[i] = lookup[src[i]];
+
+}
+
+/**
+ * Row conversion handler for 16-bit pixels, translating each pixel through
+ * the converter's lookup table.
+ */
+static void guac_vnc_convert_row_16(const guac_vnc_pixel_converter* converter,
+        const unsigned char* src, uint32_t* dst, int width) {
+
+    const uint32_t* lookup = converter->lookup;
+    const uint16_t* current = (const uint16_t*) src;
+
+    for (int i = 0; i < width; i++)
+        dst[i] = lookup[current[i]];
+
+}
+
+/**
+ * Row conversion handler for 32-bit pixels having 8 bits per component,
+ * where each component need only be shifted into place.
+ */
+static void guac_vnc_convert_row_32(const guac_vnc_pixel_converter* converter,
+        const unsigned char* src, uint32_t* dst, int width) {
+
+    const uint32_t* current = (const uint32_t*) src;
+
+    int red_shift   = converter->red_shift;
+    int green_shift = converter->green_shift;
+    int blue_shift  = converter->blue_shift;
+
+    for (int i = 0; i < width; i++) {
+        uint32_t v = current[i];
+        dst[i] = (((v >> red_shift)   & 0xFF) << 16)
+               | (((v >> green_shift) & 0xFF) << 8)
+               |  ((v >> blue_shift)  & 0xFF);
+    }
+
+}
+
+#ifdef __SSE2__
+/**
+ * Row conversion handler for 32-bit pixels having 8 bits per component,
+ * identical to guac_vnc_convert_row_32() but converting four pixels at a time
+ * using SSE2.
+ */
+static void guac_vnc_convert_row_32_sse2(
+        const guac_vnc_pixel_converter* converter,
+        const unsigned char* src, uint32_t* dst, int width) {
+
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    const __m128i red_shift   = _mm_cvtsi32_si128(converter->red_shift);
+    const __m128i green_shift = _mm_cvtsi32_si128(converter->green_shift);
+    const __m128i blue_shift  = _mm_cvtsi32_si128(converter->blue_shift);
+
+    int i;
+    for (i = 0; i + 4 <= width; i += 4) {
+
+        __m128i v = _mm_loadu_si128((const __m128i*) (src + i * 4));
+
+        __m128i red   = _mm_and_si128(_mm_srl_epi32(v, red_shift),   mask);
+        __m128i green = _mm_and_si128(_mm_srl_epi32(v, green_shift), mask);
+        __m128i blue  = _mm_and_si128(_mm_srl_epi32(v, blue_shift),  mask);
+
+        __m128i rgb = _mm_or_si128(
+                _mm_or_si128(_mm_slli_epi32(red, 16), _mm_slli_epi32(green, 8)),
+                blue);
+
+        _mm_storeu_si128((__m128i*) (dst + i), rgb);
+
+    }
+
+    /* Convert any remaining pixels individually */
+    guac_vnc_convert_row_32(converter, src + i * 4, dst + i, width - i);
+
+}
+#endif
+
+/**
+ * Builds a lookup table mapping each of the given number of possible pixel
+ * values to its RGB24 equivalent, storing the table within the converter.
+ *
+ * @param converter
+ *     The converter whose format and settings define the contents of the
+ *     lookup table.
+ *
+ * @param entries
+ *     The number of possible pixel values.
+ */
+static void guac_vnc_build_lookup(guac_vnc_pixel_converter* converter,
+        unsigned int entries) {
+
+    uint32_t* lookup = guac_mem_alloc(entries, sizeof(uint32_t));
+
+    for (unsigned int v = 0; v < entries; v++)
+        lookup[v] = guac_vnc_convert_pixel(&converter->format,
+                converter->swap_red_blue, v);
+
+    converter->lookup = lookup;
+
+}
+
+void guac_vnc_pixel_converter_init(guac_vnc_pixel_converter* converter,
+        const rfbPixelFormat* format, int swap_red_blue) {
+
+    /* Discard any lookup table built for a previous format */
+    guac_mem_free(converter->lookup);
+
+    converter->format = *format;
+    converter->swap_red_blue = swap_red_blue;
+    converter->bpp = format->bitsPerPixel / 8;
+    converter->direct = 0;
+    converter->convert_row = guac_vnc_convert_row_generic;
+
+    switch (converter->bpp) {
+
+        /* Translate 8-bit and 16-bit pixels entirely via lookup table */
+        case 1:
+            guac_vnc_build_lookup(converter, 0x100);
+            converter->convert_row = guac_vnc_convert_row_8;
+            break;
+
+        case 2:
+            guac_vnc_build_lookup(converter, 0x10000);
+            converter->convert_row = guac_vnc_convert_row_16;
+            break;
+
+        /* 32-bit pixels with 8 bits per component need only be shifted */
+        case 4:
+
+            if (format->redMax != 0xFF || format->greenMax != 0xFF
+                    || format->blueMax != 0xFF)
+                break;
+
+            converter->green_shift = format->greenShift;
+            if (swap_red_blue) {
+                converter->red_shift  = format->blueShift;
+                converter->blue_shift = format->redShift;
+            }
+            else {
+                converter->red_shift  = format->redShift;
+                converter->blue_shift = format->blueShift;
+            }
+
+            /* No conversion at all is needed if already RGB24 */
+            if (converter->red_shift == 16 && converter->green_shift == 8
+                    && converter->blue_shift == 0) {
+                converter->direct = 1;
+                converter->convert_row = NULL;
+            }
+
+#ifdef __SSE2__
+            else
+                converter->convert_row = guac_vnc_convert_row_32_sse2;
+#else
+            else
+                converter->convert_row = guac_vnc_convert_row_32;
+#endif
+
+            break;
+
+    }
+
+}
+
+void guac_vnc_pixel_converter_destroy(guac_vnc_pixel_converter* converter) {
+    guac_mem_free(converter->lookup);
+    guac_mem_free(converter->buffer);
+    converter->buffer_size = 0;
+}
+
+cairo_surface_t* guac_vnc_pixel_converter_convert(
+        guac_vnc_pixel_converter* converter, rfbClient* client,
+        int x, int y, int w, int h) {
+
+    int bpp = converter->bpp;
+    int fb_stride = bpp * client->width;
+    unsigned char* fb_row_current = client->frameBuffer
+        + (y * fb_stride) + (x * bpp);
+
+    /* Draw directly from framebuffer if already in the correct format */
+    if (converter->direct)
+        return cairo_image_surface_create_for_data(fb_row_current,
+                CAIRO_FORMAT_RGB24, w, h, fb_stride);
+
+    /* Grow conversion buffer if necessary */
+    int stride = cairo_format_stride_for_width(CAIRO_FORMAT_RGB24, w);
+    size_t size = guac_mem_ckd_mul_or_die(h, stride);
+    if (size > converter->buffer_size) {
+        guac_mem_free(converter->buffer);
+        converter->buffer = guac_mem_alloc(size);
+        converter->buffer_size = size;
+    }
+
+    /* Convert image data from VNC framebuffer row by row */
+    unsigned char* buffer_row_current = converter->buffer;
+    for (int dy = 0; dy < h; dy++) {
+
+        converter->convert_row(converter, fb_row_current,
+                (uint32_t*) buffer_row_current, w);
+
+        buffer_row_current += stride;
+        fb_row_current += fb_stride;
+
+    }
+
+    return cairo_image_surface_create_for_data(converter->buffer,
+            CAIRO_FORMAT_RGB24, w, h, stride);
+
+}
@@ -0,0 +1,196 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_VNC_PIXEL_FORMAT_H
+#define GUAC_VNC_PIXEL_FORMAT_H
+
+#include "config.h"
+
+#include <cairo/cairo.h>
+#include <rfb/rfbclient.h>
+#include <rfb/rfbproto.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct guac_vnc_pixel_converter guac_vnc_pixel_converter;
+
+/**
+ * Handler which converts a single row of VNC framebuffer pixels into the
+ * 32-bit RGB layout expected by cairo (CAIRO_FORMAT_RGB24).
+ *
+ * @param converter
+ *     The converter whose pixel format describes the source pixels.
+ *
+ * @param src
+ *     The first pixel of the row within the VNC framebuffer.
+ *
+ * @param dst
+ *     The buffer which should receive the converted pixels.
+ *
+ * @param width
+ *     The number of pixels in the row.
+ */
+typedef void guac_vnc_convert_row_handler(
+        const guac_vnc_pixel_converter* converter,
+        const unsigned char* src, uint32_t* dst, int width);
+
+/**
+ * Conversion state for translating VNC framebuffer contents into cairo image
+ * data. The conversion strategy is selected once, based on the pixel format
+ * of the VNC framebuffer, rather than being decided for each pixel.
+ */
+struct guac_vnc_pixel_converter {
+
+    /**
+     * The pixel format of the VNC framebuffer that this converter was
+     * initialized for.
+     */
+    rfbPixelFormat format;
+
+    /**
+     * Whether the red and blue components should be swapped.
+     */
+    int swap_red_blue;
+
+    /**
+     * The number of bytes per pixel within the VNC framebuffer.
+     */
+    int bpp;
+
+    /**
+     * Non-zero if the VNC framebuffer is already in cairo's RGB24 layout,
+     * in which case no conversion is necessary and the framebuffer can be
+     * drawn directly.
+     */
+    int direct;
+
+    /**
+     * The handler which converts each row of pixels, or NULL if no
+     * conversion is necessary.
+     */
+    guac_vnc_convert_row_handler* convert_row;
+
+    /**
+     * The number of bits each 32-bit pixel must be shifted right such that
+     * the component which will become the output red component occupies the
+     * least significant 8 bits. This is only applicable to 32-bit pixels
+     * having 8 bits per component.
+     */
+    int red_shift;
+
+    /**
+     * The number of bits each 32-bit pixel must be shifted right such that
+     * the green component occupies the least significant 8 bits. This is only
+     * applicable to 32-bit pixels having 8 bits per component.
+     */
+    int green_shift;
+
+    /**
+     * The number of bits each 32-bit pixel must be shifted right such that
+     * the component which will become the output blue component occupies the
+     * least significant 8 bits. This is only applicable to 32-bit pixels
+     * having 8 bits per component.
+     */
+    int blue_shift;
+
+    /**
+     * Lookup table mapping every possible 8-bit or 16-bit pixel value to its
+     * RGB24 equivalent, or NULL if the pixel format is not 8-bit or 16-bit.
+     */
+    uint32_t* lookup;
+
+    /**
+     * Buffer which receives converted image data. This buffer is reused
+     * across updates and grows as needed.
+     */
+    unsigned char* buffer;
+
+    /**
+     * The size of the buffer, in bytes.
+     */
+    size_t buffer_size;
+
+};
+
+/**
+ * Initializes the given converter for the given VNC pixel format, selecting
+ * the most efficient conversion strategy for that format. Any lookup tables
+ * required by the selected strategy are built at this time. If the converter
+ * was previously initialized, the lookup tables of the previous format are
+ * freed, while the conversion buffer is retained.
+ *
+ * @param converter
+ *     The converter to initialize. If not previously initialized, this must
+ *     be zeroed.
+ *
+ * @param format
+ *     The pixel format of the VNC framebuffer.
+ *
+ * @param swap_red_blue
+ *     Non-zero if the red and blue components should be swapped, zero
+ *     otherwise.
+ */
+void guac_vnc_pixel_converter_init(guac_vnc_pixel_converter* converter,
+        const rfbPixelFormat* format, int swap_red_blue);
+
+/**
+ * Frees all memory associated with the given converter, excluding the
+ * converter structure itself.
+ *
+ * @param converter
+ *     The converter to destroy.
+ */
+void guac_vnc_pixel_converter_destroy(guac_vnc_pixel_converter* converter);
+
+/**
+ * Converts the given rectangle of the VNC framebuffer into a cairo image
+ * surface. If the VNC framebuffer is already in cairo's RGB24 layout, the
+ * returned surface refers directly to the framebuffer and no copy is made.
+ * Otherwise, the returned surface refers to the converter's internal buffer,
+ * which will be overwritten by the next conversion.
+ *
+ * @param converter
+ *     The converter to use.
+ *
+ * @param client
+ *     The VNC client whose framebuffer contains the image data.
+ *
+ * @param x
+ *     The X coordinate of the upper-left corner of the rectangle to convert.
+ *
+ * @param y
+ *     The Y coordinate of the upper-left corner of the rectangle to convert.
+ *
+ * @param w
+ *     The width of the rectangle to convert, in pixels.
+ *
+ * @param h
+ *     The height of the rectangle to convert, in pixels.
+ *
+ * @return
+ *     A new cairo image surface containing the converted image data, which
+ *     must be destroyed with cairo_surface_destroy() before the framebuffer
+ *     is next modified or the converter is next used.
+ */
+cairo_surface_t* guac_vnc_pixel_converter_convert(
+        guac_vnc_pixel_converter* converter, rfbClient* client,
+        int x, int y, int w, int h);
+
+#endif
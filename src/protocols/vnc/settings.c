@@ -22,6 +22,7 @@
 #include "argv.h"
 #include "client.h"
 #include "common/defaults.h"
+#include "common/download.h"
 #include "settings.h"
 
 #include <guacamole/mem.h>
@@ -76,6 +77,7 @@ const char* GUAC_VNC_CLIENT_ARGS[] = {
     "sftp-server-alive-interval",
     "sftp-disable-download",
     "sftp-disable-upload",
+    "sftp-download-window",
 #endif
 
     "recording-path",
@@ -83,6 +85,7 @@ const char* GUAC_VNC_CLIENT_ARGS[] = {
     "recording-exclude-output",
     "recording-exclude-mouse",
     "recording-include-keys",
+    "recording-index",
     "create-recording-path",
     "disable-copy",
     "disable-paste",
@@ -94,6 +97,7 @@ const char* GUAC_VNC_CLIENT_ARGS[] = {
     "wol-wait-time",
 
     "force-lossless",
+    "cursor-update-interval",
     NULL
 };
 
@@ -285,6 +289,13 @@ enum VNC_ARGS_IDX {
      * "false" or not set, file uploads will be allowed.
      */
     IDX_SFTP_DISABLE_UPLOAD,
+
+    /**
+     * The maximum number of blobs which may be sent along each download
+     * stream from the SFTP server without having been acknowledged. By
+     * default, GUAC_COMMON_DOWNLOAD_DEFAULT_WINDOW blobs may be in flight.
+     */
+    IDX_SFTP_DOWNLOAD_WINDOW,
 #endif
 
     /**
@@ -325,6 +336,15 @@ enum VNC_ARGS_IDX {
      */
     IDX_RECORDING_INCLUDE_KEYS,
 
+    /**
+     * Whether an index should be written alongside the session recording,
+     * allowing playback of the recording to begin at an arbitrary point in
+     * time. If enabled, the full state of the display is periodically
+     * written to the recording as a keyframe, and the location of each
+     * keyframe is noted within the index.
+     */
+    IDX_RECORDING_INDEX,
+
     /**
      * Whether the specified screen recording path should automatically be
      * created if it does not yet exist.
@@ -382,6 +402,13 @@ enum VNC_ARGS_IDX {
      */
     IDX_FORCE_LOSSLESS,
 
+    /**
+     * The minimum number of milliseconds between updates of the shared mouse
+     * cursor sent to each user that is not moving the cursor. If blank or
+     * zero, updates are sent with every frame.
+     */
+    IDX_CURSOR_UPDATE_INTERVAL,
+
     VNC_ARGS_COUNT
 };
 
@@ -446,6 +473,11 @@ guac_vnc_settings* guac_vnc_parse_args(guac_user* user,
         guac_user_parse_args_boolean(user, GUAC_VNC_CLIENT_ARGS, argv,
                 IDX_FORCE_LOSSLESS, false);
 
+    /* Shared cursor update interval */
+    settings->cursor_update_interval =
+        guac_user_parse_args_int(user, GUAC_VNC_CLIENT_ARGS, argv,
+                IDX_CURSOR_UPDATE_INTERVAL, 0);
+
 #ifdef ENABLE_VNC_REPEATER
     /* Set repeater parameters if specified */
     settings->dest_host =
@@ -562,6 +594,10 @@ guac_vnc_settings* guac_vnc_parse_args(guac_user* user,
     settings->sftp_disable_upload =
         guac_user_parse_args_boolean(user, GUAC_VNC_CLIENT_ARGS, argv,
                 IDX_SFTP_DISABLE_UPLOAD, false);
+
+    settings->sftp_download_window =
+        guac_user_parse_args_int(user, GUAC_VNC_CLIENT_ARGS, argv,
+                IDX_SFTP_DOWNLOAD_WINDOW, GUAC_COMMON_DOWNLOAD_DEFAULT_WINDOW);
 #endif
 
     /* Read recording path */
@@ -589,6 +625,11 @@ guac_vnc_settings* guac_vnc_parse_args(guac_user* user,
         guac_user_parse_args_boolean(user, GUAC_VNC_CLIENT_ARGS, argv,
                 IDX_RECORDING_INCLUDE_KEYS, false);
 
+    /* Parse recording index flag */
+    settings->recording_index =
+        guac_user_parse_args_boolean(user, GUAC_VNC_CLIENT_ARGS, argv,
+                IDX_RECORDING_INDEX, false);
+
     /* Parse path creation flag */
     settings->create_recording_path =
         guac_user_parse_args_boolean(user, GUAC_VNC_CLIENT_ARGS, argv,
@@ -83,6 +83,13 @@ typedef struct guac_vnc_settings {
      */
     bool lossless;
 
+    /**
+     * The minimum number of milliseconds between updates of the shared mouse
+     * cursor sent to each user that is not moving the cursor, or zero if
+     * updates should be sent with every frame.
+     */
+    int cursor_update_interval;
+
 #ifdef ENABLE_VNC_REPEATER
     /**
      * The VNC host to connect to, if using a repeater.
@@ -231,6 +238,12 @@ typedef struct guac_vnc_settings {
      * to "false" or not set, file uploads will be allowed.
      */
     bool sftp_disable_upload;
+
+    /**
+     * The maximum number of blobs which may be sent along each download
+     * stream over SFTP without having been acknowledged.
+     */
+    int sftp_download_window;
 #endif
 
     /**
@@ -275,6 +288,13 @@ typedef struct guac_vnc_settings {
      * as passwords, credit card numbers, etc.
      */
     bool recording_include_keys;
+
+    /**
+     * Whether an index should be written alongside the session recording,
+     * allowing playback of the recording to begin at an arbitrary point in
+     * time.
+     */
+    bool recording_index;
     
     /**
      * Whether or not to send the magic Wake-on-LAN (WoL) packet prior to
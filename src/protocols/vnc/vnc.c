@@ -390,7 +390,8 @@ void* guac_vnc_client_thread(void* data) {
             guac_common_ssh_create_sftp_filesystem(vnc_client->sftp_session,
                     settings->sftp_root_directory, NULL,
                     settings->sftp_disable_download,
-                    settings->sftp_disable_upload);
+                    settings->sftp_disable_upload,
+                    settings->sftp_download_window);
 
         /* Expose filesystem to connection owner */
         guac_client_for_owner(client,
@@ -429,6 +430,12 @@ void* guac_vnc_client_thread(void* data) {
                 !settings->recording_exclude_mouse,
                 0, /* Touch events not supported */
                 settings->recording_include_keys);
+
+        /* Index recording, if requested */
+        if (vnc_client->recording != NULL && settings->recording_index)
+            guac_recording_enable_index(vnc_client->recording,
+                    GUAC_RECORDING_DEFAULT_KEYFRAME_INTERVAL);
+
     }
 
     /* Create display */
@@ -439,6 +446,10 @@ void* guac_vnc_client_thread(void* data) {
      * heuristics) */
     guac_common_display_set_lossless(vnc_client->display, settings->lossless);
 
+    /* Limit the rate of shared cursor updates only if requested */
+    guac_common_cursor_set_update_interval(vnc_client->display->cursor,
+            settings->cursor_update_interval);
+
     /* If not read-only, set an appropriate cursor */
     if (settings->read_only == 0) {
         if (settings->remote_cursor)
@@ -460,7 +471,8 @@ void* guac_vnc_client_thread(void* data) {
                 GUAC_VNC_FRAME_START_TIMEOUT);
         if (wait_result > 0) {
 
-            int processing_lag = guac_client_get_processing_lag(client);
+            int frame_delay = guac_common_display_get_frame_delay(
+                    vnc_client->display);
             guac_timestamp frame_start = guac_timestamp_current();
 
             /* Read server messages until frame is built */
@@ -484,7 +496,7 @@ void* guac_vnc_client_thread(void* data) {
 
                 /* Calculate time that client needs to catch up */
                 int time_elapsed = frame_end - last_frame_end;
-                int required_wait = processing_lag - time_elapsed;
+                int required_wait = frame_delay - time_elapsed;
 
                 /* Increase the duration of this frame if client is lagging */
                 if (required_wait > GUAC_VNC_FRAME_TIMEOUT)
@@ -513,8 +525,14 @@ void* guac_vnc_client_thread(void* data) {
             guac_client_abort(client, GUAC_PROTOCOL_STATUS_UPSTREAM_ERROR, "Connection closed.");
 
         /* Flush frame */
-        guac_common_surface_flush(vnc_client->display->default_surface);
+        guac_common_display_flush(vnc_client->display);
         guac_client_end_frame(client);
+
+        /* Periodically record full display state, if indexing */
+        if (vnc_client->recording != NULL)
+            guac_common_display_record_keyframe(vnc_client->display,
+                    vnc_client->recording);
+
         guac_socket_flush(client->socket);
 
     }
@@ -25,7 +25,9 @@
 #include "common/clipboard.h"
 #include "common/display.h"
 #include "common/iconv.h"
+#include "common/input.h"
 #include "common/surface.h"
+#include "pixel-format.h"
 #include "settings.h"
 
 #include <guacamole/client.h>
@@ -80,6 +82,12 @@ typedef struct guac_vnc_client {
      */
     int copy_rect_used;
 
+    /**
+     * Conversion state for translating the VNC framebuffer into image data
+     * that can be drawn to the display.
+     */
+    guac_vnc_pixel_converter converter;
+
     /**
      * Client settings, parsed from args.
      */
@@ -95,6 +103,12 @@ typedef struct guac_vnc_client {
      */
     guac_common_clipboard* clipboard;
 
+    /**
+     * Coalescer which combines rapid mouse motion before it is sent to the
+     * VNC server.
+     */
+    guac_common_input* input;
+
 #ifdef ENABLE_PULSE
     /**
      * PulseAudio output, if any.
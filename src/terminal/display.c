@@ -18,9 +18,11 @@
  */
 
 
+#include "common/encoder.h"
 #include "common/surface.h"
 #include "terminal/common.h"
 #include "terminal/display.h"
+#include "terminal/glyph-cache.h"
 #include "terminal/palette.h"
 #include "terminal/terminal.h"
 #include "terminal/terminal-priv.h"
@@ -133,6 +135,18 @@ int __guac_terminal_set(guac_terminal_display* display, int row, int col, int co
     if (width == 0)
         return 0;
 
+    /* Reuse previous rendering of identical glyph, if available */
+    surface = guac_terminal_glyph_cache_get(display->glyph_cache, codepoint,
+            color, background);
+
+    if (surface != NULL) {
+        guac_common_surface_draw(display->display_surface,
+            display->char_width * col,
+            display->char_height * row,
+            surface);
+        return 0;
+    }
+
     /* Convert to UTF-8 */
     bytes = guac_terminal_encode_utf8(codepoint, utf8);
 
@@ -194,10 +208,12 @@ int __guac_terminal_set(guac_terminal_display* display, int row, int col, int co
         display->char_height * row,
         surface);
 
-    /* Free all */
+    /* Free all but rendered glyph, which is now owned by the cache */
     g_object_unref(layout);
     cairo_destroy(cairo);
-    cairo_surface_destroy(surface);
+    cairo_surface_flush(surface);
+    guac_terminal_glyph_cache_put(display->glyph_cache, codepoint,
+            color, background, surface);
 
     return 0;
 
@@ -227,6 +243,7 @@ guac_terminal_display* guac_terminal_display_alloc(guac_client* client,
 
     /* Initially no font loaded */
     display->font_desc = NULL;
+    display->glyph_cache = guac_terminal_glyph_cache_alloc(client);
     display->char_width = 0;
     display->char_height = 0;
 
@@ -239,6 +256,9 @@ guac_terminal_display* guac_terminal_display_alloc(guac_client* client,
     /* Never use lossy compression for terminal contents */
     guac_common_surface_set_lossless(display->display_surface, 1);
 
+    /* Encode images in parallel for as long as this display exists */
+    guac_common_encoder_pool_acquire();
+
     /* Select layer is a child of the display layer */
     guac_protocol_send_move(client->socket, display->select_layer,
             display->display_layer, 0, 0, 0);
@@ -258,6 +278,9 @@ guac_terminal_display* guac_terminal_display_alloc(guac_client* client,
     display->width = 0;
     display->height = 0;
     display->operations = NULL;
+    display->dirty = NULL;
+    display->dirty_top = 0;
+    display->dirty_bottom = -1;
 
     /* Initially nothing selected */
     display->text_selected = false;
@@ -266,6 +289,8 @@ guac_terminal_display* guac_terminal_display_alloc(guac_client* client,
     if (guac_terminal_display_set_font(display, font_name, font_size, dpi)) {
         guac_client_abort(display->client, GUAC_PROTOCOL_STATUS_SERVER_ERROR,
                 "Unable to set initial font \"%s\"", font_name);
+        guac_common_encoder_pool_release();
+        guac_terminal_glyph_cache_free(display->glyph_cache);
         guac_mem_free(display);
         return NULL;
     }
@@ -276,14 +301,19 @@ guac_terminal_display* guac_terminal_display_alloc(guac_client* client,
 
 void guac_terminal_display_free(guac_terminal_display* display) {
 
-    /* Free font description */
+    /* Free font description and any glyphs rendered with that font */
     pango_font_description_free(display->font_desc);
+    guac_terminal_glyph_cache_free(display->glyph_cache);
 
     /* Free default palette. */
     guac_mem_free(display->default_palette);
 
     /* Free operations buffers */
     guac_mem_free(display->operations);
+    guac_mem_free(display->dirty);
+
+    /* Stop parallel encoding if no other display needs it */
+    guac_common_encoder_pool_release();
 
     /* Free display */
     guac_mem_free(display);
@@ -292,6 +322,9 @@ void guac_terminal_display_free(guac_terminal_display* display) {
 
 void guac_terminal_display_reset_palette(guac_terminal_display* display) {
 
+    /* Glyphs rendered using the old color scheme are unlikely to be reused */
+    guac_terminal_glyph_cache_clear(display->glyph_cache);
+
     /* Reinitialize palette with default values */
     if (display->default_palette) {
         memcpy(display->palette, *display->default_palette,
@@ -346,6 +379,75 @@ int guac_terminal_display_lookup_color(guac_terminal_display* display,
 
 }
 
+/**
+ * Records that the given range of columns within the given row may now have
+ * pending operations. The row and columns given must be within the bounds of
+ * the display.
+ *
+ * @param display
+ *     The display whose pending operations are being updated.
+ *
+ * @param row
+ *     The row containing the columns which may have pending operations.
+ *
+ * @param start_column
+ *     The first column which may have pending operations.
+ *
+ * @param end_column
+ *     The last column which may have pending operations.
+ */
+static void guac_terminal_display_mark_dirty(guac_terminal_display* display,
+        int row, int start_column, int end_column) {
+
+    guac_terminal_dirty_span* span = &(display->dirty[row]);
+
+    /* Expand existing range of row, if any */
+    if (span->end_column < span->start_column) {
+        span->start_column = start_column;
+        span->end_column = end_column;
+    }
+    else {
+        if (start_column < span->start_column)
+            span->start_column = start_column;
+        if (end_column > span->end_column)
+            span->end_column = end_column;
+    }
+
+    /* Expand range of rows */
+    if (display->dirty_bottom < display->dirty_top) {
+        display->dirty_top = row;
+        display->dirty_bottom = row;
+    }
+    else {
+        if (row < display->dirty_top)
+            display->dirty_top = row;
+        if (row > display->dirty_bottom)
+            display->dirty_bottom = row;
+    }
+
+}
+
+/**
+ * Records that the given display has no pending operations. This must only
+ * be invoked once all operations have actually been flushed.
+ *
+ * @param display
+ *     The display whose pending operations have all been flushed.
+ */
+static void guac_terminal_display_clear_dirty(guac_terminal_display* display) {
+
+    int row;
+
+    for (row = display->dirty_top; row <= display->dirty_bottom; row++) {
+        display->dirty[row].start_column = 0;
+        display->dirty[row].end_column = -1;
+    }
+
+    display->dirty_top = 0;
+    display->dirty_bottom = -1;
+
+}
+
 void guac_terminal_display_copy_columns(guac_terminal_display* display, int row,
         int start_column, int end_column, int offset) {
 
@@ -370,6 +472,9 @@ void guac_terminal_display_copy_columns(guac_terminal_display* display, int row,
     memmove(current, src_current,
         (end_column - start_column + 1) * sizeof(guac_terminal_operation));
 
+    guac_terminal_display_mark_dirty(display, row,
+            start_column + offset, end_column + offset);
+
     /* Update operations */
     for (i=start_column; i<=end_column; i++) {
 
@@ -411,6 +516,9 @@ void guac_terminal_display_copy_rows(guac_terminal_display* display,
     for (row=start_row; row<=end_row; row++) {
 
         guac_terminal_operation* current = current_row;
+        guac_terminal_display_mark_dirty(display, row + offset,
+                0, display->width - 1);
+
         for (col=0; col<display->width; col++) {
 
             /* If no operation here, set as copy */
@@ -451,6 +559,7 @@ void guac_terminal_display_set_columns(guac_terminal_display* display, int row,
     end_column   = guac_terminal_fit_to_range(end_column,   0, display->width - 1);
 
     current = &(display->operations[row * display->width + start_column]);
+    guac_terminal_display_mark_dirty(display, row, start_column, end_column);
 
     /* For each column in range */
     for (i = start_column; i <= end_column; i += character->width) {
@@ -489,10 +598,22 @@ void guac_terminal_display_resize(guac_terminal_display* display, int width, int
     if (display->operations != NULL)
         guac_mem_free(display->operations);
 
+    guac_mem_free(display->dirty);
+
     /* Alloc operations */
     display->operations = guac_mem_alloc(width, height,
             sizeof(guac_terminal_operation));
 
+    /* Any part of the resized display may have pending operations */
+    display->dirty = guac_mem_alloc(height, sizeof(guac_terminal_dirty_span));
+    for (y=0; y<height; y++) {
+        display->dirty[y].start_column = 0;
+        display->dirty[y].end_column = width - 1;
+    }
+
+    display->dirty_top = 0;
+    display->dirty_bottom = height - 1;
+
     /* Init each operation buffer row */
     current = display->operations;
     for (y=0; y<height; y++) {
@@ -535,12 +656,16 @@ void guac_terminal_display_resize(guac_terminal_display* display, int width, int
 
 void __guac_terminal_display_flush_copy(guac_terminal_display* display) {
 
-    guac_terminal_operation* current = display->operations;
     int row, col;
 
-    /* For each operation */
-    for (row=0; row<display->height; row++) {
-        for (col=0; col<display->width; col++) {
+    /* For each operation within the changed portion of the display */
+    for (row=display->dirty_top; row<=display->dirty_bottom; row++) {
+
+        guac_terminal_dirty_span* span = &(display->dirty[row]);
+        guac_terminal_operation* current =
+            &(display->operations[row * display->width + span->start_column]);
+
+        for (col=span->start_column; col<=span->end_column; col++) {
 
             /* If operation is a copy operation */
             if (current->type == GUAC_CHAR_COPY) {
@@ -660,12 +785,16 @@ void __guac_terminal_display_flush_copy(guac_terminal_display* display) {
 
 void __guac_terminal_display_flush_clear(guac_terminal_display* display) {
 
-    guac_terminal_operation* current = display->operations;
     int row, col;
 
-    /* For each operation */
-    for (row=0; row<display->height; row++) {
-        for (col=0; col<display->width; col++) {
+    /* For each operation within the changed portion of the display */
+    for (row=display->dirty_top; row<=display->dirty_bottom; row++) {
+
+        guac_terminal_dirty_span* span = &(display->dirty[row]);
+        guac_terminal_operation* current =
+            &(display->operations[row * display->width + span->start_column]);
+
+        for (col=span->start_column; col<=span->end_column; col++) {
 
             /* If operation is a clear operation (set to space) */
             if (current->type == GUAC_CHAR_SET &&
@@ -795,12 +924,16 @@ void __guac_terminal_display_flush_clear(guac_terminal_display* display) {
 
 void __guac_terminal_display_flush_set(guac_terminal_display* display) {
 
-    guac_terminal_operation* current = display->operations;
     int row, col;
 
-    /* For each operation */
-    for (row=0; row<display->height; row++) {
-        for (col=0; col<display->width; col++) {
+    /* For each operation within the changed portion of the display */
+    for (row=display->dirty_top; row<=display->dirty_bottom; row++) {
+
+        guac_terminal_dirty_span* span = &(display->dirty[row]);
+        guac_terminal_operation* current =
+            &(display->operations[row * display->width + span->start_column]);
+
+        for (col=span->start_column; col<=span->end_column; col++) {
 
             /* Perform given operation */
             if (current->type == GUAC_CHAR_SET) {
@@ -838,6 +971,9 @@ void guac_terminal_display_flush(guac_terminal_display* display) {
     __guac_terminal_display_flush_clear(display);
     __guac_terminal_display_flush_set(display);
 
+    /* All pending operations have now been handled */
+    guac_terminal_display_clear_dirty(display);
+
     /* Flush surface */
     guac_common_surface_flush(display->display_surface);
 
@@ -1041,6 +1177,9 @@ int guac_terminal_display_set_font(guac_terminal_display* display,
     display->font_desc = font_desc;
     pango_font_description_free(old_font_desc);
 
+    /* All previously-rendered glyphs used the old font */
+    guac_terminal_glyph_cache_clear(display->glyph_cache);
+
     /* Recalculate dimensions which will fit within current surface */
     int new_width = pixel_width / display->char_width;
     int new_height = pixel_height / display->char_height;
@@ -0,0 +1,259 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "terminal/glyph-cache.h"
+#include "terminal/palette.h"
+
+#include <cairo/cairo.h>
+#include <guacamole/client.h>
+#include <guacamole/mem.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Packs the RGB components of the given color into a single integer of the
+ * form 0xRRGGBB. The palette index of the color is ignored, as only the
+ * effective color affects rendering.
+ *
+ * @param color
+ *     The color to pack.
+ *
+ * @return
+ *     The RGB components of the given color, packed as 0xRRGGBB.
+ */
+static uint32_t guac_terminal_glyph_pack_color(const guac_terminal_color* color) {
+    return (color->red << 16) | (color->green << 8) | color->blue;
+}
+
+/**
+ * Returns the index of the hash bucket that should contain the glyph having
+ * the given codepoint and packed colors.
+ *
+ * @param codepoint
+ *     The Unicode codepoint of the character.
+ *
+ * @param foreground
+ *     The foreground color of the character, packed as 0xRRGGBB.
+ *
+ * @param background
+ *     The background color of the character, packed as 0xRRGGBB.
+ *
+ * @return
+ *     The index of the hash bucket for the glyph.
+ */
+static unsigned int guac_terminal_glyph_hash(int codepoint,
+        uint32_t foreground, uint32_t background) {
+
+    uint32_t hash = (uint32_t) codepoint * 0x9E3779B1;
+    hash ^= foreground * 0x85EBCA77;
+    hash ^= background * 0xC2B2AE3D;
+    hash ^= hash >> 15;
+
+    return hash & (GUAC_TERMINAL_GLYPH_CACHE_BUCKETS - 1);
+
+}
+
+/**
+ * Removes the given glyph from the LRU list of the given cache, without
+ * otherwise modifying the glyph or the cache.
+ *
+ * @param cache
+ *     The cache containing the glyph.
+ *
+ * @param glyph
+ *     The glyph to unlink.
+ */
+static void guac_terminal_glyph_unlink_used(guac_terminal_glyph_cache* cache,
+        guac_terminal_glyph* glyph) {
+
+    if (glyph->prev_used != NULL)
+        glyph->prev_used->next_used = glyph->next_used;
+    else
+        cache->most_recent = glyph->next_used;
+
+    if (glyph->next_used != NULL)
+        glyph->next_used->prev_used = glyph->prev_used;
+    else
+        cache->least_recent = glyph->prev_used;
+
+    glyph->prev_used = NULL;
+    glyph->next_used = NULL;
+
+}
+
+/**
+ * Inserts the given glyph at the head of the LRU list of the given cache,
+ * marking it as most-recently-used.
+ *
+ * @param cache
+ *     The cache containing the glyph.
+ *
+ * @param glyph
+ *     The glyph to mark as most-recently-used.
+ */
+static void guac_terminal_glyph_link_used(guac_terminal_glyph_cache* cache,
+        guac_terminal_glyph* glyph) {
+
+    glyph->prev_used = NULL;
+    glyph->next_used = cache->most_recent;
+
+    if (cache->most_recent != NULL)
+        cache->most_recent->prev_used = glyph;
+    else
+        cache->least_recent = glyph;
+
+    cache->most_recent = glyph;
+
+}
+
+/**
+ * Removes and frees the least-recently-used glyph within the given cache. If
+ * the cache is empty, this function has no effect.
+ *
+ * @param cache
+ *     The cache to evict a glyph from.
+ */
+static void guac_terminal_glyph_cache_evict(guac_terminal_glyph_cache* cache) {
+
+    guac_terminal_glyph* glyph = cache->least_recent;
+    if (glyph == NULL)
+        return;
+
+    /* Remove from containing bucket */
+    unsigned int index = guac_terminal_glyph_hash(glyph->codepoint,
+            glyph->foreground, glyph->background);
+
+    guac_terminal_glyph** current = &cache->buckets[index];
+    while (*current != glyph)
+        current = &(*current)->next_in_bucket;
+
+    *current = glyph->next_in_bucket;
+
+    /* Remove from LRU list */
+    guac_terminal_glyph_unlink_used(cache, glyph);
+
+    cache->size -= glyph->size;
+    cairo_surface_destroy(glyph->surface);
+    guac_mem_free(glyph);
+
+}
+
+guac_terminal_glyph_cache* guac_terminal_glyph_cache_alloc(guac_client* client) {
+
+    guac_terminal_glyph_cache* cache =
+        guac_mem_zalloc(sizeof(guac_terminal_glyph_cache));
+
+    cache->client = client;
+    return cache;
+
+}
+
+void guac_terminal_glyph_cache_free(guac_terminal_glyph_cache* cache) {
+
+    guac_terminal_glyph_cache_clear(cache);
+    guac_mem_free(cache);
+
+}
+
+void guac_terminal_glyph_cache_clear(guac_terminal_glyph_cache* cache) {
+
+    /* Log effectiveness of cache prior to discarding its contents */
+    if (cache->hits || cache->misses)
+        guac_client_log(cache->client, GUAC_LOG_DEBUG, "Glyph cache cleared "
+                "(%lu hits, %lu misses, %zu bytes in use).", cache->hits,
+                cache->misses, cache->size);
+
+    while (cache->least_recent != NULL)
+        guac_terminal_glyph_cache_evict(cache);
+
+    cache->hits = 0;
+    cache->misses = 0;
+
+}
+
+cairo_surface_t* guac_terminal_glyph_cache_get(guac_terminal_glyph_cache* cache,
+        int codepoint, const guac_terminal_color* foreground,
+        const guac_terminal_color* background) {
+
+    uint32_t packed_foreground = guac_terminal_glyph_pack_color(foreground);
+    uint32_t packed_background = guac_terminal_glyph_pack_color(background);
+
+    unsigned int index = guac_terminal_glyph_hash(codepoint,
+            packed_foreground, packed_background);
+
+    /* Search bucket for matching glyph */
+    guac_terminal_glyph* glyph = cache->buckets[index];
+    while (glyph != NULL) {
+
+        if (glyph->codepoint == codepoint
+                && glyph->foreground == packed_foreground
+                && glyph->background == packed_background) {
+
+            /* Glyph is now the most-recently-used */
+            if (cache->most_recent != glyph) {
+                guac_terminal_glyph_unlink_used(cache, glyph);
+                guac_terminal_glyph_link_used(cache, glyph);
+            }
+
+            cache->hits++;
+            return glyph->surface;
+
+        }
+
+        glyph = glyph->next_in_bucket;
+
+    }
+
+    cache->misses++;
+    return NULL;
+
+}
+
+void guac_terminal_glyph_cache_put(guac_terminal_glyph_cache* cache,
+        int codepoint, const guac_terminal_color* foreground,
+        const guac_terminal_color* background, cairo_surface_t* surface) {
+
+    guac_terminal_glyph* glyph = guac_mem_alloc(sizeof(guac_terminal_glyph));
+    glyph->codepoint = codepoint;
+    glyph->foreground = guac_terminal_glyph_pack_color(foreground);
+    glyph->background = guac_terminal_glyph_pack_color(background);
+    glyph->surface = surface;
+    glyph->size = guac_mem_ckd_mul_or_die(
+            cairo_image_surface_get_stride(surface),
+            cairo_image_surface_get_height(surface));
+
+    /* Evict least-recently-used glyphs until the new glyph will fit */
+    while (cache->least_recent != NULL
+            && cache->size + glyph->size > GUAC_TERMINAL_GLYPH_CACHE_MAX_BYTES)
+        guac_terminal_glyph_cache_evict(cache);
+
+    /* Add to head of bucket */
+    unsigned int index = guac_terminal_glyph_hash(codepoint,
+            glyph->foreground, glyph->background);
+
+    glyph->next_in_bucket = cache->buckets[index];
+    cache->buckets[index] = glyph;
+
+    /* New glyph is the most-recently-used */
+    guac_terminal_glyph_link_used(cache, glyph);
+    cache->size += glyph->size;
+
+}
@@ -306,6 +306,9 @@ void* guac_terminal_thread(void* data) {
         if (guac_terminal_render_frame(terminal))
             break;
 
+        /* Send latest position of the shared cursor with this frame */
+        guac_common_cursor_flush(terminal->cursor);
+
         /* Signal end of frame */
         guac_client_end_frame(client);
         guac_socket_flush(client->socket);
@@ -636,6 +639,9 @@ void guac_terminal_free(guac_terminal* term) {
     /* Free scrollbar */
     guac_terminal_scrollbar_free(term->scrollbar);
 
+    /* Free shared mouse cursor */
+    guac_common_cursor_free(term->cursor);
+
     /* Free copies of font and color scheme information */
     guac_mem_free_const(term->color_scheme);
     guac_mem_free_const(term->font_name);
@@ -1843,6 +1849,10 @@ int guac_terminal_send_mouse(guac_terminal* term, guac_user* user,
     result = __guac_terminal_send_mouse(term, user, x, y, mask);
     guac_terminal_unlock(term);
 
+    /* Ensure the new cursor position is sent to other users promptly, even
+     * if the terminal is otherwise idle */
+    guac_terminal_notify(term);
+
     return result;
 
 }
@@ -29,6 +29,7 @@
 
 
 #include "common/surface.h"
+#include "glyph-cache.h"
 #include "palette.h"
 #include "types.h"
 
@@ -108,6 +109,26 @@ typedef struct guac_terminal_operation {
 
 } guac_terminal_operation;
 
+/**
+ * The range of columns within a single row of the display which may have
+ * pending operations. All columns outside this range are guaranteed to have
+ * no pending operations (GUAC_CHAR_NOP).
+ */
+typedef struct guac_terminal_dirty_span {
+
+    /**
+     * The first column which may have a pending operation.
+     */
+    int start_column;
+
+    /**
+     * The last column which may have a pending operation. If less than
+     * start_column, the row has no pending operations.
+     */
+    int end_column;
+
+} guac_terminal_dirty_span;
+
 /**
  * Set of all pending operations for the currently-visible screen area, and the
  * contextual information necessary to interpret and render those changes.
@@ -124,6 +145,24 @@ typedef struct guac_terminal_display {
      */
     guac_terminal_operation* operations;
 
+    /**
+     * The range of columns within each row which may have pending operations,
+     * such that flushing the display need only visit those parts of the
+     * display which have actually changed.
+     */
+    guac_terminal_dirty_span* dirty;
+
+    /**
+     * The first row which may have pending operations.
+     */
+    int dirty_top;
+
+    /**
+     * The last row which may have pending operations. If less than dirty_top,
+     * the display has no pending operations.
+     */
+    int dirty_bottom;
+
     /**
      * The width of the screen, in characters.
      */
@@ -144,6 +183,13 @@ typedef struct guac_terminal_display {
      */
     PangoFontDescription* font_desc;
 
+    /**
+     * Cache of character cells which have already been rendered using the
+     * current font. This cache is cleared whenever the font or color scheme
+     * changes.
+     */
+    guac_terminal_glyph_cache* glyph_cache;
+
     /**
      * The width of each character, in pixels.
      */
@@ -0,0 +1,233 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef GUAC_TERMINAL_GLYPH_CACHE_H
+#define GUAC_TERMINAL_GLYPH_CACHE_H
+
+/**
+ * Structures and function definitions related to the cache of pre-rendered
+ * character cells used by the terminal display.
+ *
+ * @file glyph-cache.h
+ */
+
+#include "palette.h"
+
+#include <cairo/cairo.h>
+#include <guacamole/client.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The number of hash buckets within each glyph cache. This value MUST be a
+ * power of two.
+ */
+#define GUAC_TERMINAL_GLYPH_CACHE_BUCKETS 1024
+
+/**
+ * The maximum number of bytes of rendered image data that may be held by a
+ * single glyph cache. Once this limit is exceeded, the least-recently-used
+ * glyphs are evicted.
+ */
+#define GUAC_TERMINAL_GLYPH_CACHE_MAX_BYTES 4194304
+
+/**
+ * A single character cell which has been rendered with a specific foreground
+ * and background color using the current font of the terminal display.
+ */
+typedef struct guac_terminal_glyph {
+
+    /**
+     * The Unicode codepoint of the rendered character.
+     */
+    int codepoint;
+
+    /**
+     * The foreground color that the character was rendered with, packed as
+     * 0xRRGGBB.
+     */
+    uint32_t foreground;
+
+    /**
+     * The background color that the character was rendered with, packed as
+     * 0xRRGGBB.
+     */
+    uint32_t background;
+
+    /**
+     * The rendered character cell. The dimensions of this surface are the
+     * dimensions of a single character (multiplied by the number of columns
+     * the character occupies).
+     */
+    cairo_surface_t* surface;
+
+    /**
+     * The number of bytes of image data consumed by the surface.
+     */
+    size_t size;
+
+    /**
+     * The next glyph within the same hash bucket, or NULL if this is the last
+     * glyph in the bucket.
+     */
+    struct guac_terminal_glyph* next_in_bucket;
+
+    /**
+     * The glyph which was used immediately more recently than this glyph, or
+     * NULL if this is the most-recently-used glyph.
+     */
+    struct guac_terminal_glyph* prev_used;
+
+    /**
+     * The glyph which was used immediately less recently than this glyph, or
+     * NULL if this is the least-recently-used glyph.
+     */
+    struct guac_terminal_glyph* next_used;
+
+} guac_terminal_glyph;
+
+/**
+ * A bounded cache of rendered character cells, keyed by codepoint and the
+ * effective foreground and background colors. Each glyph is rendered with
+ * Pango only once; subsequent draws of the same glyph merely copy the cached
+ * image data.
+ */
+typedef struct guac_terminal_glyph_cache {
+
+    /**
+     * The client which owns the terminal using this cache. This is used only
+     * for logging.
+     */
+    guac_client* client;
+
+    /**
+     * All cached glyphs, hashed by codepoint and color.
+     */
+    guac_terminal_glyph* buckets[GUAC_TERMINAL_GLYPH_CACHE_BUCKETS];
+
+    /**
+     * The most-recently-used glyph, or NULL if the cache is empty.
+     */
+    guac_terminal_glyph* most_recent;
+
+    /**
+     * The least-recently-used glyph, or NULL if the cache is empty. This
+     * glyph is the first to be evicted when the cache is full.
+     */
+    guac_terminal_glyph* least_recent;
+
+    /**
+     * The total number of bytes of image data currently held by the cache.
+     */
+    size_t size;
+
+    /**
+     * The number of lookups which were satisfied by a cached glyph.
+     */
+    unsigned long hits;
+
+    /**
+     * The number of lookups which required the glyph to be rendered.
+     */
+    unsigned long misses;
+
+} guac_terminal_glyph_cache;
+
+/**
+ * Allocates a new, empty glyph cache.
+ *
+ * @param client
+ *     The client which owns the terminal that will use the cache.
+ *
+ * @return
+ *     A newly-allocated glyph cache, which must eventually be freed with
+ *     guac_terminal_glyph_cache_free().
+ */
+guac_terminal_glyph_cache* guac_terminal_glyph_cache_alloc(guac_client* client);
+
+/**
+ * Frees the given glyph cache and all glyphs within it.
+ *
+ * @param cache
+ *     The glyph cache to free.
+ */
+void guac_terminal_glyph_cache_free(guac_terminal_glyph_cache* cache);
+
+/**
+ * Removes all glyphs from the given glyph cache. This must be invoked
+ * whenever a change is made that would affect the rendering of previously
+ * cached glyphs, such as a change in font.
+ *
+ * @param cache
+ *     The glyph cache to clear.
+ */
+void guac_terminal_glyph_cache_clear(guac_terminal_glyph_cache* cache);
+
+/**
+ * Returns the rendered surface of the glyph having the given codepoint and
+ * colors, if such a glyph is cached. The returned glyph is marked as
+ * most-recently-used.
+ *
+ * @param cache
+ *     The glyph cache to search.
+ *
+ * @param codepoint
+ *     The Unicode codepoint of the character.
+ *
+ * @param foreground
+ *     The foreground color of the character.
+ *
+ * @param background
+ *     The background color of the character.
+ *
+ * @return
+ *     The rendered surface of the matching glyph, or NULL if no such glyph
+ *     is cached. The returned surface remains owned by the cache.
+ */
+cairo_surface_t* guac_terminal_glyph_cache_get(guac_terminal_glyph_cache* cache,
+        int codepoint, const guac_terminal_color* foreground,
+        const guac_terminal_color* background);
+
+/**
+ * Adds the given rendered surface to the glyph cache, evicting the
+ * least-recently-used glyphs as necessary to remain within
+ * GUAC_TERMINAL_GLYPH_CACHE_MAX_BYTES. Ownership of the surface is
+ * transferred to the cache.
+ *
+ * @param cache
+ *     The glyph cache to add the surface to.
+ *
+ * @param codepoint
+ *     The Unicode codepoint of the character.
+ *
+ * @param foreground
+ *     The foreground color the character was rendered with.
+ *
+ * @param background
+ *     The background color the character was rendered with.
+ *
+ * @param surface
+ *     The rendered character cell. This MUST be an image surface.
+ */
+void guac_terminal_glyph_cache_put(guac_terminal_glyph_cache* cache,
+        int codepoint, const guac_terminal_color* foreground,
+        const guac_terminal_color* background, cairo_surface_t* surface);
+
+#endif